@@ -0,0 +1,110 @@
+#pragma once
+#include <Eigen/Dense>
+#include <algorithm>
+#include <functional>
+#include <tuple>
+
+using namespace Eigen;
+
+// -------------------- 回测输出策略 --------------------
+// 列分块引擎通过输出策略决定保存哪些结果，避免无条件物化三个 T×W 矩阵。
+// 每个输出策略需实现以下接口（引擎在编译期内联调用）：
+//   int  chunk_rows() const                       每块行数，<=0 表示整段一次跑完
+//   void begin(int n_timestamps, int n_weights)   回测开始前（串行）
+//   void begin_chunk(int row_begin, int row_end)  每个行块开始前（串行）
+//   void record(int col, int idx, float portfolio, float cash, float qty)
+//                                                 每列每个时间步（并行，同一列只由一个线程写）
+//   void end_chunk(int row_begin, int row_end)    每个行块结束后（串行）
+
+// 完整输出：组合价值 / 现金 / 持仓三个 T×W 矩阵，内存 O(T·W)
+struct FullOutput {
+    MatrixXf portfolio_values;
+    MatrixXf cash_matrix;
+    MatrixXf quantity_matrix;
+
+    int chunk_rows() const { return 0; }
+    void begin(int n_timestamps, int n_weights){
+        // 不预先清零：由负责该列的线程首次写入（first-touch）
+        portfolio_values.resize(n_timestamps, n_weights);
+        cash_matrix.resize(n_timestamps, n_weights);
+        quantity_matrix.resize(n_timestamps, n_weights);
+    }
+    void begin_chunk(int, int){}
+    void record(int col, int idx, float portfolio, float cash, float qty){
+        portfolio_values.coeffRef(idx, col) = portfolio;
+        cash_matrix.coeffRef(idx, col) = cash;
+        quantity_matrix.coeffRef(idx, col) = qty;
+    }
+    void end_chunk(int, int){}
+
+    std::tuple<MatrixXf, MatrixXf, MatrixXf> to_tuple(){
+        return std::make_tuple(std::move(portfolio_values), std::move(cash_matrix), std::move(quantity_matrix));
+    }
+};
+
+// 仅保留最后一行：最终组合价值 / 现金 / 持仓 (n_weights,)，内存 O(W)
+struct FinalOutput {
+    VectorXf final_portfolio;
+    VectorXf final_cash;
+    VectorXf final_quantity;
+
+    int chunk_rows() const { return 0; }
+    void begin(int n_timestamps, int n_weights){
+        last_row_ = n_timestamps - 1;
+        final_portfolio.resize(n_weights);
+        final_cash.resize(n_weights);
+        final_quantity.resize(n_weights);
+    }
+    void begin_chunk(int, int){}
+    void record(int col, int idx, float portfolio, float cash, float qty){
+        if(idx != last_row_) return;
+        final_portfolio(col) = portfolio;
+        final_cash(col) = cash;
+        final_quantity(col) = qty;
+    }
+    void end_chunk(int, int){}
+
+private:
+    int last_row_ = -1;
+};
+
+// 分块回调：每 every_n_rows 行把该行块 (rows×W) 交给回调，内存 O(N·W)
+// 回调参数：行块起始时间步、组合价值块、现金块、持仓块（最后一块可能不足 N 行）
+struct ChunkCallbackOutput {
+    using ChunkCallback = std::function<void(int row_begin,
+                                             const Ref<const MatrixXf>& portfolio_values,
+                                             const Ref<const MatrixXf>& cash_matrix,
+                                             const Ref<const MatrixXf>& quantity_matrix)>;
+
+    ChunkCallbackOutput(int every_n_rows, ChunkCallback callback)
+        : every_n_rows_(every_n_rows > 0 ? every_n_rows : 1), callback_(std::move(callback)) {}
+
+    int chunk_rows() const { return every_n_rows_; }
+    void begin(int n_timestamps, int n_weights){
+        const int rows = std::min(every_n_rows_, std::max(n_timestamps, 1));
+        portfolio_buffer_.resize(rows, n_weights);
+        cash_buffer_.resize(rows, n_weights);
+        quantity_buffer_.resize(rows, n_weights);
+    }
+    void begin_chunk(int row_begin, int){ row_begin_ = row_begin; }
+    void record(int col, int idx, float portfolio, float cash, float qty){
+        const int r = idx - row_begin_;
+        portfolio_buffer_.coeffRef(r, col) = portfolio;
+        cash_buffer_.coeffRef(r, col) = cash;
+        quantity_buffer_.coeffRef(r, col) = qty;
+    }
+    void end_chunk(int row_begin, int row_end){
+        const int rows = row_end - row_begin;
+        if(callback_)
+            callback_(row_begin, portfolio_buffer_.topRows(rows), cash_buffer_.topRows(rows),
+                      quantity_buffer_.topRows(rows));
+    }
+
+private:
+    int every_n_rows_;
+    ChunkCallback callback_;
+    int row_begin_ = 0;
+    MatrixXf portfolio_buffer_;
+    MatrixXf cash_buffer_;
+    MatrixXf quantity_buffer_;
+};
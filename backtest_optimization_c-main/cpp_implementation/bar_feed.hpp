@@ -0,0 +1,126 @@
+#pragma once
+#include <Eigen/Dense>
+#include "streaming_backtest.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace Eigen;
+
+// -------------------- 实盘 K 线驱动增量回测 --------------------
+// 行情桥（ctp_c 的 pyctp_bridge）每收盘一根 bar，就在发布线程调用 ctp_set_bar_cb 注册的回调，交付一条 ctp_bar_t；
+// 开启落盘时 bars_*.bin 也是同样的 128 字节记录首尾相接。BarFeed 只接收指定合约 + 周期的 bar，
+// 以收盘价推进 MultiWeightState：
+//   on_bar          调用方给出本 bar 各权重组合的持仓信号
+//   on_bar_signals  调用方给出本 bar 收盘时的信号行 (n_signals,)，按 signal_processor 的规则
+//                   combined = signals · weights，阈值化为 1 / -1 / 0，并滞后一根 bar 作为持仓
+//                   （第一根 bar 持仓为 0），逐 bar 推进的结果与 run_signal_backtest 跑整段历史一致
+// read_bar_file 读取 bars_*.bin，用于开盘前以当日已落盘的 bar 预热。
+
+// 与 ctp_bar_t / BarRecord 同布局
+struct LiveBar {
+    char      inst[32];
+    long long start_ms;       // 区间起点（交易所时间，epoch ms）
+    int       inst_id, interval_s;
+    double    open, high, low, close, vwap;
+    double    turnover, open_interest, oi_delta;
+    long long volume;
+    int       ticks;
+    unsigned  flags;
+};
+static_assert(sizeof(LiveBar) == 128, "LiveBar 须与 ctp_bar_t 同为 128 字节");
+
+class BarFeed {
+public:
+    // 持仓由调用方给出
+    BarFeed(const std::string& instrument, int interval_s, int n_weights, const BacktestConfig& config,
+            float annualization_factor = DEFAULT_ANNUALIZATION_FACTOR)
+        : instrument_(instrument), interval_s_(interval_s),
+          state_(n_weights, config, annualization_factor) {
+        check_filter();
+    }
+
+    // 持仓由信号行 · 权重矩阵 (n_signals, n_weights) 现算
+    BarFeed(const std::string& instrument, int interval_s, const MatrixXf& weights_matrix, float threshold,
+            const BacktestConfig& config, float annualization_factor = DEFAULT_ANNUALIZATION_FACTOR)
+        : instrument_(instrument), interval_s_(interval_s),
+          state_(int(weights_matrix.cols()), config, annualization_factor),
+          weights_(weights_matrix), threshold_(threshold),
+          pending_(VectorXf::Zero(weights_matrix.cols())) {
+        check_filter();
+        if(weights_matrix.rows() == 0)
+            throw std::invalid_argument("权重矩阵信号数不能为 0");
+    }
+
+    bool matches(const LiveBar& bar) const {
+        return bar.interval_s == interval_s_ &&
+               std::strncmp(bar.inst, instrument_.c_str(), sizeof(bar.inst)) == 0;
+    }
+
+    // 合约 / 周期不符的 bar 忽略并返回 false
+    template <typename Derived>
+    bool on_bar(const LiveBar& bar, const DenseBase<Derived>& positions){
+        if(!matches(bar)) return false;
+        state_.advance(float(bar.close), positions);
+        return true;
+    }
+
+    template <typename Derived>
+    bool on_bar_signals(const LiveBar& bar, const MatrixBase<Derived>& signals){
+        if(weights_.size() == 0)
+            throw std::invalid_argument("未设置权重矩阵，不能按信号推进");
+        if(signals.size() != weights_.rows())
+            throw std::invalid_argument("信号长度 " + std::to_string(signals.size()) +
+                                        " 与权重矩阵信号数 " + std::to_string(weights_.rows()) + " 不一致");
+        if(!matches(bar)) return false;
+        // 本 bar 持仓取上一根 bar 收盘时的组合信号
+        state_.advance(float(bar.close), pending_);
+        pending_.noalias() = weights_.transpose() * signals.derived().template cast<float>();
+        pending_.array() = (pending_.array() > threshold_).template cast<float>()
+                         - (pending_.array() < -threshold_).template cast<float>();
+        return true;
+    }
+
+    void reset(){
+        state_.reset();
+        if(pending_.size()) pending_.setZero();
+    }
+
+    const std::string& instrument() const { return instrument_; }
+    int interval_s() const { return interval_s_; }
+    MultiWeightState& state() { return state_; }
+    const MultiWeightState& state() const { return state_; }
+
+private:
+    void check_filter() const {
+        if(instrument_.empty() || instrument_.size() >= sizeof(LiveBar::inst))
+            throw std::invalid_argument("合约代码为空或过长: " + instrument_);
+        if(interval_s_ <= 0)
+            throw std::invalid_argument("bar 周期必须为正: " + std::to_string(interval_s_));
+    }
+
+    std::string instrument_;
+    int interval_s_;
+    MultiWeightState state_;
+    MatrixXf weights_;       // 为空时只能用 on_bar
+    float threshold_ = 0.0f;
+    VectorXf pending_;       // 下一根 bar 的持仓
+};
+
+// 读取 bars_*.bin（整条记录序列，末尾不完整的记录丢弃）
+inline std::vector<LiveBar> read_bar_file(const std::string& filename){
+    FILE* f = std::fopen(filename.c_str(), "rb");
+    if(!f) throw std::runtime_error("无法打开 bar 文件 " + filename + ": " + std::strerror(errno));
+    std::vector<LiveBar> bars;
+    LiveBar bar;
+    while(std::fread(&bar, sizeof(bar), 1, f) == 1) bars.push_back(bar);
+    const bool failed = std::ferror(f) != 0;
+    std::fclose(f);
+    if(failed) throw std::runtime_error("读取 bar 文件失败: " + filename);
+    return bars;
+}
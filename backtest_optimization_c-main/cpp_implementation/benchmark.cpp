@@ -0,0 +1,254 @@
+// -------------------- 性能基准测试 --------------------
+// Google Benchmark 基准套件：扫描 T (时间步) × W (权重组合) × 交易模式 × 线程数（BM_ColumnBlockedFinal 另扫现金累加精度），
+// 数据由 test_data.hpp 按固定 seed 生成（与 test_cases/generate_test_data.py 相同），结果可复现。
+// 每项报告 weight_steps_per_second（W×T 个回测步 / 秒）和 bytes_per_second（内核读写的矩阵字节 / 秒）。
+//
+// 输出 JSON 供 CI 对比：
+//   ./backtest_bench --benchmark_out=bench.json --benchmark_out_format=json
+//   python ../test_cases/compare_benchmark.py baseline.json bench.json
+#include <benchmark/benchmark.h>
+#include <Eigen/Dense>
+#include <map>
+#include <tuple>
+#include <string>
+#include <filesystem>
+#include <omp.h>
+#include "multi_weight_backtest.hpp"
+#include "column_blocked_backtest.hpp"
+#include "metrics.hpp"
+#include "signal_processor.hpp"
+#include "simd_backtest.hpp"
+#include "optimizer_kernel.hpp"
+#include "streaming_backtest.hpp"
+#include "weight_search.hpp"
+#include "column_store.hpp"
+#include "test_data.hpp"
+
+namespace {
+
+const int BENCH_SEED = 42;
+const int BENCH_SIGNALS = 10;
+
+// 数据规模，取自 performance_benchmark.md 第 2 节（Medium / Large）及其间的中间规模
+const std::vector<std::pair<int, int>> BENCH_SIZES = {
+    {1000, 100}, {1000, 1000}, {1000, 10000}, {5000, 10000},
+};
+
+const TradeMode BENCH_MODES[] = {TradeMode::FIXED, TradeMode::CASH_ALL, TradeMode::PORTFOLIO_PCT, TradeMode::FIXED_CASH};
+
+const char* trade_mode_name(TradeMode mode){
+    switch(mode){
+        case TradeMode::FIXED:         return "fixed";
+        case TradeMode::CASH_ALL:      return "cash_all";
+        case TradeMode::PORTFOLIO_PCT: return "portfolio_pct";
+        case TradeMode::FIXED_CASH:    return "fixed_cash";
+    }
+    return "unknown";
+}
+
+// 同一规模的数据集在所有基准之间共享，只生成一次
+const TestDataset& cached_dataset(int n_timesteps, int n_weights){
+    static std::map<std::pair<int, int>, TestDataset> cache;
+    auto it = cache.find({n_timesteps, n_weights});
+    if(it == cache.end())
+        it = cache.emplace(std::make_pair(n_timesteps, n_weights),
+                           generate_test_dataset(n_timesteps, BENCH_SIGNALS, n_weights, BENCH_SEED)).first;
+    return it->second;
+}
+
+// 线程数：1, 2, 4, ... 直到机器上的处理器数
+std::vector<int64_t> thread_counts(){
+    const int max_threads = std::max(1, omp_get_num_procs());
+    std::vector<int64_t> counts;
+    for(int n=1; n<max_threads; n*=2) counts.push_back(n);
+    counts.push_back(max_threads);
+    return counts;
+}
+
+// 参数: {T, W, 交易模式, 线程数}
+void sweep_all_modes(benchmark::internal::Benchmark* bench){
+    bench->ArgNames({"T", "W", "mode", "threads"});
+    for(const auto& size : BENCH_SIZES)
+        for(TradeMode mode : BENCH_MODES)
+            for(int64_t threads : thread_counts())
+                bench->Args({size.first, size.second, (int64_t)mode, threads});
+}
+
+// 只扫规模和线程数，交易模式固定为 portfolio_pct（generate_test_data.py 生成期望输出所用模式）
+void sweep_default_mode(benchmark::internal::Benchmark* bench){
+    bench->ArgNames({"T", "W", "mode", "threads"});
+    for(const auto& size : BENCH_SIZES)
+        for(int64_t threads : thread_counts())
+            bench->Args({size.first, size.second, (int64_t)TradeMode::PORTFOLIO_PCT, threads});
+}
+
+// 列分块现金精度对比：在 sweep_all_modes 基础上再扫现金累加精度 {float, kahan, double}
+const CashPrecision BENCH_CASH_PRECISIONS[] = {CashPrecision::FLOAT, CashPrecision::KAHAN, CashPrecision::DOUBLE};
+
+void sweep_cash_precision(benchmark::internal::Benchmark* bench){
+    bench->ArgNames({"T", "W", "mode", "threads", "cash"});
+    for(const auto& size : BENCH_SIZES)
+        for(TradeMode mode : BENCH_MODES)
+            for(CashPrecision cash : BENCH_CASH_PRECISIONS)
+                for(int64_t threads : thread_counts())
+                    bench->Args({size.first, size.second, (int64_t)mode, threads, (int64_t)cash});
+}
+
+// 单线程项（增量回测）：扫规模和交易模式，线程数固定为 1
+void sweep_single_thread(benchmark::internal::Benchmark* bench){
+    bench->ArgNames({"T", "W", "mode", "threads"});
+    for(const auto& size : BENCH_SIZES)
+        for(TradeMode mode : BENCH_MODES)
+            bench->Args({size.first, size.second, (int64_t)mode, 1});
+}
+
+// 解析参数、设置线程数；返回本项使用的数据集和配置
+std::tuple<const TestDataset&, BacktestConfig> setup(benchmark::State& state){
+    const TestDataset& data = cached_dataset(state.range(0), state.range(1));
+    BacktestConfig config;
+    config.trade_mode = static_cast<TradeMode>(state.range(2));
+    omp_set_num_threads(state.range(3));
+    state.SetLabel(trade_mode_name(config.trade_mode));
+    return {data, config};
+}
+
+// 吞吐量计数：每次迭代 weight_steps 个回测步（<=0 取 T×W）、bytes_per_iteration 字节
+void report_throughput(benchmark::State& state, int64_t bytes_per_iteration, double weight_steps = 0){
+    if(weight_steps <= 0) weight_steps = double(state.range(0)) * state.range(1);
+    state.counters["weight_steps_per_second"] = benchmark::Counter(weight_steps, benchmark::Counter::kIsIterationInvariantRate);
+    if(bytes_per_iteration > 0) state.SetBytesProcessed(state.iterations() * bytes_per_iteration);
+}
+
+}  // namespace
+
+// 原始并行实现（逐时间步并行），作为对照基线
+static void BM_Parallel2(benchmark::State& state){
+    auto [data, config] = setup(state);
+    for(auto _ : state){
+        auto result = run_multi_weight_vectorized_parallel_2(data.prices, data.position_matrix, config.initial_cash,
+                                                             config.trade_mode, config.max_allocation_pct,
+                                                             config.fixed_cash_amount, config.position_size);
+        benchmark::DoNotOptimize(result);
+    }
+    // 读持仓 + 写三个输出矩阵 + 持仓变化矩阵写读
+    report_throughput(state, int64_t(sizeof(float)) * state.range(0) * state.range(1) * 6);
+}
+BENCHMARK(BM_Parallel2)->Apply(sweep_default_mode)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// 列分块，完整输出三个 T×W 矩阵
+static void BM_ColumnBlockedFull(benchmark::State& state){
+    auto [data, config] = setup(state);
+    for(auto _ : state){
+        FullOutput output;
+        run_multi_weight_column_blocked(data.prices, data.position_matrix, config, output);
+        benchmark::DoNotOptimize(output.portfolio_values.data());
+    }
+    // 读持仓 + 写三个输出矩阵
+    report_throughput(state, int64_t(sizeof(float)) * state.range(0) * state.range(1) * 4);
+}
+BENCHMARK(BM_ColumnBlockedFull)->Apply(sweep_all_modes)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// 列分块，只保留最后一行（内存 O(W)），附加现金累加精度维度
+static void BM_ColumnBlockedFinal(benchmark::State& state){
+    auto [data, config] = setup(state);
+    config.cash_precision = static_cast<CashPrecision>(state.range(4));
+    state.SetLabel(std::string(trade_mode_name(config.trade_mode)) + "/" + cash_precision_name(config.cash_precision));
+    for(auto _ : state){
+        FinalOutput output;
+        run_multi_weight_column_blocked(data.prices, data.position_matrix, config, output);
+        benchmark::DoNotOptimize(output.final_portfolio.data());
+    }
+    report_throughput(state, int64_t(sizeof(float)) * state.range(0) * state.range(1));
+}
+BENCHMARK(BM_ColumnBlockedFinal)->Apply(sweep_cash_precision)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// 显式 SIMD 列分块（运行时选择指令集），只保留最后一行
+static void BM_SimdFinal(benchmark::State& state){
+    auto [data, config] = setup(state);
+    for(auto _ : state){
+        FinalOutput output;
+        run_multi_weight_simd(data.prices, data.position_matrix, config, output);
+        benchmark::DoNotOptimize(output.final_portfolio.data());
+    }
+    report_throughput(state, int64_t(sizeof(float)) * state.range(0) * state.range(1));
+}
+BENCHMARK(BM_SimdFinal)->Apply(sweep_all_modes)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// 优化器核心：信号组合融合流水线 + 融合指标，持仓现算不落内存，只统计回测步吞吐
+static void BM_EvaluateWeightsBatch(benchmark::State& state){
+    auto [data, config] = setup(state);
+    for(auto _ : state){
+        VectorXf sharpe = evaluate_weights_batch(data.weights_matrix, data.signal_matrix, data.prices,
+                                                 DEFAULT_SIGNAL_THRESHOLD, config);
+        benchmark::DoNotOptimize(sharpe.data());
+    }
+    report_throughput(state, 0);
+}
+BENCHMARK(BM_EvaluateWeightsBatch)->Apply(sweep_default_mode)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// 权重搜索（逐轮淘汰，默认 4 轮、每轮保留 1/3）：吞吐量按等效的 T×W 全量回测步计，实际推进比例另报
+static void BM_WeightSearchHalving(benchmark::State& state){
+    auto [data, config] = setup(state);
+    const double full_steps = double(state.range(0)) * state.range(1);
+    double steps = 0.0;
+    for(auto _ : state){
+        SearchResult result = run_weight_search(data.prices, data.signal_matrix, data.weights_matrix,
+                                                DEFAULT_SIGNAL_THRESHOLD, config);
+        steps = double(result.weight_steps);
+        benchmark::DoNotOptimize(result.score.data());
+    }
+    state.counters["evaluated_fraction"] = steps / full_steps;
+    // weight_steps_per_second 按实际推进的步数计，与其他基准同口径；等效于全部跑完的速度另列
+    report_throughput(state, 0, steps);
+    state.counters["equivalent_weight_steps_per_second"] =
+        benchmark::Counter(full_steps, benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_WeightSearchHalving)->Apply(sweep_default_mode)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// 增量回测：逐行 advance 全部 T 行（实盘逐 bar 推进的单步开销 × T），持仓按行主序预先排好
+static void BM_StreamingAdvance(benchmark::State& state){
+    auto [data, config] = setup(state);
+    const Matrix<float, Dynamic, Dynamic, RowMajor> rows = data.position_matrix;
+    MultiWeightState stream(rows.cols(), config);
+    for(auto _ : state){
+        stream.reset();
+        for(Index t=0; t<rows.rows(); ++t) stream.advance(data.prices(t), rows.row(t));
+        benchmark::DoNotOptimize(stream.portfolio().data());
+    }
+    report_throughput(state, int64_t(sizeof(float)) * state.range(0) * state.range(1));
+}
+BENCHMARK(BM_StreamingAdvance)->Apply(sweep_single_thread)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// 列式 bar 库：每次迭代打开目录、定位后半段时间范围、价格用映射视图跑列分块回测（含 mmap / 缺页开销）
+static void BM_ColumnStoreBacktest(benchmark::State& state){
+    auto [data, config] = setup(state);
+    const std::string dir = std::filesystem::temp_directory_path().string() + "/bench_column_store";
+    const Index n = data.prices.size();
+    const Matrix<int64_t, Dynamic, 1> timestamps = Matrix<int64_t, Dynamic, 1>::LinSpaced(n, 0, 60000LL * (n - 1));
+    write_column_store(dir, timestamps, data.prices, Matrix<int64_t, Dynamic, 1>::Ones(n));
+    const MatrixXf positions = data.position_matrix.bottomRows(n - n / 2);
+    for(auto _ : state){
+        ColumnStore store(dir);
+        const auto [row_begin, row_end] = store.range(60000LL * (n / 2), 60000LL * n);
+        FinalOutput output;
+        run_multi_weight_column_blocked(store.prices(row_begin, row_end), positions, config, output);
+        benchmark::DoNotOptimize(output.final_portfolio.data());
+    }
+    std::filesystem::remove_all(dir);
+    const int64_t rows = n - n / 2;  // 只回测后半段
+    report_throughput(state, int64_t(sizeof(float)) * rows * state.range(1), double(rows) * state.range(1));
+}
+BENCHMARK(BM_ColumnStoreBacktest)->Apply(sweep_default_mode)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+int main(int argc, char** argv){
+    benchmark::Initialize(&argc, argv);
+    if(benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::AddCustomContext("seed", std::to_string(BENCH_SEED));
+    benchmark::AddCustomContext("n_signals", std::to_string(BENCH_SIGNALS));
+    benchmark::AddCustomContext("simd_isa", simd_isa_name(detect_simd_isa()));
+    benchmark::AddCustomContext("eigen_version", std::to_string(EIGEN_WORLD_VERSION) + "." +
+                                std::to_string(EIGEN_MAJOR_VERSION) + "." + std::to_string(EIGEN_MINOR_VERSION));
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,553 @@
+// backtest_cpp：Python 扩展模块（pybind11）
+// 输入 NumPy 数组按原始内存布局直接映射为 Eigen Map（F 序 → 列主序，C 序 → 行主序），不整体拷贝；
+// 计算期间释放 GIL；输出矩阵由 C++ 分配，NumPy 数组直接指向该缓冲区，由 capsule 负责释放。
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/eigen.h>
+#include <pybind11/stl.h>
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+
+#include "signal_processor.hpp"
+#include "optimizer_kernel.hpp"
+#include "metrics.hpp"
+#include "streaming_backtest.hpp"
+#include "bar_feed.hpp"
+#include "weight_search.hpp"
+#include "npy_writer.hpp"
+#include "column_store.hpp"
+
+namespace py = pybind11;
+
+template <typename Scalar>
+using RowMajorMatrix = Matrix<Scalar, Dynamic, Dynamic, RowMajor>;
+
+// -------------------- 输出：C++ 缓冲区 → NumPy（零拷贝） --------------------
+template <typename Scalar>
+py::array to_numpy(Matrix<Scalar, Dynamic, Dynamic>&& matrix){
+    using MatrixType = Matrix<Scalar, Dynamic, Dynamic>;
+    MatrixType* owned = new MatrixType(std::move(matrix));
+    py::capsule free_when_done(owned, [](void* p){ delete static_cast<MatrixType*>(p); });
+    const py::ssize_t rows = owned->rows();
+    const py::ssize_t cols = owned->cols();
+    // Eigen 默认列主序，对应 NumPy 的 F 序 strides
+    return py::array_t<Scalar>({rows, cols},
+                               {(py::ssize_t)sizeof(Scalar), (py::ssize_t)sizeof(Scalar) * rows},
+                               owned->data(), free_when_done);
+}
+
+template <typename Scalar>
+py::array to_numpy(Matrix<Scalar, Dynamic, 1>&& vector){
+    using VectorType = Matrix<Scalar, Dynamic, 1>;
+    VectorType* owned = new VectorType(std::move(vector));
+    py::capsule free_when_done(owned, [](void* p){ delete static_cast<VectorType*>(p); });
+    return py::array_t<Scalar>({(py::ssize_t)owned->size()}, owned->data(), free_when_done);
+}
+
+// -------------------- 输入：NumPy → Eigen Map --------------------
+inline void check_ndim(const py::array& array, const char* name){
+    if(array.ndim() != 2)
+        throw std::invalid_argument(std::string(name) + " 必须是二维数组，实际维度: " + std::to_string(array.ndim()));
+}
+
+// float32 矩阵：F 序 / C 序直接映射；dtype 不是 float32 或内存不连续时才转换一次
+template <typename F>
+auto visit_float_matrix(const py::array& input, const char* name, F&& f){
+    check_ndim(input, name);
+    py::array array = py::array_t<float, py::array::forcecast>::ensure(input);
+    if(array && !(array.flags() & (py::array::f_style | py::array::c_style)))
+        array = py::array_t<float, py::array::c_style | py::array::forcecast>::ensure(input);
+    if(!array) throw std::invalid_argument(std::string(name) + " 无法转换为 float32 数组");
+
+    const float* data = static_cast<const float*>(array.data());
+    const Index rows = array.shape(0);
+    const Index cols = array.shape(1);
+    if(array.flags() & py::array::f_style)
+        return f(Map<const MatrixXf>(data, rows, cols));
+    return f(Map<const RowMajorMatrix<float>>(data, rows, cols));
+}
+
+// 持仓矩阵：int8 / int32 / int64 / float32 / float64 按原始 dtype 和 strides 读取，其他 dtype 转换为 float32
+template <typename F>
+auto visit_position_matrix(const py::array& input, F&& f){
+    check_ndim(input, "position_matrix");
+    auto run = [&](const py::array& array, auto tag){
+        using Scalar = decltype(tag);
+        const StridedPositionSource<Scalar> source{
+            static_cast<const Scalar*>(array.data()),
+            (int)array.shape(0),
+            (int)array.shape(1),
+            (Index)(array.strides(0) / (py::ssize_t)sizeof(Scalar)),
+            (Index)(array.strides(1) / (py::ssize_t)sizeof(Scalar))};
+        return f(source);
+    };
+    if(py::isinstance<py::array_t<std::int8_t>>(input)) return run(input, std::int8_t());
+    if(py::isinstance<py::array_t<std::int32_t>>(input)) return run(input, std::int32_t());
+    if(py::isinstance<py::array_t<std::int64_t>>(input)) return run(input, std::int64_t());
+    if(py::isinstance<py::array_t<float>>(input)) return run(input, float());
+    if(py::isinstance<py::array_t<double>>(input)) return run(input, double());
+    py::array converted = py::array_t<float, py::array::c_style | py::array::forcecast>::ensure(input);
+    if(!converted) throw std::invalid_argument("position_matrix 无法转换为数值数组");
+    return run(converted, float());
+}
+
+inline BacktestConfig make_config(
+    float initial_cash,
+    const std::string& trade_mode,
+    float max_allocation_pct,
+    float fixed_cash_amount,
+    float position_size
+){
+    BacktestConfig config;
+    config.initial_cash = initial_cash;
+    config.trade_mode = parse_trade_mode(trade_mode);  // 不支持的模式抛 std::invalid_argument → ValueError
+    config.max_allocation_pct = max_allocation_pct;
+    config.fixed_cash_amount = fixed_cash_amount;
+    config.position_size = position_size;
+    return config;
+}
+
+inline py::tuple full_output_to_numpy(FullOutput& output){
+    return py::make_tuple(to_numpy(std::move(output.portfolio_values)),
+                          to_numpy(std::move(output.cash_matrix)),
+                          to_numpy(std::move(output.quantity_matrix)));
+}
+
+inline py::dict metrics_to_dict(BacktestMetrics& metrics){
+    py::dict result;
+    result["sharpe_ratio"] = to_numpy(std::move(metrics.sharpe_ratio));
+    result["max_drawdown"] = to_numpy(std::move(metrics.max_drawdown));
+    result["total_return"] = to_numpy(std::move(metrics.total_return));
+    result["win_rate"] = to_numpy(std::move(metrics.win_rate));
+    return result;
+}
+
+PYBIND11_MODULE(backtest_cpp, m) {
+    m.doc() = "C++ 加速的回测引擎模块";
+
+    // -------------------- 信号处理 --------------------
+    m.def("process_signals",
+        [](const py::array& signal_matrix, const py::array& weights_matrix, float threshold){
+            return visit_float_matrix(signal_matrix, "signal_matrix", [&](const auto& signals){
+                return visit_float_matrix(weights_matrix, "weights_matrix", [&](const auto& weights){
+                    std::tuple<MatrixXf, Matrix<std::int8_t, Dynamic, Dynamic>, Matrix<std::int8_t, Dynamic, Dynamic>> result;
+                    {
+                        py::gil_scoped_release release;
+                        result = process_signals<std::int8_t>(signals, weights, threshold);
+                    }
+                    return py::make_tuple(to_numpy(std::move(std::get<0>(result))),
+                                          to_numpy(std::move(std::get<1>(result))),
+                                          to_numpy(std::move(std::get<2>(result))));
+                });
+            });
+        },
+        py::arg("signal_matrix"),
+        py::arg("weights_matrix"),
+        py::arg("threshold") = DEFAULT_SIGNAL_THRESHOLD,
+        "处理信号矩阵，返回 (combined_signals, long_short_matrix, position_matrix)"
+    );
+
+    // -------------------- 回测引擎 --------------------
+    m.def("run_backtest",
+        [](const Eigen::Ref<const VectorXf>& prices,
+           const py::array& position_matrix,
+           float initial_cash,
+           const std::string& trade_mode,
+           float max_allocation_pct,
+           float fixed_cash_amount,
+           float position_size){
+            const BacktestConfig config = make_config(initial_cash, trade_mode, max_allocation_pct,
+                                                      fixed_cash_amount, position_size);
+            return visit_position_matrix(position_matrix, [&](const auto& source){
+                FullOutput output;
+                {
+                    py::gil_scoped_release release;
+                    run_column_blocked_source(prices, source, config, output);
+                }
+                return full_output_to_numpy(output);
+            });
+        },
+        py::arg("prices"),
+        py::arg("position_matrix"),
+        py::arg("initial_cash") = 1000000.0f,
+        py::arg("trade_mode") = "portfolio_pct",
+        py::arg("max_allocation_pct") = 0.5f,
+        py::arg("fixed_cash_amount") = 100000.0f,
+        py::arg("position_size") = 100.0f,
+        "运行多权重回测，返回 (portfolio_values, cash_matrix, quantity_matrix)"
+    );
+
+    m.def("run_backtest_to_npy",
+        [](const Eigen::Ref<const VectorXf>& prices,
+           const py::array& position_matrix,
+           const std::string& path_prefix,
+           int chunk_rows,
+           float initial_cash,
+           const std::string& trade_mode,
+           float max_allocation_pct,
+           float fixed_cash_amount,
+           float position_size){
+            const BacktestConfig config = make_config(initial_cash, trade_mode, max_allocation_pct,
+                                                      fixed_cash_amount, position_size);
+            visit_position_matrix(position_matrix, [&](const auto& source){
+                py::gil_scoped_release release;
+                NpyOutput output(path_prefix, chunk_rows);
+                run_column_blocked_source(prices, source, config, output);
+            });
+            return py::make_tuple(path_prefix + "portfolio_values.npy", path_prefix + "cash_matrix.npy",
+                                  path_prefix + "quantity_matrix.npy");
+        },
+        py::arg("prices"),
+        py::arg("position_matrix"),
+        py::arg("path_prefix"),
+        py::arg("chunk_rows") = DEFAULT_NPY_CHUNK_ROWS,
+        py::arg("initial_cash") = 1000000.0f,
+        py::arg("trade_mode") = "portfolio_pct",
+        py::arg("max_allocation_pct") = 0.5f,
+        py::arg("fixed_cash_amount") = 100000.0f,
+        py::arg("position_size") = 100.0f,
+        "运行多权重回测，结果流式写入 {path_prefix}portfolio_values.npy 等三个文件（不在内存中保留完整矩阵），"
+        "返回三个文件路径；用 np.load(path, mmap_mode='r') 读取"
+    );
+
+    m.def("write_column_store",
+        [](const std::string& dir,
+           const Eigen::Ref<const VectorXi64>& timestamps,
+           const Eigen::Ref<const VectorXf>& prices,
+           const Eigen::Ref<const VectorXi64>& volumes,
+           int chunk_rows){
+            py::gil_scoped_release release;
+            write_column_store(dir, timestamps, prices, volumes, chunk_rows);
+        },
+        py::arg("dir"),
+        py::arg("timestamps"),
+        py::arg("prices"),
+        py::arg("volumes"),
+        py::arg("chunk_rows") = DEFAULT_COLUMN_STORE_CHUNK_ROWS,
+        "把 int64 时间戳（epoch 毫秒）/ float32 价格 / int64 成交量写成列式 bar 库目录（与行情桥写出的格式一致）"
+    );
+
+    m.def("column_store_range",
+        [](const std::string& dir, int begin_yyyymmdd, int end_yyyymmdd, int utc_offset_hours){
+            const ColumnStore store(dir);
+            const auto [row_begin, row_end] = store.date_range(begin_yyyymmdd, end_yyyymmdd, utc_offset_hours);
+            return py::make_tuple(row_begin, row_end);
+        },
+        py::arg("dir"),
+        py::arg("begin_yyyymmdd"),
+        py::arg("end_yyyymmdd"),
+        py::arg("utc_offset_hours") = 8,
+        "列式 bar 库中交易日 [begin, end]（含结束日，夜盘归下一交易日）的行区间 (row_begin, row_end)；"
+        "价格用 np.load(dir + '/price.npy', mmap_mode='r')[row_begin:row_end] 零拷贝取出后传给 run_backtest"
+    );
+
+    m.def("run_signal_backtest",
+        [](const Eigen::Ref<const VectorXf>& prices,
+           const py::array& signal_matrix,
+           const py::array& weights_matrix,
+           float threshold,
+           float initial_cash,
+           const std::string& trade_mode,
+           float max_allocation_pct,
+           float fixed_cash_amount,
+           float position_size){
+            const BacktestConfig config = make_config(initial_cash, trade_mode, max_allocation_pct,
+                                                      fixed_cash_amount, position_size);
+            return visit_float_matrix(signal_matrix, "signal_matrix", [&](const auto& signals){
+                return visit_float_matrix(weights_matrix, "weights_matrix", [&](const auto& weights){
+                    FullOutput output;
+                    {
+                        py::gil_scoped_release release;
+                        run_signal_backtest(prices, signals, weights, threshold, config, output);
+                    }
+                    return full_output_to_numpy(output);
+                });
+            });
+        },
+        py::arg("prices"),
+        py::arg("signal_matrix"),
+        py::arg("weights_matrix"),
+        py::arg("threshold") = DEFAULT_SIGNAL_THRESHOLD,
+        py::arg("initial_cash") = 1000000.0f,
+        py::arg("trade_mode") = "portfolio_pct",
+        py::arg("max_allocation_pct") = 0.5f,
+        py::arg("fixed_cash_amount") = 100000.0f,
+        py::arg("position_size") = 100.0f,
+        "信号组合 → 回测融合流水线（不物化持仓矩阵），返回 (portfolio_values, cash_matrix, quantity_matrix)"
+    );
+
+    // -------------------- 性能指标 --------------------
+    m.def("calculate_sharpe_ratio",
+        [](const py::array& portfolio_values, float annualization_factor){
+            return visit_float_matrix(portfolio_values, "portfolio_values", [&](const auto& values){
+                BacktestMetrics metrics;
+                {
+                    py::gil_scoped_release release;
+                    metrics = calculate_all_metrics(values, annualization_factor);
+                }
+                return to_numpy(std::move(metrics.sharpe_ratio));
+            });
+        },
+        py::arg("portfolio_values"),
+        py::arg("annualization_factor") = DEFAULT_ANNUALIZATION_FACTOR,
+        "计算夏普比率"
+    );
+
+    m.def("calculate_max_drawdown",
+        [](const py::array& portfolio_values){
+            return visit_float_matrix(portfolio_values, "portfolio_values", [&](const auto& values){
+                BacktestMetrics metrics;
+                {
+                    py::gil_scoped_release release;
+                    metrics = calculate_all_metrics(values);
+                }
+                return to_numpy(std::move(metrics.max_drawdown));
+            });
+        },
+        py::arg("portfolio_values"),
+        "计算最大回撤"
+    );
+
+    m.def("calculate_all_metrics",
+        [](const py::array& portfolio_values, float annualization_factor){
+            return visit_float_matrix(portfolio_values, "portfolio_values", [&](const auto& values){
+                BacktestMetrics metrics;
+                {
+                    py::gil_scoped_release release;
+                    metrics = calculate_all_metrics(values, annualization_factor);
+                }
+                return metrics_to_dict(metrics);
+            });
+        },
+        py::arg("portfolio_values"),
+        py::arg("annualization_factor") = DEFAULT_ANNUALIZATION_FACTOR,
+        "单遍计算夏普比率 / 最大回撤 / 总收益 / 胜率"
+    );
+
+    // -------------------- 优化器核心 --------------------
+    m.def("evaluate_weights_batch",
+        [](const py::array& weights_batch,
+           const py::array& signal_matrix,
+           const Eigen::Ref<const VectorXf>& prices,
+           float threshold,
+           float initial_cash,
+           const std::string& trade_mode,
+           float max_allocation_pct,
+           float fixed_cash_amount){
+            const BacktestConfig config = make_config(initial_cash, trade_mode, max_allocation_pct,
+                                                      fixed_cash_amount, BacktestConfig().position_size);
+            return visit_float_matrix(weights_batch, "weights_batch", [&](const auto& weights){
+                return visit_float_matrix(signal_matrix, "signal_matrix", [&](const auto& signals){
+                    VectorXf scores;
+                    {
+                        py::gil_scoped_release release;
+                        scores = evaluate_weights_batch(weights, signals, prices, threshold, config);
+                    }
+                    return to_numpy(std::move(scores));
+                });
+            });
+        },
+        py::arg("weights_batch"),
+        py::arg("signal_matrix"),
+        py::arg("prices"),
+        py::arg("threshold") = DEFAULT_SIGNAL_THRESHOLD,
+        py::arg("initial_cash") = 1000000.0f,
+        py::arg("trade_mode") = "portfolio_pct",
+        py::arg("max_allocation_pct") = 0.5f,
+        py::arg("fixed_cash_amount") = 100000.0f,
+        "批量评估权重组合，返回夏普比率 (n_candidates,)"
+    );
+
+    // -------------------- 权重搜索 --------------------
+    m.def("grid_candidates",
+        [](int n_signals, const std::vector<float>& levels){
+            return to_numpy(make_grid_candidates(n_signals, levels));
+        },
+        py::arg("n_signals"),
+        py::arg("levels"),
+        "网格候选 (n_signals, len(levels)**n_signals)"
+    );
+
+    m.def("random_candidates",
+        [](int n_signals, int n_candidates, uint32_t seed, float low, float high){
+            return to_numpy(make_random_candidates(n_signals, n_candidates, seed, low, high));
+        },
+        py::arg("n_signals"),
+        py::arg("n_candidates"),
+        py::arg("seed") = 42,
+        py::arg("low") = -1.0f,
+        py::arg("high") = 1.0f,
+        "随机候选 (n_signals, n_candidates)，权重均匀分布于 [low, high)"
+    );
+
+    m.def("search_weights",
+        [](const py::array& candidates,
+           const py::array& signal_matrix,
+           const Eigen::Ref<const VectorXf>& prices,
+           float threshold,
+           const std::string& metric,
+           int n_rungs,
+           float keep_fraction,
+           int min_survivors,
+           float initial_cash,
+           const std::string& trade_mode,
+           float max_allocation_pct,
+           float fixed_cash_amount,
+           float annualization_factor){
+            const BacktestConfig config = make_config(initial_cash, trade_mode, max_allocation_pct,
+                                                      fixed_cash_amount, BacktestConfig().position_size);
+            SearchConfig search;
+            search.metric = parse_search_metric(metric);
+            search.n_rungs = n_rungs;
+            search.keep_fraction = keep_fraction;
+            search.min_survivors = min_survivors;
+            return visit_float_matrix(candidates, "candidates", [&](const auto& weights){
+                const MatrixXf weights_matrix = weights;  // 候选很小（S × N），引擎内部本就复制一份再逐轮压紧
+                return visit_float_matrix(signal_matrix, "signal_matrix", [&](const auto& signals){
+                    SearchResult result;
+                    {
+                        py::gil_scoped_release release;
+                        result = run_weight_search(prices, signals, weights_matrix, threshold, config, search,
+                                                   annualization_factor);
+                    }
+                    py::dict out = metrics_to_dict(result.metrics);
+                    out["candidate_index"] = to_numpy(std::move(result.candidate_index));
+                    out["score"] = to_numpy(std::move(result.score));
+                    out["rung_rows"] = result.rung_rows;
+                    out["rung_candidates"] = result.rung_candidates;
+                    out["weight_steps"] = result.weight_steps;
+                    return out;
+                });
+            });
+        },
+        py::arg("candidates"),
+        py::arg("signal_matrix"),
+        py::arg("prices"),
+        py::arg("threshold") = DEFAULT_SIGNAL_THRESHOLD,
+        py::arg("metric") = "sharpe",
+        py::arg("n_rungs") = SearchConfig().n_rungs,
+        py::arg("keep_fraction") = SearchConfig().keep_fraction,
+        py::arg("min_survivors") = SearchConfig().min_survivors,
+        py::arg("initial_cash") = 1000000.0f,
+        py::arg("trade_mode") = "portfolio_pct",
+        py::arg("max_allocation_pct") = 0.5f,
+        py::arg("fixed_cash_amount") = 100000.0f,
+        py::arg("annualization_factor") = DEFAULT_ANNUALIZATION_FACTOR,
+        "逐轮淘汰权重搜索（n_rungs=1 为全部跑完），返回幸存者按得分排序的 candidate_index / score / 指标"
+    );
+
+    // -------------------- 增量回测（实盘逐 bar 推进） --------------------
+    py::class_<MultiWeightState>(m, "MultiWeightState",
+        "常驻每个权重组合的现金 / 持仓 / 指标累加器，每根 bar 调用 advance 推进一步")
+        .def(py::init([](int n_weights,
+                         float initial_cash,
+                         const std::string& trade_mode,
+                         float max_allocation_pct,
+                         float fixed_cash_amount,
+                         float position_size,
+                         float annualization_factor){
+                return MultiWeightState(n_weights,
+                                        make_config(initial_cash, trade_mode, max_allocation_pct,
+                                                    fixed_cash_amount, position_size),
+                                        annualization_factor);
+            }),
+            py::arg("n_weights"),
+            py::arg("initial_cash") = 1000000.0f,
+            py::arg("trade_mode") = "portfolio_pct",
+            py::arg("max_allocation_pct") = 0.5f,
+            py::arg("fixed_cash_amount") = 100000.0f,
+            py::arg("position_size") = 100.0f,
+            py::arg("annualization_factor") = DEFAULT_ANNUALIZATION_FACTOR)
+        .def("advance",
+            [](MultiWeightState& state, float price, const Eigen::Ref<const VectorXf>& positions){
+                state.advance(price, positions);
+            },
+            py::arg("price"),
+            py::arg("positions"),
+            "推进一根 bar：price 为价格，positions 为各权重组合的持仓信号 (n_weights,)")
+        .def("advance_rows",
+            [](MultiWeightState& state, const Eigen::Ref<const VectorXf>& prices, const py::array& position_matrix){
+                visit_float_matrix(position_matrix, "position_matrix", [&](const auto& positions){
+                    py::gil_scoped_release release;
+                    state.advance_rows(prices, positions);
+                });
+            },
+            py::arg("prices"),
+            py::arg("position_matrix"),
+            "逐行推进一段历史（如用当日已有 bar 预热），position_matrix (rows, n_weights)")
+        .def("reset", &MultiWeightState::reset, "回到初始状态")
+        .def("portfolio", [](const MultiWeightState& state){ return to_numpy(VectorXf(state.portfolio())); })
+        .def("cash", [](const MultiWeightState& state){ return to_numpy(VectorXf(state.cash())); })
+        .def("quantity", [](const MultiWeightState& state){ return to_numpy(VectorXf(state.quantity())); })
+        .def("metrics",
+            [](const MultiWeightState& state){
+                BacktestMetrics metrics = state.metrics();
+                return metrics_to_dict(metrics);
+            },
+            "截至当前 bar 的夏普比率 / 最大回撤 / 总收益 / 胜率")
+        .def_property_readonly("n_weights", &MultiWeightState::n_weights)
+        .def_property_readonly("n_steps", &MultiWeightState::n_steps);
+
+    // -------------------- 实盘 K 线驱动（行情桥 ctp_set_bar_cb 回调的 ctp_bar_t） --------------------
+    auto live_bar = [](std::uintptr_t address) -> const LiveBar& {
+        if(address == 0) throw std::invalid_argument("bar 地址为空");
+        return *reinterpret_cast<const LiveBar*>(address);
+    };
+    py::class_<BarFeed>(m, "BarFeed",
+        "只接收指定合约 + 周期的收盘 bar，以收盘价推进 MultiWeightState；bar 以 ctp_bar_t 地址（ctypes）传入")
+        .def(py::init([](const std::string& instrument, int interval_s, int n_weights,
+                         float initial_cash, const std::string& trade_mode, float max_allocation_pct,
+                         float fixed_cash_amount, float position_size, float annualization_factor){
+                return BarFeed(instrument, interval_s, n_weights,
+                               make_config(initial_cash, trade_mode, max_allocation_pct,
+                                           fixed_cash_amount, position_size),
+                               annualization_factor);
+            }),
+            py::arg("instrument"),
+            py::arg("interval_s"),
+            py::arg("n_weights"),
+            py::arg("initial_cash") = 1000000.0f,
+            py::arg("trade_mode") = "portfolio_pct",
+            py::arg("max_allocation_pct") = 0.5f,
+            py::arg("fixed_cash_amount") = 100000.0f,
+            py::arg("position_size") = 100.0f,
+            py::arg("annualization_factor") = DEFAULT_ANNUALIZATION_FACTOR)
+        .def(py::init([](const std::string& instrument, int interval_s, const MatrixXf& weights_matrix, float threshold,
+                         float initial_cash, const std::string& trade_mode, float max_allocation_pct,
+                         float fixed_cash_amount, float position_size, float annualization_factor){
+                return BarFeed(instrument, interval_s, weights_matrix, threshold,
+                               make_config(initial_cash, trade_mode, max_allocation_pct,
+                                           fixed_cash_amount, position_size),
+                               annualization_factor);
+            }),
+            py::arg("instrument"),
+            py::arg("interval_s"),
+            py::arg("weights_matrix"),
+            py::arg("threshold") = DEFAULT_SIGNAL_THRESHOLD,
+            py::arg("initial_cash") = 1000000.0f,
+            py::arg("trade_mode") = "portfolio_pct",
+            py::arg("max_allocation_pct") = 0.5f,
+            py::arg("fixed_cash_amount") = 100000.0f,
+            py::arg("position_size") = 100.0f,
+            py::arg("annualization_factor") = DEFAULT_ANNUALIZATION_FACTOR)
+        .def("on_bar",
+            [live_bar](BarFeed& feed, std::uintptr_t address, const Eigen::Ref<const VectorXf>& positions){
+                return feed.on_bar(live_bar(address), positions);
+            },
+            py::arg("bar_address"),
+            py::arg("positions"),
+            "按给定持仓推进一根 bar，合约 / 周期不符返回 False")
+        .def("on_bar_signals",
+            [live_bar](BarFeed& feed, std::uintptr_t address, const Eigen::Ref<const VectorXf>& signals){
+                return feed.on_bar_signals(live_bar(address), signals);
+            },
+            py::arg("bar_address"),
+            py::arg("signals"),
+            "按本 bar 收盘时的信号行 (n_signals,) 推进：持仓取上一根 bar 的组合信号，合约 / 周期不符返回 False")
+        .def("reset", &BarFeed::reset, "回到初始状态")
+        .def_property_readonly("state", py::overload_cast<>(&BarFeed::state), py::return_value_policy::reference_internal)
+        .def_property_readonly("instrument", &BarFeed::instrument)
+        .def_property_readonly("interval_s", &BarFeed::interval_s);
+}
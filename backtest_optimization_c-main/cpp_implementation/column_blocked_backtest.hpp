@@ -0,0 +1,349 @@
+#pragma once
+#include "multi_weight_backtest.hpp"
+#include "backtest_output.hpp"
+
+#include <stdexcept>
+#include <vector>
+#include <algorithm>
+#include <omp.h>
+
+// -------------------- 列分块（权重主序）回测引擎 --------------------
+// 各权重列之间完全独立：每个线程领取一段连续的权重列，独立跑完整条时间序列。
+// MatrixXf 为列主序，单列在内存中连续；单列状态 (cash, qty, prev_pos) 常驻寄存器，
+// 整个回测只有一次 fork/join，而不是每个时间步一次。
+// 输出由输出策略（backtest_output.hpp）决定：完整矩阵、仅最后一行或每 N 行回调。
+
+const int DEFAULT_COLUMN_BLOCK = 64;         // 每个任务块包含的权重列数上限
+const int DEFAULT_POSITION_TILE_ROWS = 256;  // 需要转换的持仓来源每次读取的时间步数
+
+// 实际列块大小：不超过 column_block（<=0 取默认），且保证每个线程至少有约 4 块可领；
+// 固定 64 列时 W=1000 只有 16 块，线程多于块数时多余线程空转
+inline int resolve_column_block(int column_block, int n_weights, int align = 1){
+    const int upper = column_block > 0 ? column_block : DEFAULT_COLUMN_BLOCK;
+    const int tasks = omp_get_max_threads() * 4;
+    int block = std::max(1, std::min(upper, (n_weights + tasks - 1) / tasks));
+    if(align > 1) block = (block + align - 1) / align * align;
+    return block;
+}
+
+// -------------------- 现金累加器 --------------------
+// 每列现金状态的存储与累加方式，对应 BacktestConfig::cash_precision：
+//   Scalar  value() const                 参与买入数量 / 组合价值计算的现金值
+//   void    add_product(Scalar a, Scalar b) 现金增加 a * b（买入为 -qty * price，卖出为 qty * price）
+struct FloatCash {
+    using Scalar = float;
+    float sum;
+
+    Scalar value() const { return sum; }
+    void add_product(Scalar a, Scalar b){ sum += a * b; }
+};
+
+// 补偿累加：仍用 float 存储，乘积的舍入误差（FMA 精确求出）与加法的舍入误差（Neumaier）单独累计
+struct KahanCash {
+    using Scalar = float;
+    float sum;
+    float compensation = 0.0f;
+
+    Scalar value() const { return sum + compensation; }
+    void add_product(Scalar a, Scalar b){
+        const float product = a * b;
+        const float product_error = std::fma(a, b, -product);
+        const float total = sum + product;
+        if(std::abs(sum) >= std::abs(product)) compensation += (sum - total) + product;
+        else compensation += (product - total) + sum;
+        compensation += product_error;
+        sum = total;
+    }
+};
+
+struct DoubleCash {
+    using Scalar = double;
+    double sum;
+
+    Scalar value() const { return sum; }
+    void add_product(Scalar a, Scalar b){ sum += a * b; }
+};
+
+// 运行期精度 -> 现金累加器类型，f 以对应累加器的一个实例（仅作类型标签）调用
+template <typename F>
+inline decltype(auto) dispatch_cash_precision(CashPrecision cash_precision, F&& f){
+    switch(cash_precision){
+        case CashPrecision::KAHAN:
+            return f(KahanCash{0.0f});
+        case CashPrecision::DOUBLE:
+            return f(DoubleCash{0.0});
+        case CashPrecision::FLOAT:
+        default:
+            return f(FloatCash{0.0f});
+    }
+}
+
+// 单列单步：逻辑与 run_multi_weight_vectorized 的逐列计算一致
+template <TradeMode Mode, typename Cash = FloatCash>
+inline void step_single_column(
+    float price,
+    float pos_change,
+    Cash& cash,
+    float& qty,
+    const BacktestConfig& config
+){
+    using Scalar = typename Cash::Scalar;
+    // ----------------- 买入 -----------------
+    if(pos_change > 0){
+        const Scalar cash_value = cash.value();
+        Scalar buy_qty = calc_buy_qty<Mode, Scalar>(cash_value, qty, price, config.max_allocation_pct,
+                                                    config.fixed_cash_amount, config.position_size);
+        buy_qty = std::min(buy_qty, std::floor(cash_value / price));
+        cash.add_product(-buy_qty, price);
+        qty += buy_qty;
+    }
+    // ----------------- 卖出 -----------------
+    else if(pos_change < 0){
+        cash.add_product(qty, price);
+        qty = 0.0f;
+    }
+}
+
+// -------------------- 持仓信号来源 --------------------
+// 引擎按 (行块, 列块) 的小块读取持仓信号，来源需实现：
+//   struct TileBuffer                                  线程私有的暂存区（每线程一个，跨块复用）
+//   int n_timestamps() const / int n_weights() const
+//   int tile_rows() const                              每次取块的行数，<=0 表示整个行块一次取完
+//   PositionTile tile(int row_begin, int row_end, int col_begin, int col_end, TileBuffer&) const
+
+// 持仓信号块视图：块内第 j 列第 i 行位于 data[j * col_stride + i]
+struct PositionTile {
+    const float* data;
+    Index col_stride;
+};
+
+// 直接读取已物化的持仓矩阵（零拷贝）
+struct MatrixPositionSource {
+    const MatrixXf& position_matrix;
+
+    struct TileBuffer {};
+    int n_timestamps() const { return position_matrix.rows(); }
+    int n_weights() const { return position_matrix.cols(); }
+    int tile_rows() const { return 0; }
+    PositionTile tile(int row_begin, int, int col_begin, int, TileBuffer&) const {
+        return PositionTile{position_matrix.data() + (Index)col_begin * position_matrix.rows() + row_begin,
+                            position_matrix.rows()};
+    }
+};
+
+// 按任意步长读取外部内存中的持仓矩阵（如 NumPy 的 C/F 序、int8/int32/float 数组），不整体拷贝：
+// 每次把一个 (tile_rows × 列块) 小块转换为列主序 float，放在线程私有缓冲区内
+template <typename Scalar>
+struct StridedPositionSource {
+    const Scalar* data;
+    int rows;
+    int cols;
+    Index row_stride;  // 相邻时间步的元素间距
+    Index col_stride;  // 相邻权重列的元素间距
+    int rows_per_tile = DEFAULT_POSITION_TILE_ROWS;
+
+    struct TileBuffer {
+        MatrixXf positions;
+    };
+    int n_timestamps() const { return rows; }
+    int n_weights() const { return cols; }
+    int tile_rows() const { return rows_per_tile; }
+
+    PositionTile tile(int row_begin, int row_end, int col_begin, int col_end, TileBuffer& buffer) const {
+        const int tile_rows = row_end - row_begin;
+        const int tile_cols = col_end - col_begin;
+        if(buffer.positions.rows() < tile_rows || buffer.positions.cols() < tile_cols)
+            buffer.positions.resize(std::max<Index>(tile_rows, buffer.positions.rows()),
+                                    std::max<Index>(tile_cols, buffer.positions.cols()));
+
+        const Index ld = buffer.positions.rows();
+        float* out = buffer.positions.data();
+        const Scalar* in = data + row_begin * row_stride + col_begin * col_stride;
+        // 按源数据的连续方向遍历
+        if(col_stride <= row_stride){
+            for(int r=0; r<tile_rows; ++r)
+                for(int c=0; c<tile_cols; ++c)
+                    out[c * ld + r] = static_cast<float>(in[r * row_stride + c * col_stride]);
+        } else {
+            for(int c=0; c<tile_cols; ++c)
+                for(int r=0; r<tile_rows; ++r)
+                    out[c * ld + r] = static_cast<float>(in[r * row_stride + c * col_stride]);
+        }
+        return PositionTile{out, ld};
+    }
+};
+
+// 推进一个列块 [col_begin, col_end) 的 [row_begin, row_end) 时间步
+// 状态数组只覆盖该列块：第 col 列的状态位于 cash[col - col_begin]
+template <TradeMode Mode, typename Cash, typename Source, typename Output>
+inline void advance_column_block(
+    const float* price_data,
+    const Source& source,
+    typename Source::TileBuffer& buffer,
+    const BacktestConfig& config,
+    Output& output,
+    int col_begin,
+    int col_end,
+    int row_begin,
+    int row_end,
+    int tile,
+    Cash* cash_state,
+    float* qty_state,
+    float* prev_pos_state
+){
+    using Scalar = typename Cash::Scalar;
+    for(int tile_begin=row_begin; tile_begin<row_end; tile_begin+=tile){
+        const int tile_end = std::min(tile_begin + tile, row_end);
+        const PositionTile positions = source.tile(tile_begin, tile_end, col_begin, col_end, buffer);
+
+        for(int col=col_begin; col<col_end; ++col){
+            // 以 tile_begin 为原点索引，positions_col[idx] 即第 idx 个时间步
+            const float* positions_col = positions.data + (col - col_begin) * positions.col_stride - tile_begin;
+            Cash cash = cash_state[col - col_begin];
+            float qty = qty_state[col - col_begin];
+            float prev_pos = prev_pos_state[col - col_begin];
+
+            int idx = tile_begin;
+            if(idx == 0){
+                prev_pos = positions_col[0];
+                output.record(col, 0, config.initial_cash, config.initial_cash, 0.0f);
+                idx = 1;
+            }
+            for(; idx<tile_end; ++idx){
+                const float price = price_data[idx];
+                const float pos = positions_col[idx];
+                step_single_column<Mode>(price, pos - prev_pos, cash, qty, config);
+                prev_pos = pos;
+                const Scalar cash_value = cash.value();
+                output.record(col, idx, (float)(cash_value + qty * Scalar(price)), (float)cash_value, qty);
+            }
+
+            cash_state[col - col_begin] = cash;
+            qty_state[col - col_begin] = qty;
+            prev_pos_state[col - col_begin] = prev_pos;
+        }
+    }
+}
+
+// 引擎主体：逐行块推进，每个行块内各线程处理各自的连续列段
+// 跨行块只保留每列的 (cash, qty, prev_pos)，状态内存 O(W)；输出内存由 Output 决定
+template <TradeMode Mode, typename Cash, typename Source, typename Output>
+inline void run_column_blocked_engine(
+    const Ref<const VectorXf>& prices,
+    const Source& source,
+    const BacktestConfig& config,
+    Output& output,
+    int column_block
+){
+    const int n_timestamps = prices.size();
+    const int n_weights = source.n_weights();
+    output.begin(n_timestamps, n_weights);
+    if(n_timestamps == 0 || n_weights == 0) return;
+
+    const int block = resolve_column_block(column_block, n_weights);
+    const int n_blocks = (n_weights + block - 1) / block;
+    const int chunk = output.chunk_rows() > 0 ? output.chunk_rows() : n_timestamps;
+
+    std::vector<Cash> cash_state(n_weights, Cash{config.initial_cash});
+    std::vector<float> qty_state(n_weights, 0.0f);
+    std::vector<float> prev_pos_state(n_weights);
+    const float* price_data = prices.data();
+
+    // 整个回测只创建一次线程组；行块之间由 omp single 串行执行输出回调
+    #pragma omp parallel
+    {
+        typename Source::TileBuffer buffer;
+
+        for(int row_begin=0; row_begin<n_timestamps; row_begin+=chunk){
+            const int row_end = std::min(row_begin + chunk, n_timestamps);
+            const int tile = source.tile_rows() > 0 ? source.tile_rows() : row_end - row_begin;
+
+            #pragma omp single
+            output.begin_chunk(row_begin, row_end);
+
+            // schedule(static) 不指定 chunk：每个线程拿到一段连续的列块
+            #pragma omp for schedule(static)
+            for(int b=0; b<n_blocks; ++b){
+                const int col_begin = b * block;
+                const int col_end = std::min(col_begin + block, n_weights);
+                advance_column_block<Mode, Cash>(price_data, source, buffer, config, output, col_begin, col_end,
+                                           row_begin, row_end, tile, cash_state.data() + col_begin,
+                                           qty_state.data() + col_begin, prev_pos_state.data() + col_begin);
+            }
+
+            #pragma omp single
+            output.end_chunk(row_begin, row_end);
+        }
+    }
+}
+
+// 任意持仓来源的列分块回测：按 config.trade_mode 分派到编译期特化的引擎
+template <typename Source, typename Output>
+inline void run_column_blocked_source(
+    const Ref<const VectorXf>& prices,
+    const Source& source,
+    const BacktestConfig& config,
+    Output& output,
+    int column_block = DEFAULT_COLUMN_BLOCK
+){
+    if(source.n_timestamps() != prices.size())
+        throw std::invalid_argument("持仓矩阵时间步数与价格序列长度不匹配");
+
+    dispatch_trade_mode(config.trade_mode, [&](auto mode){
+        dispatch_cash_precision(config.cash_precision, [&](auto cash){
+            run_column_blocked_engine<decltype(mode)::value, decltype(cash)>(prices, source, config, output, column_block);
+        });
+    });
+}
+
+// 列分块多权重回测（输出策略版本）：output 为 FullOutput / FinalOutput / ChunkCallbackOutput 等
+template <typename Output>
+inline void run_multi_weight_column_blocked(
+    const Ref<const VectorXf>& prices,
+    const MatrixXf& position_matrix,
+    const BacktestConfig& config,
+    Output& output,
+    int column_block = DEFAULT_COLUMN_BLOCK
+){
+    run_column_blocked_source(prices, MatrixPositionSource{position_matrix}, config, output, column_block);
+}
+
+// 列分块多权重回测（枚举版本，返回完整矩阵）
+inline std::tuple<MatrixXf, MatrixXf, MatrixXf>
+run_multi_weight_column_blocked(
+    const Ref<const VectorXf>& prices,
+    const MatrixXf& position_matrix,
+    float initial_cash,
+    TradeMode trade_mode,
+    float max_allocation_pct = 0.5,
+    float fixed_cash_amount = 100000.0,
+    float position_size = 100.0,
+    int column_block = DEFAULT_COLUMN_BLOCK
+){
+    BacktestConfig config;
+    config.initial_cash = initial_cash;
+    config.trade_mode = trade_mode;
+    config.max_allocation_pct = max_allocation_pct;
+    config.fixed_cash_amount = fixed_cash_amount;
+    config.position_size = position_size;
+
+    FullOutput output;
+    run_multi_weight_column_blocked(prices, position_matrix, config, output, column_block);
+    return output.to_tuple();
+}
+
+// 列分块多权重回测（字符串版本，与其他内核参数保持一致）
+inline std::tuple<MatrixXf, MatrixXf, MatrixXf>
+run_multi_weight_column_blocked(
+    const Ref<const VectorXf>& prices,
+    const MatrixXf& position_matrix,
+    float initial_cash = 1000000.0,
+    std::string trade_mode = "portfolio_pct",
+    float max_allocation_pct = 0.5,
+    float fixed_cash_amount = 100000.0,
+    float position_size = 100.0,
+    int column_block = DEFAULT_COLUMN_BLOCK
+){
+    return run_multi_weight_column_blocked(prices, position_matrix, initial_cash, parse_trade_mode(trade_mode),
+                                           max_allocation_pct, fixed_cash_amount, position_size, column_block);
+}
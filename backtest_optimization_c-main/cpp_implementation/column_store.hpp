@@ -0,0 +1,312 @@
+#pragma once
+#include <Eigen/Dense>
+#include "npy_writer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace Eigen;
+
+// -------------------- 列式 bar 库（文件映射，按时间范围零拷贝回测） --------------------
+// 与 ctp_c 行情桥 column_store.h 写出的格式一致，每个序列一个目录 {root}/{1s|1m|1h}/{inst}/：
+//   timestamp.npy  <i8 (rows,)   区间起点 epoch 毫秒，非递减
+//   price.npy      <f4 (rows,)   收盘价
+//   volume.npy     <i8 (rows,)   区间成交量
+//   chunks.npy     <f8 (n_chunks, 7)  每块 first_row, rows, ts_min, ts_max, price_min, price_max, volume_sum
+// 头部固定 128 字节，写入端先写数据再改头部行数；读取端取三列行数的最小值，未写完的尾部不可见。
+// ColumnStore 只读映射四个文件，prices(row_begin, row_end) 返回 Map<const VectorXf>，
+// 直接传给 run_multi_weight_* 的 Ref<const VectorXf>，不复制价格；
+// range / date_range（交易日）/ calendar_day_range（自然日）先按块的 ts_max 二分，再在块内二分，只触及索引和两个块的页。
+// Python 端同一目录用 np.load(path, mmap_mode='r') 即可零拷贝读取。
+
+const int COLUMN_STORE_HEADER_BYTES = 128;
+const int COLUMN_STORE_CHUNK_FIELDS = 7;
+const int DEFAULT_COLUMN_STORE_CHUNK_ROWS = 4096;
+
+using VectorXi64 = Matrix<int64_t, Dynamic, 1>;
+
+struct ColumnStoreChunk {
+    int64_t first_row = 0;
+    int64_t rows = 0;
+    int64_t ts_min = 0;
+    int64_t ts_max = 0;
+    float price_min = 0.0f;
+    float price_max = 0.0f;
+    int64_t volume_sum = 0;
+};
+
+// 序列目录：{root}/{interval}/{inst}
+inline std::string column_store_series_dir(const std::string& root, const std::string& interval, const std::string& inst){
+    return root + "/" + interval + "/" + inst;
+}
+
+// yyyymmdd 当地零点（utc_offset_hours 时区，默认北京时间）的 epoch 毫秒
+inline int64_t yyyymmdd_to_epoch_ms(int yyyymmdd, int utc_offset_hours = 8){
+    int y = yyyymmdd / 10000;
+    const int m = yyyymmdd / 100 % 100, d = yyyymmdd % 100;
+    if(m < 1 || m > 12 || d < 1 || d > 31)
+        throw std::invalid_argument("日期格式应为 yyyymmdd: " + std::to_string(yyyymmdd));
+    // 公历日期转距 1970-01-01 的天数
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const int yoe = y - era * 400;
+    const int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    const int64_t days = (int64_t)era * 146097 + doe - 719468;
+    return (days * 86400 - (int64_t)utc_offset_hours * 3600) * 1000;
+}
+
+// -------------------- 交易日 --------------------
+// 期货夜盘（21:00 至次日凌晨）归属下一交易日；按工作日推算，不含节假日日历
+// （节前夜盘通常取消，节后首日起点落在假期内没有 bar，不影响结果）
+const int TRADING_DAY_SESSION_START_HOUR = 20;  // 前一交易日 20:00 之后的 bar 归入本交易日
+
+inline int yyyymmdd_add_days(int yyyymmdd, int days){
+    const int64_t ms = yyyymmdd_to_epoch_ms(yyyymmdd, 0) + (int64_t)days * 86400000LL;
+    int64_t z = ms / 86400000LL + 719468;  // 天数转公历日期
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const int64_t doe = z - era * 146097;
+    const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int64_t mp = (5 * doy + 2) / 153;
+    const int d = (int)(doy - (153 * mp + 2) / 5 + 1);
+    const int m = (int)(mp < 10 ? mp + 3 : mp - 9);
+    const int y = (int)(yoe + era * 400 + (m <= 2));
+    return y * 10000 + m * 100 + d;
+}
+
+// 星期几，0 = 周日
+inline int yyyymmdd_weekday(int yyyymmdd){
+    const int64_t days = yyyymmdd_to_epoch_ms(yyyymmdd, 0) / 86400000LL;
+    return (int)(((days + 4) % 7 + 7) % 7);  // 1970-01-01 为周四
+}
+
+inline int prev_weekday(int yyyymmdd){
+    do yyyymmdd = yyyymmdd_add_days(yyyymmdd, -1); while(yyyymmdd_weekday(yyyymmdd) % 6 == 0);
+    return yyyymmdd;
+}
+
+inline int next_weekday(int yyyymmdd){
+    do yyyymmdd = yyyymmdd_add_days(yyyymmdd, 1); while(yyyymmdd_weekday(yyyymmdd) % 6 == 0);
+    return yyyymmdd;
+}
+
+// 交易日 yyyymmdd 的起点：前一个工作日的 TRADING_DAY_SESSION_START_HOUR 点
+inline int64_t trading_day_begin_ms(int yyyymmdd, int utc_offset_hours = 8){
+    return yyyymmdd_to_epoch_ms(prev_weekday(yyyymmdd), utc_offset_hours) + TRADING_DAY_SESSION_START_HOUR * 3600000LL;
+}
+
+// 按 128 字节固定头部写出一列；行数由调用方保证与数据一致
+inline std::string column_store_header(const char* descr, long long rows, int cols){
+    std::vector<long long> shape{rows};
+    if(cols > 0) shape.push_back(cols);
+    std::string header = npy_header(descr, shape, false);
+    if(header.size() != (size_t)COLUMN_STORE_HEADER_BYTES)
+        throw std::invalid_argument("列式库头部长度不是 128 字节");
+    return header;
+}
+
+// 把一段完整序列写成列式库（覆盖已有文件），用于把历史数据 / Python 数组转换进库、以及测试
+inline void write_column_store(const std::string& dir, const Ref<const VectorXi64>& timestamps,
+                               const Ref<const VectorXf>& prices, const Ref<const VectorXi64>& volumes,
+                               int chunk_rows = DEFAULT_COLUMN_STORE_CHUNK_ROWS){
+    const Index rows = timestamps.size();
+    if(prices.size() != rows || volumes.size() != rows)
+        throw std::invalid_argument("时间戳 / 价格 / 成交量长度不一致");
+    for(Index i=1; i<rows; ++i)
+        if(timestamps(i) < timestamps(i - 1))
+            throw std::invalid_argument("时间戳必须非递减，第 " + std::to_string(i) + " 行倒退");
+    if(chunk_rows <= 0) chunk_rows = DEFAULT_COLUMN_STORE_CHUNK_ROWS;
+
+    const Index n_chunks = (rows + chunk_rows - 1) / chunk_rows;
+    Matrix<double, Dynamic, Dynamic, RowMajor> chunks(n_chunks, COLUMN_STORE_CHUNK_FIELDS);
+    for(Index c=0; c<n_chunks; ++c){
+        const Index begin = c * chunk_rows, n = std::min<Index>(chunk_rows, rows - begin);
+        chunks.row(c) << (double)begin, (double)n, (double)timestamps(begin), (double)timestamps(begin + n - 1),
+                         prices.segment(begin, n).minCoeff(), prices.segment(begin, n).maxCoeff(),
+                         (double)volumes.segment(begin, n).sum();
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if(ec) throw std::runtime_error("无法创建目录 " + dir + ": " + ec.message());
+    auto write_column = [&](const std::string& name, const std::string& header, const void* data, size_t bytes){
+        const std::string filename = dir + "/" + name;
+        std::FILE* file = std::fopen(filename.c_str(), "wb");
+        if(!file) throw npy_io_error("无法创建", filename);
+        std::unique_ptr<std::FILE, int (*)(std::FILE*)> guard(file, std::fclose);
+        write_all(file, header.data(), header.size(), filename);
+        write_all(file, data, bytes, filename);
+        if(std::fclose(guard.release()) != 0) throw npy_io_error("写入失败", filename);
+    };
+    write_column("timestamp.npy", column_store_header("<i8", rows, 0), timestamps.data(), sizeof(int64_t) * rows);
+    write_column("price.npy", column_store_header("<f4", rows, 0), prices.data(), sizeof(float) * rows);
+    write_column("volume.npy", column_store_header("<i8", rows, 0), volumes.data(), sizeof(int64_t) * rows);
+    write_column("chunks.npy", column_store_header("<f8", n_chunks, COLUMN_STORE_CHUNK_FIELDS), chunks.data(),
+                 sizeof(double) * chunks.size());
+}
+
+// -------------------- 只读映射 --------------------
+class ColumnStore {
+public:
+    explicit ColumnStore(const std::string& dir) : dir_(dir) {
+        const int64_t ts_rows = map_column(timestamps_, "timestamp.npy", "<i8", sizeof(int64_t), 0);
+        const int64_t price_rows = map_column(prices_, "price.npy", "<f4", sizeof(float), 0);
+        const int64_t volume_rows = map_column(volumes_, "volume.npy", "<i8", sizeof(int64_t), 0);
+        rows_ = std::min({ts_rows, price_rows, volume_rows});
+        // 索引只采用完全落在已提交行内的块；崩溃后缺失的块由块外二分兜底
+        int64_t n_chunks = map_column(chunks_, "chunks.npy", "<f8", sizeof(double) * COLUMN_STORE_CHUNK_FIELDS,
+                                      COLUMN_STORE_CHUNK_FIELDS);
+        while(n_chunks > 0 && chunk(n_chunks - 1).first_row + chunk(n_chunks - 1).rows > rows_) --n_chunks;
+        n_chunks_ = n_chunks;
+    }
+    ColumnStore(const ColumnStore&) = delete;
+    ColumnStore& operator=(const ColumnStore&) = delete;
+
+    const std::string& dir() const { return dir_; }
+    int64_t rows() const { return rows_; }
+    int64_t n_chunks() const { return n_chunks_; }
+
+    ColumnStoreChunk chunk(int64_t c) const {
+        const double* row = chunk_data() + c * COLUMN_STORE_CHUNK_FIELDS;
+        ColumnStoreChunk info;
+        info.first_row = (int64_t)row[0];
+        info.rows = (int64_t)row[1];
+        info.ts_min = (int64_t)row[2];
+        info.ts_max = (int64_t)row[3];
+        info.price_min = (float)row[4];
+        info.price_max = (float)row[5];
+        info.volume_sum = (int64_t)row[6];
+        return info;
+    }
+
+    // 行区间 [row_begin, row_end) 的零拷贝视图
+    Map<const VectorXi64> timestamps(int64_t row_begin = 0, int64_t row_end = -1) const {
+        check_rows(row_begin, row_end);
+        return Map<const VectorXi64>(timestamp_data() + row_begin, row_end - row_begin);
+    }
+    Map<const VectorXf> prices(int64_t row_begin = 0, int64_t row_end = -1) const {
+        check_rows(row_begin, row_end);
+        return Map<const VectorXf>(price_data() + row_begin, row_end - row_begin);
+    }
+    Map<const VectorXi64> volumes(int64_t row_begin = 0, int64_t row_end = -1) const {
+        check_rows(row_begin, row_end);
+        return Map<const VectorXi64>(volume_data() + row_begin, row_end - row_begin);
+    }
+
+    // 时间戳落在 [ts_begin, ts_end) 的行区间
+    std::pair<int64_t, int64_t> range(int64_t ts_begin, int64_t ts_end) const {
+        if(ts_end < ts_begin)
+            throw std::invalid_argument("时间范围结束早于开始");
+        const int64_t row_begin = lower_bound_row(ts_begin);
+        return {row_begin, std::max(row_begin, lower_bound_row(ts_end))};
+    }
+
+    // 交易日 [yyyymmdd_begin, yyyymmdd_end]（含结束日）的行区间：夜盘归下一交易日，
+    // 交易日 D 从前一个工作日 20:00 起（周一从上周五 20:00 起，含周六凌晨），到 D 的 20:00 止
+    std::pair<int64_t, int64_t> date_range(int yyyymmdd_begin, int yyyymmdd_end, int utc_offset_hours = 8) const {
+        return range(trading_day_begin_ms(yyyymmdd_begin, utc_offset_hours),
+                     trading_day_begin_ms(next_weekday(yyyymmdd_end), utc_offset_hours));
+    }
+
+    // 自然日 [yyyymmdd_begin, yyyymmdd_end]（含结束日）当地零点到零点的行区间（不按夜盘归属调整）
+    std::pair<int64_t, int64_t> calendar_day_range(int yyyymmdd_begin, int yyyymmdd_end, int utc_offset_hours = 8) const {
+        return range(yyyymmdd_to_epoch_ms(yyyymmdd_begin, utc_offset_hours),
+                     yyyymmdd_to_epoch_ms(yyyymmdd_end, utc_offset_hours) + 86400000LL);
+    }
+
+private:
+    // 映射随对象释放（构造中途抛异常时已映射的列也会解除）
+    struct Column {
+        char* base = nullptr;
+        size_t bytes = 0;
+        size_t data_offset = 0;
+        Column() = default;
+        Column(const Column&) = delete;
+        Column& operator=(const Column&) = delete;
+        ~Column(){ if(base) ::munmap(base, bytes); }
+    };
+
+    // 映射一列并解析头部，返回文件里实际可读的行数（头部行数与文件长度取小）
+    int64_t map_column(Column& column, const char* name, const char* descr, size_t row_bytes, int cols){
+        const std::string filename = dir_ + "/" + name;
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        if(fd < 0) throw npy_io_error("无法打开", filename);
+        struct stat st;
+        if(::fstat(fd, &st) != 0){ ::close(fd); throw npy_io_error("无法读取文件信息", filename); }
+        column.bytes = (size_t)st.st_size;
+        if(column.bytes < 10){ ::close(fd); throw std::invalid_argument("不是 NPY 1.0 文件: " + filename); }
+        void* p = ::mmap(nullptr, column.bytes, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(p == MAP_FAILED) throw npy_io_error("无法映射", filename);
+        column.base = static_cast<char*>(p);
+
+        const unsigned char* prefix = reinterpret_cast<const unsigned char*>(column.base);
+        if(std::memcmp(prefix, "\x93NUMPY\x01", 7) != 0)
+            throw std::invalid_argument("不是 NPY 1.0 文件: " + filename);
+        column.data_offset = 10 + (prefix[8] | (prefix[9] << 8));
+        if(column.data_offset > column.bytes)
+            throw std::invalid_argument("NPY 头部不完整: " + filename);
+        const std::string dict(column.base + 10, column.data_offset - 10);
+        if(dict.find(std::string("'descr': '") + descr + "'") == std::string::npos)
+            throw std::invalid_argument(std::string("列类型应为 ") + descr + ": " + filename);
+        if(dict.find("'fortran_order': False") == std::string::npos)
+            throw std::invalid_argument("列式库文件应为 C 序: " + filename);
+        long long rows = 0, parsed_cols = 0;
+        const size_t shape = dict.find("'shape': (");
+        const int n_fields = shape == std::string::npos ? 0
+            : std::sscanf(dict.c_str() + shape + 10, "%lld, %lld", &rows, &parsed_cols);
+        if(n_fields < 1 || rows < 0 || (cols > 0 && (n_fields != 2 || parsed_cols != cols)))
+            throw std::invalid_argument("列式库文件形状不符: " + filename);
+        return std::min<int64_t>(rows, (int64_t)((column.bytes - column.data_offset) / row_bytes));
+    }
+
+    const int64_t* timestamp_data() const { return reinterpret_cast<const int64_t*>(timestamps_.base + timestamps_.data_offset); }
+    const float* price_data() const { return reinterpret_cast<const float*>(prices_.base + prices_.data_offset); }
+    const int64_t* volume_data() const { return reinterpret_cast<const int64_t*>(volumes_.base + volumes_.data_offset); }
+    const double* chunk_data() const { return reinterpret_cast<const double*>(chunks_.base + chunks_.data_offset); }
+
+    void check_rows(int64_t row_begin, int64_t& row_end) const {
+        if(row_end < 0) row_end = rows_;
+        if(row_begin < 0 || row_begin > row_end || row_end > rows_)
+            throw std::invalid_argument("行区间 [" + std::to_string(row_begin) + ", " + std::to_string(row_end) +
+                                        ") 超出 0.." + std::to_string(rows_));
+    }
+
+    // 第一个时间戳 >= ts 的行
+    int64_t lower_bound_row(int64_t ts) const {
+        const int64_t* data = timestamp_data();
+        int64_t begin = 0, end = rows_;
+        if(n_chunks_ > 0){
+            const double* index = chunk_data();
+            int64_t lo = 0, hi = n_chunks_;  // 第一个 ts_max >= ts 的块
+            while(lo < hi){
+                const int64_t mid = (lo + hi) / 2;
+                if((int64_t)index[mid * COLUMN_STORE_CHUNK_FIELDS + 3] < ts) lo = mid + 1;
+                else hi = mid;
+            }
+            if(lo < n_chunks_){
+                begin = (int64_t)index[lo * COLUMN_STORE_CHUNK_FIELDS + 0];
+                end = begin + (int64_t)index[lo * COLUMN_STORE_CHUNK_FIELDS + 1];
+            } else {
+                const ColumnStoreChunk last = chunk(n_chunks_ - 1);
+                begin = last.first_row + last.rows;  // 索引之后尚未建块的行
+            }
+        }
+        return std::lower_bound(data + begin, data + end, ts) - data;
+    }
+
+    std::string dir_;
+    Column timestamps_, prices_, volumes_, chunks_;
+    int64_t rows_ = 0;
+    int64_t n_chunks_ = 0;
+};
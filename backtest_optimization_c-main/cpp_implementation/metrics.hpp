@@ -0,0 +1,190 @@
+#pragma once
+#include <Eigen/Dense>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+using namespace Eigen;
+
+// -------------------- 性能指标（单遍融合计算） --------------------
+// 与 reference_impl/metrics.py 的公式保持一致：
+//   returns[t]   = portfolio[t] / portfolio[t-1] - 1（非有限值记为 0）
+//   Sharpe       = mean(returns) / (std(returns, ddof=1) + 1e-8) * sqrt(annualization_factor)
+//   MaxDrawdown  = max((peak - value) / (peak + 1e-8))
+//   TotalReturn  = final / (initial + 1e-8) - 1
+//   WinRate      = count(returns > 0) / len(returns)
+// 均值/方差用 Welford 在线算法，回撤维护运行峰值，整条曲线只需读一遍，且无需保存组合价值矩阵。
+
+const float DEFAULT_ANNUALIZATION_FACTOR = 252.0f;
+
+// 各权重组合的指标 (n_weights,)
+struct BacktestMetrics {
+    VectorXf sharpe_ratio;
+    VectorXf max_drawdown;
+    VectorXf total_return;
+    VectorXf win_rate;
+};
+
+// 单列指标累加器：每个时间步 O(1) 更新
+struct MetricsAccumulator {
+    long long n_returns = 0;  // 收益率个数（= 时间步数 - 1）
+    long long n_wins = 0;     // 正收益个数
+    double mean = 0.0;        // 收益率均值（Welford）
+    double m2 = 0.0;          // 收益率离差平方和（Welford）
+    float initial_value = 0.0f;
+    float prev_value = 0.0f;
+    float peak = 0.0f;
+    float max_drawdown = 0.0f;
+
+    void reset(float value){
+        n_returns = 0;
+        n_wins = 0;
+        mean = 0.0;
+        m2 = 0.0;
+        initial_value = value;
+        prev_value = value;
+        peak = value;
+        max_drawdown = 0.0f;
+    }
+
+    void update(float value){
+        // 收益率（与 Python 一致：float32 计算，除零/非有限值记为 0）
+        float r = value / prev_value - 1.0f;
+        if(!std::isfinite(r)) r = 0.0f;
+        prev_value = value;
+
+        ++n_returns;
+        if(r > 0.0f) ++n_wins;
+        const double delta = r - mean;
+        mean += delta / n_returns;
+        m2 += delta * (r - mean);
+
+        // 回撤
+        if(value > peak){
+            peak = value;
+        } else {
+            const float drawdown = (peak - value) / (peak + 1e-8f);
+            if(drawdown > max_drawdown) max_drawdown = drawdown;
+        }
+    }
+
+    float sharpe_ratio(float annualization_factor = DEFAULT_ANNUALIZATION_FACTOR) const {
+        if(n_returns < 2) return 0.0f;
+        const double std_return = std::sqrt(m2 / (n_returns - 1));  // 样本标准差 ddof=1
+        const double sharpe = mean / (std_return + 1e-8) * std::sqrt((double)annualization_factor);
+        return std::isfinite(sharpe) ? (float)sharpe : 0.0f;
+    }
+    float total_return() const {
+        const float total = prev_value / (initial_value + 1e-8f) - 1.0f;
+        return std::isfinite(total) ? total : 0.0f;
+    }
+    float win_rate() const {
+        return n_returns > 0 ? (float)n_wins / (float)n_returns : 0.0f;
+    }
+};
+
+inline BacktestMetrics collect_metrics(
+    const std::vector<MetricsAccumulator>& accumulators,
+    float annualization_factor = DEFAULT_ANNUALIZATION_FACTOR
+){
+    const int n_weights = accumulators.size();
+    BacktestMetrics metrics;
+    metrics.sharpe_ratio.resize(n_weights);
+    metrics.max_drawdown.resize(n_weights);
+    metrics.total_return.resize(n_weights);
+    metrics.win_rate.resize(n_weights);
+    for(int w=0; w<n_weights; ++w){
+        const MetricsAccumulator& acc = accumulators[w];
+        metrics.sharpe_ratio(w) = acc.sharpe_ratio(annualization_factor);
+        metrics.max_drawdown(w) = acc.max_drawdown;
+        metrics.total_return(w) = acc.total_return();
+        metrics.win_rate(w) = acc.win_rate();
+    }
+    return metrics;
+}
+
+// 指标输出策略：回测时间循环内直接累加，内存 O(W)，不产生额外的矩阵读写
+struct MetricsOutput {
+    explicit MetricsOutput(float annualization_factor = DEFAULT_ANNUALIZATION_FACTOR)
+        : annualization_factor_(annualization_factor) {}
+
+    int chunk_rows() const { return 0; }
+    void begin(int, int n_weights){ accumulators_.assign(n_weights, MetricsAccumulator()); }
+    void begin_chunk(int, int){}
+    void record(int col, int idx, float portfolio, float, float){
+        if(idx == 0) accumulators_[col].reset(portfolio);
+        else accumulators_[col].update(portfolio);
+    }
+    void end_chunk(int, int){}
+
+    const std::vector<MetricsAccumulator>& accumulators() const { return accumulators_; }
+    BacktestMetrics metrics() const { return collect_metrics(accumulators_, annualization_factor_); }
+
+private:
+    float annualization_factor_;
+    std::vector<MetricsAccumulator> accumulators_;
+};
+
+// -------------------- 基于完整组合价值矩阵的指标计算 --------------------
+// 已有 portfolio_values 矩阵时使用，单遍扫描；列主序逐列读，行主序（如 NumPy C 序）逐行读一个列块
+const int METRICS_ROW_MAJOR_BLOCK = 64;
+
+template <typename Derived>
+inline BacktestMetrics calculate_all_metrics(
+    const MatrixBase<Derived>& portfolio_values,  // (n_timestamps, n_weights)
+    float annualization_factor = DEFAULT_ANNUALIZATION_FACTOR
+){
+    const int n_timestamps = portfolio_values.rows();
+    const int n_weights = portfolio_values.cols();
+    std::vector<MetricsAccumulator> accumulators(n_weights);
+    if(n_timestamps > 0){
+        if(Derived::IsRowMajor){
+            const int n_blocks = (n_weights + METRICS_ROW_MAJOR_BLOCK - 1) / METRICS_ROW_MAJOR_BLOCK;
+            #pragma omp parallel for schedule(static)
+            for(int b=0; b<n_blocks; ++b){
+                const int col_begin = b * METRICS_ROW_MAJOR_BLOCK;
+                const int col_end = std::min(col_begin + METRICS_ROW_MAJOR_BLOCK, n_weights);
+                for(int w=col_begin; w<col_end; ++w) accumulators[w].reset(portfolio_values(0, w));
+                for(int t=1; t<n_timestamps; ++t)
+                    for(int w=col_begin; w<col_end; ++w) accumulators[w].update(portfolio_values(t, w));
+            }
+        } else {
+            #pragma omp parallel for schedule(static)
+            for(int w=0; w<n_weights; ++w){
+                MetricsAccumulator acc;
+                acc.reset(portfolio_values(0, w));
+                for(int t=1; t<n_timestamps; ++t) acc.update(portfolio_values(t, w));
+                accumulators[w] = acc;
+            }
+        }
+    }
+    return collect_metrics(accumulators, annualization_factor);
+}
+
+inline VectorXf calculate_sharpe_ratio(
+    const MatrixXf& portfolio_values,
+    float annualization_factor = DEFAULT_ANNUALIZATION_FACTOR
+){
+    return calculate_all_metrics(portfolio_values, annualization_factor).sharpe_ratio;
+}
+
+inline VectorXf calculate_max_drawdown(const MatrixXf& portfolio_values){
+    return calculate_all_metrics(portfolio_values).max_drawdown;
+}
+
+inline VectorXf calculate_total_return(const MatrixXf& portfolio_values){
+    return calculate_all_metrics(portfolio_values).total_return;
+}
+
+inline VectorXf calculate_win_rate(const MatrixXf& portfolio_values){
+    return calculate_all_metrics(portfolio_values).win_rate;
+}
+
+// 收益率矩阵 (n_timestamps-1, n_weights)
+inline MatrixXf calculate_returns(const MatrixXf& portfolio_values){
+    const int n_timestamps = portfolio_values.rows();
+    if(n_timestamps < 2) return MatrixXf(0, portfolio_values.cols());
+    MatrixXf returns = (portfolio_values.bottomRows(n_timestamps - 1).array()
+                        / portfolio_values.topRows(n_timestamps - 1).array() - 1.0f).matrix();
+    return returns.unaryExpr([](float r){ return std::isfinite(r) ? r : 0.0f; });
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include "column_blocked_backtest.hpp"
+#include "signal_processor.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <omp.h>
+
+// -------------------- 多品种批量回测 --------------------
+// 一次调用回测一个价格面板 (T × N 个品种)：每个品种有自己的持仓矩阵，或有自己的信号矩阵并共享一组权重。
+// 所有 (品种, 权重列块) 组成一个任务列表，由同一个线程组动态调度（各品种的计算量可以不同），
+// 每个线程的持仓小块缓冲区和状态数组在整个批次内复用，不再逐品种重新分配 / 重新创建线程组。
+// 每个任务独立跑完完整时间序列，因此输出策略须为整段输出（chunk_rows() <= 0）。
+
+// 引擎主体：outputs[i] 接收第 i 个品种的结果
+template <TradeMode Mode, typename Cash, typename Source, typename Output>
+inline void run_multi_asset_engine(
+    const Ref<const MatrixXf>& price_panel,  // (n_timestamps, n_instruments)
+    const std::vector<Source>& sources,
+    const BacktestConfig& config,
+    std::vector<Output>& outputs,
+    int column_block
+){
+    const int n_timestamps = price_panel.rows();
+    const int n_instruments = price_panel.cols();
+    const int block = column_block > 0 ? column_block : DEFAULT_COLUMN_BLOCK;
+
+    // 任务表：(品种, 该品种内的起始列)
+    std::vector<std::pair<int, int>> tasks;
+    for(int i=0; i<n_instruments; ++i){
+        outputs[i].begin(n_timestamps, sources[i].n_weights());
+        outputs[i].begin_chunk(0, n_timestamps);
+        if(n_timestamps > 0)
+            for(int col=0; col<sources[i].n_weights(); col+=block) tasks.emplace_back(i, col);
+    }
+    const int n_tasks = tasks.size();
+
+    #pragma omp parallel
+    {
+        typename Source::TileBuffer buffer;
+        std::vector<Cash> cash_state(block, Cash{config.initial_cash});
+        std::vector<float> qty_state(block), prev_pos_state(block);
+
+        #pragma omp for schedule(dynamic)
+        for(int k=0; k<n_tasks; ++k){
+            const int i = tasks[k].first;
+            const int col_begin = tasks[k].second;
+            const int col_end = std::min(col_begin + block, sources[i].n_weights());
+            const int tile = sources[i].tile_rows() > 0 ? sources[i].tile_rows() : n_timestamps;
+
+            std::fill(cash_state.begin(), cash_state.end(), Cash{config.initial_cash});
+            std::fill(qty_state.begin(), qty_state.end(), 0.0f);
+            advance_column_block<Mode, Cash>(price_panel.col(i).data(), sources[i], buffer, config, outputs[i],
+                                             col_begin, col_end, 0, n_timestamps, tile,
+                                             cash_state.data(), qty_state.data(), prev_pos_state.data());
+        }
+    }
+
+    for(int i=0; i<n_instruments; ++i) outputs[i].end_chunk(0, n_timestamps);
+}
+
+// 任意持仓来源的多品种回测：检查维度后按 config.trade_mode 分派
+template <typename Source, typename Output>
+inline void run_multi_asset_source(
+    const Ref<const MatrixXf>& price_panel,
+    const std::vector<Source>& sources,
+    const BacktestConfig& config,
+    std::vector<Output>& outputs,
+    int column_block = DEFAULT_COLUMN_BLOCK
+){
+    const int n_instruments = price_panel.cols();
+    if((int)sources.size() != n_instruments)
+        throw std::invalid_argument("持仓来源数量 (" + std::to_string(sources.size()) +
+                                    ") 与价格面板品种数 (" + std::to_string(n_instruments) + ") 不匹配");
+    for(int i=0; i<n_instruments; ++i)
+        if(sources[i].n_timestamps() != price_panel.rows())
+            throw std::invalid_argument("第 " + std::to_string(i) + " 个品种的时间步数与价格面板不匹配");
+
+    outputs.resize(n_instruments);
+    for(const Output& output : outputs)
+        if(output.chunk_rows() > 0)
+            throw std::invalid_argument("多品种批量回测不支持分块输出");
+
+    dispatch_trade_mode(config.trade_mode, [&](auto mode){
+        dispatch_cash_precision(config.cash_precision, [&](auto cash){
+            run_multi_asset_engine<decltype(mode)::value, decltype(cash)>(price_panel, sources, config, outputs, column_block);
+        });
+    });
+}
+
+// 每个品种各自的持仓矩阵 (n_timestamps, n_weights_i)
+template <typename Output>
+inline void run_multi_asset_backtest(
+    const Ref<const MatrixXf>& price_panel,
+    const std::vector<MatrixXf>& position_matrices,
+    const BacktestConfig& config,
+    std::vector<Output>& outputs,
+    int column_block = DEFAULT_COLUMN_BLOCK
+){
+    std::vector<MatrixPositionSource> sources;
+    sources.reserve(position_matrices.size());
+    for(const MatrixXf& position_matrix : position_matrices) sources.push_back(MatrixPositionSource{position_matrix});
+    run_multi_asset_source(price_panel, sources, config, outputs, column_block);
+}
+
+// 每个品种各自的信号矩阵 (n_timestamps, n_signals)，共享权重矩阵 (n_signals, n_weights)，走融合流水线
+template <typename Output>
+inline void run_multi_asset_signal_backtest(
+    const Ref<const MatrixXf>& price_panel,
+    const std::vector<MatrixXf>& signal_matrices,
+    const MatrixXf& weights_matrix,
+    float threshold,
+    const BacktestConfig& config,
+    std::vector<Output>& outputs,
+    int column_block = DEFAULT_COLUMN_BLOCK,
+    int tile_rows = DEFAULT_SIGNAL_TILE_ROWS
+){
+    std::vector<SignalPositionSource<>> sources;
+    sources.reserve(signal_matrices.size());
+    for(const MatrixXf& signal_matrix : signal_matrices){
+        check_signal_dims(signal_matrix, weights_matrix);
+        sources.push_back(SignalPositionSource<>{signal_matrix, weights_matrix, threshold,
+                                                 tile_rows > 0 ? tile_rows : DEFAULT_SIGNAL_TILE_ROWS});
+    }
+    run_multi_asset_source(price_panel, sources, config, outputs, column_block);
+}
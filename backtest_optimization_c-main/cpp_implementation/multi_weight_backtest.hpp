@@ -6,6 +6,9 @@
 #include <Eigen/Dense>
 #include <tuple>
 #include <string>
+#include <stdexcept>
+#include <type_traits>
+#include <algorithm>
 #include <fstream>
 #include <cmath>
 #include <omp.h>
@@ -14,6 +17,104 @@
 
 using namespace Eigen;
 
+// 分阶段耗时打印：编译时定义 BACKTEST_VERBOSE_TIMING 才输出，默认关闭，避免污染基准测试计时
+#ifdef BACKTEST_VERBOSE_TIMING
+#define BACKTEST_STAGE_TIME(label, t_begin, t_end) \
+    (std::cout << "[耗时] " << label << ": " << std::chrono::duration<double>((t_end) - (t_begin)).count() << " 秒" << std::endl)
+#else
+#define BACKTEST_STAGE_TIME(label, t_begin, t_end) ((void)(t_begin), (void)(t_end))
+#endif
+
+
+// -------------------- 交易模式 --------------------
+// 交易模式枚举：字符串只在 API 入口解析一次，内核按模式编译期特化
+enum class TradeMode {
+    FIXED,          // 固定仓位大小
+    CASH_ALL,       // 全部现金买入
+    PORTFOLIO_PCT,  // 组合百分比分配
+    FIXED_CASH      // 固定金额交易
+};
+
+// 字符串转枚举，取值与 Python 参考实现一致
+inline TradeMode parse_trade_mode(const std::string& trade_mode){
+    if(trade_mode == "fixed") return TradeMode::FIXED;
+    if(trade_mode == "cash_all") return TradeMode::CASH_ALL;
+    if(trade_mode == "portfolio_pct") return TradeMode::PORTFOLIO_PCT;
+    if(trade_mode == "fixed_cash") return TradeMode::FIXED_CASH;
+    throw std::invalid_argument("不支持的交易模式: " + trade_mode);
+}
+
+// -------------------- 现金累加精度 --------------------
+// 长周期回测中 float 现金逐步累加会产生漂移；持仓信号 / 价格仍为 float，只有现金状态换精度
+enum class CashPrecision {
+    FLOAT,   // float 累加（与旧内核一致，最快）
+    KAHAN,   // float + Kahan-Neumaier 补偿累加
+    DOUBLE   // double 累加，买入数量 / 组合价值也按 double 计算
+};
+
+inline CashPrecision parse_cash_precision(const std::string& cash_precision){
+    if(cash_precision == "float") return CashPrecision::FLOAT;
+    if(cash_precision == "kahan") return CashPrecision::KAHAN;
+    if(cash_precision == "double") return CashPrecision::DOUBLE;
+    throw std::invalid_argument("不支持的现金累加精度: " + cash_precision);
+}
+
+inline const char* cash_precision_name(CashPrecision cash_precision){
+    switch(cash_precision){
+        case CashPrecision::KAHAN: return "kahan";
+        case CashPrecision::DOUBLE: return "double";
+        default: return "float";
+    }
+}
+
+// 回测配置（列分块引擎等新接口使用，字段含义与旧内核同名参数一致）
+struct BacktestConfig {
+    float initial_cash = 1000000.0f;
+    TradeMode trade_mode = TradeMode::PORTFOLIO_PCT;
+    float max_allocation_pct = 0.5f;  // 仅 PORTFOLIO_PCT 模式使用
+    float fixed_cash_amount = 100000.0f;  // 仅 FIXED_CASH 模式使用
+    float position_size = 100.0f;  // 仅 FIXED 模式使用
+    CashPrecision cash_precision = CashPrecision::FLOAT;  // 仅列分块 / 多品种引擎使用
+};
+
+// 运行期模式 -> 编译期模式，f 以 std::integral_constant<TradeMode, M> 调用
+template <typename F>
+inline decltype(auto) dispatch_trade_mode(TradeMode trade_mode, F&& f){
+    switch(trade_mode){
+        case TradeMode::FIXED:
+            return f(std::integral_constant<TradeMode, TradeMode::FIXED>{});
+        case TradeMode::CASH_ALL:
+            return f(std::integral_constant<TradeMode, TradeMode::CASH_ALL>{});
+        case TradeMode::FIXED_CASH:
+            return f(std::integral_constant<TradeMode, TradeMode::FIXED_CASH>{});
+        case TradeMode::PORTFOLIO_PCT:
+        default:
+            return f(std::integral_constant<TradeMode, TradeMode::PORTFOLIO_PCT>{});
+    }
+}
+
+// 单列买入数量（未做现金上限约束），每种模式各自一份无分支实例；Scalar 为计算精度
+template <TradeMode Mode, typename Scalar = float>
+inline Scalar calc_buy_qty(
+    Scalar cash,
+    Scalar qty,
+    Scalar price,
+    float max_allocation_pct,
+    float fixed_cash_amount,
+    float position_size
+){
+    if constexpr (Mode == TradeMode::FIXED){
+        return position_size;
+    } else if constexpr (Mode == TradeMode::CASH_ALL){
+        return std::floor(cash / price);
+    } else if constexpr (Mode == TradeMode::PORTFOLIO_PCT){
+        Scalar portfolio_value = cash + qty * price;
+        Scalar max_pos = std::floor(portfolio_value * max_allocation_pct / price);
+        return std::max(Scalar(0), std::min(max_pos - qty, std::floor(cash / price)));
+    } else {
+        return std::floor(fixed_cash_amount / price);
+    }
+}
 
 // -------------------- 函数声明 --------------------
 // 基于 Eigen 向量化 API 的多权重回测（尽量使用 Eigen 运算替代显式循环）
@@ -28,6 +129,16 @@ run_multi_weight_vectorized_eigen(
     float position_size = 100.0
 );
 std::tuple<MatrixXf, MatrixXf, MatrixXf>
+run_multi_weight_vectorized_eigen(
+    const VectorXf& prices,
+    const MatrixXf& position_matrix,
+    float initial_cash,
+    TradeMode trade_mode,
+    float max_allocation_pct = 0.5,
+    float fixed_cash_amount = 100000.0,
+    float position_size = 100.0
+);
+std::tuple<MatrixXf, MatrixXf, MatrixXf>
 run_multi_weight_vectorized_parallel_1(
     const VectorXf& prices,
     const MatrixXf& position_matrix,
@@ -48,17 +159,17 @@ run_multi_weight_vectorized_parallel_2(
     float fixed_cash_amount = 100000.0,
     float position_size = 100.0
 );
-// std::tuple<MatrixXf, MatrixXf, MatrixXf> 
-// run_multi_weight_vectorized_parallel(
-//     const VectorXf& prices,
-//     const MatrixXf& position_matrix,
-//     float initial_cash = 1000000.0,
-//     TradeMode trade_mode = TradeMode::PORTFOLIO_PCT,
-//     float max_allocation_pct = 0.5,
-//     float fixed_cash_amount = 100000.0,
-//     float position_size = 100.0
-// );
-// 保存矩阵为 CSV 文件
+std::tuple<MatrixXf, MatrixXf, MatrixXf> 
+run_multi_weight_vectorized_parallel_2(
+    const VectorXf& prices,
+    const MatrixXf& position_matrix,
+    float initial_cash,
+    TradeMode trade_mode,
+    float max_allocation_pct = 0.5,
+    float fixed_cash_amount = 100000.0,
+    float position_size = 100.0
+);
+// 保存矩阵为 CSV 文件（逐个数文本格式化，慢；大结果用 npy_writer.hpp 的 save_matrix_npy / NpyOutput）
 inline void save_matrix_csv(const MatrixXf& mat, const std::string& filename){
     std::ofstream file(filename);
     for(int i=0; i<mat.rows(); ++i){
@@ -72,15 +183,15 @@ inline void save_matrix_csv(const MatrixXf& mat, const std::string& filename){
 
 //
 // 单线程多权重回测函数（原始版本，用于验证并行计算）
+template <TradeMode Mode>
 inline std::tuple<MatrixXf, MatrixXf, MatrixXf> 
-run_multi_weight_vectorized(
+run_multi_weight_vectorized_impl(
     const VectorXf& prices,
     const MatrixXf& position_matrix,
-    float initial_cash = 1000000.0,
-    std::string trade_mode = "portfolio_pct",
-    float max_allocation_pct = 0.5,
-    float fixed_cash_amount = 100000.0,
-    float position_size = 100.0
+    float initial_cash,
+    float max_allocation_pct,
+    float fixed_cash_amount,
+    float position_size
 ){
     int n_timestamps = prices.size();
     int n_weights = position_matrix.cols();
@@ -112,24 +223,9 @@ run_multi_weight_vectorized(
         // ----------------- 买入 -----------------
         if(buys.sum() > 0){
             VectorXf buy_positions(n_weights);
-            buy_positions.setZero();
-
-            if(trade_mode == "fixed"){
-                buy_positions.array() = position_size;
-            } else if(trade_mode == "cash_all"){
-                for(int w=0; w<n_weights; ++w)
-                    buy_positions(w) = std::floor(cash_matrix(idx, w) / price);
-            } else if(trade_mode == "portfolio_pct"){
-                for(int w=0; w<n_weights; ++w){
-                    float portfolio_value = cash_matrix(idx, w) + real_position_matrix(idx, w) * price;
-                    float max_pos = std::floor(portfolio_value * max_allocation_pct / price);
-                    buy_positions(w) = std::max(0.0f, std::min(max_pos - real_position_matrix(idx, w),
-                                                               std::floor(cash_matrix(idx, w) / price)));
-                }
-            } else if(trade_mode == "fixed_cash"){
-                for(int w=0; w<n_weights; ++w)
-                    buy_positions(w) = std::floor(fixed_cash_amount / price);
-            }
+            for(int w=0; w<n_weights; ++w)
+                buy_positions(w) = calc_buy_qty<Mode>(cash_matrix(idx, w), real_position_matrix(idx, w), price,
+                                                      max_allocation_pct, fixed_cash_amount, position_size);
 
             // 只对买入信号生效
             for(int w=0; w<n_weights; ++w){
@@ -165,6 +261,36 @@ run_multi_weight_vectorized(
     return std::make_tuple(portfolio_value_matrix, cash_matrix, real_position_matrix);
 }
 
+inline std::tuple<MatrixXf, MatrixXf, MatrixXf> 
+run_multi_weight_vectorized(
+    const VectorXf& prices,
+    const MatrixXf& position_matrix,
+    float initial_cash,
+    TradeMode trade_mode,
+    float max_allocation_pct = 0.5,
+    float fixed_cash_amount = 100000.0,
+    float position_size = 100.0
+){
+    return dispatch_trade_mode(trade_mode, [&](auto mode){
+        return run_multi_weight_vectorized_impl<decltype(mode)::value>(
+            prices, position_matrix, initial_cash, max_allocation_pct, fixed_cash_amount, position_size);
+    });
+}
+
+inline std::tuple<MatrixXf, MatrixXf, MatrixXf> 
+run_multi_weight_vectorized(
+    const VectorXf& prices,
+    const MatrixXf& position_matrix,
+    float initial_cash = 1000000.0,
+    std::string trade_mode = "portfolio_pct",
+    float max_allocation_pct = 0.5,
+    float fixed_cash_amount = 100000.0,
+    float position_size = 100.0
+){
+    return run_multi_weight_vectorized(prices, position_matrix, initial_cash, parse_trade_mode(trade_mode),
+                                       max_allocation_pct, fixed_cash_amount, position_size);
+}
+
 
 
 
@@ -503,8 +629,7 @@ run_multi_weight_vectorized_parallel_1(
     ArrayXXf max_afford(1, n_weights); max_afford.setZero();
     ArrayXXf tmp(1, n_weights); tmp.setZero();
     auto t1 = std::chrono::high_resolution_clock::now();
-    std::cout << "[耗时] 矩阵初始化: " 
-              << std::chrono::duration<double>(t1 - t0).count() << " 秒" << std::endl;
+    BACKTEST_STAGE_TIME("矩阵初始化", t0, t1);
               
     // // 计算持仓变化矩阵 (首行等于初始持仓，后续为逐行差分)
     // MatrixXf position_change_matrix(n_timestamps, n_weights);
@@ -521,8 +646,7 @@ run_multi_weight_vectorized_parallel_1(
 
 
     auto t2 = std::chrono::high_resolution_clock::now();
-    std::cout << "[耗时] 计算 position_change_matrix: "
-            << std::chrono::duration<double>(t2 - t1).count() << " 秒" << std::endl;
+    BACKTEST_STAGE_TIME("计算 position_change_matrix", t1, t2);
     const int unroll_factor = 4;
 
     // ------------------ 时间步串行，列并行 + 循环展开 ------------------
@@ -570,17 +694,16 @@ run_multi_weight_vectorized_parallel_1(
             cash_matrix.row(idx).array() + real_position_matrix.row(idx).array() * price32;  // 组合价值
     }
     auto t3 = std::chrono::high_resolution_clock::now();
-    std::cout << "[耗时] 主循环总耗时: "
-              << std::chrono::duration<double>(t3 - t_loop_start).count() << " 秒" << std::endl;
+    BACKTEST_STAGE_TIME("主循环总耗时", t_loop_start, t3);
     return std::make_tuple(portfolio_value_matrix, cash_matrix, real_position_matrix);
 }
 
+template <TradeMode Mode>
 inline std::tuple<MatrixXf, MatrixXf, MatrixXf>
-run_multi_weight_vectorized_parallel_2(
+run_multi_weight_vectorized_parallel_2_impl(
     const VectorXf& prices,
     const MatrixXf& position_matrix,
     float initial_cash,
-    std::string trade_mode,
     float max_allocation_pct,
     float fixed_cash_amount,
     float position_size
@@ -599,8 +722,7 @@ run_multi_weight_vectorized_parallel_2(
     portfolio_value_matrix.row(0).array() = initial_cash;
 
     auto t1 = std::chrono::high_resolution_clock::now();
-    std::cout << "[耗时] 矩阵初始化: " 
-              << std::chrono::duration<double>(t1 - t0).count() << " 秒" << std::endl;
+    BACKTEST_STAGE_TIME("矩阵初始化", t0, t1);
 
     // 计算持仓变化矩阵
     MatrixXf position_change_matrix(n_timestamps, n_weights);
@@ -610,8 +732,7 @@ run_multi_weight_vectorized_parallel_2(
         position_matrix.block(0, 0, n_timestamps-1, n_weights);
 
     auto t2 = std::chrono::high_resolution_clock::now();
-    std::cout << "[耗时] 计算 position_change_matrix: "
-              << std::chrono::duration<double>(t2 - t1).count() << " 秒" << std::endl;
+    BACKTEST_STAGE_TIME("计算 position_change_matrix", t1, t2);
 
     const int unroll_factor = 4;
 
@@ -633,18 +754,8 @@ run_multi_weight_vectorized_parallel_2(
 
         // ----------------- 买入 -----------------
                 if(pos_change > 0){
-                    float buy_qty = 0;
-                    if(trade_mode == "fixed")
-                        buy_qty = position_size;
-                    else if(trade_mode == "cash_all")
-                        buy_qty = std::floor(cash_matrix(idx, col) / price);
-                    else if(trade_mode == "portfolio_pct"){
-                        float portfolio_value = cash_matrix(idx, col) + real_position_matrix(idx, col) * price;
-                        float max_pos = std::floor(portfolio_value * max_allocation_pct / price);
-                        buy_qty = std::max(0.0f, std::min(max_pos - real_position_matrix(idx, col),
-                                                          std::floor(cash_matrix(idx, col) / price)));
-                    } else if(trade_mode == "fixed_cash")
-                        buy_qty = std::floor(fixed_cash_amount / price);
+                    float buy_qty = calc_buy_qty<Mode>(cash_matrix(idx, col), real_position_matrix(idx, col), price,
+                                                       max_allocation_pct, fixed_cash_amount, position_size);
 
                     float max_affordable = std::floor(cash_matrix(idx, col) / price);
                     buy_qty = std::min(buy_qty, max_affordable);
@@ -676,18 +787,47 @@ run_multi_weight_vectorized_parallel_2(
         // }
     }
     auto t3 = std::chrono::high_resolution_clock::now();
-    std::cout << "[耗时] 主循环总耗时: "
-              << std::chrono::duration<double>(t3 - t_loop_start).count() << " 秒" << std::endl;
+    BACKTEST_STAGE_TIME("主循环总耗时", t_loop_start, t3);
 
     return std::make_tuple(portfolio_value_matrix, cash_matrix, real_position_matrix);
 }
 
+inline std::tuple<MatrixXf, MatrixXf, MatrixXf>
+run_multi_weight_vectorized_parallel_2(
+    const VectorXf& prices,
+    const MatrixXf& position_matrix,
+    float initial_cash,
+    TradeMode trade_mode,
+    float max_allocation_pct,
+    float fixed_cash_amount,
+    float position_size
+){
+    return dispatch_trade_mode(trade_mode, [&](auto mode){
+        return run_multi_weight_vectorized_parallel_2_impl<decltype(mode)::value>(
+            prices, position_matrix, initial_cash, max_allocation_pct, fixed_cash_amount, position_size);
+    });
+}
+
+inline std::tuple<MatrixXf, MatrixXf, MatrixXf>
+run_multi_weight_vectorized_parallel_2(
+    const VectorXf& prices,
+    const MatrixXf& position_matrix,
+    float initial_cash,
+    std::string trade_mode,
+    float max_allocation_pct,
+    float fixed_cash_amount,
+    float position_size
+){
+    return run_multi_weight_vectorized_parallel_2(prices, position_matrix, initial_cash, parse_trade_mode(trade_mode),
+                                                  max_allocation_pct, fixed_cash_amount, position_size);
+}
+
+template <TradeMode Mode>
 inline std::tuple<MatrixXf, MatrixXf, MatrixXf> 
-run_multi_weight_vectorized_eigen(
+run_multi_weight_vectorized_eigen_impl(
     const VectorXf& prices,  // 价格序列 (n_timestamps,)
     const MatrixXf& position_matrix,  // 持仓矩阵 (n_timestamps, n_weights)
     float initial_cash,  // 初始现金
-    std::string trade_mode,  // 默认交易模式为 portfolio_pct
     float max_allocation_pct,  // 最大仓位比例
     float fixed_cash_amount,  // 固定现金金额
     float position_size  // 固定仓位大小
@@ -725,20 +865,18 @@ run_multi_weight_vectorized_eigen(
         if (has_buys) {
             Array<float, 1, Dynamic> buy_qty(1, n_weights);
             buy_qty.setZero();
-            if (trade_mode == "fixed"){
+            if constexpr (Mode == TradeMode::FIXED){
                 buy_qty.setConstant(position_size);
-            } else if (trade_mode == "cash_all"){
+            } else if constexpr (Mode == TradeMode::CASH_ALL){
                 buy_qty = (cash_matrix.row(idx).array() / price32).floor();
-            } else if (trade_mode == "portfolio_pct"){
+            } else if constexpr (Mode == TradeMode::PORTFOLIO_PCT){
                 Array<float, 1, Dynamic> portfolio_val = cash_matrix.row(idx).array() + real_position_matrix.row(idx).array() * price32;
                 Array<float, 1, Dynamic> max_pos = (portfolio_val * max_allocation_pct / price32).floor();
                 buy_qty = (max_pos - real_position_matrix.row(idx).array())
                               .max(0.0f)
                               .min((cash_matrix.row(idx).array() / price32).floor());
-            } else if (trade_mode == "fixed_cash"){
-                buy_qty.setConstant(std::floor(fixed_cash_amount / price32));
             } else {
-                buy_qty.setConstant(position_size);
+                buy_qty.setConstant(std::floor(fixed_cash_amount / price32));
             }
 
             // 仅对买入信号生效
@@ -768,3 +906,33 @@ run_multi_weight_vectorized_eigen(
     return std::make_tuple(portfolio_value_matrix, cash_matrix, real_position_matrix);
 }
 
+inline std::tuple<MatrixXf, MatrixXf, MatrixXf> 
+run_multi_weight_vectorized_eigen(
+    const VectorXf& prices,
+    const MatrixXf& position_matrix,
+    float initial_cash,
+    TradeMode trade_mode,
+    float max_allocation_pct,
+    float fixed_cash_amount,
+    float position_size
+) {
+    return dispatch_trade_mode(trade_mode, [&](auto mode){
+        return run_multi_weight_vectorized_eigen_impl<decltype(mode)::value>(
+            prices, position_matrix, initial_cash, max_allocation_pct, fixed_cash_amount, position_size);
+    });
+}
+
+inline std::tuple<MatrixXf, MatrixXf, MatrixXf> 
+run_multi_weight_vectorized_eigen(
+    const VectorXf& prices,
+    const MatrixXf& position_matrix,
+    float initial_cash,
+    std::string trade_mode,
+    float max_allocation_pct,
+    float fixed_cash_amount,
+    float position_size
+) {
+    return run_multi_weight_vectorized_eigen(prices, position_matrix, initial_cash, parse_trade_mode(trade_mode),
+                                             max_allocation_pct, fixed_cash_amount, position_size);
+}
+
@@ -0,0 +1,317 @@
+#pragma once
+#include <Eigen/Dense>
+#include "backtest_output.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace Eigen;
+
+// -------------------- 二进制结果输出（NPY / NPZ / 文件映射） --------------------
+// save_matrix_csv 逐个 float 文本格式化，100k×1000 的结果保存比计算还慢；这里直接写 NumPy 格式：
+//   save_matrix_npy / load_matrix_npy   单个矩阵，NPY 1.0，fortran_order=True，Eigen 列主序内存原样写出
+//   save_npz / save_full_output_npz     多个数组打包为 .npz（zip 不压缩），键名与 output/*.npz 一致
+//   NpyOutput                           回测输出策略：三个结果矩阵直接写进文件映射的 .npy，
+//                                       每个行块结束后回写并释放该行块的页，常驻内存与结果总大小无关
+// 头部按 NumPy 的做法补齐到 64 字节，数据区对齐，np.load(path, mmap_mode='r') 可直接映射读取。
+
+const int DEFAULT_NPY_CHUNK_ROWS = 4096;  // NpyOutput 每个行块的时间步数（每列 16KB，按页回写）
+
+inline std::runtime_error npy_io_error(const std::string& what, const std::string& filename){
+    return std::runtime_error(what + " " + filename + ": " + std::strerror(errno));
+}
+
+// NPY 1.0 头部：魔数 + 版本 + 头长度 + 字典，空格补齐、换行结尾，总长为 64 的倍数
+inline std::string npy_header(const char* descr, const std::vector<long long>& shape, bool fortran_order){
+    std::string dict = std::string("{'descr': '") + descr + "', 'fortran_order': " +
+                       (fortran_order ? "True" : "False") + ", 'shape': (";
+    for(size_t i=0; i<shape.size(); ++i){
+        dict += std::to_string(shape[i]);
+        if(shape.size() == 1 || i + 1 < shape.size()) dict += ",";
+        if(i + 1 < shape.size()) dict += " ";
+    }
+    dict += "), }";
+    const size_t prefix = 10;  // 魔数 6 + 版本 2 + 头长度 2
+    size_t total = prefix + dict.size() + 1;
+    total = (total + 63) / 64 * 64;
+    dict.append(total - prefix - dict.size() - 1, ' ');
+    dict += '\n';
+    const uint16_t header_len = (uint16_t)dict.size();
+    std::string header("\x93NUMPY\x01\x00", 8);
+    header += (char)(header_len & 0xff);
+    header += (char)(header_len >> 8);
+    return header + dict;
+}
+
+inline void write_all(std::FILE* file, const void* data, size_t bytes, const std::string& filename){
+    if(bytes > 0 && std::fwrite(data, 1, bytes, file) != bytes)
+        throw npy_io_error("写入失败", filename);
+}
+
+inline void save_matrix_npy(const Ref<const MatrixXf>& mat, const std::string& filename){
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if(!file) throw npy_io_error("无法创建", filename);
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> guard(file, std::fclose);
+    const std::string header = npy_header("<f4", {(long long)mat.rows(), (long long)mat.cols()}, true);
+    write_all(file, header.data(), header.size(), filename);
+    // Ref 的外步长可能大于行数（如 topRows），逐列写
+    if(mat.outerStride() == mat.rows()){
+        write_all(file, mat.data(), sizeof(float) * mat.size(), filename);
+    } else {
+        for(Index c=0; c<mat.cols(); ++c)
+            write_all(file, mat.col(c).data(), sizeof(float) * mat.rows(), filename);
+    }
+    if(std::fclose(guard.release()) != 0) throw npy_io_error("写入失败", filename);
+}
+
+// 读取 float32 二维 .npy（C 序或 F 序）
+inline MatrixXf load_matrix_npy(const std::string& filename){
+    std::FILE* file = std::fopen(filename.c_str(), "rb");
+    if(!file) throw npy_io_error("无法打开", filename);
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> guard(file, std::fclose);
+    unsigned char prefix[10];
+    if(std::fread(prefix, 1, sizeof(prefix), file) != sizeof(prefix) || std::memcmp(prefix, "\x93NUMPY\x01", 7) != 0)
+        throw std::invalid_argument("不是 NPY 1.0 文件: " + filename);
+    std::string dict(prefix[8] | (prefix[9] << 8), '\0');
+    if(std::fread(&dict[0], 1, dict.size(), file) != dict.size())
+        throw std::invalid_argument("NPY 头部不完整: " + filename);
+    if(dict.find("'descr': '<f4'") == std::string::npos)
+        throw std::invalid_argument("仅支持 float32 (<f4) 数组: " + filename);
+    const bool fortran_order = dict.find("'fortran_order': True") != std::string::npos;
+    long long rows = 0, cols = 0;
+    const size_t shape = dict.find("'shape': (");
+    if(shape == std::string::npos || std::sscanf(dict.c_str() + shape + 10, "%lld, %lld", &rows, &cols) != 2)
+        throw std::invalid_argument("仅支持二维数组: " + filename);
+
+    MatrixXf mat(rows, cols);
+    const size_t count = (size_t)rows * cols;
+    if(fortran_order){
+        if(std::fread(mat.data(), sizeof(float), count, file) != count)
+            throw std::invalid_argument("NPY 数据不完整: " + filename);
+    } else {
+        Matrix<float, Dynamic, Dynamic, RowMajor> row_major(rows, cols);
+        if(std::fread(row_major.data(), sizeof(float), count, file) != count)
+            throw std::invalid_argument("NPY 数据不完整: " + filename);
+        mat = row_major;
+    }
+    return mat;
+}
+
+// -------------------- NPZ（zip，不压缩） --------------------
+inline uint32_t crc32_update(uint32_t crc, const void* data, size_t bytes){
+    static const std::vector<uint32_t> table = []{
+        std::vector<uint32_t> t(256);
+        for(uint32_t i=0; i<256; ++i){
+            uint32_t c = i;
+            for(int k=0; k<8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    for(size_t i=0; i<bytes; ++i) crc = table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+// 一个 npz 成员：name 不含 .npy 后缀；data 为 header 描述的原始字节
+struct NpzEntry {
+    std::string name;
+    std::string header;
+    const void* data;
+    size_t bytes;
+};
+
+inline NpzEntry npz_matrix(const std::string& name, const MatrixXf& mat){
+    return NpzEntry{name, npy_header("<f4", {(long long)mat.rows(), (long long)mat.cols()}, true),
+                    mat.data(), sizeof(float) * (size_t)mat.size()};
+}
+
+inline NpzEntry npz_vector(const std::string& name, const VectorXf& vec){
+    return NpzEntry{name, npy_header("<f4", {(long long)vec.size()}, false), vec.data(), sizeof(float) * (size_t)vec.size()};
+}
+
+// 0 维 int64 标量（如 n_timestamps），value 需在写出前保持有效
+inline NpzEntry npz_scalar(const std::string& name, const long long& value){
+    return NpzEntry{name, npy_header("<i8", {}, false), &value, sizeof(value)};
+}
+
+// 不用 ZIP64：单个成员和整个文件都须小于 4GB，更大的结果用 NpyOutput 写独立的 .npy
+inline void save_npz(const std::string& filename, const std::vector<NpzEntry>& entries){
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if(!file) throw npy_io_error("无法创建", filename);
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> guard(file, std::fclose);
+
+    std::string central;
+    uint64_t offset = 0;
+    auto put16 = [](std::string& s, uint32_t v){ s += (char)(v & 0xff); s += (char)((v >> 8) & 0xff); };
+    auto put32 = [&](std::string& s, uint32_t v){ put16(s, v & 0xffff); put16(s, v >> 16); };
+
+    for(const NpzEntry& entry : entries){
+        const std::string member = entry.name + ".npy";
+        const uint64_t size = entry.header.size() + entry.bytes;
+        if(offset + size + 30 + member.size() >= 0xFFFFFFFFull)
+            throw std::invalid_argument("npz 超过 4GB，请改用 NpyOutput 写 .npy: " + filename);
+        const uint32_t crc = crc32_update(crc32_update(0, entry.header.data(), entry.header.size()), entry.data, entry.bytes);
+
+        // 本地文件头：版本 2.0，存储（不压缩），时间字段为 1980-01-01
+        std::string local;
+        put32(local, 0x04034b50); put16(local, 20); put16(local, 0); put16(local, 0);
+        put16(local, 0); put16(local, 0x21);
+        put32(local, crc); put32(local, (uint32_t)size); put32(local, (uint32_t)size);
+        put16(local, member.size()); put16(local, 0);
+        local += member;
+        write_all(file, local.data(), local.size(), filename);
+        write_all(file, entry.header.data(), entry.header.size(), filename);
+        write_all(file, entry.data, entry.bytes, filename);
+
+        put32(central, 0x02014b50); put16(central, 20); put16(central, 20); put16(central, 0); put16(central, 0);
+        put16(central, 0); put16(central, 0x21);
+        put32(central, crc); put32(central, (uint32_t)size); put32(central, (uint32_t)size);
+        put16(central, member.size()); put16(central, 0); put16(central, 0); put16(central, 0); put16(central, 0);
+        put32(central, 0); put32(central, (uint32_t)offset);
+        central += member;
+        offset += local.size() + size;
+    }
+
+    std::string end;
+    put32(end, 0x06054b50); put16(end, 0); put16(end, 0);
+    put16(end, entries.size()); put16(end, entries.size());
+    put32(end, central.size()); put32(end, (uint32_t)offset); put16(end, 0);
+    write_all(file, central.data(), central.size(), filename);
+    write_all(file, end.data(), end.size(), filename);
+    if(std::fclose(guard.release()) != 0) throw npy_io_error("写入失败", filename);
+}
+
+// 完整输出 → .npz，键名与 Python 侧输出（test_cases/view_results.py 读取）一致
+inline void save_full_output_npz(const std::string& filename, const FullOutput& output, const VectorXf* prices = nullptr){
+    const long long n_timestamps = output.portfolio_values.rows();
+    const long long n_weights = output.portfolio_values.cols();
+    std::vector<NpzEntry> entries = {
+        npz_matrix("portfolio_values", output.portfolio_values),
+        npz_matrix("cash_matrix", output.cash_matrix),
+        npz_matrix("quantity_matrix", output.quantity_matrix),
+        npz_scalar("n_timestamps", n_timestamps),
+        npz_scalar("n_weights", n_weights),
+    };
+    if(prices) entries.push_back(npz_vector("prices", *prices));
+    save_npz(filename, entries);
+}
+
+// -------------------- 文件映射的 .npy 矩阵 --------------------
+// 创建 (rows, cols) float32 F 序 .npy 并整体映射（MAP_SHARED），写入即落到页缓存，由内核异步回写
+class NpyMmapMatrix {
+public:
+    NpyMmapMatrix(const std::string& filename, int rows, int cols) : filename_(filename), rows_(rows), cols_(cols) {
+        if(rows < 0 || cols < 0)
+            throw std::invalid_argument("矩阵维度不能为负: " + std::to_string(rows) + "x" + std::to_string(cols));
+        const std::string header = npy_header("<f4", {(long long)rows, (long long)cols}, true);
+        header_bytes_ = header.size();
+        bytes_ = header_bytes_ + sizeof(float) * (size_t)rows * cols;
+
+        fd_ = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if(fd_ < 0) throw npy_io_error("无法创建", filename);
+        if(::ftruncate(fd_, bytes_) != 0){ ::close(fd_); throw npy_io_error("无法扩展文件", filename); }
+        void* p = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if(p == MAP_FAILED){ ::close(fd_); throw npy_io_error("无法映射", filename); }
+        base_ = static_cast<char*>(p);
+        std::memcpy(base_, header.data(), header_bytes_);
+    }
+    ~NpyMmapMatrix(){ close(); }
+    NpyMmapMatrix(const NpyMmapMatrix&) = delete;
+    NpyMmapMatrix& operator=(const NpyMmapMatrix&) = delete;
+
+    float* data(){ return reinterpret_cast<float*>(base_ + header_bytes_); }
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    const std::string& filename() const { return filename_; }
+
+    // 行块 [row_begin, row_end) 已写完：发起回写并把这些页移出本进程（数据留在页缓存），控制常驻内存
+    void release_rows(int row_begin, int row_end){
+        if(!base_ || row_end <= row_begin) return;
+        const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        for(int c=0; c<cols_; ++c){
+            const size_t begin = header_bytes_ + sizeof(float) * ((size_t)c * rows_ + row_begin);
+            const size_t end = header_bytes_ + sizeof(float) * ((size_t)c * rows_ + row_end);
+            const size_t aligned = begin / page * page;
+            ::msync(base_ + aligned, end - aligned, MS_ASYNC);
+            ::madvise(base_ + aligned, end - aligned, MADV_DONTNEED);
+        }
+    }
+
+    // 解除映射并关闭；之后文件即为完整的 .npy
+    void close(){
+        if(base_){
+            ::munmap(base_, bytes_);
+            base_ = nullptr;
+        }
+        if(fd_ >= 0){
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+private:
+    std::string filename_;
+    int rows_;
+    int cols_;
+    size_t header_bytes_ = 0;
+    size_t bytes_ = 0;
+    int fd_ = -1;
+    char* base_ = nullptr;
+};
+
+// 流式输出策略：结果写进 {prefix}portfolio_values.npy / cash_matrix.npy / quantity_matrix.npy，
+// 每 chunk_rows 行回写并释放一次；结果大于内存也不需要在内存里保留完整副本
+struct NpyOutput {
+    explicit NpyOutput(std::string prefix, int chunk_rows = DEFAULT_NPY_CHUNK_ROWS)
+        : prefix_(std::move(prefix)), chunk_rows_(chunk_rows > 0 ? chunk_rows : DEFAULT_NPY_CHUNK_ROWS) {}
+
+    int chunk_rows() const { return chunk_rows_; }
+    void begin(int n_timestamps, int n_weights){
+        n_timestamps_ = n_timestamps;
+        portfolio_ = std::make_unique<NpyMmapMatrix>(prefix_ + "portfolio_values.npy", n_timestamps, n_weights);
+        cash_ = std::make_unique<NpyMmapMatrix>(prefix_ + "cash_matrix.npy", n_timestamps, n_weights);
+        quantity_ = std::make_unique<NpyMmapMatrix>(prefix_ + "quantity_matrix.npy", n_timestamps, n_weights);
+        portfolio_data_ = portfolio_->data();
+        cash_data_ = cash_->data();
+        quantity_data_ = quantity_->data();
+    }
+    void begin_chunk(int, int){}
+    void record(int col, int idx, float portfolio, float cash, float qty){
+        const size_t k = (size_t)col * n_timestamps_ + idx;
+        portfolio_data_[k] = portfolio;
+        cash_data_[k] = cash;
+        quantity_data_[k] = qty;
+    }
+    void end_chunk(int row_begin, int row_end){
+        portfolio_->release_rows(row_begin, row_end);
+        cash_->release_rows(row_begin, row_end);
+        quantity_->release_rows(row_begin, row_end);
+    }
+
+    // 回测结束后调用（析构时也会调用）
+    void close(){
+        if(portfolio_) portfolio_->close();
+        if(cash_) cash_->close();
+        if(quantity_) quantity_->close();
+    }
+
+private:
+    std::string prefix_;
+    int chunk_rows_;
+    int n_timestamps_ = 0;
+    std::unique_ptr<NpyMmapMatrix> portfolio_, cash_, quantity_;
+    float* portfolio_data_ = nullptr;
+    float* cash_data_ = nullptr;
+    float* quantity_data_ = nullptr;
+};
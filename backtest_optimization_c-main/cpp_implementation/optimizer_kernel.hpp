@@ -0,0 +1,36 @@
+#pragma once
+#include <Eigen/Dense>
+#include "signal_processor.hpp"
+#include "metrics.hpp"
+
+using namespace Eigen;
+
+// -------------------- 优化器核心 --------------------
+// 与 reference_impl/optimization_kernel.py 一致：信号组合 → 回测 → 夏普比率。
+// 走融合流水线 + 融合指标，不物化持仓矩阵和组合价值矩阵，内存 O(W)。
+
+// 批量评估权重组合，返回夏普比率 (n_candidates,)
+template <typename WeightsDerived, typename SignalDerived>
+inline VectorXf evaluate_weights_batch(
+    const MatrixBase<WeightsDerived>& weights_batch,  // (n_signals, n_candidates)
+    const MatrixBase<SignalDerived>& signal_matrix,   // (n_timestamps, n_signals)
+    const Ref<const VectorXf>& prices,                // (n_timestamps,)
+    float threshold,
+    const BacktestConfig& config,
+    float annualization_factor = DEFAULT_ANNUALIZATION_FACTOR
+){
+    MetricsOutput output(annualization_factor);
+    run_signal_backtest(prices, signal_matrix, weights_batch, threshold, config, output);
+    return output.metrics().sharpe_ratio;
+}
+
+// 单个权重组合评估（便捷接口）
+inline float evaluate_single_weight(
+    const VectorXf& weights,
+    const MatrixXf& signal_matrix,
+    const Ref<const VectorXf>& prices,
+    float threshold,
+    const BacktestConfig& config
+){
+    return evaluate_weights_batch(weights, signal_matrix, prices, threshold, config)(0);
+}
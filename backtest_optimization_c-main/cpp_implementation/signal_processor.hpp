@@ -0,0 +1,127 @@
+#pragma once
+#include <Eigen/Dense>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <algorithm>
+#include "column_blocked_backtest.hpp"
+
+using namespace Eigen;
+
+// -------------------- 信号组合处理 --------------------
+// 与 reference_impl/signal_combination.py 一致：
+//   combined    = signal_matrix (T×S) @ weights_matrix (S×W)
+//   long_short  = combined > threshold → 1；combined < -threshold → -1；其他 → 0
+//   position[t] = long_short[t-1]，position[0] = 0（今日信号，明日持仓）
+
+const float DEFAULT_SIGNAL_THRESHOLD = 0.5f;
+const int DEFAULT_SIGNAL_TILE_ROWS = 128;  // 融合流水线每次计算的时间步数
+
+template <typename SignalDerived, typename WeightsDerived>
+inline void check_signal_dims(const MatrixBase<SignalDerived>& signal_matrix, const MatrixBase<WeightsDerived>& weights_matrix){
+    if(signal_matrix.cols() != weights_matrix.rows())
+        throw std::invalid_argument("信号矩阵列数 (" + std::to_string(signal_matrix.cols()) +
+                                    ") 与权重矩阵行数 (" + std::to_string(weights_matrix.rows()) + ") 不匹配");
+}
+
+// 参考实现：物化 combined / long_short / position 三个 T×W 矩阵
+// 输入可为任意 Eigen 稠密矩阵或 Map（列主序/行主序均可，不拷贝）；PositionScalar 为多空/持仓矩阵的元素类型
+template <typename PositionScalar = int, typename SignalDerived, typename WeightsDerived>
+inline std::tuple<MatrixXf, Matrix<PositionScalar, Dynamic, Dynamic>, Matrix<PositionScalar, Dynamic, Dynamic>>
+process_signals(
+    const MatrixBase<SignalDerived>& signal_matrix,   // (n_timestamps, n_signals)
+    const MatrixBase<WeightsDerived>& weights_matrix,  // (n_signals, n_weights)
+    float threshold = DEFAULT_SIGNAL_THRESHOLD
+){
+    using PositionMatrix = Matrix<PositionScalar, Dynamic, Dynamic>;
+    check_signal_dims(signal_matrix, weights_matrix);
+    const int n_timestamps = signal_matrix.rows();
+    const int n_weights = weights_matrix.cols();
+
+    MatrixXf combined_signals = signal_matrix * weights_matrix;
+    PositionMatrix long_short_matrix = (combined_signals.array() > threshold).template cast<PositionScalar>()
+                                     - (combined_signals.array() < -threshold).template cast<PositionScalar>();
+
+    PositionMatrix position_matrix(n_timestamps, n_weights);
+    if(n_timestamps > 0){
+        position_matrix.row(0).setZero();
+        position_matrix.bottomRows(n_timestamps - 1) = long_short_matrix.topRows(n_timestamps - 1);
+    }
+
+    return std::make_tuple(std::move(combined_signals), std::move(long_short_matrix), std::move(position_matrix));
+}
+
+// 融合持仓来源：在列分块引擎内按 (tile_rows × 列块) 现算持仓，
+// 每块是一次 (tile_rows×S)·(S×block) 的小 GEMM，结果留在线程私有缓冲区（L1/L2）内直接喂给交易逻辑。
+// 不物化 T×W 的 combined / position 矩阵，省掉写出再读回的带宽。
+template <typename SignalMatrix = MatrixXf, typename WeightsMatrix = MatrixXf>
+struct SignalPositionSource {
+    const SignalMatrix& signal_matrix;
+    const WeightsMatrix& weights_matrix;
+    float threshold;
+    int rows_per_tile;
+
+    struct TileBuffer {
+        MatrixXf positions;  // (tile_rows, block)，跨块复用，不逐块分配
+    };
+    int n_timestamps() const { return signal_matrix.rows(); }
+    int n_weights() const { return weights_matrix.cols(); }
+    int tile_rows() const { return rows_per_tile; }
+
+    PositionTile tile(int row_begin, int row_end, int col_begin, int col_end, TileBuffer& buffer) const {
+        const int rows = row_end - row_begin;
+        const int cols = col_end - col_begin;
+        if(buffer.positions.rows() < rows || buffer.positions.cols() < cols)
+            buffer.positions.resize(std::max<Index>(rows, buffer.positions.rows()),
+                                    std::max<Index>(cols, buffer.positions.cols()));
+
+        // position[t] 取 combined[t-1]；第 0 行持仓恒为 0
+        const int lead = row_begin == 0 ? 1 : 0;
+        auto tile_block = buffer.positions.block(0, 0, rows, cols);
+        if(lead) tile_block.row(0).setZero();
+
+        auto combined = tile_block.bottomRows(rows - lead);
+        combined.noalias() = signal_matrix.middleRows(row_begin + lead - 1, rows - lead)
+                           * weights_matrix.middleCols(col_begin, cols);
+        combined.array() = (combined.array() > threshold).template cast<float>()
+                         - (combined.array() < -threshold).template cast<float>();
+
+        return PositionTile{buffer.positions.data(), buffer.positions.rows()};
+    }
+};
+
+// 融合流水线：信号组合 → 阈值 → 滞后 → 回测，一次完成（输出策略版本）
+template <typename Output, typename SignalDerived, typename WeightsDerived>
+inline void run_signal_backtest(
+    const Ref<const VectorXf>& prices,
+    const MatrixBase<SignalDerived>& signal_matrix,
+    const MatrixBase<WeightsDerived>& weights_matrix,
+    float threshold,
+    const BacktestConfig& config,
+    Output& output,
+    int column_block = DEFAULT_COLUMN_BLOCK,
+    int tile_rows = DEFAULT_SIGNAL_TILE_ROWS
+){
+    check_signal_dims(signal_matrix, weights_matrix);
+    if(signal_matrix.rows() != prices.size())
+        throw std::invalid_argument("信号矩阵时间步数与价格序列长度不匹配");
+
+    const SignalPositionSource<SignalDerived, WeightsDerived> source{
+        signal_matrix.derived(), weights_matrix.derived(), threshold,
+        tile_rows > 0 ? tile_rows : DEFAULT_SIGNAL_TILE_ROWS};
+    run_column_blocked_source(prices, source, config, output, column_block);
+}
+
+// 融合流水线（返回完整矩阵）
+inline std::tuple<MatrixXf, MatrixXf, MatrixXf>
+run_signal_backtest(
+    const Ref<const VectorXf>& prices,
+    const MatrixXf& signal_matrix,
+    const MatrixXf& weights_matrix,
+    float threshold = DEFAULT_SIGNAL_THRESHOLD,
+    const BacktestConfig& config = BacktestConfig()
+){
+    FullOutput output;
+    run_signal_backtest(prices, signal_matrix, weights_matrix, threshold, config, output);
+    return output.to_tuple();
+}
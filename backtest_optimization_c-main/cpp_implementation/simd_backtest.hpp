@@ -0,0 +1,429 @@
+#pragma once
+#include "column_blocked_backtest.hpp"
+
+#include <stdexcept>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define BACKTEST_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define BACKTEST_X86_SIMD 0
+#endif
+
+// -------------------- 显式 SIMD 列分块回测引擎 --------------------
+// 在列分块引擎的基础上，把一个列块内的若干权重列放进 SIMD 通道同时推进（AVX2 8 路 / AVX-512 16 路）：
+// 买卖判断用比较掩码 + blend 代替分支，floor / min / max 直接用向量指令，没有 Array<bool> 和临时数组。
+// 每个线程的暂存区在回测开始时分配一次，时间循环内没有堆分配。
+// 指令集在运行时按 CPU 选择（__builtin_cpu_supports），不支持时退回逐通道标量实现。
+// 逐步逻辑与 step_single_column / run_multi_weight_vectorized_eigen 一致，后者保留作参考实现。
+// 注意：标量 / AVX2 路径是否把乘加合并为 FMA 取决于编译选项（-mfma 下 GCC 默认合并），AVX-512 路径不合并；
+// 因此默认编译下各路径结果只在浮点舍入意义上一致，-ffp-contract=off 编译时逐位一致。
+
+const int SIMD_LANE_ALIGN = 16;        // 列块通道数按 16 对齐（AVX-512 一个寄存器）
+const int DEFAULT_SIMD_TILE_ROWS = 64; // 每次转置 / 推进的时间步数
+
+enum class SimdIsa {
+    AUTO,
+    SCALAR,
+    AVX2,
+    AVX512
+};
+
+inline const char* simd_isa_name(SimdIsa isa){
+    switch(isa){
+        case SimdIsa::SCALAR: return "scalar";
+        case SimdIsa::AVX2: return "avx2";
+        case SimdIsa::AVX512: return "avx512";
+        default: return "auto";
+    }
+}
+
+// 当前 CPU 可用的最高指令集
+inline SimdIsa detect_simd_isa(){
+#if BACKTEST_X86_SIMD
+    if(__builtin_cpu_supports("avx512f")) return SimdIsa::AVX512;
+    if(__builtin_cpu_supports("avx2")) return SimdIsa::AVX2;
+#endif
+    return SimdIsa::SCALAR;
+}
+
+// 一个 (rows × lanes) 小块的输入输出，均为行主序：第 r 步第 c 通道位于 [r * lanes + c]
+struct SimdTileArgs {
+    const float* prices;     // (rows,)
+    const float* positions;  // (rows, lanes)
+    float* portfolio_out;    // (rows, lanes)
+    float* cash_out;         // (rows, lanes)
+    float* qty_out;          // (rows, lanes)
+    float* cash;             // (lanes,) 跨块状态，原地更新
+    float* qty;              // (lanes,)
+    float* prev_pos;         // (lanes,)
+    int rows;
+    int lanes;               // SIMD_LANE_ALIGN 的整数倍
+    float max_allocation_pct;
+    float fixed_cash_amount;
+    float position_size;
+};
+
+using SimdTileKernel = void (*)(const SimdTileArgs&);
+
+// 逐通道标量实现（无 AVX2 时使用），与向量版本同样无分支
+template <TradeMode Mode>
+inline void simd_tile_scalar(const SimdTileArgs& a){
+    for(int r=0; r<a.rows; ++r){
+        const float price = a.prices[r];
+        const float fixed_qty = std::floor(a.fixed_cash_amount / price);
+        const float* pos_row = a.positions + (Index)r * a.lanes;
+        for(int c=0; c<a.lanes; ++c){
+            float cash = a.cash[c];
+            float qty = a.qty[c];
+            const float change = pos_row[c] - a.prev_pos[c];
+            const float affordable = std::floor(cash / price);
+
+            float buy_qty;
+            if constexpr (Mode == TradeMode::FIXED){
+                buy_qty = a.position_size;
+            } else if constexpr (Mode == TradeMode::CASH_ALL){
+                buy_qty = affordable;
+            } else if constexpr (Mode == TradeMode::PORTFOLIO_PCT){
+                const float max_pos = std::floor((cash + qty * price) * a.max_allocation_pct / price);
+                buy_qty = std::max(0.0f, std::min(max_pos - qty, affordable));
+            } else {
+                buy_qty = fixed_qty;
+            }
+            buy_qty = change > 0 ? std::min(buy_qty, affordable) : 0.0f;
+            cash -= buy_qty * price;
+            qty += buy_qty;
+            if(change < 0){
+                cash += qty * price;
+                qty = 0.0f;
+            }
+
+            a.cash[c] = cash;
+            a.qty[c] = qty;
+            a.prev_pos[c] = pos_row[c];
+            a.portfolio_out[(Index)r * a.lanes + c] = cash + qty * price;
+            a.cash_out[(Index)r * a.lanes + c] = cash;
+            a.qty_out[(Index)r * a.lanes + c] = qty;
+        }
+    }
+}
+
+#if BACKTEST_X86_SIMD
+// AVX2：每条指令 8 个权重
+template <TradeMode Mode>
+__attribute__((target("avx2")))
+void simd_tile_avx2(const SimdTileArgs& a){
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 pct = _mm256_set1_ps(a.max_allocation_pct);
+    const __m256 size = _mm256_set1_ps(a.position_size);
+    for(int r=0; r<a.rows; ++r){
+        const __m256 price = _mm256_set1_ps(a.prices[r]);
+        const __m256 fixed_qty = _mm256_set1_ps(std::floor(a.fixed_cash_amount / a.prices[r]));
+        const Index row = (Index)r * a.lanes;
+        for(int c=0; c<a.lanes; c+=8){
+            __m256 cash = _mm256_loadu_ps(a.cash + c);
+            __m256 qty = _mm256_loadu_ps(a.qty + c);
+            const __m256 pos = _mm256_loadu_ps(a.positions + row + c);
+            const __m256 change = _mm256_sub_ps(pos, _mm256_loadu_ps(a.prev_pos + c));
+            const __m256 buy_mask = _mm256_cmp_ps(change, zero, _CMP_GT_OQ);
+            const __m256 sell_mask = _mm256_cmp_ps(change, zero, _CMP_LT_OQ);
+            const __m256 affordable = _mm256_floor_ps(_mm256_div_ps(cash, price));
+
+            __m256 buy_qty;
+            if constexpr (Mode == TradeMode::FIXED){
+                buy_qty = size;
+            } else if constexpr (Mode == TradeMode::CASH_ALL){
+                buy_qty = affordable;
+            } else if constexpr (Mode == TradeMode::PORTFOLIO_PCT){
+                const __m256 portfolio = _mm256_add_ps(cash, _mm256_mul_ps(qty, price));
+                const __m256 max_pos = _mm256_floor_ps(_mm256_div_ps(_mm256_mul_ps(portfolio, pct), price));
+                buy_qty = _mm256_max_ps(_mm256_min_ps(_mm256_sub_ps(max_pos, qty), affordable), zero);
+            } else {
+                buy_qty = fixed_qty;
+            }
+            buy_qty = _mm256_and_ps(_mm256_min_ps(buy_qty, affordable), buy_mask);
+            cash = _mm256_sub_ps(cash, _mm256_mul_ps(buy_qty, price));
+            qty = _mm256_add_ps(qty, buy_qty);
+            cash = _mm256_blendv_ps(cash, _mm256_add_ps(cash, _mm256_mul_ps(qty, price)), sell_mask);
+            qty = _mm256_andnot_ps(sell_mask, qty);
+
+            _mm256_storeu_ps(a.cash + c, cash);
+            _mm256_storeu_ps(a.qty + c, qty);
+            _mm256_storeu_ps(a.prev_pos + c, pos);
+            _mm256_storeu_ps(a.portfolio_out + row + c, _mm256_add_ps(cash, _mm256_mul_ps(qty, price)));
+            _mm256_storeu_ps(a.cash_out + row + c, cash);
+            _mm256_storeu_ps(a.qty_out + row + c, qty);
+        }
+    }
+}
+
+// 显式舍入版本的乘加减是独立的内建指令，编译器不会把它们合并为 FMA
+#define BACKTEST_AVX512_EXACT(op) \
+    __attribute__((target("avx512f"))) inline __m512 op##_exact(__m512 a, __m512 b){ \
+        return _mm512_##op##_round_ps(a, b, _MM_FROUND_CUR_DIRECTION); }
+BACKTEST_AVX512_EXACT(mul)
+BACKTEST_AVX512_EXACT(add)
+BACKTEST_AVX512_EXACT(sub)
+#undef BACKTEST_AVX512_EXACT
+
+// AVX-512：每条指令 16 个权重，掩码寄存器直接做 blend
+template <TradeMode Mode>
+__attribute__((target("avx512f")))
+void simd_tile_avx512(const SimdTileArgs& a){
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 pct = _mm512_set1_ps(a.max_allocation_pct);
+    const __m512 size = _mm512_set1_ps(a.position_size);
+    for(int r=0; r<a.rows; ++r){
+        const __m512 price = _mm512_set1_ps(a.prices[r]);
+        const __m512 fixed_qty = _mm512_set1_ps(std::floor(a.fixed_cash_amount / a.prices[r]));
+        const Index row = (Index)r * a.lanes;
+        for(int c=0; c<a.lanes; c+=16){
+            __m512 cash = _mm512_loadu_ps(a.cash + c);
+            __m512 qty = _mm512_loadu_ps(a.qty + c);
+            const __m512 pos = _mm512_loadu_ps(a.positions + row + c);
+            const __m512 change = sub_exact(pos, _mm512_loadu_ps(a.prev_pos + c));
+            const __mmask16 buy_mask = _mm512_cmp_ps_mask(change, zero, _CMP_GT_OQ);
+            const __mmask16 sell_mask = _mm512_cmp_ps_mask(change, zero, _CMP_LT_OQ);
+            const __m512 affordable = _mm512_roundscale_ps(_mm512_div_ps(cash, price),
+                                                           _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+
+            __m512 buy_qty;
+            if constexpr (Mode == TradeMode::FIXED){
+                buy_qty = size;
+            } else if constexpr (Mode == TradeMode::CASH_ALL){
+                buy_qty = affordable;
+            } else if constexpr (Mode == TradeMode::PORTFOLIO_PCT){
+                const __m512 portfolio = add_exact(cash, mul_exact(qty, price));
+                const __m512 max_pos = _mm512_roundscale_ps(_mm512_div_ps(mul_exact(portfolio, pct), price),
+                                                            _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+                buy_qty = _mm512_max_ps(_mm512_min_ps(sub_exact(max_pos, qty), affordable), zero);
+            } else {
+                buy_qty = fixed_qty;
+            }
+            buy_qty = _mm512_maskz_mov_ps(buy_mask, _mm512_min_ps(buy_qty, affordable));
+            cash = sub_exact(cash, mul_exact(buy_qty, price));
+            qty = add_exact(qty, buy_qty);
+            cash = _mm512_mask_add_ps(cash, sell_mask, cash, mul_exact(qty, price));
+            qty = _mm512_mask_mov_ps(qty, sell_mask, zero);
+
+            _mm512_storeu_ps(a.cash + c, cash);
+            _mm512_storeu_ps(a.qty + c, qty);
+            _mm512_storeu_ps(a.prev_pos + c, pos);
+            _mm512_storeu_ps(a.portfolio_out + row + c, add_exact(cash, mul_exact(qty, price)));
+            _mm512_storeu_ps(a.cash_out + row + c, cash);
+            _mm512_storeu_ps(a.qty_out + row + c, qty);
+        }
+    }
+}
+#endif
+
+// 按指令集选择小块内核；请求的指令集 CPU 不支持时抛 std::invalid_argument
+template <TradeMode Mode>
+inline SimdTileKernel select_simd_tile_kernel(SimdIsa isa){
+    const SimdIsa available = detect_simd_isa();
+    if(isa == SimdIsa::AUTO) isa = available;
+    if((int)isa > (int)available)
+        throw std::invalid_argument(std::string("当前 CPU 不支持指令集: ") + simd_isa_name(isa));
+#if BACKTEST_X86_SIMD
+    if(isa == SimdIsa::AVX512) return simd_tile_avx512<Mode>;
+    if(isa == SimdIsa::AVX2) return simd_tile_avx2<Mode>;
+#endif
+    return simd_tile_scalar<Mode>;
+}
+
+// 线程私有暂存区：回测开始时分配一次，跨列块 / 行块复用
+struct SimdScratch {
+    std::vector<float> positions, portfolio, cash_out, qty_out;  // (tile_rows, lanes)
+    std::vector<float> cash, qty, prev_pos;                      // (lanes,)
+
+    SimdScratch(int tile_rows, int lanes)
+        : positions((size_t)tile_rows * lanes, 0.0f), portfolio((size_t)tile_rows * lanes),
+          cash_out((size_t)tile_rows * lanes), qty_out((size_t)tile_rows * lanes),
+          cash(lanes), qty(lanes), prev_pos(lanes) {}
+};
+
+// 引擎主体：行块 / 列块划分与 run_column_blocked_engine 相同；
+// 列块内先把持仓小块转置为行主序，再由 SIMD 内核逐时间步推进整块，最后逐列交给输出策略
+template <TradeMode Mode, typename Source, typename Output>
+inline void run_column_blocked_simd_engine(
+    const Ref<const VectorXf>& prices,
+    const Source& source,
+    const BacktestConfig& config,
+    Output& output,
+    int column_block,
+    SimdIsa isa
+){
+    const int n_timestamps = prices.size();
+    const int n_weights = source.n_weights();
+    const SimdTileKernel kernel = select_simd_tile_kernel<Mode>(isa);
+    output.begin(n_timestamps, n_weights);
+    if(n_timestamps == 0 || n_weights == 0) return;
+
+    const int block = resolve_column_block(column_block, n_weights, SIMD_LANE_ALIGN);
+    const int lanes = (block + SIMD_LANE_ALIGN - 1) / SIMD_LANE_ALIGN * SIMD_LANE_ALIGN;
+    const int n_blocks = (n_weights + block - 1) / block;
+    const int chunk = output.chunk_rows() > 0 ? output.chunk_rows() : n_timestamps;
+    const int tile = source.tile_rows() > 0 ? source.tile_rows() : DEFAULT_SIMD_TILE_ROWS;
+
+    std::vector<float> cash_state(n_weights, config.initial_cash);
+    std::vector<float> qty_state(n_weights, 0.0f);
+    std::vector<float> prev_pos_state(n_weights);
+    const float* price_data = prices.data();
+
+    #pragma omp parallel
+    {
+        typename Source::TileBuffer buffer;
+        SimdScratch scratch(tile, lanes);
+
+        SimdTileArgs args;
+        args.cash = scratch.cash.data();
+        args.qty = scratch.qty.data();
+        args.prev_pos = scratch.prev_pos.data();
+        args.lanes = lanes;
+        args.max_allocation_pct = config.max_allocation_pct;
+        args.fixed_cash_amount = config.fixed_cash_amount;
+        args.position_size = config.position_size;
+
+        for(int row_begin=0; row_begin<n_timestamps; row_begin+=chunk){
+            const int row_end = std::min(row_begin + chunk, n_timestamps);
+
+            #pragma omp single
+            output.begin_chunk(row_begin, row_end);
+
+            #pragma omp for schedule(static)
+            for(int b=0; b<n_blocks; ++b){
+                const int col_begin = b * block;
+                const int cols = std::min(col_begin + block, n_weights) - col_begin;
+
+                // 载入列块状态，多余的填充通道置 0
+                for(int c=0; c<lanes; ++c){
+                    scratch.cash[c] = c < cols ? cash_state[col_begin + c] : 0.0f;
+                    scratch.qty[c] = c < cols ? qty_state[col_begin + c] : 0.0f;
+                    scratch.prev_pos[c] = c < cols ? prev_pos_state[col_begin + c] : 0.0f;
+                }
+
+                for(int tile_begin=row_begin; tile_begin<row_end; tile_begin+=tile){
+                    const int tile_end = std::min(tile_begin + tile, row_end);
+                    const int rows = tile_end - tile_begin;
+                    const PositionTile positions = source.tile(tile_begin, tile_end, col_begin, col_begin + cols, buffer);
+
+                    // 列主序小块 → 行主序暂存区
+                    for(int c=0; c<cols; ++c){
+                        const float* src = positions.data + c * positions.col_stride;
+                        for(int r=0; r<rows; ++r) scratch.positions[(size_t)r * lanes + c] = src[r];
+                    }
+
+                    int first = 0;
+                    if(tile_begin == 0){
+                        for(int c=0; c<cols; ++c){
+                            scratch.prev_pos[c] = scratch.positions[c];
+                            output.record(col_begin + c, 0, config.initial_cash, config.initial_cash, 0.0f);
+                        }
+                        first = 1;
+                    }
+                    if(rows > first){
+                        const size_t offset = (size_t)first * lanes;
+                        args.prices = price_data + tile_begin + first;
+                        args.positions = scratch.positions.data() + offset;
+                        args.portfolio_out = scratch.portfolio.data() + offset;
+                        args.cash_out = scratch.cash_out.data() + offset;
+                        args.qty_out = scratch.qty_out.data() + offset;
+                        args.rows = rows - first;
+                        kernel(args);
+                    }
+
+                    for(int c=0; c<cols; ++c)
+                        for(int r=first; r<rows; ++r){
+                            const size_t k = (size_t)r * lanes + c;
+                            output.record(col_begin + c, tile_begin + r, scratch.portfolio[k],
+                                          scratch.cash_out[k], scratch.qty_out[k]);
+                        }
+                }
+
+                for(int c=0; c<cols; ++c){
+                    cash_state[col_begin + c] = scratch.cash[c];
+                    qty_state[col_begin + c] = scratch.qty[c];
+                    prev_pos_state[col_begin + c] = scratch.prev_pos[c];
+                }
+            }
+
+            #pragma omp single
+            output.end_chunk(row_begin, row_end);
+        }
+    }
+}
+
+// 任意持仓来源的 SIMD 列分块回测
+template <typename Source, typename Output>
+inline void run_column_blocked_simd_source(
+    const Ref<const VectorXf>& prices,
+    const Source& source,
+    const BacktestConfig& config,
+    Output& output,
+    int column_block = DEFAULT_COLUMN_BLOCK,
+    SimdIsa isa = SimdIsa::AUTO
+){
+    if(source.n_timestamps() != prices.size())
+        throw std::invalid_argument("持仓矩阵时间步数与价格序列长度不匹配");
+    if(config.cash_precision != CashPrecision::FLOAT)
+        throw std::invalid_argument("SIMD 内核仅支持 float 现金累加，请使用 run_multi_weight_column_blocked");
+
+    dispatch_trade_mode(config.trade_mode, [&](auto mode){
+        run_column_blocked_simd_engine<decltype(mode)::value>(prices, source, config, output, column_block, isa);
+    });
+}
+
+// SIMD 列分块多权重回测（输出策略版本）
+template <typename Output>
+inline void run_multi_weight_simd(
+    const Ref<const VectorXf>& prices,
+    const MatrixXf& position_matrix,
+    const BacktestConfig& config,
+    Output& output,
+    int column_block = DEFAULT_COLUMN_BLOCK,
+    SimdIsa isa = SimdIsa::AUTO
+){
+    run_column_blocked_simd_source(prices, MatrixPositionSource{position_matrix}, config, output, column_block, isa);
+}
+
+// SIMD 列分块多权重回测（枚举版本，返回完整矩阵）
+inline std::tuple<MatrixXf, MatrixXf, MatrixXf>
+run_multi_weight_simd(
+    const Ref<const VectorXf>& prices,
+    const MatrixXf& position_matrix,
+    float initial_cash,
+    TradeMode trade_mode,
+    float max_allocation_pct = 0.5,
+    float fixed_cash_amount = 100000.0,
+    float position_size = 100.0
+){
+    BacktestConfig config;
+    config.initial_cash = initial_cash;
+    config.trade_mode = trade_mode;
+    config.max_allocation_pct = max_allocation_pct;
+    config.fixed_cash_amount = fixed_cash_amount;
+    config.position_size = position_size;
+
+    FullOutput output;
+    run_multi_weight_simd(prices, position_matrix, config, output);
+    return output.to_tuple();
+}
+
+// SIMD 列分块多权重回测（字符串版本，与其他内核参数保持一致）
+inline std::tuple<MatrixXf, MatrixXf, MatrixXf>
+run_multi_weight_simd(
+    const Ref<const VectorXf>& prices,
+    const MatrixXf& position_matrix,
+    float initial_cash = 1000000.0,
+    std::string trade_mode = "portfolio_pct",
+    float max_allocation_pct = 0.5,
+    float fixed_cash_amount = 100000.0,
+    float position_size = 100.0
+){
+    return run_multi_weight_simd(prices, position_matrix, initial_cash, parse_trade_mode(trade_mode),
+                                 max_allocation_pct, fixed_cash_amount, position_size);
+}
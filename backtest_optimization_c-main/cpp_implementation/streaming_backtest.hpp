@@ -0,0 +1,132 @@
+#pragma once
+#include "simd_backtest.hpp"
+#include "metrics.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// -------------------- 增量（流式）多权重回测状态 --------------------
+// 实盘逐 bar 评估大量候选权重：不再每来一根 bar 就对全部历史重跑批量内核，
+// 而是常驻每个权重列的 (cash, qty, prev_pos) 与指标累加器，每根 bar 只推进一步，耗时 O(W)、与历史长度无关。
+// 单步推进直接调用 SIMD 列分块引擎的小块内核（rows = 1，全部权重列作为通道），交易逻辑与批量内核完全相同；
+// 指标用 MetricsAccumulator 逐步更新。同一指令集下，逐行 advance T 次的现金 / 持仓 / 指标
+// 与 run_multi_weight_simd + FinalOutput / MetricsOutput 跑同样 T 行的结果逐位一致。
+// 与批量内核一致：第一次 advance 只记录初始持仓信号（不交易），之后按持仓信号的变化买卖。
+// 单线程推进：W 为几千时一步只有几微秒，并行的 fork/join 开销反而更大；多个品种各用一个状态对象。
+
+class MultiWeightState {
+public:
+    MultiWeightState(int n_weights, const BacktestConfig& config,
+                     float annualization_factor = DEFAULT_ANNUALIZATION_FACTOR, SimdIsa isa = SimdIsa::AUTO)
+        : n_weights_(n_weights),
+          lanes_((std::max(n_weights, 1) + SIMD_LANE_ALIGN - 1) / SIMD_LANE_ALIGN * SIMD_LANE_ALIGN),
+          config_(config),
+          annualization_factor_(annualization_factor),
+          cash_(lanes_), qty_(lanes_), prev_pos_(lanes_), positions_(lanes_),
+          portfolio_out_(lanes_), cash_out_(lanes_), qty_out_(lanes_),
+          accumulators_(std::max(n_weights, 0)), row_buffer_(std::max(n_weights, 0)) {
+        if(n_weights <= 0)
+            throw std::invalid_argument("权重组合数必须为正: " + std::to_string(n_weights));
+        if(config.cash_precision != CashPrecision::FLOAT)
+            throw std::invalid_argument("增量回测仅支持 float 现金累加");
+        kernel_ = dispatch_trade_mode(config.trade_mode, [&](auto mode){
+            return select_simd_tile_kernel<decltype(mode)::value>(isa);
+        });
+        reset();
+    }
+
+    // 回到初始状态（全部现金、无持仓、未见过任何 bar）
+    void reset(){
+        std::fill(cash_.begin(), cash_.end(), 0.0f);
+        std::fill(cash_.begin(), cash_.begin() + n_weights_, config_.initial_cash);
+        std::fill(qty_.begin(), qty_.end(), 0.0f);
+        std::fill(prev_pos_.begin(), prev_pos_.end(), 0.0f);
+        std::fill(positions_.begin(), positions_.end(), 0.0f);  // 填充通道始终为 0
+        std::fill(portfolio_out_.begin(), portfolio_out_.begin() + n_weights_, config_.initial_cash);
+        std::copy(cash_.begin(), cash_.end(), cash_out_.begin());
+        std::fill(qty_out_.begin(), qty_out_.end(), 0.0f);
+        n_steps_ = 0;
+    }
+
+    // 推进一个时间步：price 为本 bar 价格，positions 为本 bar 各权重组合的持仓信号 (n_weights,)
+    void advance(float price, const float* positions){
+        std::copy(positions, positions + n_weights_, positions_.begin());
+        if(n_steps_ == 0){
+            std::copy(positions_.begin(), positions_.end(), prev_pos_.begin());
+            for(int w=0; w<n_weights_; ++w) accumulators_[w].reset(config_.initial_cash);
+            ++n_steps_;
+            return;
+        }
+
+        SimdTileArgs args;
+        args.prices = &price;
+        args.positions = positions_.data();
+        args.portfolio_out = portfolio_out_.data();
+        args.cash_out = cash_out_.data();
+        args.qty_out = qty_out_.data();
+        args.cash = cash_.data();
+        args.qty = qty_.data();
+        args.prev_pos = prev_pos_.data();
+        args.rows = 1;
+        args.lanes = lanes_;
+        args.max_allocation_pct = config_.max_allocation_pct;
+        args.fixed_cash_amount = config_.fixed_cash_amount;
+        args.position_size = config_.position_size;
+        kernel_(args);
+
+        for(int w=0; w<n_weights_; ++w) accumulators_[w].update(portfolio_out_[w]);
+        ++n_steps_;
+    }
+
+    template <typename Derived>
+    void advance(float price, const DenseBase<Derived>& positions){
+        if(positions.size() != n_weights_)
+            throw std::invalid_argument("持仓信号长度 " + std::to_string(positions.size()) +
+                                        " 与权重组合数 " + std::to_string(n_weights_) + " 不一致");
+        if constexpr (bool(Derived::Flags & DirectAccessBit) && Derived::InnerStrideAtCompileTime == 1){
+            advance(price, positions.derived().data());
+        } else {
+            for(int w=0; w<n_weights_; ++w) row_buffer_(w) = positions(w);
+            advance(price, row_buffer_.data());
+        }
+    }
+
+    // 逐行推进一段历史（如开盘前用当日已有 bar 预热），prices (rows,)，position_matrix (rows, n_weights)
+    template <typename Derived>
+    void advance_rows(const Ref<const VectorXf>& prices, const MatrixBase<Derived>& position_matrix){
+        if(position_matrix.rows() != prices.size())
+            throw std::invalid_argument("持仓矩阵时间步数与价格序列长度不匹配");
+        if(position_matrix.cols() != n_weights_)
+            throw std::invalid_argument("持仓矩阵列数与权重组合数不一致");
+        for(Index r=0; r<prices.size(); ++r){
+            for(int w=0; w<n_weights_; ++w) row_buffer_(w) = position_matrix(r, w);
+            advance(prices(r), row_buffer_.data());
+        }
+    }
+
+    int n_weights() const { return n_weights_; }
+    long long n_steps() const { return n_steps_; }  // 已推进的时间步数（含第一步）
+    const BacktestConfig& config() const { return config_; }
+
+    // 最近一步之后的状态 (n_weights,)
+    Map<const VectorXf> portfolio() const { return Map<const VectorXf>(portfolio_out_.data(), n_weights_); }
+    Map<const VectorXf> cash() const { return Map<const VectorXf>(cash_.data(), n_weights_); }
+    Map<const VectorXf> quantity() const { return Map<const VectorXf>(qty_.data(), n_weights_); }
+
+    const std::vector<MetricsAccumulator>& accumulators() const { return accumulators_; }
+    BacktestMetrics metrics() const { return collect_metrics(accumulators_, annualization_factor_); }
+
+private:
+    int n_weights_;
+    int lanes_;  // n_weights 按 SIMD_LANE_ALIGN 向上取整，填充通道持仓恒为 0、现金为 0，不参与指标
+    BacktestConfig config_;
+    float annualization_factor_;
+    SimdTileKernel kernel_ = nullptr;
+    std::vector<float> cash_, qty_, prev_pos_, positions_;
+    std::vector<float> portfolio_out_, cash_out_, qty_out_;
+    std::vector<MetricsAccumulator> accumulators_;
+    VectorXf row_buffer_;  // 非连续持仓行的暂存
+    long long n_steps_ = 0;
+};
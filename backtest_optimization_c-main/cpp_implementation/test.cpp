@@ -2,6 +2,19 @@
 #include <Eigen/Dense>
 #include <chrono>
 #include "multi_weight_backtest.hpp"  // 需要包含两个版本的函数
+#include "column_blocked_backtest.hpp"
+#include "metrics.hpp"
+#include "signal_processor.hpp"
+#include "simd_backtest.hpp"
+#include "multi_asset_backtest.hpp"
+#include "streaming_backtest.hpp"
+#include "optimizer_kernel.hpp"
+#include "weight_search.hpp"
+#include "npy_writer.hpp"
+#include "column_store.hpp"
+#include "test_data.hpp"
+#include <cstdio>
+#include <filesystem>
 
 int main() {
     // -------------------- 测试数据 --------------------
@@ -42,8 +55,250 @@ int main() {
     elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
     std::cout << "2耗时: " << elapsed_parallel << " 秒" << std::endl;
 
-    // -------------------- 并行向量化 --------------------
-    
+    // -------------------- 列分块并行（按权重列分配线程） --------------------
+    t1 = std::chrono::high_resolution_clock::now();
+    auto [portfolio_blocked, cash_blocked, pos_blocked] = 
+        run_multi_weight_column_blocked(prices, position_matrix);
+    t2 = std::chrono::high_resolution_clock::now();
+    elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "3耗时(列分块, " << omp_get_max_threads() << " 线程): " << elapsed_parallel << " 秒" << std::endl;
+
+    // -------------------- 列分块 + 仅保留最后一行（内存 O(W)） --------------------
+    BacktestConfig config;
+    FinalOutput final_output;
+    t1 = std::chrono::high_resolution_clock::now();
+    run_multi_weight_column_blocked(prices, position_matrix, config, final_output);
+    t2 = std::chrono::high_resolution_clock::now();
+    elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "4耗时(列分块, 仅最后一行): " << elapsed_parallel << " 秒" << std::endl;
+
+    // -------------------- 列分块 + 融合指标（Sharpe/回撤/收益/胜率） --------------------
+    MetricsOutput metrics_output;
+    t1 = std::chrono::high_resolution_clock::now();
+    run_multi_weight_column_blocked(prices, position_matrix, config, metrics_output);
+    t2 = std::chrono::high_resolution_clock::now();
+    elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "5耗时(列分块, 融合指标): " << elapsed_parallel << " 秒" << std::endl;
+    BacktestMetrics fused_metrics = metrics_output.metrics();
+    BacktestMetrics batch_metrics = calculate_all_metrics(portfolio_parallel_2);
+
+    // -------------------- 显式 SIMD 列分块（运行时选择指令集） --------------------
+    t1 = std::chrono::high_resolution_clock::now();
+    auto [portfolio_simd, cash_simd, pos_simd] =
+        run_multi_weight_simd(prices, position_matrix);
+    t2 = std::chrono::high_resolution_clock::now();
+    elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "8耗时(SIMD 列分块, " << simd_isa_name(detect_simd_isa()) << "): " << elapsed_parallel << " 秒" << std::endl;
+
+    // -------------------- 信号组合 → 回测 融合流水线（不物化持仓矩阵） --------------------
+    const int n_signals = 10;
+    Eigen::MatrixXf signal_matrix = Eigen::MatrixXf::Random(n_timestamps, n_signals);
+    Eigen::MatrixXf weights_matrix = Eigen::MatrixXf::Random(n_signals, n_weights);
+
+    t1 = std::chrono::high_resolution_clock::now();
+    auto [combined_signals, long_short_matrix, signal_positions] = process_signals(signal_matrix, weights_matrix);
+    Eigen::MatrixXf signal_position_matrix = signal_positions.cast<float>();
+    MetricsOutput materialized_output;
+    run_multi_weight_column_blocked(prices, signal_position_matrix, config, materialized_output);
+    t2 = std::chrono::high_resolution_clock::now();
+    elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "6耗时(信号组合 + 列分块, 物化持仓): " << elapsed_parallel << " 秒" << std::endl;
+
+    MetricsOutput fused_signal_output;
+    t1 = std::chrono::high_resolution_clock::now();
+    run_signal_backtest(prices, signal_matrix, weights_matrix, DEFAULT_SIGNAL_THRESHOLD, config, fused_signal_output);
+    t2 = std::chrono::high_resolution_clock::now();
+    elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "7耗时(信号组合融合流水线): " << elapsed_parallel << " 秒" << std::endl;
+
+    // -------------------- 多品种批量回测（价格面板 × 各品种持仓矩阵，一次调用） --------------------
+    const int n_instruments = 20;
+    const int weights_per_instrument = n_weights / n_instruments;
+    Eigen::MatrixXf price_panel(n_timestamps, n_instruments);
+    std::vector<Eigen::MatrixXf> instrument_positions;
+    for(int i = 0; i < n_instruments; ++i){
+        price_panel.col(i) = (Eigen::VectorXf::Random(n_timestamps).array() + 1.0f) * 5.0f + 10.0f;  // 10~20
+        instrument_positions.push_back(position_matrix.middleCols(i * weights_per_instrument, weights_per_instrument));
+    }
+
+    t1 = std::chrono::high_resolution_clock::now();
+    std::vector<FinalOutput> loop_outputs(n_instruments);
+    for(int i = 0; i < n_instruments; ++i)
+        run_multi_weight_column_blocked(price_panel.col(i), instrument_positions[i], config, loop_outputs[i]);
+    t2 = std::chrono::high_resolution_clock::now();
+    elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "9耗时(逐品种调用, " << n_instruments << " 个品种): " << elapsed_parallel << " 秒" << std::endl;
+
+    t1 = std::chrono::high_resolution_clock::now();
+    std::vector<FinalOutput> batch_outputs;
+    run_multi_asset_backtest(price_panel, instrument_positions, config, batch_outputs);
+    t2 = std::chrono::high_resolution_clock::now();
+    elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "10耗时(多品种批量): " << elapsed_parallel << " 秒" << std::endl;
+    float max_diff_multi_asset = 0.0f;
+    for(int i = 0; i < n_instruments; ++i)
+        max_diff_multi_asset = std::max(max_diff_multi_asset,
+            (batch_outputs[i].final_portfolio - loop_outputs[i].final_portfolio).cwiseAbs().maxCoeff());
+
+    // -------------------- 现金累加精度（float / Kahan 补偿 / double） --------------------
+    BacktestConfig double_config;
+    double_config.cash_precision = CashPrecision::DOUBLE;
+    FinalOutput double_output;
+    t1 = std::chrono::high_resolution_clock::now();
+    run_multi_weight_column_blocked(prices, position_matrix, double_config, double_output);
+    t2 = std::chrono::high_resolution_clock::now();
+    elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "11耗时(列分块, double 现金): " << elapsed_parallel << " 秒" << std::endl;
+
+    BacktestConfig kahan_config;
+    kahan_config.cash_precision = CashPrecision::KAHAN;
+    FinalOutput kahan_output;
+    t1 = std::chrono::high_resolution_clock::now();
+    run_multi_weight_column_blocked(prices, position_matrix, kahan_config, kahan_output);
+    t2 = std::chrono::high_resolution_clock::now();
+    elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "12耗时(列分块, Kahan 补偿现金): " << elapsed_parallel << " 秒" << std::endl;
+
+    // 精度容差：上面的随机价格在复利模式下会溢出，这里改用 test_data.hpp 的随机游走数据（seed 固定，结果可复现）
+    const float FLOAT_CASH_REL_TOL = 1e-3f;  // float 现金 vs double 最后一行 portfolio 相对误差上限
+    const float KAHAN_CASH_REL_TOL = 5e-4f;  // Kahan 补偿现金 vs double
+    const TestDataset precision_data = generate_test_dataset(5000, 10, n_weights, 42);
+    float max_rel_float = 0.0f, max_rel_kahan = 0.0f;
+    for(TradeMode mode : {TradeMode::FIXED, TradeMode::CASH_ALL, TradeMode::PORTFOLIO_PCT, TradeMode::FIXED_CASH}){
+        FinalOutput precision_outputs[3];
+        for(CashPrecision cash : {CashPrecision::FLOAT, CashPrecision::KAHAN, CashPrecision::DOUBLE}){
+            BacktestConfig precision_config;
+            precision_config.trade_mode = mode;
+            precision_config.cash_precision = cash;
+            run_multi_weight_column_blocked(precision_data.prices, precision_data.position_matrix, precision_config,
+                                            precision_outputs[(int)cash]);
+        }
+        const Eigen::ArrayXf reference = precision_outputs[(int)CashPrecision::DOUBLE].final_portfolio.array();
+        max_rel_float = std::max(max_rel_float, ((precision_outputs[(int)CashPrecision::FLOAT].final_portfolio.array()
+                                                  - reference) / reference).abs().maxCoeff());
+        max_rel_kahan = std::max(max_rel_kahan, ((precision_outputs[(int)CashPrecision::KAHAN].final_portfolio.array()
+                                                  - reference) / reference).abs().maxCoeff());
+    }
+    const bool precision_ok = max_rel_float <= FLOAT_CASH_REL_TOL && max_rel_kahan <= KAHAN_CASH_REL_TOL;
+
+    // -------------------- 增量回测（逐 bar advance，对比同样前缀的批量结果） --------------------
+    const int n_stream = 5000;
+    Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> stream_rows = position_matrix.topRows(n_stream);
+    MultiWeightState stream_state(n_weights, config);
+    t1 = std::chrono::high_resolution_clock::now();
+    for(int i = 0; i < n_stream; ++i)
+        stream_state.advance(prices(i), stream_rows.row(i));
+    t2 = std::chrono::high_resolution_clock::now();
+    elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "13耗时(增量回测, 每步 " << n_weights << " 个权重): " << elapsed_parallel / n_stream * 1e6 << " 微秒/步" << std::endl;
+    FinalOutput stream_batch_final;
+    MetricsOutput stream_batch_metrics;
+    const Eigen::MatrixXf stream_positions = position_matrix.topRows(n_stream);
+    run_multi_weight_simd(prices.head(n_stream), stream_positions, config, stream_batch_final);
+    run_multi_weight_simd(prices.head(n_stream), stream_positions, config, stream_batch_metrics);
+    BacktestMetrics stream_metrics = stream_state.metrics();
+    BacktestMetrics stream_batch = stream_batch_metrics.metrics();
+
+    // -------------------- 权重搜索：全部跑完 vs 逐轮淘汰 --------------------
+    const int n_candidates = 3000;
+    Eigen::MatrixXf candidates = make_random_candidates(n_signals, n_candidates);
+    SearchConfig exhaustive;
+    exhaustive.n_rungs = 1;
+    t1 = std::chrono::high_resolution_clock::now();
+    SearchResult exhaustive_result = run_weight_search(prices, signal_matrix, candidates, DEFAULT_SIGNAL_THRESHOLD, config, exhaustive);
+    t2 = std::chrono::high_resolution_clock::now();
+    elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "14耗时(权重搜索, 全部跑完, " << n_candidates << " 个候选): " << elapsed_parallel << " 秒" << std::endl;
+
+    t1 = std::chrono::high_resolution_clock::now();
+    SearchResult halving_result = run_weight_search(prices, signal_matrix, candidates, DEFAULT_SIGNAL_THRESHOLD, config);
+    t2 = std::chrono::high_resolution_clock::now();
+    elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "15耗时(权重搜索, 逐轮淘汰 " << halving_result.rung_rows.size() << " 轮): " << elapsed_parallel << " 秒" << std::endl;
+
+    Eigen::VectorXf batch_sharpe = evaluate_weights_batch(candidates, signal_matrix, prices, DEFAULT_SIGNAL_THRESHOLD, config);
+    Eigen::VectorXf exhaustive_sharpe(n_candidates);
+    for(int k = 0; k < n_candidates; ++k)
+        exhaustive_sharpe(exhaustive_result.candidate_index(k)) = exhaustive_result.metrics.sharpe_ratio(k);
+    float max_diff_survivor = 0.0f;
+    for(int k = 0; k < halving_result.candidate_index.size(); ++k)
+        max_diff_survivor = std::max(max_diff_survivor,
+            std::abs(halving_result.metrics.sharpe_ratio(k) - batch_sharpe(halving_result.candidate_index(k))));
+    int best_rank = 0;  // 逐轮淘汰选出的最优候选在完整评估中的名次
+    for(int k = 0; k < n_candidates; ++k)
+        if(batch_sharpe(k) > batch_sharpe(halving_result.candidate_index(0))) ++best_rank;
+
+    // -------------------- 结果保存：CSV vs NPY vs 流式写文件映射 --------------------
+    const std::string tmp_dir = std::filesystem::temp_directory_path().string() + "/";
+    const int n_csv_rows = 10000;
+    t1 = std::chrono::high_resolution_clock::now();
+    save_matrix_csv(portfolio_blocked.topRows(n_csv_rows), tmp_dir + "backtest_portfolio.csv");
+    t2 = std::chrono::high_resolution_clock::now();
+    elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "16耗时(save_matrix_csv, 前 " << n_csv_rows << " 行): " << elapsed_parallel << " 秒" << std::endl;
+
+    t1 = std::chrono::high_resolution_clock::now();
+    save_matrix_npy(portfolio_blocked, tmp_dir + "backtest_portfolio.npy");
+    t2 = std::chrono::high_resolution_clock::now();
+    elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "17耗时(save_matrix_npy, 全部 " << n_timestamps << " 行): " << elapsed_parallel << " 秒" << std::endl;
+
+    FullOutput npz_output{portfolio_blocked.topRows(n_csv_rows), cash_blocked.topRows(n_csv_rows), pos_blocked.topRows(n_csv_rows)};
+    t1 = std::chrono::high_resolution_clock::now();
+    save_full_output_npz(tmp_dir + "backtest_output.npz", npz_output);
+    t2 = std::chrono::high_resolution_clock::now();
+    elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "18耗时(save_full_output_npz, 前 " << n_csv_rows << " 行): " << elapsed_parallel << " 秒" << std::endl;
+
+    t1 = std::chrono::high_resolution_clock::now();
+    {
+        NpyOutput npy_output(tmp_dir + "backtest_stream_");
+        run_multi_weight_column_blocked(prices, position_matrix, config, npy_output);
+    }
+    t2 = std::chrono::high_resolution_clock::now();
+    elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "19耗时(列分块 + 流式写 .npy): " << elapsed_parallel << " 秒" << std::endl;
+    const float max_diff_npy = (load_matrix_npy(tmp_dir + "backtest_portfolio.npy") - portfolio_blocked).cwiseAbs().maxCoeff();
+    const float max_diff_npy_stream = std::max({
+        (load_matrix_npy(tmp_dir + "backtest_stream_portfolio_values.npy") - portfolio_blocked).cwiseAbs().maxCoeff(),
+        (load_matrix_npy(tmp_dir + "backtest_stream_cash_matrix.npy") - cash_blocked).cwiseAbs().maxCoeff(),
+        (load_matrix_npy(tmp_dir + "backtest_stream_quantity_matrix.npy") - pos_blocked).cwiseAbs().maxCoeff()});
+    for(const char* name : {"backtest_portfolio.csv", "backtest_portfolio.npy", "backtest_output.npz",
+                            "backtest_stream_portfolio_values.npy", "backtest_stream_cash_matrix.npy",
+                            "backtest_stream_quantity_matrix.npy"})
+        std::remove((tmp_dir + name).c_str());
+
+    // -------------------- 列式 bar 库：按日期范围映射回测 --------------------
+    // 1 分钟 bar，自 2025-01-01 00:00（北京时间）起连续；取中间一段日期回测，价格直接用映射视图
+    const std::string store_dir = column_store_series_dir(tmp_dir + "backtest_store", "1m", "TEST");
+    Matrix<int64_t, Dynamic, 1> bar_ts(n_timestamps), bar_volume(n_timestamps);
+    for(int i = 0; i < n_timestamps; ++i){
+        bar_ts(i) = yyyymmdd_to_epoch_ms(20250101) + 60000LL * i;
+        bar_volume(i) = i % 100;
+    }
+    write_column_store(store_dir, bar_ts, prices, bar_volume);
+    t1 = std::chrono::high_resolution_clock::now();
+    ColumnStore bar_store(store_dir);
+    const auto [store_begin, store_end] = bar_store.calendar_day_range(20250104, 20250110);
+    t2 = std::chrono::high_resolution_clock::now();
+    elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "20耗时(列式库打开 + 自然日范围定位, 行 " << store_begin << ".." << store_end << "): "
+              << elapsed_parallel * 1e6 << " 微秒" << std::endl;
+    const Eigen::MatrixXf store_positions = position_matrix.middleRows(store_begin, store_end - store_begin);
+    MetricsOutput store_metrics_output, copy_metrics_output;
+    t1 = std::chrono::high_resolution_clock::now();
+    run_multi_weight_column_blocked(bar_store.prices(store_begin, store_end), store_positions, config, store_metrics_output);
+    t2 = std::chrono::high_resolution_clock::now();
+    elapsed_parallel = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "21耗时(列分块 + 融合指标, 价格为映射视图): " << elapsed_parallel << " 秒" << std::endl;
+    const Eigen::VectorXf store_prices_copy = prices.segment(store_begin, store_end - store_begin);
+    run_multi_weight_column_blocked(store_prices_copy, store_positions, config, copy_metrics_output);
+    const bool store_range_ok = store_begin == (3 * 1440) && store_end == std::min(10 * 1440, n_timestamps)
+                                && bar_store.timestamps(store_begin, store_end)(0) == yyyymmdd_to_epoch_ms(20250104)
+                                // 交易日 2025-01-06（周一）从上周五 20:00 起，到周一 20:00 止
+                                && bar_store.date_range(20250106, 20250106) == std::make_pair<int64_t, int64_t>(2 * 1440 + 1200, 5 * 1440 + 1200)
+                                && bar_store.date_range(20250102, 20250103) == std::make_pair<int64_t, int64_t>(1200, 2 * 1440 + 1200);
+    std::filesystem::remove_all(tmp_dir + "backtest_store");
 
     // -------------------- 最大误差对比 --------------------
     float max_diff_portfolio = (portfolio_parallel - portfolio_parallel_2).cwiseAbs().maxCoeff();
@@ -55,5 +310,59 @@ int main() {
     std::cout << "  cash 最大差值: "      << max_diff_cash << "\n";
     std::cout << "  position 最大差值: "  << max_diff_pos << "\n";
 
-    return 0;
+    std::cout << "\n列分块 vs 2 最大误差:\n";
+    std::cout << "  portfolio 最大差值: " << (portfolio_blocked - portfolio_parallel_2).cwiseAbs().maxCoeff() << "\n";
+    std::cout << "  cash 最大差值: "      << (cash_blocked - cash_parallel_2).cwiseAbs().maxCoeff() << "\n";
+    std::cout << "  position 最大差值: "  << (pos_blocked - pos_parallel_2).cwiseAbs().maxCoeff() << "\n";
+    std::cout << "  最后一行 portfolio 最大差值: "
+              << (final_output.final_portfolio.transpose() - portfolio_parallel_2.bottomRows(1)).cwiseAbs().maxCoeff() << "\n";
+
+    std::cout << "\nSIMD 列分块 vs 列分块 最大误差:\n";
+    std::cout << "  portfolio 最大差值: " << (portfolio_simd - portfolio_blocked).cwiseAbs().maxCoeff() << "\n";
+    std::cout << "  cash 最大差值: "      << (cash_simd - cash_blocked).cwiseAbs().maxCoeff() << "\n";
+    std::cout << "  position 最大差值: "  << (pos_simd - pos_blocked).cwiseAbs().maxCoeff() << "\n";
+
+    std::cout << "\n融合指标 vs 基于矩阵计算 最大误差:\n";
+    std::cout << "  sharpe 最大差值: "       << (fused_metrics.sharpe_ratio - batch_metrics.sharpe_ratio).cwiseAbs().maxCoeff() << "\n";
+    std::cout << "  max_drawdown 最大差值: " << (fused_metrics.max_drawdown - batch_metrics.max_drawdown).cwiseAbs().maxCoeff() << "\n";
+    std::cout << "  total_return 最大差值: " << (fused_metrics.total_return - batch_metrics.total_return).cwiseAbs().maxCoeff() << "\n";
+    std::cout << "  win_rate 最大差值: "     << (fused_metrics.win_rate - batch_metrics.win_rate).cwiseAbs().maxCoeff() << "\n";
+
+    std::cout << "\n融合流水线 vs 物化持仓 最大误差:\n";
+    std::cout << "  sharpe 最大差值: " << (fused_signal_output.metrics().sharpe_ratio
+                                           - materialized_output.metrics().sharpe_ratio).cwiseAbs().maxCoeff() << "\n";
+
+    std::cout << "\n现金累加精度 vs double 最后一行 portfolio 最大相对误差:\n";
+    std::cout << "  float: " << ((final_output.final_portfolio - double_output.final_portfolio).array()
+                                 / double_output.final_portfolio.array()).abs().maxCoeff() << "\n";
+    std::cout << "  kahan: " << ((kahan_output.final_portfolio - double_output.final_portfolio).array()
+                                 / double_output.final_portfolio.array()).abs().maxCoeff() << "\n";
+    std::cout << "  容差检查（随机游走数据 T=5000, 四种交易模式）: float " << max_rel_float << " <= " << FLOAT_CASH_REL_TOL
+              << ", kahan " << max_rel_kahan << " <= " << KAHAN_CASH_REL_TOL << ": " << (precision_ok ? "通过" : "超出") << "\n";
+
+    std::cout << "\n多品种批量 vs 逐品种 最后一行 portfolio 最大差值: " << max_diff_multi_asset << "\n";
+
+    std::cout << "\n权重搜索:\n";
+    std::cout << "  全部跑完 vs evaluate_weights_batch sharpe 最大差值: " << (exhaustive_sharpe - batch_sharpe).cwiseAbs().maxCoeff() << "\n";
+    std::cout << "  逐轮淘汰幸存者 sharpe 最大差值: " << max_diff_survivor << "\n";
+    std::cout << "  逐轮淘汰回测步数 / 全部跑完: " << (double)halving_result.weight_steps / exhaustive_result.weight_steps << "\n";
+    std::cout << "  逐轮淘汰最优候选在完整评估中的名次: " << best_rank << " / " << n_candidates << "\n";
+
+    std::cout << "\n.npy 读回 vs 内存结果 最大差值:\n";
+    std::cout << "  save_matrix_npy: " << max_diff_npy << "\n";
+    std::cout << "  流式写 NpyOutput: " << max_diff_npy_stream << "\n";
+
+    std::cout << "\n列式库映射回测 vs 内存副本:\n";
+    std::cout << "  日期范围定位: " << (store_range_ok ? "正确" : "错误") << "\n";
+    std::cout << "  sharpe 最大差值: " << (store_metrics_output.metrics().sharpe_ratio
+                                           - copy_metrics_output.metrics().sharpe_ratio).cwiseAbs().maxCoeff() << "\n";
+
+    std::cout << "\n增量回测 vs SIMD 批量（前 " << n_stream << " 行）最大差值:\n";
+    std::cout << "  portfolio 最大差值: " << (stream_state.portfolio() - stream_batch_final.final_portfolio).cwiseAbs().maxCoeff() << "\n";
+    std::cout << "  cash 最大差值: "      << (stream_state.cash() - stream_batch_final.final_cash).cwiseAbs().maxCoeff() << "\n";
+    std::cout << "  position 最大差值: "  << (stream_state.quantity() - stream_batch_final.final_quantity).cwiseAbs().maxCoeff() << "\n";
+    std::cout << "  sharpe 最大差值: "    << (stream_metrics.sharpe_ratio - stream_batch.sharpe_ratio).cwiseAbs().maxCoeff() << "\n";
+    std::cout << "  max_drawdown 最大差值: " << (stream_metrics.max_drawdown - stream_batch.max_drawdown).cwiseAbs().maxCoeff() << "\n";
+
+    return precision_ok ? 0 : 1;
 }
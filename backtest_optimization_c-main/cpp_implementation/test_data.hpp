@@ -0,0 +1,200 @@
+#pragma once
+#include <Eigen/Dense>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include "signal_processor.hpp"
+
+using namespace Eigen;
+
+// -------------------- 可复现测试数据 --------------------
+// 与 test_cases/generate_test_data.py 同一套生成算法和随机数序列（相同 seed → 相同数据），
+// C++ 基准测试不依赖 Python / .npy 文件即可得到与 Python 侧一致的数据集。
+// 价格 / 权重与 numpy 逐位一致；信号里的滚动均值、RSI 由 pandas 计算，可能有末位舍入差异。
+
+// numpy.random.RandomState（np.random.seed(int) 后的旧版全局生成器）：MT19937 + 极坐标法高斯
+class NumpyRandomState {
+public:
+    explicit NumpyRandomState(uint32_t seed) : engine_(seed) {}
+
+    // [0, 1) 53 位精度，对应 np.random.random_sample
+    double random_sample(){
+        const uint32_t a = engine_() >> 5;
+        const uint32_t b = engine_() >> 6;
+        return (a * 67108864.0 + b) / 9007199254740992.0;
+    }
+
+    // 对应 np.random.randn / standard_normal：一次生成两个，缓存一个
+    double standard_normal(){
+        if(has_gauss_){
+            has_gauss_ = false;
+            return gauss_;
+        }
+        double x1, x2, r2;
+        do {
+            x1 = 2.0 * random_sample() - 1.0;
+            x2 = 2.0 * random_sample() - 1.0;
+            r2 = x1 * x1 + x2 * x2;
+        } while(r2 >= 1.0 || r2 == 0.0);
+        const double f = std::sqrt(-2.0 * std::log(r2) / r2);
+        gauss_ = f * x1;
+        has_gauss_ = true;
+        return f * x2;
+    }
+
+    double normal(double loc, double scale){ return loc + scale * standard_normal(); }
+    double uniform(double low, double high){ return low + (high - low) * random_sample(); }
+
+    // [0, high)，对应 np.random.randint(high)（掩码拒绝采样）
+    int randint(int high){
+        const uint32_t rng = high - 1;
+        if(rng == 0) return 0;
+        uint32_t mask = rng;
+        mask |= mask >> 1; mask |= mask >> 2; mask |= mask >> 4; mask |= mask >> 8; mask |= mask >> 16;
+        uint32_t value;
+        while((value = (engine_() & mask)) > rng) {}
+        return value;
+    }
+
+private:
+    std::mt19937 engine_;
+    bool has_gauss_ = false;
+    double gauss_ = 0.0;
+};
+
+// 收盘价（几何布朗运动），对应 generate_price_data(...)['close']
+inline VectorXf generate_price_data(int n_timesteps, double initial_price = 100.0, double volatility = 0.02, uint32_t seed = 42){
+    NumpyRandomState random(seed);
+    VectorXf prices(n_timesteps);
+    double log_return = 0.0;
+    for(int t=0; t<n_timesteps; ++t){
+        log_return += random.normal(0.0005, volatility);
+        prices(t) = static_cast<float>(initial_price * std::exp(log_return));
+    }
+    return prices;
+}
+
+// 技术指标信号 (n_timesteps, n_signals)：均线偏离 / 动量 / RSI，不足部分补随机噪声，NaN 置 0 并截断到 [-1, 1]
+inline MatrixXf generate_signals(const VectorXf& prices, int n_signals = 10, uint32_t seed = 42){
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const int n_timesteps = prices.size();
+    std::vector<VectorXd> signals;
+
+    // 滚动均值，前 period-1 个为 NaN
+    auto rolling_mean = [&](const VectorXd& values, int period){
+        VectorXd mean = VectorXd::Constant(n_timesteps, nan);
+        double sum = 0.0;
+        for(int t=0; t<n_timesteps; ++t){
+            sum += values(t);
+            if(t >= period) sum -= values(t - period);
+            if(t >= period - 1) mean(t) = sum / period;
+        }
+        return mean;
+    };
+    const VectorXd close = prices.cast<double>();
+
+    // 趋势信号：均线差分
+    for(int period : {5, 20, 60}){
+        const VectorXd ma = rolling_mean(close, period);
+        signals.push_back(((close - ma).array() / ma.array()).matrix());
+    }
+
+    // 动量信号
+    for(int period : {5, 10, 20}){
+        VectorXd momentum = VectorXd::Constant(n_timesteps, nan);
+        for(int t=period; t<n_timesteps; ++t) momentum(t) = prices(t) / prices(t - period) - 1.0f;
+        signals.push_back(momentum);
+    }
+
+    // RSI 信号（首个差分为 NaN，按 where(...) 语义记为 0）
+    for(int period : {14, 28}){
+        VectorXd gain = VectorXd::Zero(n_timesteps), loss = VectorXd::Zero(n_timesteps);
+        for(int t=1; t<n_timesteps; ++t){
+            const float delta = prices(t) - prices(t - 1);
+            if(delta > 0) gain(t) = delta;
+            if(delta < 0) loss(t) = -delta;
+        }
+        const VectorXd avg_gain = rolling_mean(gain, period);
+        const VectorXd avg_loss = rolling_mean(loss, period);
+        const ArrayXd rs = avg_gain.array() / (avg_loss.array() + 1e-10);
+        const ArrayXd rsi = 100.0 - 100.0 / (1.0 + rs);
+        signals.push_back(((rsi - 50.0) / 50.0).matrix());
+    }
+
+    // 补充随机信号
+    NumpyRandomState random(seed);
+    while((int)signals.size() < n_signals){
+        VectorXd noise(n_timesteps);
+        for(int t=0; t<n_timesteps; ++t) noise(t) = random.standard_normal() * 0.1;
+        signals.push_back(noise);
+    }
+
+    MatrixXf signal_matrix(n_timesteps, n_signals);
+    for(int j=0; j<n_signals; ++j)
+        for(int t=0; t<n_timesteps; ++t){
+            const double value = std::isnan(signals[j](t)) ? 0.0 : signals[j](t);
+            signal_matrix(t, j) = static_cast<float>(std::min(1.0, std::max(-1.0, value)));
+        }
+    return signal_matrix;
+}
+
+// 权重矩阵 (n_signals, n_weights)：等权 10% / 随机 50% / 偏向单信号 30% / 极端 10%，不足部分补随机
+inline MatrixXf generate_weights(int n_signals = 10, int n_weights = 100, uint32_t seed = 42){
+    NumpyRandomState random(seed);
+    std::vector<VectorXd> weights;
+    auto randn = [&](){
+        VectorXd w(n_signals);
+        for(int i=0; i<n_signals; ++i) w(i) = random.standard_normal();
+        return w;
+    };
+
+    // 等权重
+    for(int k=0; k<int(n_weights * 0.1); ++k) weights.push_back(VectorXd::Constant(n_signals, 1.0 / n_signals));
+
+    // 随机权重
+    for(int k=0; k<int(n_weights * 0.5); ++k) weights.push_back(randn());
+
+    // 偏向特定信号
+    for(int k=0; k<int(n_weights * 0.3); ++k){
+        VectorXd w = randn() * 0.3;
+        const int idx = random.randint(n_signals);
+        w(idx) += random.uniform(1.0, 3.0);
+        weights.push_back(w);
+    }
+
+    // 极端权重（Python 先求赋值右侧的 choice，再求下标 randint）
+    for(int k=0; k<int(n_weights * 0.1); ++k){
+        VectorXd w = VectorXd::Zero(n_signals);
+        const double value = random.randint(2) == 0 ? 5.0 : -5.0;
+        w(random.randint(n_signals)) = value;
+        weights.push_back(w);
+    }
+
+    // 补齐
+    while((int)weights.size() < n_weights) weights.push_back(randn());
+
+    MatrixXf weight_matrix(n_signals, n_weights);
+    for(int j=0; j<n_weights; ++j) weight_matrix.col(j) = weights[j].cast<float>();
+    return weight_matrix;
+}
+
+// 完整数据集：价格 / 信号 / 权重使用同一个 seed（与 generate_test_data.py main() 一致），持仓由信号组合得到
+struct TestDataset {
+    VectorXf prices;          // (n_timesteps,)
+    MatrixXf signal_matrix;   // (n_timesteps, n_signals)
+    MatrixXf weights_matrix;  // (n_signals, n_weights)
+    MatrixXf position_matrix; // (n_timesteps, n_weights)
+};
+
+inline TestDataset generate_test_dataset(int n_timesteps, int n_signals, int n_weights, uint32_t seed = 42,
+                                         float threshold = DEFAULT_SIGNAL_THRESHOLD){
+    TestDataset data;
+    data.prices = generate_price_data(n_timesteps, 100.0, 0.02, seed);
+    data.signal_matrix = generate_signals(data.prices, n_signals, seed);
+    data.weights_matrix = generate_weights(n_signals, n_weights, seed);
+    data.position_matrix = std::get<2>(process_signals<float>(data.signal_matrix, data.weights_matrix, threshold));
+    return data;
+}
@@ -0,0 +1,240 @@
+#pragma once
+#include <Eigen/Dense>
+#include "signal_processor.hpp"
+#include "metrics.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <random>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+
+using namespace Eigen;
+
+// -------------------- 权重搜索（网格 / 随机 / 逐轮淘汰） --------------------
+// evaluate_weights_batch 把每个候选都跑到序列末尾；这里在列分块融合流水线之上做搜索驱动：
+//   网格 / 随机：生成候选矩阵 (n_signals, n_candidates)，n_rungs = 1 时全部跑完，结果与 evaluate_weights_batch 一致
+//   逐轮淘汰（successive halving）：全部候选先跑一段前缀，按运行中的夏普 / 回撤淘汰末尾部分，
+//     幸存者从断点（cash, qty, prev_pos, 指标累加器）接着跑下一段，最后一轮跑到序列末尾。
+//     幸存者的最终指标与完整回测逐位一致（状态原样续跑，不重跑前缀）。
+// 每轮结束把幸存者的权重列和状态压紧成连续数组，列块随存活数缩小；
+// 列块用 schedule(dynamic) 分发，空闲线程领取剩余列块，候选减少后负载仍然均衡。
+
+enum class SearchMetric { SHARPE, DRAWDOWN };
+
+inline SearchMetric parse_search_metric(const std::string& metric){
+    if(metric == "sharpe") return SearchMetric::SHARPE;
+    if(metric == "drawdown") return SearchMetric::DRAWDOWN;
+    throw std::invalid_argument("不支持的搜索指标: " + metric + "（可选 sharpe / drawdown）");
+}
+
+struct SearchConfig {
+    SearchMetric metric = SearchMetric::SHARPE;  // 排名依据：夏普越大越好 / 最大回撤越小越好
+    int n_rungs = 4;                 // 轮数；1 表示不淘汰，全部跑到末尾
+    float keep_fraction = 1.0f / 3;  // 每轮保留的比例，第 r 轮跑到 T * keep^(n_rungs-1-r) 行
+    int min_survivors = 1;           // 每轮至少保留的候选数
+    int column_block = DEFAULT_COLUMN_BLOCK;
+    int tile_rows = DEFAULT_SIGNAL_TILE_ROWS;
+};
+
+struct SearchResult {
+    VectorXi candidate_index;  // 最后一轮幸存者在候选矩阵中的列号，按得分从好到差
+    VectorXf score;            // 对应得分（夏普，或 -最大回撤）
+    BacktestMetrics metrics;   // 对应的完整序列指标
+    std::vector<int> rung_rows;       // 每轮结束时的行数
+    std::vector<int> rung_candidates; // 每轮参与的候选数
+    long long weight_steps = 0;       // 实际推进的 候选 × 时间步
+};
+
+// -------------------- 候选生成 --------------------
+// 网格：每个信号的权重取 levels 中的一个值，共 levels^n_signals 个（第 0 个信号变化最快）
+inline MatrixXf make_grid_candidates(int n_signals, const std::vector<float>& levels, long long max_candidates = 1 << 22){
+    if(n_signals <= 0 || levels.empty())
+        throw std::invalid_argument("网格搜索需要正的信号数和非空的取值列表");
+    long long n_candidates = 1;
+    for(int s=0; s<n_signals; ++s){
+        n_candidates *= (long long)levels.size();
+        if(n_candidates > max_candidates)
+            throw std::invalid_argument("网格候选数超过上限 " + std::to_string(max_candidates));
+    }
+    MatrixXf candidates(n_signals, n_candidates);
+    for(long long c=0; c<n_candidates; ++c){
+        long long rest = c;
+        for(int s=0; s<n_signals; ++s){
+            candidates(s, c) = levels[rest % levels.size()];
+            rest /= levels.size();
+        }
+    }
+    return candidates;
+}
+
+// 随机：每个权重独立均匀分布于 [low, high)
+inline MatrixXf make_random_candidates(int n_signals, int n_candidates, uint32_t seed = 42,
+                                       float low = -1.0f, float high = 1.0f){
+    if(n_signals <= 0 || n_candidates <= 0)
+        throw std::invalid_argument("随机搜索需要正的信号数和候选数");
+    std::mt19937 engine(seed);
+    std::uniform_real_distribution<float> uniform(low, high);
+    MatrixXf candidates(n_signals, n_candidates);
+    for(int c=0; c<n_candidates; ++c)
+        for(int s=0; s<n_signals; ++s) candidates(s, c) = uniform(engine);
+    return candidates;
+}
+
+// -------------------- 搜索驱动 --------------------
+// 续跑用的输出策略：累加器由调用方持有，第 col 列对应压紧后的第 col 个幸存者
+struct ResumableMetricsOutput {
+    MetricsAccumulator* accumulators;
+    void record(int col, int idx, float portfolio, float, float){
+        if(idx == 0) accumulators[col].reset(portfolio);
+        else accumulators[col].update(portfolio);
+    }
+};
+
+inline float search_score(const MetricsAccumulator& acc, SearchMetric metric, float annualization_factor){
+    return metric == SearchMetric::SHARPE ? acc.sharpe_ratio(annualization_factor) : -acc.max_drawdown;
+}
+
+// 按得分从好到差排序的下标（同分按候选列号，结果与线程数无关）
+inline std::vector<int> rank_by_score(const std::vector<float>& score, const std::vector<int>& candidate){
+    std::vector<int> order(score.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b){
+        return score[a] != score[b] ? score[a] > score[b] : candidate[a] < candidate[b];
+    });
+    return order;
+}
+
+template <TradeMode Mode, typename Cash, typename SignalDerived>
+inline SearchResult run_weight_search_engine(
+    const Ref<const VectorXf>& prices,
+    const MatrixBase<SignalDerived>& signal_matrix,
+    const MatrixXf& candidates,
+    float threshold,
+    const BacktestConfig& config,
+    const SearchConfig& search,
+    float annualization_factor
+){
+    const int n_timestamps = prices.size();
+    int n_alive = candidates.cols();
+
+    // 压紧后的幸存者：权重列、候选列号、续跑状态
+    MatrixXf weights = candidates;
+    std::vector<int> candidate(n_alive);
+    std::iota(candidate.begin(), candidate.end(), 0);
+    std::vector<Cash> cash_state(n_alive, Cash{config.initial_cash});
+    std::vector<float> qty_state(n_alive, 0.0f);
+    std::vector<float> prev_pos_state(n_alive, 0.0f);
+    std::vector<MetricsAccumulator> accumulators(n_alive);
+    std::vector<float> score(n_alive, 0.0f);
+
+    SearchResult result;
+    const float* price_data = prices.data();
+    int row_begin = 0;
+
+    for(int rung=0; rung<search.n_rungs && n_timestamps > 0; ++rung){
+        const int remaining = search.n_rungs - 1 - rung;
+        const int row_end = remaining == 0 ? n_timestamps
+            : std::max(row_begin + 1, std::min(n_timestamps, (int)std::ceil(n_timestamps * std::pow(search.keep_fraction, remaining))));
+
+        // 列块随存活数缩小，保证每个线程还有若干块可领
+        const int block = resolve_column_block(search.column_block, n_alive);
+        const int n_blocks = (n_alive + block - 1) / block;
+        const SignalPositionSource<SignalDerived, MatrixXf> source{
+            signal_matrix.derived(), weights, threshold, search.tile_rows};
+        ResumableMetricsOutput output{accumulators.data()};
+
+        #pragma omp parallel
+        {
+            typename SignalPositionSource<SignalDerived, MatrixXf>::TileBuffer buffer;
+            #pragma omp for schedule(dynamic)
+            for(int b=0; b<n_blocks; ++b){
+                const int col_begin = b * block;
+                const int col_end = std::min(col_begin + block, n_alive);
+                advance_column_block<Mode, Cash>(price_data, source, buffer, config, output, col_begin, col_end,
+                                                 row_begin, row_end, search.tile_rows, cash_state.data() + col_begin,
+                                                 qty_state.data() + col_begin, prev_pos_state.data() + col_begin);
+                for(int c=col_begin; c<col_end; ++c)
+                    score[c] = search_score(accumulators[c], search.metric, annualization_factor);
+            }
+        }
+
+        result.rung_rows.push_back(row_end);
+        result.rung_candidates.push_back(n_alive);
+        result.weight_steps += (long long)n_alive * (row_end - row_begin);
+        row_begin = row_end;
+        if(row_end == n_timestamps) break;
+
+        // 淘汰：保留得分最好的 keep_fraction，压紧幸存者
+        const int n_keep = std::min(n_alive, std::max(std::max(search.min_survivors, 1),
+                                                      (int)std::ceil(n_alive * search.keep_fraction)));
+        std::vector<int> order = rank_by_score(score, candidate);
+        order.resize(n_keep);
+        std::sort(order.begin(), order.end());  // 保持候选原顺序，压紧时源下标不小于目标下标
+        for(int k=0; k<n_keep; ++k){
+            const int from = order[k];
+            weights.col(k) = weights.col(from);
+            candidate[k] = candidate[from];
+            cash_state[k] = cash_state[from];
+            qty_state[k] = qty_state[from];
+            prev_pos_state[k] = prev_pos_state[from];
+            accumulators[k] = accumulators[from];
+            score[k] = score[from];
+        }
+        n_alive = n_keep;
+        weights.conservativeResize(NoChange, n_alive);
+        candidate.resize(n_alive);
+        cash_state.resize(n_alive, Cash{config.initial_cash});
+        qty_state.resize(n_alive);
+        prev_pos_state.resize(n_alive);
+        accumulators.resize(n_alive);
+        score.resize(n_alive);
+    }
+
+    const std::vector<int> order = rank_by_score(score, candidate);
+    std::vector<MetricsAccumulator> ranked(n_alive);
+    result.candidate_index.resize(n_alive);
+    result.score.resize(n_alive);
+    for(int k=0; k<n_alive; ++k){
+        result.candidate_index(k) = candidate[order[k]];
+        result.score(k) = score[order[k]];
+        ranked[k] = accumulators[order[k]];
+    }
+    result.metrics = collect_metrics(ranked, annualization_factor);
+    return result;
+}
+
+// 搜索入口：candidates (n_signals, n_candidates) 由 make_grid_candidates / make_random_candidates 生成或外部给定
+template <typename SignalDerived>
+inline SearchResult run_weight_search(
+    const Ref<const VectorXf>& prices,                // (n_timestamps,)
+    const MatrixBase<SignalDerived>& signal_matrix,   // (n_timestamps, n_signals)
+    const MatrixXf& candidates,                       // (n_signals, n_candidates)
+    float threshold,
+    const BacktestConfig& config,
+    const SearchConfig& search = SearchConfig(),
+    float annualization_factor = DEFAULT_ANNUALIZATION_FACTOR
+){
+    check_signal_dims(signal_matrix, candidates);
+    if(signal_matrix.rows() != prices.size())
+        throw std::invalid_argument("信号矩阵时间步数与价格序列长度不匹配");
+    if(candidates.cols() == 0)
+        throw std::invalid_argument("候选权重为空");
+    if(search.n_rungs < 1)
+        throw std::invalid_argument("搜索轮数必须为正: " + std::to_string(search.n_rungs));
+    if(!(search.keep_fraction > 0.0f && search.keep_fraction <= 1.0f))
+        throw std::invalid_argument("每轮保留比例必须在 (0, 1] 内: " + std::to_string(search.keep_fraction));
+
+    SearchConfig resolved = search;
+    if(resolved.column_block <= 0) resolved.column_block = DEFAULT_COLUMN_BLOCK;
+    if(resolved.tile_rows <= 0) resolved.tile_rows = DEFAULT_SIGNAL_TILE_ROWS;
+    return dispatch_trade_mode(config.trade_mode, [&](auto mode){
+        return dispatch_cash_precision(config.cash_precision, [&](auto cash){
+            return run_weight_search_engine<decltype(mode)::value, decltype(cash)>(
+                prices, signal_matrix, candidates, threshold, config, resolved, annualization_factor);
+        });
+    });
+}
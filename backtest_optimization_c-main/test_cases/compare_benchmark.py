@@ -0,0 +1,68 @@
+"""
+基准结果对比脚本
+
+对比两份 Google Benchmark JSON 输出（cpp_implementation/benchmark.cpp 生成），
+按 weight_steps_per_second 吞吐量检查性能回退，供 CI 使用：
+    python compare_benchmark.py baseline.json current.json --tolerance 0.1
+存在超出容忍度的回退时返回非零退出码。
+"""
+import json
+import sys
+import argparse
+
+
+def load_results(path):
+    """读取 JSON，返回 {基准名: 结果}（多次重复时只取 mean 聚合项）"""
+    with open(path, encoding='utf-8') as f:
+        data = json.load(f)
+
+    results = {}
+    for bench in data.get('benchmarks', []):
+        if bench.get('run_type') == 'aggregate' and bench.get('aggregate_name') != 'mean':
+            continue
+        name = bench.get('run_name', bench['name'])
+        results[name] = bench
+    return data.get('context', {}), results
+
+
+def main():
+    parser = argparse.ArgumentParser(description='对比基准测试结果')
+    parser.add_argument('baseline', help='基线 JSON')
+    parser.add_argument('current', help='当前 JSON')
+    parser.add_argument('--tolerance', type=float, default=0.1, help='允许的吞吐量下降比例')
+    parser.add_argument('--metric', type=str, default='weight_steps_per_second', help='对比的计数器')
+    args = parser.parse_args()
+
+    baseline_context, baseline = load_results(args.baseline)
+    current_context, current = load_results(args.current)
+
+    for key in ['simd_isa', 'num_cpus']:
+        if baseline_context.get(key) != current_context.get(key):
+            print(f"⚠ 运行环境不同: {key} {baseline_context.get(key)} → {current_context.get(key)}")
+
+    regressions = []
+    print(f"{'基准':<70} {'基线':>12} {'当前':>12} {'变化':>8}")
+    for name, bench in sorted(current.items()):
+        if name not in baseline or args.metric not in bench:
+            continue
+        old = baseline[name][args.metric]
+        new = bench[args.metric]
+        change = new / old - 1.0
+        status = ''
+        if change < -args.tolerance:
+            status = ' ✗'
+            regressions.append(name)
+        print(f"{name:<70} {old / 1e6:>10.1f}M {new / 1e6:>10.1f}M {change:>+7.1%}{status}")
+
+    missing = sorted(set(baseline) - set(current))
+    if missing:
+        print(f"\n⚠ 当前结果缺少 {len(missing)} 项基准: {', '.join(missing[:5])}{' ...' if len(missing) > 5 else ''}")
+
+    if regressions:
+        print(f"\n✗ {len(regressions)} 项吞吐量下降超过 {args.tolerance:.0%}")
+        sys.exit(1)
+    print(f"\n✓ 无超过 {args.tolerance:.0%} 的性能回退")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,420 @@
+// 异步日志后台：线程缓冲登记、后台格式化线程、滚动文件输出
+#include "async_log.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+#include "thread_tuning.h"
+
+extern FILE* logfile;  // define.h 约定的全局日志文件，由使用方定义
+
+namespace alog {
+
+std::atomic<int> g_full_policy{FULL_DROP};
+std::atomic<bool> g_sync_fallback{false};
+
+// ---------------- Ring ----------------
+Ring::Ring(size_t want) {
+  cap = 4096;
+  while (cap < want) cap <<= 1;
+  mask = cap - 1;
+  buf = new char[cap];
+}
+Ring::~Ring() { delete[] buf; }
+
+char* Ring::reserve(size_t n) {
+  size_t pos = head_local & mask;
+  const size_t room = cap - pos;  // 到缓冲尾部的连续空间；不够时填充到尾部、从头开始
+  const size_t need = n <= room ? n : room + n;
+  if (head_local + need - tail_cache > cap) {
+    tail_cache = tail.load(std::memory_order_acquire);
+    if (head_local + need - tail_cache > cap) return nullptr;
+  }
+  if (n > room) {
+    const uint32_t pad = (uint32_t)room | kPadFlag;
+    std::memcpy(buf + pos, &pad, sizeof(pad));
+    head_local += room;
+    pos = 0;
+  }
+  head_local += n;
+  return buf + pos;
+}
+
+// ---------------- 全局状态 ----------------
+static std::mutex g_mu;                 // 保护 g_rings
+static std::vector<Ring*> g_rings;
+static std::once_flag g_start_once;
+static std::thread* g_worker = nullptr;
+static std::atomic<bool> g_running{false}, g_stop{false};
+static std::mutex g_wake_mu;
+static std::condition_variable g_wake_cv, g_pass_cv;
+static bool g_kick = false;
+static uint64_t g_pass = 0;             // 已完成的轮数（g_wake_mu 保护）
+
+static std::mutex g_out_mu;             // 保护以下输出状态
+static FILE* g_file = nullptr;          // 滚动文件；为空时写 logfile
+static std::string g_path;
+static long long g_max_bytes = 0, g_file_bytes = 0;
+static int g_keep = 0;
+static std::atomic<int> g_echo{-1};
+
+static std::mutex g_cpu_mu;             // 保护 g_cpus；g_cpu_gen 变化时后台线程重新绑核
+static std::vector<int> g_cpus;
+static std::atomic<int> g_cpu_gen{0};
+
+static std::atomic<long long> g_written{0}, g_dropped_reaped{0};
+static long long g_dropped_reported = 0;  // 仅后台线程
+
+static thread_local bool t_dead = false;  // 本线程的缓冲已随线程退出交回
+
+static size_t ring_bytes() {
+  const char* e = std::getenv("CTP_LOG_RING_KB");
+  long kb = e ? std::atol(e) : 0;
+  return (size_t)(kb > 0 ? kb : 1024) * 1024;
+}
+
+// ---------------- 格式化 ----------------
+struct Arg {
+  uint8_t tag;
+  union { int64_t i; uint64_t u; double d; };
+  const char* s;
+  size_t n;
+};
+
+static long long as_int(const Arg& a) {
+  switch (a.tag) {
+    case A_I64: return a.i;
+    case A_F64: return (long long)a.d;
+    case A_STR: return 0;
+    default:    return (long long)a.u;
+  }
+}
+static double as_double(const Arg& a) {
+  switch (a.tag) {
+    case A_F64: return a.d;
+    case A_I64: return (double)a.i;
+    case A_STR: return 0;
+    default:    return (double)a.u;
+  }
+}
+
+static void append_fmt(std::string& out, const char* spec, ...) {
+  char tmp[256];
+  va_list ap, ap2;
+  va_start(ap, spec);
+  va_copy(ap2, ap);
+  const int m = std::vsnprintf(tmp, sizeof(tmp), spec, ap);
+  if (m > 0 && (size_t)m < sizeof(tmp)) {
+    out.append(tmp, (size_t)m);
+  } else if (m > 0) {
+    const size_t at = out.size();
+    out.resize(at + (size_t)m + 1);
+    std::vsnprintf(&out[at], (size_t)m + 1, spec, ap2);
+    out.resize(at + (size_t)m);
+  }
+  va_end(ap2);
+  va_end(ap);
+}
+
+// 按 printf 规则逐个转换说明符格式化；长度修饰符忽略（整数一律按 64 位、浮点按 double 传入），
+// 参数不足或说明符不识别时原样输出该说明符
+static void format_record(const char* rec, std::string& out) {
+  RecordHeader h;
+  std::memcpy(&h, rec, sizeof(h));
+  Arg args[256];
+  const char* p = rec + sizeof(h);
+  for (int k = 0; k < h.nargs; ++k) {
+    Arg& a = args[k];
+    a.tag = (uint8_t)*p++;
+    if (a.tag == A_STR) {
+      uint16_t n; std::memcpy(&n, p, 2); p += 2;
+      a.s = p; a.n = n; p += n;
+    } else {
+      std::memcpy(&a.u, p, 8); p += 8;
+    }
+  }
+  const char* f = h.fmt ? h.fmt : "";
+  int ai = 0;
+  for (;;) {
+    const char* pct = std::strchr(f, '%');
+    if (!pct) { out.append(f); break; }
+    out.append(f, (size_t)(pct - f));
+    f = pct + 1;
+    if (*f == '%') { out.push_back('%'); ++f; continue; }
+    char spec[64];
+    size_t k = 0, dot = 0;
+    int prec = -1;
+    spec[k++] = '%';
+    while (*f && std::strchr("-+ #0", *f) && k < 16) spec[k++] = *f++;
+    if (*f == '*') {
+      ++f;
+      k += std::snprintf(spec + k, 16, "%d", ai < h.nargs ? (int)as_int(args[ai++]) : 0);
+    } else {
+      while (std::isdigit((unsigned char)*f) && k < 32) spec[k++] = *f++;
+    }
+    dot = k;
+    if (*f == '.') {
+      ++f;
+      if (*f == '*') {
+        ++f;
+        prec = ai < h.nargs ? (int)as_int(args[ai++]) : 0;
+      } else {
+        prec = 0;
+        while (std::isdigit((unsigned char)*f)) prec = prec * 10 + (*f++ - '0');
+      }
+      if (prec >= 0) k += std::snprintf(spec + k, 16, ".%d", prec);
+    }
+    while (*f && std::strchr("hlLqjzt", *f)) ++f;
+    const char conv = *f;
+    if (!conv) { out.append(pct); break; }
+    ++f;
+    if (ai >= h.nargs) { out.append(pct, (size_t)(f - pct)); continue; }
+    const Arg& a = args[ai++];
+    switch (conv) {
+      case 'd': case 'i':
+        spec[k++] = 'l'; spec[k++] = 'l'; spec[k++] = conv; spec[k] = 0;
+        append_fmt(out, spec, as_int(a));
+        break;
+      case 'u': case 'o': case 'x': case 'X':
+        spec[k++] = 'l'; spec[k++] = 'l'; spec[k++] = conv; spec[k] = 0;
+        append_fmt(out, spec, (unsigned long long)as_int(a));
+        break;
+      case 'c':
+        spec[k++] = 'c'; spec[k] = 0;
+        append_fmt(out, spec, (int)as_int(a));
+        break;
+      case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        spec[k++] = conv; spec[k] = 0;
+        append_fmt(out, spec, as_double(a));
+        break;
+      case 's':
+        if (a.tag == A_STR) {
+          size_t n = a.n;
+          if (prec >= 0 && (size_t)prec < n) n = (size_t)prec;
+          std::memcpy(spec + dot, ".*s", 4);
+          append_fmt(out, spec, (int)n, a.s);
+        } else {
+          std::memcpy(spec + dot, "lld", 4);
+          append_fmt(out, spec, as_int(a));
+        }
+        break;
+      case 'p':
+        spec[k++] = 'p'; spec[k] = 0;
+        append_fmt(out, spec, (void*)(uintptr_t)a.u);
+        break;
+      default:
+        out.append(pct, (size_t)(f - pct));
+        break;
+    }
+  }
+  g_written.fetch_add(1, std::memory_order_relaxed);
+}
+
+// ---------------- 输出 ----------------
+static void rotate_locked() {
+  std::fclose(g_file);
+  g_file = nullptr;
+  for (int i = g_keep - 1; i >= 1; --i)
+    std::rename((g_path + "." + std::to_string(i)).c_str(), (g_path + "." + std::to_string(i + 1)).c_str());
+  if (g_keep > 0) std::rename(g_path.c_str(), (g_path + ".1").c_str());
+  g_file = std::fopen(g_path.c_str(), "w");
+  g_file_bytes = 0;
+}
+
+static void write_out(const std::string& s) {
+  if (s.empty()) return;
+  std::lock_guard<std::mutex> lk(g_out_mu);
+  FILE* f = g_file ? g_file : (logfile ? logfile : stdout);
+  const int e = g_echo.load(std::memory_order_relaxed);
+  const bool echo = f != stdout && (e < 0 ? true : e != 0);
+  // 写入后会超过上限且当前文件非空时先滚动，当前文件总是保存最新的日志
+  if (g_file && g_max_bytes > 0 && g_file_bytes > 0 && g_file_bytes + (long long)s.size() > g_max_bytes) {
+    rotate_locked();
+    f = g_file ? g_file : (logfile ? logfile : stdout);
+  }
+  std::fwrite(s.data(), 1, s.size(), f);
+  std::fflush(f);
+  if (echo) { std::fwrite(s.data(), 1, s.size(), stdout); std::fflush(stdout); }
+  if (f == g_file) g_file_bytes += (long long)s.size();
+}
+
+void write_record_sync(const char* rec) {
+  std::string s;
+  format_record(rec, s);
+  write_out(s);
+}
+
+// 排空一个缓冲，返回处理的记录数
+static size_t drain(Ring* r, std::string& out) {
+  const uint64_t head = r->head.load(std::memory_order_acquire);
+  uint64_t tail = r->tail.load(std::memory_order_relaxed);
+  size_t n = 0;
+  while (tail < head) {
+    const char* p = r->buf + (tail & r->mask);
+    uint32_t len;
+    std::memcpy(&len, p, sizeof(len));
+    if (len & kPadFlag) { tail += len & ~kPadFlag; continue; }
+    format_record(p, out);
+    tail += len;
+    ++n;
+    r->tail.store(tail, std::memory_order_release);
+  }
+  r->tail.store(tail, std::memory_order_release);
+  return n;
+}
+
+static long long dropped_total() {
+  long long d = g_dropped_reaped.load(std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lk(g_mu);
+  for (Ring* r : g_rings) d += (long long)r->dropped.load(std::memory_order_relaxed);
+  return d;
+}
+
+static void worker() {
+  std::string out;
+  out.reserve(1 << 20);
+  std::vector<Ring*> snap;
+  int cpu_gen = 0;
+  for (;;) {
+    const bool stop = g_stop.load(std::memory_order_acquire);
+    if (g_cpu_gen.load(std::memory_order_acquire) != cpu_gen) {
+      std::vector<int> cpus;
+      { std::lock_guard<std::mutex> lk(g_cpu_mu); cpus = g_cpus; cpu_gen = g_cpu_gen.load(); }
+      thread_pin_self(cpus);
+    }
+    { std::lock_guard<std::mutex> lk(g_mu); snap = g_rings; }
+    size_t n = 0;
+    for (Ring* r : snap) n += drain(r, out);
+    const long long d = dropped_total();
+    if (d > g_dropped_reported) {
+      append_fmt(out, "<log> dropped %lld records (ring full)\n", d - g_dropped_reported);
+      g_dropped_reported = d;
+    }
+    write_out(out);
+    out.clear();
+    {
+      // 回收已退出线程的缓冲：orphaned 之后 head 不再变化
+      std::lock_guard<std::mutex> lk(g_mu);
+      for (size_t i = 0; i < g_rings.size();) {
+        Ring* r = g_rings[i];
+        if (r->orphaned.load(std::memory_order_acquire) &&
+            r->tail.load(std::memory_order_relaxed) == r->head.load(std::memory_order_acquire)) {
+          g_dropped_reaped.fetch_add((long long)r->dropped.load(), std::memory_order_relaxed);
+          delete r;
+          g_rings[i] = g_rings.back();
+          g_rings.pop_back();
+        } else {
+          ++i;
+        }
+      }
+    }
+    std::unique_lock<std::mutex> lk(g_wake_mu);
+    ++g_pass;
+    g_pass_cv.notify_all();
+    if (stop) break;
+    if (n == 0) g_wake_cv.wait_for(lk, std::chrono::milliseconds(1), [] { return g_kick; });
+    g_kick = false;
+  }
+}
+
+static void start() {
+  if (const char* e = std::getenv("CTP_CPU_LOG")) set_cpus(e);
+  g_running.store(true);
+  g_worker = new std::thread(worker);
+  std::atexit(shutdown);
+}
+
+namespace {
+struct RingOwner {
+  Ring* r = nullptr;
+  ~RingOwner() {
+    if (r) r->orphaned.store(true, std::memory_order_release);
+    t_ring = nullptr;
+    t_dead = true;
+  }
+};
+}  // namespace
+
+Ring* thread_ring_slow() {
+  static thread_local RingOwner owner;
+  std::call_once(g_start_once, start);
+  Ring* r = new Ring(ring_bytes());
+  { std::lock_guard<std::mutex> lk(g_mu); g_rings.push_back(r); }
+  // 线程退出阶段（owner 已析构）再打日志：缓冲不再回收，只保证能写出
+  if (!t_dead) owner.r = r;
+  t_ring = r;
+  return r;
+}
+
+// ---------------- 控制接口 ----------------
+bool flush(int timeout_ms) {
+  if (!g_running.load()) return false;
+  std::unique_lock<std::mutex> lk(g_wake_mu);
+  const uint64_t target = g_pass + 2;  // 下一整轮开始前已提交的记录一定会被处理
+  g_kick = true;
+  g_wake_cv.notify_one();
+  return g_pass_cv.wait_for(lk, std::chrono::milliseconds(timeout_ms), [&] { return g_pass >= target; });
+}
+
+bool open_file(const char* path, long long max_bytes, int keep) {
+  flush();
+  std::lock_guard<std::mutex> lk(g_out_mu);
+  if (g_file) { std::fclose(g_file); g_file = nullptr; }
+  g_path.clear();
+  if (!path || !*path) return true;
+  FILE* f = std::fopen(path, "a");
+  if (!f) return false;
+  std::fseek(f, 0, SEEK_END);
+  g_file = f;
+  g_path = path;
+  g_file_bytes = std::ftell(f);
+  g_max_bytes = max_bytes;
+  g_keep = std::max(keep, 0);
+  return true;
+}
+
+void set_logfile(FILE* f) {
+  flush();
+  std::lock_guard<std::mutex> lk(g_out_mu);
+  FILE* old = logfile;
+  logfile = f;
+  if (old && old != f && old != stdout && old != stderr) std::fclose(old);
+}
+
+void set_echo(int on) { g_echo.store(on < 0 ? -1 : (on ? 1 : 0)); }
+void set_full_policy(int policy) { g_full_policy.store(policy == FULL_BLOCK ? FULL_BLOCK : FULL_DROP); }
+bool set_cpus(const char* cpus) {
+  std::vector<int> v;
+  if (!parse_cpu_list(cpus, v)) return false;
+  std::lock_guard<std::mutex> lk(g_cpu_mu);
+  g_cpus.swap(v);
+  g_cpu_gen.fetch_add(1, std::memory_order_release);
+  return true;
+}
+
+void stats(long long* written, long long* dropped) {
+  if (written) *written = g_written.load(std::memory_order_relaxed);
+  if (dropped) *dropped = dropped_total();
+}
+
+void shutdown() {
+  if (!g_running.exchange(false)) return;
+  g_sync_fallback.store(true);  // 此后的日志同步写出
+  {
+    std::lock_guard<std::mutex> lk(g_wake_mu);
+    g_stop.store(true, std::memory_order_release);
+    g_kick = true;
+  }
+  g_wake_cv.notify_one();
+  g_worker->join();
+  delete g_worker;
+  g_worker = nullptr;
+  std::lock_guard<std::mutex> lk(g_out_mu);
+  if (g_file) { std::fclose(g_file); g_file = nullptr; }
+}
+
+}  // namespace alog
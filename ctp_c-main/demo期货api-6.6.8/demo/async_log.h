@@ -0,0 +1,166 @@
+// 异步日志：调用线程只把「格式串指针 + 原始参数」写进本线程的无锁环形缓冲（SPSC），不格式化、不做系统调用；
+// 后台线程轮询各线程缓冲，按格式串逐个转换说明符格式化后批量写文件（可按大小滚动），每轮只 fflush 一次。
+// - 多参数形式的格式串必须有静态存储期（字符串字面量），只记录指针；字符串参数按值拷贝进缓冲
+// - 编译期级别过滤：-DCTP_LOG_LEVEL=CTP_LOG_INFO 等，低于该级别的调用整段编译掉（LOG 为 DEBUG 级）
+// - 缓冲满时默认丢弃并计数（不阻塞调用线程），可切换为等待
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#define CTP_LOG_DEBUG 0
+#define CTP_LOG_INFO  1
+#define CTP_LOG_WARN  2
+#define CTP_LOG_ERROR 3
+#define CTP_LOG_OFF   4
+#ifndef CTP_LOG_LEVEL
+#define CTP_LOG_LEVEL CTP_LOG_DEBUG
+#endif
+
+namespace alog {
+
+enum ArgTag : uint8_t { A_I64 = 1, A_U64, A_F64, A_STR, A_PTR };
+static const size_t kMaxStrArg = 4095;  // 单个字符串参数最多拷贝的字节数
+
+// 记录头：后接参数（每个参数 1 字节 tag + 定长 8 字节或 2 字节长度 + 字节串），整条按 8 字节对齐
+struct RecordHeader {
+  uint32_t len;        // 整条长度（含头）；kPadFlag 表示缓冲尾部的填充，读端跳回开头
+  uint8_t  level;
+  uint8_t  nargs;
+  uint16_t reserved;
+  const char* fmt;
+};
+static const uint32_t kPadFlag = 0x80000000u;
+
+// 单生产者（所属线程）/ 单消费者（后台线程）字节环
+struct Ring {
+  explicit Ring(size_t cap);
+  ~Ring();
+  // 预留 n 字节连续空间（n 已按 8 对齐）；空间不足返回 nullptr
+  char* reserve(size_t n);
+  void commit(size_t) { head.store(head_local, std::memory_order_release); }
+
+  char* buf;
+  size_t cap, mask;
+  // 生产者侧与消费者侧分开缓存行；head/tail 为单调递增的字节位置
+  alignas(64) std::atomic<uint64_t> head{0};
+  uint64_t head_local = 0;                  // 生产者私有：预留后的写位置
+  uint64_t tail_cache = 0;
+  std::atomic<uint64_t> dropped{0};
+  alignas(64) std::atomic<uint64_t> tail{0};
+  std::atomic<bool> orphaned{false};        // 所属线程已退出，排空后可回收
+};
+
+inline thread_local Ring* t_ring = nullptr;
+Ring* thread_ring_slow();  // 首次调用时分配并登记本线程的缓冲，同时按需启动后台线程
+enum FullPolicy { FULL_DROP = 0, FULL_BLOCK = 1 };
+extern std::atomic<int> g_full_policy;
+extern std::atomic<bool> g_sync_fallback;  // 后台线程已停止（进程退出阶段），改为同步写
+void write_record_sync(const char* rec);
+
+// ---------------- 参数编码 ----------------
+template <typename T> struct ArgKind {
+  using D = std::decay_t<T>;
+  static constexpr int value =
+      (std::is_same<D, char*>::value || std::is_same<D, const char*>::value || std::is_same<D, std::string>::value) ? A_STR :
+      std::is_floating_point<D>::value ? A_F64 :
+      std::is_pointer<D>::value ? A_PTR :
+      (std::is_integral<D>::value || std::is_enum<D>::value) ? (std::is_signed<D>::value ? A_I64 : A_U64) : 0;
+};
+
+inline size_t str_len_(const char* s) { return s ? strnlen(s, kMaxStrArg) : 6; }  // null 写作 "(null)"
+inline size_t str_len_(const std::string& s) { return s.size() < kMaxStrArg ? s.size() : kMaxStrArg; }
+
+template <typename T> inline size_t arg_size_(const T& v) {
+  static_assert(ArgKind<T>::value != 0, "LOG: unsupported argument type");
+  if constexpr (ArgKind<T>::value == A_STR) return 1 + 2 + str_len_(v);
+  else return 1 + 8;
+}
+
+inline void put_str_(char*& p, const char* s, size_t n) {
+  *p++ = (char)A_STR;
+  uint16_t k = (uint16_t)n;
+  std::memcpy(p, &k, 2); p += 2;
+  std::memcpy(p, s ? s : "(null)", n); p += n;
+}
+template <typename T> inline void put_arg_(char*& p, const T& v) {
+  constexpr int kind = ArgKind<T>::value;
+  if constexpr (kind == A_STR) {
+    if constexpr (std::is_same<std::decay_t<T>, std::string>::value) put_str_(p, v.data(), str_len_(v));
+    else put_str_(p, v, str_len_(v));
+  } else if constexpr (kind == A_F64) {
+    *p++ = (char)A_F64; double d = (double)v; std::memcpy(p, &d, 8); p += 8;
+  } else if constexpr (kind == A_PTR) {
+    *p++ = (char)A_PTR; uint64_t u = (uint64_t)(uintptr_t)v; std::memcpy(p, &u, 8); p += 8;
+  } else if constexpr (kind == A_I64) {
+    *p++ = (char)A_I64; int64_t i = (int64_t)v; std::memcpy(p, &i, 8); p += 8;
+  } else {
+    *p++ = (char)A_U64; uint64_t u = (uint64_t)v; std::memcpy(p, &u, 8); p += 8;
+  }
+}
+
+template <typename... Args>
+inline void push(int level, const char* fmt, const Args&... args) {
+  size_t n = sizeof(RecordHeader);
+  ((n += arg_size_(args)), ...);
+  n = (n + 7) & ~(size_t)7;
+  Ring* r = nullptr;
+  char* p = nullptr;
+  std::unique_ptr<char[]> tmp;
+  if (!g_sync_fallback.load(std::memory_order_relaxed)) {
+    r = t_ring ? t_ring : thread_ring_slow();
+    p = r->reserve(n);
+    while (!p) {
+      if (g_full_policy.load(std::memory_order_relaxed) == FULL_DROP || n > r->cap / 2) { r->dropped.fetch_add(1, std::memory_order_relaxed); return; }
+      std::this_thread::yield();
+      p = r->reserve(n);
+    }
+  } else {
+    tmp.reset(new char[n]);
+    p = tmp.get();
+  }
+  RecordHeader h{(uint32_t)n, (uint8_t)level, (uint8_t)sizeof...(Args), 0, fmt};
+  std::memcpy(p, &h, sizeof(h));
+  char* q = p + sizeof(h);
+  (put_arg_(q, args), ...);
+  if (r) r->commit(n);
+  else write_record_sync(p);
+}
+
+// 单个字符串（无格式）：按 "%s" 记录并拷贝内容，可传非字面量
+inline void push_str(int level, const char* s) { push(level, "%s", s); }
+
+// 阻塞直到调用前写入的日志全部落盘；返回 false 表示后台线程未运行
+bool flush(int timeout_ms = 1000);
+// 输出到滚动文件：超过 max_bytes 时 path → path.1 → ... → path.{keep}；path 为空恢复写 logfile
+bool open_file(const char* path, long long max_bytes, int keep);
+// 替换 logfile（持输出锁，与后台线程写出互斥）；旧文件不是 stdout / stderr 时关闭
+void set_logfile(FILE* f);
+// 另外写一份到 stdout（默认：logfile 不是 stdout 时开启，与旧 LOG 行为一致）
+void set_echo(int on);  // 1 开，0 关，-1 恢复默认
+void set_full_policy(int policy);
+// 后台线程绑核（CPU 列表同 taskset -c，空串解除）；后台线程下一轮生效。格式错误返回 false
+bool set_cpus(const char* cpus);
+void stats(long long* written, long long* dropped);
+void shutdown();  // 排空并停止后台线程（注册为 atexit）
+
+}  // namespace alog
+
+// ---------------- 对外宏接口 ----------------
+template <int L, typename... Args>
+inline void ctp_log_at(const char* fmt, const Args&... args) {
+  if constexpr (L >= CTP_LOG_LEVEL) {
+    if constexpr (sizeof...(Args) == 0) alog::push_str(L, fmt);
+    else alog::push(L, fmt, args...);
+  }
+}
+#define LOG_DEBUG(...) ctp_log_at<CTP_LOG_DEBUG>(__VA_ARGS__)
+#define LOG_INFO(...)  ctp_log_at<CTP_LOG_INFO>(__VA_ARGS__)
+#define LOG_WARN(...)  ctp_log_at<CTP_LOG_WARN>(__VA_ARGS__)
+#define LOG_ERROR(...) ctp_log_at<CTP_LOG_ERROR>(__VA_ARGS__)
@@ -0,0 +1,167 @@
+// async_log.h 测试：格式化与 printf 一致、LOG 兼容（非字面量单串/三目格式串）、多线程不丢不乱、
+// 缓冲满丢弃计数、按大小滚动、编译期级别过滤、写入中替换 logfile、入队耗时
+#include "define.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+FILE* logfile = stdout;
+
+static std::string slurp(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  std::stringstream ss; ss << in.rdbuf();
+  return ss.str();
+}
+
+int main() {
+  int rc = 0;
+  char dir[] = "/tmp/async_log_testXXXXXX";
+  if (!mkdtemp(dir)) { std::printf("mkdtemp\n"); return 1; }
+  const std::string path = std::string(dir) + "/t.log";
+  alog::set_echo(0);
+
+  // 1) 格式化与 snprintf 逐字一致
+  {
+    alog::open_file(path.c_str(), 0, 0);
+    char expect[4096]; std::string want;
+    const char* inst = "IM2512";
+    std::string name = "中文名称";
+    char buf[16] = "rb2601";
+    long long big = -9000000000000LL;
+    unsigned short us = 65535;
+#define BOTH(...) do { LOG(__VA_ARGS__); std::snprintf(expect, sizeof(expect), __VA_ARGS__); want += expect; } while (0)
+    BOTH("plain line\n");
+    BOTH("合约=[%s] 价=[%.8lf] 量=[%d] 方向=[%c]\n", inst, 6123.2, 17, '0');
+    BOTH("%5d|%-5d|%05d|%+d|%x|%X|%o|%u\n", 42, 42, 42, 42, 255u, 255u, 8u, 4000000000u);
+    BOTH("%lld %hu %ld %zu\n", big, us, -5L, (size_t)123);
+    BOTH("%10.3f|%-10.2e|%g|%G\n", 3.14159, 12345.678, 0.0001, 1e20);
+    BOTH("%s|%.3s|%8s|%-8s|%s\n", buf, "abcdef", "ab", "ab", "");
+    BOTH("100%% done %s\n", "ok");
+    BOTH("%*d|%.*f\n", 6, 7, 2, 1.005);
+    LOG("name=%s\n", name); want += "name=" + name + "\n";
+    LOG(buf); want += buf;                                   // 非字面量单串按值拷贝
+    for (int result : {0, 3}) {
+      LOG((result == 0) ? "send ok\n" : "send fail [%d]\n", result);
+      want += result == 0 ? "send ok\n" : "send fail [3]\n";
+    }
+    buf[0] = 'X';                                            // 入队后改写不影响已记录的内容
+    LOG("%d %s\n", 1);                                       // 参数不足：说明符原样输出
+    want += "1 %s\n";
+    alog::flush();
+    std::string got = slurp(path);
+    if (got != want) { std::printf("format mismatch\n--- got\n%s--- want\n%s", got.c_str(), want.c_str()); rc = 1; }
+  }
+
+  // 2) 编译期级别过滤：这里 LEVEL=DEBUG，各级都写出，低于 DEBUG 的调用被编译掉
+  {
+    alog::open_file(path.c_str(), 0, 0);
+    const size_t before = slurp(path).size();
+    LOG_DEBUG("d\n"); LOG_INFO("i\n"); LOG_WARN("w\n"); LOG_ERROR("e\n");
+    ctp_log_at<CTP_LOG_DEBUG - 1>("never\n");
+    alog::flush();
+    if (slurp(path).substr(before) != "d\ni\nw\ne\n") { std::printf("levels\n"); rc = 1; }
+  }
+
+  // 3) 多线程（阻塞模式）：每线程的记录不丢、线程内顺序不变
+  {
+    unlink(path.c_str());
+    alog::open_file(path.c_str(), 0, 0);
+    alog::set_full_policy(alog::FULL_BLOCK);
+    const int T = 4, N = 20000;
+    std::vector<std::thread> th;
+    for (int t = 0; t < T; ++t)
+      th.emplace_back([t] { for (int i = 0; i < N; ++i) LOG("t%d %d %s\n", t, i, "payload-payload-payload"); });
+    for (auto& x : th) x.join();
+    alog::flush();
+    std::istringstream in(slurp(path));
+    std::string line; int next[T] = {0}; long long lines = 0, bad = 0;
+    while (std::getline(in, line)) {
+      int t, i; char s[64];
+      if (std::sscanf(line.c_str(), "t%d %d %63s", &t, &i, s) != 3 || t < 0 || t >= T || i != next[t]++) ++bad;
+      ++lines;
+    }
+    if (lines != (long long)T * N || bad) { std::printf("threads lines=%lld bad=%lld\n", lines, bad); rc = 1; }
+    alog::set_full_policy(alog::FULL_DROP);
+  }
+
+  // 4) 丢弃模式：一次性写入远超缓冲容量，丢弃计数 + 写出数 = 总数（新线程的缓冲容量由环境变量限定）
+  {
+    long long w0, d0, w1, d1;
+    alog::flush();
+    alog::stats(&w0, &d0);
+    setenv("CTP_LOG_RING_KB", "16", 1);
+    const int N = 20000;
+    std::thread([&] { for (int i = 0; i < N; ++i) LOG("drop %d %s\n", i, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"); }).join();
+    unsetenv("CTP_LOG_RING_KB");
+    alog::flush();
+    alog::stats(&w1, &d1);
+    if (d1 - d0 <= 0 || (w1 - w0) + (d1 - d0) != N) { std::printf("drop written=%lld dropped=%lld\n", w1 - w0, d1 - d0); rc = 1; }
+    if (slurp(path).find("<log> dropped") == std::string::npos) { std::printf("drop notice\n"); rc = 1; }
+  }
+
+  // 5) 滚动：上限 4KB、保留 2 个旧文件
+  {
+    unlink(path.c_str());
+    alog::open_file(path.c_str(), 4096, 2);
+    for (int i = 0; i < 600; ++i) { LOG("rotate line %04d ..............................\n", i); if (i % 50 == 0) alog::flush(); }
+    alog::flush();
+    const std::string a = slurp(path), b = slurp(path + ".1"), c = slurp(path + ".2"), d = slurp(path + ".3");
+    if (b.empty() || c.empty() || !d.empty() || a.size() > 4096 || b.size() > 4096 ||
+        a.find("rotate line 0599") == std::string::npos) {
+      std::printf("rotate sizes %zu %zu %zu %zu\n", a.size(), b.size(), c.size(), d.size()); rc = 1;
+    }
+  }
+
+  // 6) 写入中替换 logfile（阻塞模式）：后台线程写出与替换互斥，记录不丢
+  {
+    alog::open_file(nullptr, 0, 0);
+    alog::set_full_policy(alog::FULL_BLOCK);
+    const std::string pa = path + ".a", pb = path + ".b";
+    unlink(pa.c_str()); unlink(pb.c_str());
+    const int N = 20000;
+    alog::set_logfile(std::fopen(pa.c_str(), "a"));
+    std::thread writer([] { for (int i = 0; i < N; ++i) LOG("swap %d\n", i); });
+    for (int k = 1; k < 50; ++k) {
+      if (FILE* f = std::fopen((k % 2 ? pb : pa).c_str(), "a")) alog::set_logfile(f);
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    writer.join();
+    alog::flush();
+    alog::set_logfile(stdout);
+    long long lines = 0;
+    for (const std::string* p : {&pa, &pb}) {
+      std::istringstream in(slurp(*p));
+      std::string line;
+      while (std::getline(in, line)) lines += line.compare(0, 5, "swap ") == 0;
+    }
+    if (lines != N) { std::printf("set_logfile lines=%lld\n", lines); rc = 1; }
+    alog::set_full_policy(alog::FULL_DROP);
+  }
+
+  // 7) 入队耗时（典型：一个字符串 + 两个数值；每轮不超过缓冲容量，只计调用线程耗时）
+  {
+    alog::open_file(path.c_str(), 0, 0);
+    const int R = 20, N = 10000;
+    double total = 0;
+    for (int r = 0; r < R; ++r) {
+      auto t0 = std::chrono::steady_clock::now();
+      for (int i = 0; i < N; ++i) LOG("合约=[%s] 价=[%.8lf] 量=[%d]\n", "IM2512", 6000.2 + i, i);
+      total += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+      alog::flush();
+    }
+    long long w, d;
+    alog::stats(&w, &d);
+    std::printf("push %.1f ns/record (written=%lld dropped=%lld)\n", total / (R * N), w, d);
+  }
+
+  alog::open_file(nullptr, 0, 0);
+  std::string cmd = std::string("rm -rf ") + dir;
+  if (std::system(cmd.c_str()) != 0) {}
+  std::printf(rc == 0 ? "ALL OK\n" : "FAILED\n");
+  return rc;
+}
@@ -0,0 +1,195 @@
+// K 线聚合：按合约（符号表 id）× 周期维护当前 bar，逐笔 O(1) 更新，跨周期边界时产出上一根
+// - 时间按交易所时间（epoch ms）对齐到周期整数倍；无成交的区间不补 bar
+// - CTP 的 Volume / Turnover 是当日累计值：逐笔取差分；累计值变小视为新交易日（夜盘开盘）重新计数，
+//   该笔的累计值整体计入；进程启动后各合约首笔只作基准（不知道之前已成交多少）
+// - 持仓量变化 oi_delta 相对上一根 bar 收盘（首根相对首笔）
+// - VWAP：设置了合约乘数时为 成交额差 / (成交量差 × 乘数)，否则按逐笔 last × 成交量差 加权
+// - 迟到的笔（属于已产出的 bar）只把成交量 / 成交额并入下一根，不改已产出 bar 的价格
+// 单线程使用（发布线程）
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+enum : uint32_t {
+  BAR_F_SESSION = 1,  // 本 bar 内累计量重置过（新交易日）
+  BAR_F_TIMER   = 2,  // 由 close_expired 按时钟收盘（之后没有新 tick）
+  BAR_F_LATE    = 4,  // 并入了迟到笔的成交量
+};
+
+struct Bar {
+  int64_t  start_ms;         // 区间起点（交易所时间，epoch ms）
+  int32_t  inst_id, interval_s;
+  double   open, high, low, close, vwap;
+  double   turnover;         // 区间成交额
+  double   open_interest;    // 收盘时持仓量
+  double   oi_delta;
+  int64_t  volume;           // 区间成交量
+  int32_t  ticks;            // 区间内有效价格的笔数
+  uint32_t flags;            // BAR_F_*
+};
+static_assert(sizeof(Bar) == 96, "Bar layout");
+
+// 落盘记录（bars_*.bin 为该记录首尾相接）：合约名 + Bar
+struct BarRecord {
+  char inst[32];
+  Bar  bar;
+};
+static_assert(sizeof(BarRecord) == 128, "BarRecord layout");
+
+class BarAggregator {
+public:
+  static constexpr int kMaxIntervals = 4;
+
+  explicit BarAggregator(int max_instruments) : st_((size_t)max_instruments) {}
+
+  // 设置周期（秒，去掉非正值，最多 kMaxIntervals 个）并清空状态；返回生效的周期数
+  int set_intervals(const int* secs, int n) {
+    n_iv_ = 0;
+    for (int i = 0; i < n && n_iv_ < kMaxIntervals; ++i)
+      if (secs[i] > 0) iv_ms_[n_iv_++] = (int64_t)secs[i] * 1000;
+    clear();
+    return n_iv_;
+  }
+  int intervals() const { return n_iv_; }
+  int interval_s(int k) const { return (int)(iv_ms_[k] / 1000); }
+
+  void set_multiplier(int id, double m) { if (id >= 0 && (size_t)id < st_.size()) st_[id].mult = m > 0 ? m : 0; }
+
+  // 逐笔更新；完成的 bar 写入 out（至多 kMaxIntervals 根），返回根数
+  int update(int id, int64_t ts_ms, double last, int64_t cum_volume, double cum_turnover, double oi, Bar* out) {
+    if (id < 0 || (size_t)id >= st_.size() || n_iv_ == 0 || ts_ms <= 0) return 0;
+    Inst& s = st_[id];
+    if (id >= n_used_) n_used_ = id + 1;
+    int64_t dv = 0;
+    double dt = 0;
+    bool reset = false;
+    if (!s.have_prev) {
+      s.have_prev = true;
+    } else if (cum_volume < s.prev_vol) {
+      dv = cum_volume; dt = cum_turnover; reset = true;
+    } else {
+      dv = cum_volume - s.prev_vol;
+      dt = cum_turnover >= s.prev_turn ? cum_turnover - s.prev_turn : 0;
+    }
+    s.prev_vol = cum_volume;
+    s.prev_turn = cum_turnover;
+    const bool px_ok = valid_(last);
+    const double oi_v = valid_(oi) ? oi : 0;
+    int produced = 0;
+    for (int k = 0; k < n_iv_; ++k) {
+      Cur& c = s.cur[k];
+      const int64_t start = ts_ms - ts_ms % iv_ms_[k];
+      if (c.open && start > c.bar.start_ms) { out[produced++] = finish_(s, c, 0); }
+      if (!c.open && start < c.closed_until) {
+        // 迟到：并入下一根
+        c.carry_vol += dv; c.carry_turn += dt; c.carry_pv += px_ok ? last * (double)dv : 0;
+        c.carry_flags |= BAR_F_LATE;
+        if (reset) c.carry_flags |= BAR_F_SESSION;
+        continue;
+      }
+      if (c.open && start < c.bar.start_ms) {
+        c.bar.volume += dv; c.bar.turnover += dt; c.pv += px_ok ? last * (double)dv : 0;
+        c.bar.flags |= BAR_F_LATE;
+        if (reset) c.bar.flags |= BAR_F_SESSION;
+        continue;
+      }
+      if (!c.open) {
+        if (!px_ok) { c.carry_vol += dv; c.carry_turn += dt; continue; }  // 没有价格不开新 bar
+        open_(s, c, id, k, start, last, oi_v);
+      }
+      Bar& b = c.bar;
+      if (px_ok) {
+        if (b.ticks == 0) b.open = b.high = b.low = last;
+        if (last > b.high) b.high = last;
+        if (last < b.low) b.low = last;
+        b.close = last;
+        ++b.ticks;
+        c.pv += last * (double)dv;
+      }
+      b.volume += dv;
+      b.turnover += dt;
+      if (oi_v > 0) b.open_interest = oi_v;
+      if (reset) b.flags |= BAR_F_SESSION;
+    }
+    return produced;
+  }
+
+  // 按时钟收盘：区间终点 + grace_ms <= now_ms 仍未收盘的 bar 全部产出（最多 cap 根，返回根数，可重复调用取完）
+  int close_expired(int64_t now_ms, int64_t grace_ms, Bar* out, int cap) {
+    int produced = 0;
+    for (; scan_ < n_used_ && produced < cap; ++scan_) {
+      Inst& s = st_[scan_];
+      for (int k = 0; k < n_iv_ && produced < cap; ++k) {
+        Cur& c = s.cur[k];
+        if (c.open && c.bar.start_ms + iv_ms_[k] + grace_ms <= now_ms) { out[produced++] = finish_(s, c, BAR_F_TIMER); }
+      }
+      if (produced >= cap) break;
+    }
+    if (scan_ >= n_used_) scan_ = 0;
+    return produced;
+  }
+
+  // 全部未收盘的 bar 产出（停止 / 回放结束时）
+  int close_all(Bar* out, int cap) { return close_expired(INT64_MAX / 2, 0, out, cap); }
+
+  void clear() {
+    for (Inst& s : st_) { const double m = s.mult; s = Inst(); s.mult = m; }
+    n_used_ = 0; scan_ = 0;
+  }
+
+private:
+  struct Cur {
+    Bar     bar;
+    bool    open = false;
+    int64_t closed_until = 0;  // 已产出的最后一根的终点
+    double  pv = 0;            // Σ last × 成交量差
+    int64_t carry_vol = 0;     // 待并入下一根的迟到成交
+    double  carry_turn = 0, carry_pv = 0;
+    uint32_t carry_flags = 0;
+  };
+  struct Inst {
+    bool    have_prev = false;
+    int64_t prev_vol = 0;
+    double  prev_turn = 0;
+    double  mult = 0;
+    double  oi_close[kMaxIntervals] = {0, 0, 0, 0};  // 各周期上一根 bar 收盘持仓量（首根之前为首笔持仓量）
+    Cur     cur[kMaxIntervals];
+  };
+
+  static bool valid_(double v) { return std::isfinite(v) && v > 0 && v < 1e300; }  // CTP 用 DBL_MAX 表示无值
+
+  void open_(Inst& s, Cur& c, int id, int k, int64_t start, double last, double oi) {
+    Bar& b = c.bar;
+    std::memset(&b, 0, sizeof(b));
+    b.start_ms = start;
+    b.inst_id = id;
+    b.interval_s = (int32_t)(iv_ms_[k] / 1000);
+    b.open = b.high = b.low = b.close = last;
+    if (s.oi_close[k] <= 0) s.oi_close[k] = oi;
+    b.open_interest = oi > 0 ? oi : s.oi_close[k];
+    b.volume = c.carry_vol; b.turnover = c.carry_turn; c.pv = c.carry_pv; b.flags = c.carry_flags;
+    c.carry_vol = 0; c.carry_turn = 0; c.carry_pv = 0; c.carry_flags = 0;
+    c.open = true;
+  }
+
+  Bar finish_(Inst& s, Cur& c, uint32_t flag) {
+    Bar& b = c.bar;
+    const int k = (int)(&c - s.cur);
+    b.flags |= flag;
+    if (b.volume > 0 && s.mult > 0 && b.turnover > 0) b.vwap = b.turnover / ((double)b.volume * s.mult);
+    else if (b.volume > 0 && c.pv > 0) b.vwap = c.pv / (double)b.volume;
+    else b.vwap = b.close;
+    b.oi_delta = b.open_interest - s.oi_close[k];
+    s.oi_close[k] = b.open_interest;
+    c.open = false;
+    c.closed_until = b.start_ms + iv_ms_[k];
+    return b;
+  }
+
+  std::vector<Inst> st_;
+  int64_t iv_ms_[kMaxIntervals] = {0, 0, 0, 0};
+  int n_iv_ = 0;
+  int n_used_ = 0, scan_ = 0;
+};
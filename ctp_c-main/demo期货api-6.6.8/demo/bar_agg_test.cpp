@@ -0,0 +1,134 @@
+// bar_agg.h 测试：OHLCV 与成交量差分、首笔基准、VWAP（乘数 / 价量加权）、持仓变化、新交易日累计量重置、
+// 迟到笔并入下一根、按时钟收盘、无效价格、周期对齐、成交量守恒、更新耗时
+#include "bar_agg.h"
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+static const int64_t T0 = 1760000000000LL - 1760000000000LL % 60000;  // 整分钟
+
+int main() {
+  int rc = 0;
+  BarAggregator agg(100);
+  const int iv[] = {1, 60, 0, -5};
+  if (agg.set_intervals(iv, 4) != 2 || agg.interval_s(1) != 60) { std::printf("intervals\n"); rc = 1; }
+  agg.set_multiplier(1, 10);
+  Bar out[BarAggregator::kMaxIntervals];
+
+  // 1) 首笔只作基准；同一秒内 OHLC / 成交量差 / 持仓
+  if (agg.update(1, T0 + 100, 100.0, 1000, 1e6, 500, out) != 0) { std::printf("first\n"); rc = 1; }
+  agg.update(1, T0 + 400, 101.0, 1010, 1e6 + 101.0 * 10 * 10, 505, out);
+  agg.update(1, T0 + 900, 99.0, 1015, 1e6 + 101.0 * 100 + 99.0 * 5 * 10, 503, out);
+  // 跨秒：产出 1s bar
+  int n = agg.update(1, T0 + 1200, 100.5, 1016, 1e6 + 101.0 * 100 + 99.0 * 50 + 100.5 * 10, 503, out);
+  if (n != 1) { std::printf("1s close n=%d\n", n); rc = 1; }
+  else {
+    const Bar& b = out[0];
+    const double vwap = (101.0 * 10 + 99.0 * 5) / 15;
+    if (b.start_ms != T0 || b.interval_s != 1 || b.open != 100 || b.high != 101 || b.low != 99 || b.close != 99 ||
+        b.volume != 15 || b.ticks != 3 || std::fabs(b.vwap - vwap) > 1e-9 || b.open_interest != 503 || b.oi_delta != 3) {
+      std::printf("1s bar o=%g h=%g l=%g c=%g v=%lld vwap=%g oi=%g doi=%g\n", b.open, b.high, b.low, b.close,
+                  (long long)b.volume, b.vwap, b.open_interest, b.oi_delta);
+      rc = 1;
+    }
+  }
+
+  // 2) 无乘数的合约按价量加权；DBL_MAX 价格不计入 OHLC
+  agg.update(2, T0 + 10, 50.0, 0, 0, 0, out);
+  agg.update(2, T0 + 20, 50.0, 4, 200, 10, out);
+  agg.update(2, T0 + 30, DBL_MAX, 6, 300, 10, out);
+  agg.update(2, T0 + 40, 52.0, 10, 500, 12, out);
+  n = agg.update(2, T0 + 1000, 52.0, 10, 500, 12, out);
+  if (n != 1 || out[0].high != 52 || out[0].low != 50 || out[0].volume != 10 || out[0].ticks != 3 ||
+      std::fabs(out[0].vwap - (50.0 * 4 + 52.0 * 4) / 10) > 1e-9 || out[0].oi_delta != 12) {
+    std::printf("dbl_max / vwap n=%d v=%lld vwap=%g\n", n, n ? (long long)out[0].volume : 0LL, n ? out[0].vwap : 0.0); rc = 1;
+  }
+
+  // 3) 跨分钟：1s 与 1m 同时产出；1m 的成交量为整分钟之和
+  n = agg.update(1, T0 + 60000 + 5, 100.0, 1020, 1e6 + 20000, 510, out);
+  if (n != 2 || out[0].interval_s != 1 || out[1].interval_s != 60 || out[1].start_ms != T0 || out[1].volume != 16 ||
+      out[1].open != 100 || out[1].close != 100.5 || out[1].oi_delta != 3) {
+    std::printf("1m close n=%d v=%lld\n", n, n > 1 ? (long long)out[1].volume : 0LL); rc = 1;
+  }
+
+  // 4) 新交易日：累计量变小 → 整体计入并标记
+  agg.update(1, T0 + 60500, 100.0, 1030, 1e6 + 30000, 510, out);
+  agg.update(1, T0 + 60600, 101.0, 7, 7070, 511, out);   // 重置
+  n = agg.update(1, T0 + 61000, 101.0, 9, 9090, 511, out);
+  if (n != 1 || out[0].volume != 4 + 10 + 7 || !(out[0].flags & BAR_F_SESSION)) {
+    std::printf("session reset n=%d v=%lld flags=%u\n", n, n ? (long long)out[0].volume : 0LL, n ? out[0].flags : 0u); rc = 1;
+  }
+
+  // 5) 迟到笔：属于已产出的秒，成交量并入下一根并标记
+  agg.update(1, T0 + 60990, 101.0, 12, 12120, 511, out);   // 落在已产出的 60 秒内 → 当前 61 秒 bar 之前 → 记入当前 bar
+  n = agg.update(1, T0 + 62000, 101.0, 13, 13130, 511, out);
+  if (n != 1 || out[0].start_ms != T0 + 61000 || out[0].volume != 2 + 3 || !(out[0].flags & BAR_F_LATE)) {
+    std::printf("late into open bar n=%d v=%lld\n", n, n ? (long long)out[0].volume : 0LL); rc = 1;
+  }
+
+  // 6) 按时钟收盘：宽限内不收，之后收盘并标记；之后同一秒再来的笔并入下一根
+  n = agg.close_expired(T0 + 62500, 1000, out, 16);  // 合约 2 早已停更的 1s / 1m bar
+  if (n != 2 || out[0].inst_id != 2 || out[1].inst_id != 2 || !(out[0].flags & out[1].flags & BAR_F_TIMER)) {
+    std::printf("timer sweep n=%d\n", n); rc = 1;
+  }
+  if (agg.close_expired(T0 + 63000 + 500, 1000, out, 16) != 0) { std::printf("grace\n"); rc = 1; }
+  n = agg.close_expired(T0 + 63000 + 1000, 1000, out, 16);
+  if (n != 1 || out[0].inst_id != 1 || out[0].start_ms != T0 + 62000 || !(out[0].flags & BAR_F_TIMER)) {
+    std::printf("timer close n=%d\n", n); rc = 1;
+  }
+  agg.update(1, T0 + 62900, 101.0, 20, 20200, 511, out);   // 62 秒已按时钟收盘 → 结转
+  agg.update(1, T0 + 63100, 102.0, 21, 21420, 511, out);
+  n = agg.update(1, T0 + 64000, 102.0, 21, 21420, 511, out);
+  if (n != 1 || out[0].start_ms != T0 + 63000 || out[0].volume != 7 + 1 || !(out[0].flags & BAR_F_LATE) || out[0].open != 102) {
+    std::printf("carry after timer n=%d v=%lld\n", n, n ? (long long)out[0].volume : 0LL); rc = 1;
+  }
+
+  // 7) 随机序列：各周期产出的成交量之和 = 全部差分之和（含收尾 close_all）
+  {
+    BarAggregator a(8);
+    const int ivs[] = {1, 60, 300};
+    a.set_intervals(ivs, 3);
+    std::mt19937 rng(1);
+    int64_t vol[8] = {0}, total = 0, sum[3] = {0, 0, 0}, ts = T0;
+    bool first[8] = {true, true, true, true, true, true, true, true};
+    for (int i = 0; i < 200000; ++i) {
+      const int id = (int)(rng() % 8);
+      ts += rng() % 40;
+      const int64_t late = (rng() % 50 == 0) ? 1500 : 0;   // 偶尔迟到 1.5 秒
+      const int64_t dv = rng() % 5;
+      vol[id] += dv;
+      if (!first[id]) total += dv;
+      first[id] = false;
+      Bar o[4];
+      const int k = a.update(id, ts - late, 100 + (rng() % 100) * 0.2, vol[id], (double)vol[id] * 100, 1000, o);
+      for (int j = 0; j < k; ++j) sum[o[j].interval_s == 1 ? 0 : (o[j].interval_s == 60 ? 1 : 2)] += o[j].volume;
+    }
+    Bar o[64];
+    for (int k; (k = a.close_all(o, 64)) > 0;)
+      for (int j = 0; j < k; ++j) sum[o[j].interval_s == 1 ? 0 : (o[j].interval_s == 60 ? 1 : 2)] += o[j].volume;
+    if (sum[0] != total || sum[1] != total || sum[2] != total) {
+      std::printf("conservation total=%lld 1s=%lld 1m=%lld 5m=%lld\n", (long long)total, (long long)sum[0],
+                  (long long)sum[1], (long long)sum[2]);
+      rc = 1;
+    }
+  }
+
+  // 8) 更新耗时（200 个合约 × 1s/1m）
+  {
+    BarAggregator a(256);
+    const int ivs[] = {1, 60};
+    a.set_intervals(ivs, 2);
+    const int N = 2000000;
+    long long sink = 0;
+    Bar o[4];
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; ++i) sink += a.update(i % 200, T0 + i / 4, 100 + (i & 15) * 0.2, i / 200, i * 50.0, 1000, o);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / N;
+    std::printf("update %.1f ns (bars=%lld)\n", ns, sink);
+  }
+
+  std::printf(rc == 0 ? "ALL OK\n" : "FAILED\n");
+  return rc;
+}
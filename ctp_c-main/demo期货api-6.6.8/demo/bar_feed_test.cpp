@@ -0,0 +1,157 @@
+// K 线驱动增量回测测试：bar_agg.h 由逐笔合成 bar，按 bar_emit 的方式交付 ctp_bar_t，
+// BarFeed（backtest 的 bar_feed.hpp）逐 bar 推进 MultiWeightState；与批量内核跑同样收盘价序列的结果对比，
+// 另验证合约 / 周期过滤、bars_*.bin 回读预热、每根 bar 推进耗时
+#include "bar_agg.h"
+#include "pyctp_bridge.h"
+#include "simd_backtest.hpp"
+#include "signal_processor.hpp"
+#include "bar_feed.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+static_assert(sizeof(ctp_bar_t) == sizeof(BarRecord) && sizeof(ctp_bar_t) == sizeof(LiveBar), "bar layout");
+static_assert(offsetof(ctp_bar_t, close) == offsetof(LiveBar, close) &&
+              offsetof(ctp_bar_t, flags) == offsetof(LiveBar, flags), "bar layout");
+
+static const int64_t T0 = 1760000000000LL - 1760000000000LL % 60000;
+static const char* const kInst[2] = {"rb2601", "ag2602"};
+static const int kSignals = 3, kWeights = 64;
+
+// 信号 / 权重取 0.25 的整数倍，组合值在 float 下精确，逐 bar 与批量 GEMM 的阈值判断一致
+static float quarter(std::mt19937& rng) { return float(int(rng() % 9) - 4) * 0.25f; }
+
+int main() {
+  int rc = 0;
+  std::mt19937 rng(7);
+  MatrixXf weights(kSignals, kWeights);
+  for (int i = 0; i < weights.size(); ++i) weights.data()[i] = quarter(rng);
+  const float threshold = 0.3f;
+  BacktestConfig config;
+
+  BarFeed feed_sig(kInst[0], 60, weights, threshold, config);
+  BarFeed feed_pos(kInst[0], 60, kWeights, config);
+  std::vector<ctp_bar_t> delivered;   // 回调收到的 rb2601 60s bar
+  std::vector<float> signal_rows;     // 每根 bar 收盘时的信号行
+  size_t other = 0, filtered = 0;
+
+  // 按 bar_emit：BarRecord（合约名 + Bar）→ ctp_bar_t 交给回调
+  auto emit = [&](const Bar& b) {
+    BarRecord r;
+    std::memset(r.inst, 0, sizeof(r.inst));
+    std::strncpy(r.inst, kInst[b.inst_id], sizeof(r.inst) - 1);
+    r.bar = b;
+    const ctp_bar_t* cb = reinterpret_cast<const ctp_bar_t*>(&r);
+    const LiveBar& bar = *reinterpret_cast<const LiveBar*>(cb);
+    VectorXf sig(kSignals);
+    for (int s = 0; s < kSignals; ++s) sig(s) = quarter(rng);
+    if (!feed_sig.matches(bar)) {
+      ++other;
+      if (feed_sig.on_bar_signals(bar, sig)) rc = 1;
+      return;
+    }
+    if (!feed_sig.on_bar_signals(bar, sig)) { std::printf("match but not advanced\n"); rc = 1; }
+    delivered.push_back(*cb);
+    signal_rows.insert(signal_rows.end(), sig.data(), sig.data() + kSignals);
+  };
+
+  // 1) 两个合约各按 1 笔 / 250ms 随机游走，5s + 60s 两个周期
+  BarAggregator agg(4);
+  const int iv[] = {5, 60};
+  agg.set_intervals(iv, 2);
+  Bar out[BarAggregator::kMaxIntervals];
+  double px[2] = {3500, 5800};
+  int64_t vol[2] = {0, 0};
+  const int n_ticks = 4 * 3600 * 4;   // 4 小时
+  for (int i = 0; i < n_ticks; ++i) {
+    for (int k = 0; k < 2; ++k) {
+      px[k] += double(int(rng() % 5) - 2);
+      vol[k] += rng() % 20;
+      const int n = agg.update(k, T0 + int64_t(i) * 250 + k, px[k], vol[k], double(vol[k]) * px[k], 1000, out);
+      for (int j = 0; j < n; ++j) emit(out[j]);
+    }
+  }
+  for (int n; (n = agg.close_all(out, BarAggregator::kMaxIntervals)) > 0;)
+    for (int j = 0; j < n; ++j) emit(out[j]);
+
+  const int T = int(delivered.size());
+  if (T < 200 || other < size_t(T) * 12) { std::printf("bars T=%d other=%zu\n", T, other); rc = 1; }
+  if (feed_sig.state().n_steps() != T) { std::printf("steps %lld != %d\n", feed_sig.state().n_steps(), T); rc = 1; }
+
+  // 2) 批量：同样的收盘价 + 信号矩阵，run_signal_backtest（持仓取上一根 bar 的组合信号）
+  VectorXf prices(T);
+  for (int t = 0; t < T; ++t) prices(t) = float(delivered[t].close);
+  const MatrixXf signals = Map<const Matrix<float, Dynamic, Dynamic, RowMajor>>(signal_rows.data(), T, kSignals);
+  FinalOutput final_sig;
+  MetricsOutput metrics_sig;
+  run_signal_backtest(prices, signals, weights, threshold, config, final_sig);
+  run_signal_backtest(prices, signals, weights, threshold, config, metrics_sig);
+
+  auto max_diff = [](const auto& a, const auto& b) { return (a - b).cwiseAbs().maxCoeff(); };
+  auto compare = [&](const char* what, const BarFeed& feed, const FinalOutput& f, MetricsOutput& m) {
+    const BacktestMetrics sm = feed.state().metrics(), bm = m.metrics();
+    const float d[6] = {max_diff(feed.state().portfolio(), f.final_portfolio),
+                        max_diff(feed.state().cash(), f.final_cash),
+                        max_diff(feed.state().quantity(), f.final_quantity),
+                        max_diff(sm.sharpe_ratio, bm.sharpe_ratio),
+                        max_diff(sm.max_drawdown, bm.max_drawdown),
+                        max_diff(sm.total_return, bm.total_return)};
+    std::printf("%s: T=%d portfolio=%g cash=%g qty=%g sharpe=%g mdd=%g ret=%g\n", what, T, d[0], d[1], d[2], d[3], d[4], d[5]);
+    if (d[0] > 1e-2f || d[1] > 1e-2f || d[2] > 1e-4f || d[3] > 1e-4f || d[4] > 1e-6f || d[5] > 1e-6f) rc = 1;
+  };
+  compare("signals", feed_sig, final_sig, metrics_sig);
+  if (feed_sig.state().quantity().cwiseAbs().maxCoeff() == 0) { std::printf("no trades\n"); rc = 1; }
+
+  // 3) bars_*.bin 回读：文件里混有其他合约 / 周期的 bar，按持仓推进，对比 run_multi_weight_simd
+  const std::string path = "/tmp/bar_feed_test_" + std::to_string(getpid()) + ".bin";
+  FILE* f = std::fopen(path.c_str(), "wb");
+  for (const ctp_bar_t& b : delivered) {
+    ctp_bar_t x = b;
+    x.interval_s = 5;
+    std::fwrite(&x, sizeof(x), 1, f);          // 周期不符
+    std::fwrite(&b, sizeof(b), 1, f);
+  }
+  std::fwrite(&delivered[0], 17, 1, f);        // 末尾不完整的记录
+  std::fclose(f);
+  const std::vector<LiveBar> bars = read_bar_file(path);
+  std::remove(path.c_str());
+  if (bars.size() != size_t(T) * 2) { std::printf("read %zu\n", bars.size()); rc = 1; }
+
+  const auto [combined, long_short, positions] = process_signals<float>(signals, weights, threshold);
+  for (size_t i = 0, t = 0; i < bars.size(); ++i) {
+    const bool ok = feed_pos.on_bar(bars[i], positions.row(std::min<size_t>(t, T - 1)));
+    if (ok) ++t; else ++filtered;
+  }
+  if (filtered != size_t(T)) { std::printf("filtered %zu\n", filtered); rc = 1; }
+  FinalOutput final_pos;
+  MetricsOutput metrics_pos;
+  run_multi_weight_simd(prices, positions, config, final_pos);
+  run_multi_weight_simd(prices, positions, config, metrics_pos);
+  compare("positions", feed_pos, final_pos, metrics_pos);
+
+  // 4) 参数检查
+  bool threw = false;
+  try { BarFeed bad("", 60, kWeights, config); } catch (const std::invalid_argument&) { threw = true; }
+  try { BarFeed bad(kInst[0], 0, kWeights, config); threw = false; } catch (const std::invalid_argument&) {}
+  try { feed_pos.on_bar_signals(bars[0], VectorXf::Zero(kSignals)); threw = false; } catch (const std::invalid_argument&) {}
+  try { feed_sig.on_bar_signals(bars[0], VectorXf::Zero(kSignals + 1)); threw = false; } catch (const std::invalid_argument&) {}
+  if (!threw) { std::printf("argument checks\n"); rc = 1; }
+
+  // 5) 每根 bar 推进耗时
+  const int reps = 20000;
+  feed_sig.reset();
+  const VectorXf sig = signals.row(0).transpose();
+  LiveBar bar = *reinterpret_cast<const LiveBar*>(&delivered[0]);
+  auto t1 = std::chrono::steady_clock::now();
+  for (int i = 0; i < reps; ++i) { bar.close = prices(i % T); feed_sig.on_bar_signals(bar, sig); }
+  auto t2 = std::chrono::steady_clock::now();
+  std::printf("on_bar_signals (%d weights): %.2f us/bar\n", kWeights,
+              std::chrono::duration<double, std::micro>(t2 - t1).count() / reps);
+
+  std::printf(rc ? "FAILED\n" : "ALL OK\n");
+  return rc;
+}
@@ -0,0 +1,246 @@
+// 列式 K 线库：每个（周期, 合约）一个目录，时间 / 价格 / 成交量各一个只追加的 .npy 列文件，外加分块统计，
+// 回测引擎（backtest_optimization_c 的 column_store.hpp）和 Python（np.load(mmap_mode='r')）直接映射读取，不解析不拷贝
+// 目录布局：{root}/{周期}/{合约}/
+//   timestamp.npy  <i8 (rows,)   区间起点（交易所时间，epoch ms），单调不减
+//   price.npy      <f4 (rows,)   收盘价（回测引擎按 float 计算）
+//   volume.npy     <i8 (rows,)   区间成交量
+//   chunks.npy     <f8 (n_chunks, 7) C 序，每块一行：first_row, rows, ts_min, ts_max, price_min, price_max, volume_sum
+// - 每个文件头固定 128 字节（NPY 1.0，空格补齐），追加后原地改写 shape；先写数据、再写分块、最后改头部，
+//   读端按三列头部行数的最小值读取，进程崩溃也只会少最后一次未完成的刷新
+// - 续写：同目录已有文件时从已提交行数接着写，最后一块的统计按数据重新计算
+// 单线程使用（发布线程）
+#pragma once
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static const int COLSTORE_HEADER_BYTES      = 128;
+static const int COLSTORE_CHUNK_FIELDS      = 7;
+static const int COLSTORE_DEFAULT_CHUNK_ROWS = 4096;
+
+// 固定 128 字节的 NPY 1.0 头部；cols<=0 为一维 (rows,)，否则二维 (rows, cols)
+inline std::string colstore_npy_header(const char* descr, int64_t rows, int cols) {
+  char dict[COLSTORE_HEADER_BYTES];
+  int n = cols > 0 ? std::snprintf(dict, sizeof(dict), "{'descr': '%s', 'fortran_order': False, 'shape': (%lld, %d), }", descr, (long long)rows, cols)
+                   : std::snprintf(dict, sizeof(dict), "{'descr': '%s', 'fortran_order': False, 'shape': (%lld,), }", descr, (long long)rows);
+  std::string h("\x93NUMPY\x01\x00", 8);
+  const int len = COLSTORE_HEADER_BYTES - 10;
+  h += (char)(len & 0xff);
+  h += (char)(len >> 8);
+  h.append(dict, (size_t)n);
+  h.append((size_t)(len - n - 1), ' ');
+  h += '\n';
+  return h;
+}
+
+// 读头部里的行数；不是本格式（头长、dtype 不符）返回 -1
+inline int64_t colstore_npy_rows(int fd, const char* descr) {
+  char h[COLSTORE_HEADER_BYTES + 1];
+  if (::pread(fd, h, COLSTORE_HEADER_BYTES, 0) != COLSTORE_HEADER_BYTES) return -1;
+  h[COLSTORE_HEADER_BYTES] = 0;
+  if (std::memcmp(h, "\x93NUMPY\x01", 7) != 0 || (uint8_t)h[8] + ((uint8_t)h[9] << 8) != COLSTORE_HEADER_BYTES - 10) return -1;
+  char want[32];
+  std::snprintf(want, sizeof(want), "'descr': '%s'", descr);
+  if (!std::strstr(h + 10, want)) return -1;
+  const char* s = std::strstr(h + 10, "'shape': (");
+  return s ? std::atoll(s + 10) : -1;
+}
+
+inline bool colstore_mkdirs(const std::string& dir) {
+  for (size_t i = 1; i <= dir.size(); ++i)
+    if (i == dir.size() || dir[i] == '/') ::mkdir(dir.substr(0, i).c_str(), 0755);
+  return ::access(dir.c_str(), W_OK) == 0;
+}
+
+class ColumnSeriesWriter {
+public:
+  enum { COL_TS, COL_PRICE, COL_VOLUME, COL_CHUNKS, N_FILES };
+
+  ~ColumnSeriesWriter() { close(); }
+
+  bool open(const std::string& dir, int chunk_rows = COLSTORE_DEFAULT_CHUNK_ROWS) {
+    close();
+    if (!colstore_mkdirs(dir)) return false;
+    chunk_rows_ = chunk_rows > 0 ? chunk_rows : COLSTORE_DEFAULT_CHUNK_ROWS;
+    static const char* const names[N_FILES] = {"timestamp.npy", "price.npy", "volume.npy", "chunks.npy"};
+    for (int i = 0; i < N_FILES; ++i)
+      if ((fd_[i] = ::open((dir + "/" + names[i]).c_str(), O_RDWR | O_CREAT, 0644)) < 0) { close(); return false; }
+    if (!resume()) { close(); return false; }
+    return true;
+  }
+
+  // 追加一行；时间戳早于上一行时丢弃并返回 false
+  bool append(int64_t ts_ms, float price, int64_t volume) {
+    if (fd_[0] < 0 || ts_ms < last_ts_) return false;
+    if (cur_rows_ == chunk_rows_) {  // 上一块已满：确认写出后再开新块
+      if (!flush()) return false;
+      cur_rows_ = 0;
+    }
+    if (cur_rows_ == 0) {
+      cur_[0] = (double)(rows_ + (int64_t)buf_ts_.size());
+      cur_[2] = cur_[3] = (double)ts_ms;
+      cur_[4] = cur_[5] = price;
+      cur_[6] = 0;
+    }
+    ++cur_rows_;
+    cur_[1] = (double)cur_rows_;
+    cur_[3] = (double)ts_ms;
+    cur_[4] = std::min(cur_[4], (double)price);
+    cur_[5] = std::max(cur_[5], (double)price);
+    cur_[6] += (double)volume;
+    buf_ts_.push_back(ts_ms);
+    buf_px_.push_back(price);
+    buf_vol_.push_back(volume);
+    last_ts_ = ts_ms;
+    if (cur_rows_ == chunk_rows_) flush();  // 块满即写出；失败时下一行先重试
+    return true;
+  }
+
+  // 把缓冲的行写入文件并更新分块与头部；失败时保留缓冲，下次重试
+  bool flush() {
+    const size_t n = buf_ts_.size();
+    if (n == 0 || fd_[0] < 0) return true;
+    const off_t at = COLSTORE_HEADER_BYTES;
+    if (!pwrite_all(fd_[COL_TS], buf_ts_.data(), n * 8, at + (off_t)rows_ * 8) ||
+        !pwrite_all(fd_[COL_PRICE], buf_px_.data(), n * 4, at + (off_t)rows_ * 4) ||
+        !pwrite_all(fd_[COL_VOLUME], buf_vol_.data(), n * 8, at + (off_t)rows_ * 8))
+      return false;
+    const int64_t chunk = n_chunks_ - (cur_is_open_ ? 1 : 0);  // 当前块的下标
+    if (!pwrite_all(fd_[COL_CHUNKS], cur_, sizeof(cur_), at + (off_t)chunk * sizeof(cur_))) return false;
+    rows_ += (int64_t)n;
+    n_chunks_ = chunk + 1;
+    cur_is_open_ = (int)cur_[1] < chunk_rows_;
+    if (!write_headers()) return false;
+    buf_ts_.clear(); buf_px_.clear(); buf_vol_.clear();
+    return true;
+  }
+
+  void close() {
+    if (fd_[0] >= 0) flush();
+    for (int& fd : fd_) if (fd >= 0) { ::close(fd); fd = -1; }
+    rows_ = n_chunks_ = 0;
+    cur_rows_ = 0;
+    cur_is_open_ = false;
+    last_ts_ = INT64_MIN;
+    buf_ts_.clear(); buf_px_.clear(); buf_vol_.clear();
+  }
+
+  bool is_open() const { return fd_[0] >= 0; }
+  bool dirty() const { return !buf_ts_.empty(); }
+  int64_t rows() const { return rows_ + (int64_t)buf_ts_.size(); }  // 含未刷新的行
+  int64_t committed_rows() const { return rows_; }
+
+private:
+  static bool pwrite_all(int fd, const void* p, size_t n, off_t off) {
+    const char* c = static_cast<const char*>(p);
+    while (n > 0) {
+      const ssize_t w = ::pwrite(fd, c, n, off);
+      if (w <= 0) return false;
+      c += w; n -= (size_t)w; off += w;
+    }
+    return true;
+  }
+
+  bool write_headers() {
+    const std::string h[N_FILES] = {colstore_npy_header("<i8", rows_, 0), colstore_npy_header("<f4", rows_, 0),
+                                    colstore_npy_header("<i8", rows_, 0), colstore_npy_header("<f8", n_chunks_, COLSTORE_CHUNK_FIELDS)};
+    for (int i = 0; i < N_FILES; ++i)
+      if (!pwrite_all(fd_[i], h[i].data(), h[i].size(), 0)) return false;
+    return true;
+  }
+
+  // 新文件写空头部；已有文件取三列行数的最小值，丢掉其后的分块，按数据重算最后一块
+  bool resume() {
+    struct stat st;
+    if (::fstat(fd_[COL_TS], &st) != 0) return false;
+    if (st.st_size == 0) return write_headers();
+    const int64_t r[3] = {colstore_npy_rows(fd_[COL_TS], "<i8"), colstore_npy_rows(fd_[COL_PRICE], "<f4"),
+                          colstore_npy_rows(fd_[COL_VOLUME], "<i8")};
+    const int64_t nc = colstore_npy_rows(fd_[COL_CHUNKS], "<f8");
+    if (r[0] < 0 || r[1] < 0 || r[2] < 0 || nc < 0) return false;
+    rows_ = std::min(r[0], std::min(r[1], r[2]));
+    n_chunks_ = 0;
+    for (int64_t c = nc - 1; c >= 0 && rows_ > 0; --c) {
+      double row[COLSTORE_CHUNK_FIELDS];
+      if (::pread(fd_[COL_CHUNKS], row, sizeof(row), COLSTORE_HEADER_BYTES + (off_t)c * sizeof(row)) != (ssize_t)sizeof(row)) continue;
+      if ((int64_t)row[0] < rows_) { n_chunks_ = c + 1; cur_[0] = row[0]; break; }
+    }
+    if (rows_ > 0 && n_chunks_ == 0) { n_chunks_ = 1; cur_[0] = 0; }
+    if (n_chunks_ > 0) {
+      const int64_t first = (int64_t)cur_[0], n = rows_ - first;
+      std::vector<int64_t> ts((size_t)n), vol((size_t)n);
+      std::vector<float> px((size_t)n);
+      if (::pread(fd_[COL_TS], ts.data(), (size_t)n * 8, COLSTORE_HEADER_BYTES + (off_t)first * 8) != (ssize_t)(n * 8) ||
+          ::pread(fd_[COL_PRICE], px.data(), (size_t)n * 4, COLSTORE_HEADER_BYTES + (off_t)first * 4) != (ssize_t)(n * 4) ||
+          ::pread(fd_[COL_VOLUME], vol.data(), (size_t)n * 8, COLSTORE_HEADER_BYTES + (off_t)first * 8) != (ssize_t)(n * 8))
+        return false;
+      cur_[1] = (double)n;
+      cur_[2] = (double)ts.front(); cur_[3] = (double)ts.back();
+      cur_[4] = *std::min_element(px.begin(), px.end());
+      cur_[5] = *std::max_element(px.begin(), px.end());
+      cur_[6] = 0;
+      for (int64_t v : vol) cur_[6] += (double)v;
+      last_ts_ = ts.back();
+      cur_rows_ = (int)std::min<int64_t>(n, chunk_rows_);
+      cur_is_open_ = n < chunk_rows_;
+      if (!pwrite_all(fd_[COL_CHUNKS], cur_, sizeof(cur_), COLSTORE_HEADER_BYTES + (off_t)(n_chunks_ - 1) * sizeof(cur_))) return false;
+    }
+    return write_headers();
+  }
+
+  int fd_[N_FILES] = {-1, -1, -1, -1};
+  int chunk_rows_ = COLSTORE_DEFAULT_CHUNK_ROWS;
+  int64_t rows_ = 0, n_chunks_ = 0;   // 已提交的行数 / 块数
+  double cur_[COLSTORE_CHUNK_FIELDS] = {0};  // 当前块统计
+  int cur_rows_ = 0;        // 当前块已有行数（含未刷新）；0 或 chunk_rows_ 时下一行开新块
+  bool cur_is_open_ = false;  // 已提交的最后一块还没写满（下次刷新覆盖同一块）
+  int64_t last_ts_ = INT64_MIN;
+  std::vector<int64_t> buf_ts_, buf_vol_;
+  std::vector<float> buf_px_;
+};
+
+// 多个序列：按 {root}/{周期}/{合约} 懒打开
+class ColumnStoreWriter {
+public:
+  void set_root(const std::string& root, int chunk_rows) { close_all(); root_ = root; chunk_rows_ = chunk_rows; }
+  bool enabled() const { return !root_.empty(); }
+
+  bool append(const char* interval, const char* inst, int64_t ts_ms, float price, int64_t volume) {
+    std::string key = std::string(interval) + "/" + inst;
+    auto it = series_.find(key);
+    if (it == series_.end()) {
+      std::unique_ptr<ColumnSeriesWriter> w(new ColumnSeriesWriter());
+      if (!w->open(root_ + "/" + key, chunk_rows_)) { ++open_fail_; w.reset(); }
+      it = series_.emplace(std::move(key), std::move(w)).first;  // 打不开也记下，不再反复尝试
+    }
+    if (!it->second) { ++dropped_; return false; }
+    if (!it->second->append(ts_ms, price, volume)) { ++dropped_; return false; }
+    ++rows_;
+    return true;
+  }
+
+  void flush_all() {
+    for (auto& kv : series_)
+      if (kv.second && kv.second->dirty()) kv.second->flush();
+  }
+  void close_all() { series_.clear(); }  // 析构时刷新并关闭
+
+  long long rows() const { return rows_; }
+  long long dropped() const { return dropped_; }
+  long long open_fail() const { return open_fail_; }
+  size_t series() const { return series_.size(); }
+
+private:
+  std::string root_;
+  int chunk_rows_ = COLSTORE_DEFAULT_CHUNK_ROWS;
+  std::unordered_map<std::string, std::unique_ptr<ColumnSeriesWriter>> series_;
+  long long rows_ = 0, dropped_ = 0, open_fail_ = 0;
+};
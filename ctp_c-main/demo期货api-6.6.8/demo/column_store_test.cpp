@@ -0,0 +1,133 @@
+// column_store.h 测试：头部格式、分块统计、乱序丢弃、关闭后续写、模拟崩溃（头部行数不一致）后续写、
+// 多序列懒打开；追加吞吐
+#include "column_store.h"
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+// 按头部行数读回一列（chunks.npy 每行 COLSTORE_CHUNK_FIELDS 个数）
+template <typename T>
+static std::vector<T> column(const std::string& path, const char* descr, int per_row = 1) {
+  std::vector<T> out;
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return out;
+  const int64_t rows = colstore_npy_rows(fd, descr);
+  if (rows > 0) {
+    out.resize((size_t)(rows * per_row));
+    if (::pread(fd, out.data(), out.size() * sizeof(T), COLSTORE_HEADER_BYTES) != (ssize_t)(out.size() * sizeof(T))) out.clear();
+  }
+  ::close(fd);
+  return out;
+}
+static std::vector<int64_t> ts_col(const std::string& dir) { return column<int64_t>(dir + "/timestamp.npy", "<i8"); }
+static std::vector<double> chunk_col(const std::string& dir) { return column<double>(dir + "/chunks.npy", "<f8", COLSTORE_CHUNK_FIELDS); }
+
+int main() {
+  int rc = 0;
+  char tmpl[] = "/tmp/colstore_test_XXXXXX";
+  const std::string root = mkdtemp(tmpl);
+  const std::string dir = root + "/1m/IF2512";
+
+  // 1) 头部：128 字节、换行结尾、shape 原地改写
+  {
+    const std::string h1 = colstore_npy_header("<i8", 0, 0), h2 = colstore_npy_header("<f8", 123456789012LL, 7);
+    if (h1.size() != 128 || h2.size() != 128 || h1.back() != '\n' || h2.find("(123456789012, 7)") == std::string::npos) {
+      std::printf("header\n"); rc = 1;
+    }
+  }
+
+  // 2) 写 10 行（块 4 行）：3 块、统计正确；乱序丢弃
+  {
+    ColumnSeriesWriter w;
+    if (!w.open(dir, 4)) { std::printf("open %s\n", dir.c_str()); return 1; }
+    for (int i = 0; i < 10; ++i)
+      if (!w.append(1000 + i * 60000, 4000.0f + (i % 3), 10 + i)) { std::printf("append %d\n", i); rc = 1; }
+    if (w.append(999, 1.0f, 1) || w.rows() != 10) { std::printf("out of order accepted\n"); rc = 1; }
+    if (w.committed_rows() != 8) { std::printf("full chunks not flushed: %lld\n", (long long)w.committed_rows()); rc = 1; }
+    w.flush();
+  }
+  {
+    auto ts = ts_col(dir);
+    auto px = column<float>(dir + "/price.npy", "<f4");
+    auto vol = column<int64_t>(dir + "/volume.npy", "<i8");
+    auto ch = chunk_col(dir);
+    if (ts.size() != 10 || px.size() != 10 || vol.size() != 10 || ts[9] != 1000 + 9 * 60000 || px[4] != 4001.0f || vol[9] != 19) {
+      std::printf("columns %zu %zu %zu\n", ts.size(), px.size(), vol.size()); rc = 1;
+    }
+    // 块 2：行 8、9
+    if (ch.size() != 3 * 7 || ch[0] != 0 || ch[1] != 4 || ch[7] != 4 || ch[14] != 8 || ch[15] != 2 ||
+        ch[16] != 1000 + 8 * 60000 || ch[17] != 1000 + 9 * 60000 || ch[18] != 4000 || ch[19] != 4002 || ch[20] != 18 + 19) {
+      std::printf("chunks size=%zu\n", ch.size()); rc = 1;
+    }
+  }
+
+  // 3) 续写：最后一块接着填满；早于已有最后一行的丢弃
+  {
+    ColumnSeriesWriter w;
+    if (!w.open(dir, 4) || w.rows() != 10) { std::printf("reopen rows=%lld\n", (long long)w.rows()); rc = 1; }
+    if (w.append(500, 1.0f, 1)) { std::printf("resume last_ts\n"); rc = 1; }
+    for (int i = 10; i < 13; ++i) w.append(1000 + i * 60000, 4010.0f, 1);
+  }
+  {
+    auto ch = chunk_col(dir);
+    if (ts_col(dir).size() != 13 || ch.size() != 4 * 7 || ch[15] != 4 || ch[19] != 4010 || ch[21] != 12 || ch[22] != 1) {
+      std::printf("resume chunks size=%zu\n", ch.size()); rc = 1;
+    }
+  }
+
+  // 4) 模拟崩溃：price 头部停在 11 行 → 续写按 11 行继续，第 2 块统计按数据重算
+  {
+    const int fd = ::open((dir + "/price.npy").c_str(), O_RDWR);
+    const std::string h = colstore_npy_header("<f4", 11, 0);
+    if (::pwrite(fd, h.data(), h.size(), 0) != (ssize_t)h.size()) rc = 1;
+    ::close(fd);
+    ColumnSeriesWriter w;
+    if (!w.open(dir, 4) || w.rows() != 11) { std::printf("crash resume rows=%lld\n", (long long)w.rows()); rc = 1; }
+    w.close();
+    auto ch = chunk_col(dir);
+    if (ch.size() != 3 * 7 || ch[15] != 3 || ch[19] != 4010 || ch[17] != 1000 + 10 * 60000) { std::printf("crash chunks size=%zu\n", ch.size()); rc = 1; }
+  }
+
+  // 5) 不是本格式的文件：打开失败
+  {
+    const std::string bad = root + "/bad";
+    colstore_mkdirs(bad);
+    if (FILE* f = std::fopen((bad + "/timestamp.npy").c_str(), "wb")) { std::fputs("not npy", f); std::fclose(f); }
+    ColumnSeriesWriter w;
+    if (w.open(bad)) { std::printf("bad file accepted\n"); rc = 1; }
+  }
+
+  // 6) 多序列：懒打开、打不开的只记一次
+  {
+    ColumnStoreWriter s;
+    s.set_root(root + "/store", 64);
+    s.append("1m", "rb2510", 1000, 3000.0f, 5);
+    s.append("1s", "rb2510", 1000, 3000.0f, 5);
+    s.append("1m", "rb2510", 500, 3000.0f, 5);   // 乱序
+    s.flush_all();
+    if (s.series() != 2 || s.rows() != 2 || s.dropped() != 1 || ts_col(root + "/store/1s/rb2510").size() != 1) {
+      std::printf("store series=%zu rows=%lld dropped=%lld\n", s.series(), s.rows(), s.dropped()); rc = 1;
+    }
+    ColumnStoreWriter ro;
+    ro.set_root("/proc/colstore_forbidden", 64);
+    ro.append("1m", "x", 1, 1, 1);
+    ro.append("1m", "x", 2, 1, 1);
+    if (ro.open_fail() != 1 || ro.dropped() != 2) { std::printf("open_fail=%lld\n", ro.open_fail()); rc = 1; }
+  }
+
+  // 7) 吞吐：1M 行、默认块大小
+  {
+    ColumnSeriesWriter w;
+    w.open(root + "/bench");
+    const int N = 1000000;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; ++i) w.append(i, 100.0f + (i & 7), i & 15);
+    w.flush();
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / N;
+    std::printf("append %.1f ns/row (%lld rows)\n", ns, (long long)w.committed_rows());
+  }
+
+  std::system(("rm -rf " + root).c_str());
+  std::printf(rc == 0 ? "ALL OK\n" : "FAILED\n");
+  return rc;
+}
@@ -1,21 +1,13 @@
 // 覆盖 /home/zhousiyuan/ctp_c/demo期货api-6.6.8/demo/define.h
 #pragma once
 #include <stdio.h>
-#include <utility>
+#include "async_log.h"  // LOG 走异步日志：调用线程只入队，后台线程格式化并写 logfile（另写一份 stdout）
 
 extern FILE *logfile;
 
-// 仅字符串（无需格式）
-inline void LOG(const char *s) {
-    fprintf(logfile, "%s", s);
-    printf("%s", s);
-    fflush(logfile);
-}
+// 仅字符串（无需格式）：内容按值拷贝，可传非字面量
+inline void LOG(const char *s) { ctp_log_at<CTP_LOG_DEBUG>(s); }
 
-// 带格式化参数
+// 带格式化参数：fmt 须为字符串字面量
 template <typename... Args>
-inline void LOG(const char *fmt, Args&&... args) {
-    fprintf(logfile, fmt, std::forward<Args>(args)...);
-    printf(fmt, std::forward<Args>(args)...);
-    fflush(logfile);
-}
\ No newline at end of file
+inline void LOG(const char *fmt, const Args&... args) { ctp_log_at<CTP_LOG_DEBUG>(fmt, args...); }
\ No newline at end of file
@@ -0,0 +1,99 @@
+// 交易所时间解析：ActionDay/TradingDay + UpdateTime + UpdateMillisec → Unix 纳秒（与 now_ns() 的 recv_ns 同一时基）
+// 逐笔只做定长数字运算：日期字符串按 8 字节比较命中缓存，当日 0 点的 epoch 只在换日时用 mktime 算一次，
+// UpdateTime "HH:MM:SS" 按固定偏移取数字
+//
+// 夜盘日期：各所字段含义不同
+//   上期所/能源中心：ActionDay 为自然日，TradingDay 为下一交易日（正确）
+//   大商所：ActionDay 与 TradingDay 相同，都是下一交易日（周五夜盘显示为下周一）
+//   郑商所：ActionDay 与 TradingDay 相同，都是夜盘所在的自然日（凌晨后为前一自然日）
+// 仅凭行情字段无法区分后两者，因此以本机收到时间 ref_ns 为参照：按 ActionDay（为空用 TradingDay）算出的时间
+// 与 ref_ns 相差超过 12 小时时，按整天平移到离 ref_ns 最近的那一天（最多 ±4 天，覆盖周末）。
+// 要求本机时钟误差远小于 12 小时；ref_ns<=0 时不做修正。
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include "ThostFtdcUserApiStruct.h"
+
+class ExchTimeDecoder {
+public:
+  static constexpr int64_t kDayNs = 86400LL * 1000000000LL;
+
+  // 无法解析返回 0；单线程使用（缓存无锁）
+  int64_t decode_ns(const CThostFtdcDepthMarketDataField& md, int64_t ref_ns) {
+    const char* day = md.ActionDay[0] ? md.ActionDay : md.TradingDay;
+    int64_t base = day_base_ns(day);
+    if (base < 0) return 0;
+    int64_t tod = tod_ms(md.UpdateTime);
+    if (tod < 0) return 0;
+    int64_t ms = md.UpdateMillisec;
+    if (ms < 0 || ms > 999) ms = 0;
+    int64_t ts = base + (tod + ms) * 1000000LL;
+    if (ref_ns > 0) {
+      int64_t diff = ref_ns - ts;
+      if (diff > kDayNs / 2 || diff < -kDayNs / 2) {
+        // 按整天平移（国内无夏令时，整天即 86400s）
+        int64_t k = (diff + (diff > 0 ? kDayNs / 2 : -kDayNs / 2)) / kDayNs;
+        if (k >= -4 && k <= 4) ts += k * kDayNs;
+      }
+    }
+    return ts;
+  }
+
+  int64_t decode_ms(const CThostFtdcDepthMarketDataField& md, int64_t ref_ns) {
+    return decode_ns(md, ref_ns) / 1000000;
+  }
+
+  // "HH:MM:SS" → 当日毫秒；格式不符返回 -1
+  static int64_t tod_ms(const char* t) {
+    auto dg = [](char c) { return (unsigned)(c - '0') <= 9u; };
+    if (!dg(t[0]) || !dg(t[1]) || t[2] != ':' || !dg(t[3]) || !dg(t[4]) || t[5] != ':' || !dg(t[6]) || !dg(t[7]))
+      return -1;
+    int H = (t[0] - '0') * 10 + (t[1] - '0');
+    int M = (t[3] - '0') * 10 + (t[4] - '0');
+    int S = (t[6] - '0') * 10 + (t[7] - '0');
+    if (H > 23 || M > 59 || S > 60) return -1;
+    return ((int64_t)H * 3600 + M * 60 + S) * 1000;
+  }
+
+  // "YYYYMMDD" 当地 0 点的 Unix 纳秒；两项缓存（夜盘 ActionDay 与修正后日期交替出现时也能命中）
+  int64_t day_base_ns(const char* day) {
+    uint64_t key;
+    std::memcpy(&key, day, 8);  // TThostFtdcDateType 为 char[9]，总能读 8 字节
+    for (Slot& s : slots_)
+      if (s.key == key) return s.base_ns;
+    int64_t base = compute_day_base_ns(day);
+    if (base < 0) return -1;
+    Slot& s = slots_[next_];
+    next_ ^= 1;
+    s.key = key;
+    s.base_ns = base;
+    ++misses_;
+    return base;
+  }
+
+  uint64_t cache_misses() const { return misses_; }
+
+private:
+  static int64_t compute_day_base_ns(const char* day) {
+    int v[8];
+    for (int i = 0; i < 8; ++i) {
+      if ((unsigned)(day[i] - '0') > 9u) return -1;
+      v[i] = day[i] - '0';
+    }
+    std::tm tm{};
+    tm.tm_year = v[0] * 1000 + v[1] * 100 + v[2] * 10 + v[3] - 1900;
+    tm.tm_mon = v[4] * 10 + v[5] - 1;
+    tm.tm_mday = v[6] * 10 + v[7];
+    tm.tm_isdst = -1;
+    if (tm.tm_mon < 0 || tm.tm_mon > 11 || tm.tm_mday < 1 || tm.tm_mday > 31) return -1;
+    time_t sec = std::mktime(&tm);
+    if (sec < 0) return -1;
+    return (int64_t)sec * 1000000000LL;
+  }
+
+  struct Slot { uint64_t key = ~0ull; int64_t base_ns = 0; };  // 全 0xFF 不是合法日期
+  Slot slots_[2];
+  int next_ = 0;
+  uint64_t misses_ = 0;
+};
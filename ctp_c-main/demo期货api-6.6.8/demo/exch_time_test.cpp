@@ -0,0 +1,105 @@
+// exch_time.h 测试：与 sscanf + mktime 逐笔结果一致、各所夜盘日期修正、非法输入、逐笔耗时
+#include "exch_time.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+// 原实现：两次 sscanf + mktime
+static long long ref_ms(const CThostFtdcDepthMarketDataField& md) {
+  const char* day = md.ActionDay[0] ? md.ActionDay : md.TradingDay;
+  int y = 0, m = 0, d = 0, H = 0, M = 0, S = 0;
+  if (std::sscanf(day, "%4d%2d%2d", &y, &m, &d) != 3) return 0;
+  if (std::sscanf(md.UpdateTime, "%2d:%2d:%2d", &H, &M, &S) != 3) return 0;
+  std::tm tm{};
+  tm.tm_year = y - 1900; tm.tm_mon = m - 1; tm.tm_mday = d;
+  tm.tm_hour = H; tm.tm_min = M; tm.tm_sec = S; tm.tm_isdst = -1;
+  time_t sec = std::mktime(&tm);
+  return sec < 0 ? 0 : (long long)sec * 1000 + md.UpdateMillisec;
+}
+
+static void copy_field(char* dst, size_t cap, const char* src) {
+  size_t n = std::strlen(src);
+  std::memcpy(dst, src, n < cap ? n : cap - 1);
+}
+
+static CThostFtdcDepthMarketDataField make_md(const char* action, const char* trading, const char* t, int ms) {
+  CThostFtdcDepthMarketDataField md;
+  std::memset(&md, 0, sizeof(md));
+  copy_field(md.ActionDay, sizeof(md.ActionDay), action);
+  copy_field(md.TradingDay, sizeof(md.TradingDay), trading);
+  copy_field(md.UpdateTime, sizeof(md.UpdateTime), t);
+  md.UpdateMillisec = ms;
+  return md;
+}
+
+// 本地时间 → Unix ms（作参照时钟）
+static long long local_ms(int y, int m, int d, int H, int M, int S) {
+  std::tm tm{};
+  tm.tm_year = y - 1900; tm.tm_mon = m - 1; tm.tm_mday = d;
+  tm.tm_hour = H; tm.tm_min = M; tm.tm_sec = S; tm.tm_isdst = -1;
+  return (long long)std::mktime(&tm) * 1000;
+}
+
+int main() {
+  setenv("TZ", "Asia/Shanghai", 1);
+  tzset();
+  int rc = 0;
+  ExchTimeDecoder dec;
+
+  // 1) 随机日期/时间与原实现一致（不给参照时钟）
+  std::mt19937 rng(7);
+  for (int i = 0; i < 200000; ++i) {
+    char day[16], t[16];
+    std::snprintf(day, sizeof(day), "%04d%02d%02d", 2020 + (int)(rng() % 8), 1 + (int)(rng() % 12), 1 + (int)(rng() % 28));
+    std::snprintf(t, sizeof(t), "%02d:%02d:%02d", (int)(rng() % 24), (int)(rng() % 60), (int)(rng() % 60));
+    CThostFtdcDepthMarketDataField md = (i & 1) ? make_md(day, "20250101", t, (int)(rng() % 1000)) : make_md("", day, t, 500);
+    if (dec.decode_ms(md, 0) != ref_ms(md)) { std::printf("mismatch %s %s\n", day, t); rc = 1; break; }
+  }
+
+  // 2) 夜盘：参照时钟为真实收到时间（交易所时间后 30ms）
+  struct Case { const char* name; const char* action; const char* trading; const char* t; long long real_ms; };
+  const Case cases[] = {
+    // 周五 2025-10-10 夜盘，下一交易日为周一 10-13
+    {"SHFE night",        "20251010", "20251013", "21:05:00", local_ms(2025, 10, 10, 21, 5, 0)},
+    {"SHFE after 0:00",   "20251011", "20251013", "00:30:00", local_ms(2025, 10, 11, 0, 30, 0)},
+    {"DCE night",         "20251013", "20251013", "21:05:00", local_ms(2025, 10, 10, 21, 5, 0)},
+    {"DCE after 0:00",    "20251013", "20251013", "00:30:00", local_ms(2025, 10, 11, 0, 30, 0)},
+    {"CZCE night",        "20251010", "20251010", "21:05:00", local_ms(2025, 10, 10, 21, 5, 0)},
+    {"CZCE after 0:00",   "20251010", "20251010", "00:30:00", local_ms(2025, 10, 11, 0, 30, 0)},
+    {"day session",       "20251013", "20251013", "10:15:00", local_ms(2025, 10, 13, 10, 15, 0)},
+    {"empty ActionDay",   "",         "20251013", "14:59:59", local_ms(2025, 10, 13, 14, 59, 59)},
+  };
+  for (const Case& c : cases) {
+    CThostFtdcDepthMarketDataField md = make_md(c.action, c.trading, c.t, 250);
+    long long expect = c.real_ms + 250;
+    long long got = dec.decode_ms(md, (expect + 30) * 1000000LL);
+    if (got != expect) { std::printf("%s: got %lld expect %lld\n", c.name, got, expect); rc = 1; }
+  }
+
+  // 3) 非法输入返回 0
+  const CThostFtdcDepthMarketDataField bad[] = {
+    make_md("", "", "09:30:00", 0), make_md("2025101x", "", "09:30:00", 0),
+    make_md("20251013", "", "9:30:00", 0), make_md("20251013", "", "25:00:00", 0),
+    make_md("20251332", "", "09:30:00", 0),
+  };
+  for (const auto& md : bad)
+    if (dec.decode_ns(md, 0) != 0) { std::printf("bad input accepted: %s %s\n", md.ActionDay, md.UpdateTime); rc = 1; }
+
+  // 4) 耗时：同一交易日逐笔解析
+  const int N = 2000000;
+  CThostFtdcDepthMarketDataField md = make_md("20251013", "20251013", "10:15:00", 0);
+  long long sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < N; ++i) { md.UpdateMillisec = i % 1000; sink += dec.decode_ns(md, 0); }
+  double fast = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / N;
+  t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < N / 10; ++i) { md.UpdateMillisec = i % 1000; sink += ref_ms(md); }
+  double slow = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / (N / 10);
+  std::printf("decode %.1f ns/tick, sscanf+mktime %.1f ns/tick, day cache misses=%llu (sink=%lld)\n",
+              fast, slow, (unsigned long long)dec.cache_misses(), sink & 1);
+
+  std::printf(rc == 0 ? "ALL OK\n" : "FAILED\n");
+  return rc;
+}
@@ -0,0 +1,75 @@
+// GBK → UTF-8 转换：每线程缓存一个 iconv 句柄（iconv_open 要加载 gconv 模块，开销远大于转换本身）
+// - 纯 ASCII（报单引用、状态文本等绝大多数回报）直接返回原指针，不拷贝
+// - 非 ASCII 短串按内容记入小的直接映射表，CTP 反复出现的错误信息 / 状态文本命中后不再调 iconv
+// 返回的指针在本线程下一次 convert 之前有效
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <iconv.h>
+#include <string>
+
+class GbkToUtf8 {
+public:
+  static constexpr int kMemoSlots = 64;
+  static constexpr size_t kMemoMaxLen = 255;  // 超过此长度的串不入表
+
+  GbkToUtf8() = default;
+  GbkToUtf8(const GbkToUtf8&) = delete;
+  GbkToUtf8& operator=(const GbkToUtf8&) = delete;
+  ~GbkToUtf8() { if (cd_ != (iconv_t)-1) iconv_close(cd_); }
+
+  // 转换失败（无句柄 / 非法字节序列）时返回原串
+  const char* convert(const char* s) {
+    if (!s) return "";
+    const unsigned char* p = (const unsigned char*)s;
+    while (*p && *p < 0x80) ++p;
+    if (!*p) return s;
+    const size_t len = (size_t)((const char*)p - s) + std::strlen((const char*)p);
+    if (len > kMemoMaxLen) { ++misses_; return convert_(s, len, scratch_) ? scratch_.c_str() : s; }
+    Memo& m = memo_[hash_(s, len) & (kMemoSlots - 1)];
+    if (m.ok && m.key.size() == len && std::memcmp(m.key.data(), s, len) == 0) { ++hits_; return m.val.c_str(); }
+    ++misses_;
+    if (!convert_(s, len, m.val)) { m.ok = false; return s; }
+    m.key.assign(s, len);
+    m.ok = true;
+    return m.val.c_str();
+  }
+
+  long long hits() const { return hits_; }
+  long long misses() const { return misses_; }
+
+private:
+  struct Memo { std::string key, val; bool ok = false; };
+
+  static uint32_t hash_(const char* s, size_t n) {
+    uint32_t h = 2166136261u;  // FNV-1a
+    for (size_t i = 0; i < n; ++i) h = (h ^ (unsigned char)s[i]) * 16777619u;
+    return h;
+  }
+
+  bool convert_(const char* s, size_t len, std::string& out) {
+    if (cd_ == (iconv_t)-1) {
+      cd_ = iconv_open("UTF-8//IGNORE", "GBK");
+      if (cd_ == (iconv_t)-1) return false;
+    }
+    iconv(cd_, nullptr, nullptr, nullptr, nullptr);  // 复位移位状态（上次可能中途出错）
+    out.resize(len * 3 + 8);
+    char* inbuf = const_cast<char*>(s);
+    char* outbuf = &out[0];
+    size_t inlen = len, outleft = out.size();
+    if (iconv(cd_, &inbuf, &inlen, &outbuf, &outleft) == (size_t)-1) return false;
+    out.resize(out.size() - outleft);
+    return true;
+  }
+
+  iconv_t cd_ = (iconv_t)-1;
+  Memo memo_[kMemoSlots];
+  std::string scratch_;
+  long long hits_ = 0, misses_ = 0;
+};
+
+// 本线程的转换器
+inline GbkToUtf8& gbk_to_utf8_tls() {
+  static thread_local GbkToUtf8 c;
+  return c;
+}
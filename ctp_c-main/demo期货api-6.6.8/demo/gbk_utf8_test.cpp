@@ -0,0 +1,102 @@
+// gbk_utf8.h 测试：ASCII 零拷贝、中文转换正确、缓存命中、槽位冲突覆盖、长串不入表、多线程各自句柄、耗时对比
+#include "gbk_utf8.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// "报单被拒绝" / "中文" 的 GBK 编码
+static const char kRejGbk[] = "\xB1\xA8\xB5\xA5\xB1\xBB\xBE\xDC\xBE\xF8";
+static const char kRejUtf8[] = "\xE6\x8A\xA5\xE5\x8D\x95\xE8\xA2\xAB\xE6\x8B\x92\xE7\xBB\x9D";
+static const char kZhGbk[] = "\xD6\xD0\xCE\xC4";
+static const char kZhUtf8[] = "\xE4\xB8\xAD\xE6\x96\x87";
+
+// 旧实现：每次 iconv_open / iconv_close
+static std::string convert_open_close(const char* s) {
+  iconv_t cd = iconv_open("UTF-8//IGNORE", "GBK");
+  if (cd == (iconv_t)-1) return s;
+  size_t inlen = std::strlen(s), outleft = inlen * 3 + 8;
+  std::string out(outleft, '\0');
+  char* in = const_cast<char*>(s);
+  char* o = &out[0];
+  if (iconv(cd, &in, &inlen, &o, &outleft) == (size_t)-1) { iconv_close(cd); return s; }
+  iconv_close(cd);
+  out.resize(out.size() - outleft);
+  return out;
+}
+
+int main() {
+  int rc = 0;
+  GbkToUtf8 c;
+
+  // 1) ASCII 原指针返回，不计入命中 / 未命中
+  const char* ascii = "       12345 OrderInsert ok";
+  if (c.convert(ascii) != ascii || std::strcmp(c.convert(nullptr), "") != 0 || c.hits() + c.misses() != 0) {
+    std::printf("ascii fast path\n"); rc = 1;
+  }
+
+  // 2) 转换正确；第二次命中缓存
+  if (std::strcmp(c.convert(kRejGbk), kRejUtf8) != 0) { std::printf("convert\n"); rc = 1; }
+  if (std::strcmp(c.convert(kRejGbk), kRejUtf8) != 0 || c.hits() != 1 || c.misses() != 1) { std::printf("memo hit\n"); rc = 1; }
+  std::string mixed = std::string("CTP:") + kZhGbk + " ref=12";
+  if (c.convert(mixed.c_str()) != std::string("CTP:") + kZhUtf8 + " ref=12") { std::printf("mixed\n"); rc = 1; }
+
+  // 3) 许多不同文本轮转（远超槽数）：结果始终正确
+  for (int i = 0; i < 1000; ++i) {
+    std::string s = std::string(kZhGbk) + std::to_string(i);
+    if (c.convert(s.c_str()) != std::string(kZhUtf8) + std::to_string(i)) { std::printf("rotate %d\n", i); rc = 1; break; }
+  }
+
+  // 4) 长串不入表但同样正确
+  std::string lg, lu;
+  for (int i = 0; i < 100; ++i) { lg += kZhGbk; lu += kZhUtf8; }
+  if (c.convert(lg.c_str()) != lu) { std::printf("long\n"); rc = 1; }
+
+  // 5) 非法序列：不崩溃，返回非空串
+  const char bad[] = "\x81";
+  if (!c.convert(bad)) { std::printf("invalid\n"); rc = 1; }
+  if (std::strcmp(c.convert(kRejGbk), kRejUtf8) != 0) { std::printf("after invalid\n"); rc = 1; }
+
+  // 6) 多线程：各线程的转换器互不影响
+  {
+    std::vector<std::thread> th;
+    std::vector<int> bad_n(4, 0);
+    for (int t = 0; t < 4; ++t)
+      th.emplace_back([&, t] {
+        for (int i = 0; i < 20000; ++i) {
+          std::string s = std::string(kZhGbk) + std::to_string((i + t) % 100);
+          if (gbk_to_utf8_tls().convert(s.c_str()) != std::string(kZhUtf8) + std::to_string((i + t) % 100)) ++bad_n[t];
+        }
+      });
+    for (auto& x : th) x.join();
+    for (int t = 0; t < 4; ++t) if (bad_n[t]) { std::printf("thread %d bad=%d\n", t, bad_n[t]); rc = 1; }
+  }
+
+  // 7) 耗时：每次 open/close vs 缓存句柄未命中 vs 命中 vs ASCII
+  {
+    const int N = 20000;
+    auto ns = [](auto t0) { return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count(); };
+    size_t sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; ++i) sink += convert_open_close(kRejGbk).size();
+    const double old_ns = ns(t0) / N;
+    std::vector<std::string> texts;
+    for (int i = 0; i < 64; ++i) texts.push_back(std::string(kRejGbk) + std::to_string(i * 7919));
+    GbkToUtf8 m;
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; ++i) sink += std::strlen(m.convert(texts[i % 64].c_str()));
+    const double mixed_ns = ns(t0) / N;
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; ++i) sink += std::strlen(m.convert(kRejGbk));
+    const double hit_ns = ns(t0) / N;
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; ++i) sink += std::strlen(m.convert(ascii));
+    const double ascii_ns = ns(t0) / N;
+    std::printf("open/close %.0f ns, cached handle (64 texts, hits=%lld misses=%lld) %.0f ns, hit %.0f ns, ascii %.0f ns (sink=%zu)\n",
+                old_ns, m.hits(), m.misses(), mixed_ns, hit_ns, ascii_ns, sink & 1);
+  }
+
+  std::printf(rc == 0 ? "ALL OK\n" : "FAILED\n");
+  return rc;
+}
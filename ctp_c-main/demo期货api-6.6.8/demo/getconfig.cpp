@@ -16,6 +16,7 @@
 #include <sstream>
 #include <locale.h>
 #include <vector>
+#include <map>
 
 /*函数名称：getConfig()
 函数功能：获取配置文件ini中相应大标题title下指定配置字段cfgname的值
@@ -54,9 +55,13 @@ vector<string> split(const string &str, const string &pattern)
 //	return;
 //}
 
-string getConfig(string title, string cfgName)
+// 配置表：首次调用时整份读入，之后按 标题 → 字段 查表，不再逐个字段重新打开文件扫描
+// 与逐行查找的规则一致：# 开头为注释；同名标题只认第一个；同一标题下同名字段只认第一个；值取第一个 = 之后的全部内容
+static map<string, map<string, string>> g_config;
+static bool g_config_loaded = false;
+
+static void loadConfig(const char* INIFile)
 {
-	const char* INIFile = "config.ini";
 	ifstream inifile(INIFile);
 	if (!inifile.is_open())
 	{
@@ -65,47 +70,37 @@ string getConfig(string title, string cfgName)
 		_getch();
 		exit(-1);
 	}
-	string strtmp, strtitle, strcfgname, returnValue;
-	int flag = 0;
+	string strtmp;
+	map<string, string>* section = NULL;
 	while (getline(inifile, strtmp, '\n'))
 	{
-		if (strtmp.substr(0, 1) == "#")	continue;	//过滤注释		
-		if (flag == 0)
-		{
-			if (strtmp.find(title) != string::npos)
-			{
-				if (strtmp.substr(0, 1) == "[")
-				{
-					if (strtmp.find("]") == string::npos) 	break;	//缺失“]”退出
-					strtitle = strtmp.substr(1);
-					strtitle = strtitle.erase(strtitle.find("]"));
-					if (strtitle == title)		//找到大标题设置标志位为1，这样就不再找下一个大标题了
-					{
-						flag = 1;
-						continue;
-					}
-				}
-			}
-		}
-		if (flag == 1)
+		if (strtmp.substr(0, 1) == "#")	continue;	//过滤注释
+		if (strtmp.substr(0, 1) == "[")
 		{
-			if (strtmp.substr(0, 1) == "[")	break;	//如果遇到下一个[]号说明当前大标题对应的配置字段搜索完毕，结束搜索。
-			if (strtmp.find(cfgName) != string::npos)
-			{
-				if (strtmp.find("=") == string::npos)	break;	//缺失“=”退出
-				strcfgname = strtmp;
-				strcfgname = strcfgname.erase(strcfgname.find("="));
-				if (strcfgname == cfgName)		//找到大标题相应的字段后，返回值
-				{
-					returnValue = strtmp.substr(strtmp.find("=") + 1);
-					return returnValue;
-				}
-				else continue;
-			}
+			section = NULL;
+			if (strtmp.find("]") == string::npos)	continue;	//缺失“]”的标题忽略
+			string strtitle = strtmp.substr(1);
+			strtitle = strtitle.erase(strtitle.find("]"));
+			if (g_config.find(strtitle) == g_config.end())	section = &g_config[strtitle];	//重复的标题忽略
+			continue;
 		}
+		if (section == NULL || strtmp.find("=") == string::npos)	continue;
+		string strcfgname = strtmp.substr(0, strtmp.find("="));
+		section->insert(make_pair(strcfgname, strtmp.substr(strtmp.find("=") + 1)));
+	}
+	g_config_loaded = true;
+}
+
+string getConfig(string title, string cfgName)
+{
+	if (!g_config_loaded)	loadConfig("config.ini");
+	map<string, map<string, string>>::const_iterator t = g_config.find(title);
+	if (t != g_config.end())
+	{
+		map<string, string>::const_iterator v = t->second.find(cfgName);
+		if (v != t->second.end())	return v->second;
 	}
 	cout << "配置文件错误：没找到" << title << "对应配置项" << cfgName << "！" << endl;
 	_getch();
 	exit(-1);
 }
-
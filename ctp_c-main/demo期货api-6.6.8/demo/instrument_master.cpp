@@ -0,0 +1,288 @@
+// instrument_master.h 实现
+#include "instrument_master.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include "ThostFtdcUserApiStruct.h"
+
+static const size_t INSTRUMENT_MASTER_HEADER_BYTES = 4096;
+
+static uint32_t master_hash(const char* s) {  // FNV-1a，与 InstrumentTable 相同
+  uint32_t h = 2166136261u;
+  for (; *s; ++s) h = (h ^ (unsigned char)*s) * 16777619u;
+  return h;
+}
+
+static void copy_field(char* dst, size_t cap, const char* src, size_t n) {
+  std::memset(dst, 0, cap);
+  if (n >= cap) n = cap - 1;
+  std::memcpy(dst, src, n);
+}
+
+// CTP / JSON 中的无效值（DBL_MAX、null）记 0
+static double clean_num(double v) { return (std::isfinite(v) && std::fabs(v) < 1e300) ? v : 0; }
+
+// "2026-01-07" / "20260107" → 20260107
+static int32_t parse_date(const char* s, size_t n) {
+  int32_t d = 0, k = 0;
+  for (size_t i = 0; i < n && k < 8; ++i)
+    if (s[i] >= '0' && s[i] <= '9') { d = d * 10 + (s[i] - '0'); ++k; }
+  return k == 8 ? d : 0;
+}
+
+static void fill_product(InstrumentRecord& r) {
+  size_t n = 0;
+  while (r.inst[n] && ((r.inst[n] >= 'a' && r.inst[n] <= 'z') || (r.inst[n] >= 'A' && r.inst[n] <= 'Z'))) ++n;
+  copy_field(r.product, sizeof(r.product), r.inst, n);
+}
+
+bool InstrumentMasterBuilder::add(const InstrumentRecord& r) {
+  if (!r.inst[0] || !seen_.emplace(r.inst, recs_.size()).second) return false;
+  recs_.push_back(r);
+  return true;
+}
+
+bool InstrumentMasterBuilder::add(const CThostFtdcInstrumentField& f) {
+  InstrumentRecord r;
+  std::memset(&r, 0, sizeof(r));
+  copy_field(r.inst, sizeof(r.inst), f.InstrumentID, strnlen(f.InstrumentID, sizeof(f.InstrumentID)));
+  copy_field(r.exchange, sizeof(r.exchange), f.ExchangeID, strnlen(f.ExchangeID, sizeof(f.ExchangeID)));
+  copy_field(r.product, sizeof(r.product), f.ProductID, strnlen(f.ProductID, sizeof(f.ProductID)));
+  r.price_tick = clean_num(f.PriceTick);
+  r.multiplier = f.VolumeMultiple > 0 ? (double)f.VolumeMultiple : 0;
+  r.long_margin = clean_num(f.LongMarginRatio);
+  r.short_margin = clean_num(f.ShortMarginRatio);
+  r.expire_date = parse_date(f.ExpireDate, strnlen(f.ExpireDate, sizeof(f.ExpireDate)));
+  if (f.ProductClass == THOST_FTDC_PC_Options || f.ProductClass == THOST_FTDC_PC_SpotOption) {
+    r.option_type = f.OptionsType;
+    r.strike = clean_num(f.StrikePrice);
+  }
+  r.is_trading = f.IsTrading ? 1 : 0;
+  return add(r);
+}
+
+// ---------------- dat（JSON）解析 ----------------
+// 只支持该文件用到的子集：对象 / 字符串（无转义以外的特殊处理）/ 数字 / true / false / null；数组等其他值跳过
+namespace {
+struct JsonCursor {
+  const char* p;
+  const char* end;
+
+  void ws() { while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) ++p; }
+  bool eat(char c) { ws(); if (p < end && *p == c) { ++p; return true; } return false; }
+
+  // 字符串：返回 [s, s+n)，不解码转义（代码 / 交易所 / 日期不含转义）
+  bool str(const char** s, size_t* n) {
+    ws();
+    if (p >= end || *p != '"') return false;
+    const char* b = ++p;
+    while (p < end && *p != '"') p += (*p == '\\' && p + 1 < end) ? 2 : 1;
+    if (p >= end) return false;
+    *s = b; *n = (size_t)(p - b);
+    ++p;
+    return true;
+  }
+
+  // 标量 / 任意值；数字写入 *num（null / 非数字为 0），字符串写入 *s / *n
+  bool value(double* num, const char** s, size_t* n, bool* flag) {
+    ws();
+    if (p >= end) return false;
+    *num = 0; *s = nullptr; *n = 0; *flag = false;
+    if (*p == '"') return str(s, n);
+    if (*p == '{' || *p == '[') return skip_nested();
+    if (end - p >= 4 && std::memcmp(p, "true", 4) == 0) { p += 4; *flag = true; return true; }
+    if (end - p >= 5 && std::memcmp(p, "false", 5) == 0) { p += 5; return true; }
+    if (end - p >= 4 && std::memcmp(p, "null", 4) == 0) { p += 4; return true; }
+    char* e = nullptr;
+    *num = std::strtod(p, &e);
+    if (e == p) return false;
+    p = e;
+    return true;
+  }
+
+  bool skip_nested() {
+    int depth = 0;
+    for (; p < end; ++p) {
+      if (*p == '"') { const char* s; size_t n; if (!str(&s, &n)) return false; --p; continue; }
+      if (*p == '{' || *p == '[') ++depth;
+      else if ((*p == '}' || *p == ']') && --depth == 0) { ++p; return true; }
+    }
+    return false;
+  }
+};
+
+bool key_is(const char* s, size_t n, const char* k) { return std::strlen(k) == n && std::memcmp(s, k, n) == 0; }
+}  // namespace
+
+int InstrumentMasterBuilder::load_dat(const std::string& path, int32_t* trading_day) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return -1;
+  std::stringstream ss;
+  ss << in.rdbuf();
+  const std::string buf = ss.str();
+  const size_t nl = buf.find('\n');
+  if (nl == std::string::npos) return -1;
+  const int32_t day = parse_date(buf.data(), nl);
+  if (day == 0) return -1;
+  if (trading_day) *trading_day = day;
+
+  JsonCursor c{buf.data() + nl + 1, buf.data() + buf.size()};
+  if (!c.eat('{')) return -1;
+  int added = 0;
+  if (c.eat('}')) return 0;
+  do {
+    const char* k; size_t kn;
+    if (!c.str(&k, &kn) || !c.eat(':') || !c.eat('{')) return -1;
+    InstrumentRecord r;
+    std::memset(&r, 0, sizeof(r));
+    copy_field(r.inst, sizeof(r.inst), k, kn);
+    if (!c.eat('}')) {
+      do {
+        const char* f; size_t fn;
+        double num; const char* s; size_t sn; bool flag;
+        if (!c.str(&f, &fn) || !c.eat(':') || !c.value(&num, &s, &sn, &flag)) return -1;
+        if (key_is(f, fn, "exchange") && s)          copy_field(r.exchange, sizeof(r.exchange), s, sn);
+        else if (key_is(f, fn, "multiple"))           r.multiplier = clean_num(num);
+        else if (key_is(f, fn, "price_tick"))         r.price_tick = clean_num(num);
+        else if (key_is(f, fn, "expire_date") && s)   r.expire_date = parse_date(s, sn);
+        else if (key_is(f, fn, "long_margin_ratio"))  r.long_margin = clean_num(num);
+        else if (key_is(f, fn, "short_margin_ratio")) r.short_margin = clean_num(num);
+        else if (key_is(f, fn, "strike_price"))       r.strike = clean_num(num);
+        else if (key_is(f, fn, "is_trading"))         r.is_trading = flag ? 1 : 0;
+        else if (key_is(f, fn, "option_type") && s)
+          r.option_type = key_is(s, sn, "call") ? '1' : (key_is(s, sn, "put") ? '2' : 0);
+      } while (c.eat(','));
+      if (!c.eat('}')) return -1;
+    }
+    fill_product(r);
+    if (add(r)) ++added;
+  } while (c.eat(','));
+  return c.eat('}') ? added : -1;
+}
+
+bool InstrumentMasterBuilder::write(const std::string& path, int32_t trading_day, int32_t source,
+                                    int64_t source_size, int64_t source_mtime) const {
+  // 期货在前、期权在后，各自保持原顺序
+  std::vector<InstrumentRecord> out;
+  out.reserve(recs_.size());
+  for (const auto& r : recs_) if (!r.option_type) out.push_back(r);
+  const uint32_t n_fut = (uint32_t)out.size();
+  for (const auto& r : recs_) if (r.option_type) out.push_back(r);
+  uint32_t slots = 16;
+  while (slots < out.size() * 2) slots <<= 1;
+  std::vector<uint32_t> index(slots, 0);
+  for (size_t i = 0; i < out.size(); ++i) {
+    out[i].id = (int32_t)i;
+    uint32_t h = master_hash(out[i].inst) & (slots - 1);
+    while (index[h]) h = (h + 1) & (slots - 1);
+    index[h] = (uint32_t)i + 1;
+  }
+
+  std::vector<char> hdr_buf(INSTRUMENT_MASTER_HEADER_BYTES, 0);
+  InstrumentMasterHeader* h = reinterpret_cast<InstrumentMasterHeader*>(hdr_buf.data());
+  std::memcpy(h->magic, INSTRUMENT_MASTER_MAGIC, 8);
+  h->version = INSTRUMENT_MASTER_VERSION;
+  h->record_size = sizeof(InstrumentRecord);
+  h->count = (uint32_t)out.size();
+  h->n_futures = n_fut;
+  h->index_slots = slots;
+  h->trading_day = trading_day;
+  h->source = source;
+  h->source_size = source_size;
+  h->source_mtime = source_mtime;
+  h->built_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+
+  const std::string tmp = path + ".tmp";
+  FILE* f = std::fopen(tmp.c_str(), "wb");
+  if (!f) { std::perror("[instruments] fopen"); return false; }
+  bool ok = std::fwrite(hdr_buf.data(), hdr_buf.size(), 1, f) == 1;
+  if (ok && !out.empty()) ok = std::fwrite(out.data(), sizeof(InstrumentRecord), out.size(), f) == out.size();
+  if (ok) ok = std::fwrite(index.data(), sizeof(uint32_t), index.size(), f) == index.size();
+  ok = (std::fclose(f) == 0) && ok;
+  if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::perror("[instruments] write");
+    std::remove(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+// ---------------- 读端 ----------------
+
+bool InstrumentMaster::open(const std::string& path) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || (size_t)st.st_size < INSTRUMENT_MASTER_HEADER_BYTES) { ::close(fd); return false; }
+  const size_t len = (size_t)st.st_size;
+  void* p = ::mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) { std::perror("[instruments] mmap"); return false; }
+  const InstrumentMasterHeader* h = static_cast<const InstrumentMasterHeader*>(p);
+  const size_t want = INSTRUMENT_MASTER_HEADER_BYTES + (size_t)h->count * sizeof(InstrumentRecord) +
+                      (size_t)h->index_slots * sizeof(uint32_t);
+  if (std::memcmp(h->magic, INSTRUMENT_MASTER_MAGIC, 8) != 0 || h->version != INSTRUMENT_MASTER_VERSION ||
+      h->record_size != sizeof(InstrumentRecord) || h->n_futures > h->count || h->index_slots < h->count ||
+      (h->index_slots & (h->index_slots - 1)) != 0 || want != len) {
+    std::fprintf(stderr, "[instruments] %s: bad master file\n", path.c_str());
+    ::munmap(p, len);
+    return false;
+  }
+  base_ = static_cast<const char*>(p);
+  map_len_ = len;
+  hdr_ = h;
+  recs_ = reinterpret_cast<const InstrumentRecord*>(base_ + INSTRUMENT_MASTER_HEADER_BYTES);
+  slots_ = reinterpret_cast<const uint32_t*>(recs_ + h->count);
+  return true;
+}
+
+void InstrumentMaster::close() {
+  if (base_) ::munmap(const_cast<char*>(base_), map_len_);
+  base_ = nullptr; map_len_ = 0; hdr_ = nullptr; recs_ = nullptr; slots_ = nullptr;
+}
+
+int InstrumentMaster::find(const char* inst) const {
+  if (!hdr_ || !inst || !*inst || hdr_->count == 0) return -1;
+  const uint32_t mask = hdr_->index_slots - 1;
+  for (uint32_t i = master_hash(inst) & mask;; i = (i + 1) & mask) {
+    const uint32_t v = slots_[i];
+    if (v == 0) return -1;
+    if (std::strncmp(recs_[v - 1].inst, inst, sizeof(recs_[0].inst)) == 0) return (int)(v - 1);
+  }
+}
+
+std::string instrument_master_path(const std::string& dir, int32_t trading_day) {
+  return (dir.empty() ? std::string(".") : dir) + "/instruments_" + std::to_string(trading_day) + ".bin";
+}
+
+int instrument_master_from_dat(const std::string& dat_path, const std::string& cache_dir, InstrumentMaster& out) {
+  // 只读首行日期和文件属性就能判断缓存是否可用
+  struct stat st;
+  std::ifstream in(dat_path);
+  std::string first;
+  if (::stat(dat_path.c_str(), &st) != 0 || !in || !std::getline(in, first)) return -1;
+  const int32_t day = parse_date(first.data(), first.size());
+  if (day == 0) return -1;
+  const std::string path = instrument_master_path(cache_dir, day);
+  if (out.open(path)) {
+    const InstrumentMasterHeader* h = out.header();
+    if (h->source == INSTR_SRC_DAT && h->trading_day == day && h->source_size == (int64_t)st.st_size &&
+        h->source_mtime == (int64_t)st.st_mtime)
+      return 0;
+    out.close();
+  }
+  InstrumentMasterBuilder b;
+  int32_t d = 0;
+  if (b.load_dat(dat_path, &d) < 0) return -1;
+  if (!b.write(path, d, INSTR_SRC_DAT, (int64_t)st.st_size, (int64_t)st.st_mtime)) return -2;
+  return out.open(path) ? 0 : -3;
+}
@@ -0,0 +1,102 @@
+// 合约主数据缓存：每个交易日一个定长二进制文件 {dir}/instruments_{YYYYMMDD}.bin，启动时 mmap 直接使用
+// 数据源二选一：交易前置 OnRspQryInstrument 分页回报，或 live_futuresinstruments.dat（首行日期 + JSON）
+// 文件布局：[InstrumentMasterHeader 4KB][InstrumentRecord × count][uint32 索引槽 × index_slots]
+// - 记录按 期货在前、期权在后 排列，下标即稠密 id；id 在同一份主数据内稳定，可直接作为 InstrumentTable 的预登记顺序
+// - 索引为开放寻址表（FNV-1a，值为 id+1，0 为空），打开后按代码查找不需要任何解析
+// 写文件先写临时文件再 rename，读端不会看到半截文件
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct CThostFtdcInstrumentField;
+
+static const char     INSTRUMENT_MASTER_MAGIC[8] = {'C', 'T', 'P', 'I', 'N', 'S', 'T', '1'};
+static const uint32_t INSTRUMENT_MASTER_VERSION  = 1;
+
+enum InstrumentSource { INSTR_SRC_DAT = 1, INSTR_SRC_QRY = 2 };
+
+struct InstrumentRecord {
+  char     inst[32];
+  char     exchange[12];
+  char     product[12];      // 品种代码（dat 源取合约代码的字母前缀）
+  double   price_tick;
+  double   multiplier;       // 合约乘数
+  double   strike;           // 行权价，期货为 0
+  double   long_margin, short_margin;  // 保证金率，未知为 0
+  int32_t  expire_date;      // YYYYMMDD，未知为 0
+  int32_t  id;               // 稠密 id（= 记录下标）
+  char     option_type;      // 0 期货 / '1' 看涨 / '2' 看跌（同 THOST_FTDC_CP_*）
+  uint8_t  is_trading;
+  uint8_t  reserved[22];
+};
+static_assert(sizeof(InstrumentRecord) == 128, "InstrumentRecord layout");
+
+struct InstrumentMasterHeader {
+  char     magic[8];
+  uint32_t version, record_size;
+  uint32_t count, n_futures;   // 记录数 / 其中期货数（id < n_futures 的为期货）
+  uint32_t index_slots;        // 2 的幂
+  int32_t  trading_day;        // YYYYMMDD
+  int32_t  source;             // InstrumentSource
+  int32_t  reserved;
+  int64_t  source_size, source_mtime;  // dat 源的大小 / 修改时间，用于判断缓存是否过期
+  int64_t  built_ns;
+};
+
+// 收集记录并写出主数据文件；同一代码重复出现时保留第一条
+class InstrumentMasterBuilder {
+public:
+  void clear() { recs_.clear(); seen_.clear(); }
+  size_t size() const { return recs_.size(); }
+
+  bool add(const InstrumentRecord& r);
+  bool add(const CThostFtdcInstrumentField& f);  // OnRspQryInstrument 的一条回报
+  // 解析 live_futuresinstruments.dat；返回加入的记录数，文件不可读或格式错误返回 -1，trading_day 取首行日期
+  int load_dat(const std::string& path, int32_t* trading_day);
+
+  // 写出到 path（临时文件 + rename）
+  bool write(const std::string& path, int32_t trading_day, int32_t source,
+             int64_t source_size = 0, int64_t source_mtime = 0) const;
+
+private:
+  std::vector<InstrumentRecord> recs_;
+  std::unordered_map<std::string, size_t> seen_;
+};
+
+// 只读 mmap 视图
+class InstrumentMaster {
+public:
+  InstrumentMaster() = default;
+  InstrumentMaster(const InstrumentMaster&) = delete;
+  InstrumentMaster& operator=(const InstrumentMaster&) = delete;
+  ~InstrumentMaster() { close(); }
+
+  bool open(const std::string& path);
+  void close();
+  bool is_open() const { return hdr_ != nullptr; }
+
+  // 按代码查找，未找到返回 -1
+  int find(const char* inst) const;
+  const InstrumentRecord& at(int id) const { return recs_[id]; }
+  int size() const { return hdr_ ? (int)hdr_->count : 0; }
+  int n_futures() const { return hdr_ ? (int)hdr_->n_futures : 0; }
+  int32_t trading_day() const { return hdr_ ? hdr_->trading_day : 0; }
+  const InstrumentMasterHeader* header() const { return hdr_; }
+
+private:
+  const char* base_ = nullptr;
+  size_t map_len_ = 0;
+  const InstrumentMasterHeader* hdr_ = nullptr;
+  const InstrumentRecord* recs_ = nullptr;
+  const uint32_t* slots_ = nullptr;
+};
+
+// {dir}/instruments_{day}.bin
+std::string instrument_master_path(const std::string& dir, int32_t trading_day);
+
+// 以 dat 为源：缓存存在且与 dat（首行日期 / 大小 / 修改时间）一致时直接打开，否则解析 dat 重建缓存后打开
+// 0 成功；-1 dat 不可读或格式错误；-2 缓存写入失败；-3 缓存打开失败
+int instrument_master_from_dat(const std::string& dat_path, const std::string& cache_dir, InstrumentMaster& out);
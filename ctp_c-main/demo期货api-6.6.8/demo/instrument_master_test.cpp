@@ -0,0 +1,156 @@
+// instrument_master.h 测试：dat 解析、期货在前的稠密 id、索引查找、OnRspQryInstrument 源、缓存复用 / 过期重建、
+// 损坏文件拒绝、冷启动耗时（解析 dat vs mmap 缓存）
+// 用法：./instrument_master_test [live_futuresinstruments.dat]
+#include "instrument_master.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include "ThostFtdcUserApiStruct.h"
+
+static const char* kDir = "/tmp/instrument_master_test";
+
+static void write_file(const std::string& path, const std::string& s) { std::ofstream(path, std::ios::binary) << s; }
+
+int main(int argc, char** argv) {
+  int rc = 0;
+  mkdir(kDir, 0755);
+  const std::string dir = kDir;
+
+  // 1) 小 dat：字段、null、期权排在期货之后、重复代码只留第一条
+  const std::string dat = dir + "/small.dat";
+  write_file(dat,
+             "2025-11-03\n{\n"
+             "  \"ru2601P18000\": {\"name\": \"ru2601P18000\", \"exchange\": \"SHFE\", \"multiple\": 10, \"price_tick\": 1.0,\n"
+             "    \"expire_date\": \"2025-12-25\", \"long_margin_ratio\": null, \"short_margin_ratio\": null,\n"
+             "    \"option_type\": \"put\", \"strike_price\": 18000.0, \"is_trading\": true},\n"
+             "  \"ZC601\": {\"name\": \"ZC601\", \"exchange\": \"CZCE\", \"multiple\": 100, \"price_tick\": 0.2,\n"
+             "    \"expire_date\": \"2026-01-07\", \"long_margin_ratio\": 0.2, \"short_margin_ratio\": 0.15,\n"
+             "    \"option_type\": null, \"strike_price\": null, \"is_trading\": true, \"extra\": [1, {\"a\": \"}\"}]},\n"
+             "  \"IO2511-C-4000\": {\"exchange\": \"CFFEX\", \"multiple\": 100, \"price_tick\": 0.2, \"option_type\": \"call\",\n"
+             "    \"strike_price\": 4000, \"is_trading\": false},\n"
+             "  \"ZC601\": {\"exchange\": \"XXX\"}\n"
+             "}\n");
+  InstrumentMasterBuilder b;
+  int32_t day = 0;
+  if (b.load_dat(dat, &day) != 3 || day != 20251103) { std::printf("load_dat day=%d\n", day); rc = 1; }
+  const std::string small_bin = dir + "/small.bin";
+  b.write(small_bin, day, INSTR_SRC_DAT);
+  InstrumentMaster m;
+  if (!m.open(small_bin) || m.size() != 3 || m.n_futures() != 1 || m.trading_day() != 20251103) {
+    std::printf("open small n=%d fut=%d\n", m.size(), m.n_futures()); rc = 1;
+  } else {
+    const int zc = m.find("ZC601"), ru = m.find("ru2601P18000"), io = m.find("IO2511-C-4000");
+    if (zc != 0 || ru != 1 || io != 2 || m.find("ZC60") != -1 || m.find("") != -1) {
+      std::printf("ids zc=%d ru=%d io=%d\n", zc, ru, io); rc = 1;
+    } else {
+      const InstrumentRecord& z = m.at(zc);
+      if (std::strcmp(z.exchange, "CZCE") != 0 || std::strcmp(z.product, "ZC") != 0 || z.multiplier != 100 ||
+          z.price_tick != 0.2 || z.expire_date != 20260107 || z.long_margin != 0.2 || z.short_margin != 0.15 ||
+          z.option_type != 0 || z.strike != 0 || !z.is_trading || z.id != 0) {
+        std::printf("ZC601 fields\n"); rc = 1;
+      }
+      const InstrumentRecord& r = m.at(ru);
+      if (r.option_type != '2' || r.strike != 18000 || r.long_margin != 0 || std::strcmp(r.product, "ru") != 0) { std::printf("put fields\n"); rc = 1; }
+      if (m.at(io).option_type != '1' || m.at(io).is_trading || m.at(io).expire_date != 0) { std::printf("call fields\n"); rc = 1; }
+    }
+  }
+
+  // 2) OnRspQryInstrument 源：DBL_MAX 记 0，期权按 ProductClass 判定
+  {
+    InstrumentMasterBuilder q;
+    CThostFtdcInstrumentField f;
+    std::memset(&f, 0, sizeof(f));
+    std::strcpy(f.InstrumentID, "IF2512"); std::strcpy(f.ExchangeID, "CFFEX"); std::strcpy(f.ProductID, "IF");
+    std::strcpy(f.ExpireDate, "20251219");
+    f.ProductClass = THOST_FTDC_PC_Futures; f.VolumeMultiple = 300; f.PriceTick = 0.2;
+    f.LongMarginRatio = 0.12; f.ShortMarginRatio = DBL_MAX; f.IsTrading = 1; f.StrikePrice = DBL_MAX;
+    q.add(f);
+    std::strcpy(f.InstrumentID, "IO2512-C-4000"); std::strcpy(f.ProductID, "IO");
+    f.ProductClass = THOST_FTDC_PC_Options; f.OptionsType = THOST_FTDC_CP_CallOptions; f.StrikePrice = 4000; f.VolumeMultiple = 100;
+    q.add(f);
+    if (q.add(f)) { std::printf("dup qry\n"); rc = 1; }
+    InstrumentMaster qm;
+    const std::string qp = instrument_master_path(dir, 20251103);
+    if (!q.write(qp, 20251103, INSTR_SRC_QRY) || !qm.open(qp) || qm.size() != 2 || qm.n_futures() != 1) {
+      std::printf("qry master\n"); rc = 1;
+    } else {
+      const InstrumentRecord& a = qm.at(qm.find("IF2512"));
+      const InstrumentRecord& o = qm.at(qm.find("IO2512-C-4000"));
+      if (a.multiplier != 300 || a.short_margin != 0 || a.strike != 0 || a.expire_date != 20251219 ||
+          o.option_type != '1' || o.strike != 4000 || o.id != 1 || qm.header()->source != INSTR_SRC_QRY) {
+        std::printf("qry fields\n"); rc = 1;
+      }
+    }
+  }
+
+  // 3) 缓存：同一 dat 第二次直接打开（不重建）；dat 修改后重建
+  {
+    const std::string cache = dir + "/cache";
+    mkdir(cache.c_str(), 0755);
+    unlink(instrument_master_path(cache, 20251103).c_str());
+    InstrumentMaster c1, c2, c3;
+    if (instrument_master_from_dat(dat, cache, c1) != 0 || c1.size() != 3) { std::printf("from_dat build\n"); rc = 1; }
+    const int64_t built = c1.header() ? c1.header()->built_ns : 0;
+    if (instrument_master_from_dat(dat, cache, c2) != 0 || !c2.header() || c2.header()->built_ns != built) {
+      std::printf("from_dat reuse\n"); rc = 1;
+    }
+    std::ofstream(dat, std::ios::app) << "\n";   // 大小变化 → 重建
+    if (instrument_master_from_dat(dat, cache, c3) != 0 || !c3.header() || c3.header()->built_ns == built || c3.size() != 3) {
+      std::printf("from_dat rebuild\n"); rc = 1;
+    }
+    InstrumentMaster bad;
+    write_file(dir + "/bad.dat", "no date\n{}");
+    if (instrument_master_from_dat(dir + "/bad.dat", cache, bad) != -1) { std::printf("bad dat\n"); rc = 1; }
+  }
+
+  // 4) 损坏 / 截断的主数据文件
+  {
+    std::ifstream in(small_bin, std::ios::binary);
+    std::string s((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    write_file(dir + "/trunc.bin", s.substr(0, s.size() - 4));
+    s[0] = 'X';
+    write_file(dir + "/magic.bin", s);
+    InstrumentMaster t;
+    if (t.open(dir + "/trunc.bin") || t.open(dir + "/magic.bin") || t.open(dir + "/none.bin") || t.find("ZC601") != -1) {
+      std::printf("corrupt accepted\n"); rc = 1;
+    }
+  }
+
+  // 5) 真实 dat：全部合约可查、id 与下标一致；冷启动耗时
+  const char* live = argc > 1 ? argv[1] : "live_futuresinstruments.dat";
+  if (access(live, R_OK) == 0) {
+    auto ms = [](auto t0) { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count(); };
+    InstrumentMasterBuilder lb;
+    auto t0 = std::chrono::steady_clock::now();
+    const int n = lb.load_dat(live, &day);
+    const double parse_ms = ms(t0);
+    const std::string lp = instrument_master_path(dir, day);
+    lb.write(lp, day, INSTR_SRC_DAT);
+    InstrumentMaster lm;
+    t0 = std::chrono::steady_clock::now();
+    const bool ok = lm.open(lp);
+    const double open_ms = ms(t0);
+    int bad_ids = 0, options_before = 0;
+    for (int i = 0; ok && i < lm.size(); ++i) {
+      if (lm.find(lm.at(i).inst) != i || lm.at(i).id != i || lm.at(i).multiplier <= 0 || lm.at(i).price_tick <= 0) ++bad_ids;
+      if (i < lm.n_futures() && lm.at(i).option_type) ++options_before;
+    }
+    t0 = std::chrono::steady_clock::now();
+    long long sink = 0;
+    for (int r = 0; ok && r < 20; ++r) for (int i = 0; i < lm.size(); ++i) sink += lm.find(lm.at(i).inst);
+    const double find_ns = ok ? ms(t0) * 1e6 / (20.0 * lm.size()) : 0;
+    if (!ok || n <= 0 || lm.size() != n || bad_ids || options_before) {
+      std::printf("live n=%d size=%d bad=%d\n", n, lm.size(), bad_ids); rc = 1;
+    }
+    std::printf("live %d instruments (%d futures): parse dat %.1f ms, open cache %.3f ms, find %.0f ns (sink=%lld)\n",
+                lm.size(), lm.n_futures(), parse_ms, open_ms, find_ns, sink & 1);
+  } else {
+    std::printf("skip live dat (%s not found)\n", live);
+  }
+
+  std::printf(rc == 0 ? "ALL OK\n" : "FAILED\n");
+  return rc;
+}
@@ -0,0 +1,195 @@
+// 合约符号表：InstrumentID → 稠密整数 id（按登记顺序 0,1,2,...），订阅时登记
+// 行情热路径按 id 取条目：Redis key / RESP 命令头尾已预先生成，逐笔只把数字填进去。
+// 也是 L5 盘口、共享内存快照等按合约分槽数据的统一下标。
+#pragma once
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "tick_codec.h"
+
+// 每类 key 的取值格式：文本（JSON / %.10f 字段）或 BinTickV1 二进制
+enum TickFormat { TICK_FMT_TEXT = 0, TICK_FMT_BIN = 1 };
+
+// 单合约的 Redis 行情命令模板（仅行情发布线程读写）
+// 每笔行情发三条命令：SET str_key json EX ttl / HSET hash_key last .. bid1 .. ask1 .. ts .. / EXPIRE hash_key ttl
+// 二进制格式下 SET 的值为 BinTickV1，HSET 只写一个字段 bin
+struct TickRespTemplate {
+  uint32_t prefix_gen = 0;  // 生成时的前缀版本，前缀变化后需重新生成
+  std::string str_key, hash_key;
+  std::string set_head;     // *5 SET <str_key>，其后接 JSON 值
+  std::string set_tail;     // EX <ttl>
+  std::string json_head;    // {"inst":"<id>","last":
+  std::string hset_head;    // *10 HSET <hash_key> last，其后接 last 值
+  std::string hset_bin_head;  // *4 HSET <hash_key> bin，其后接 BinTickV1
+  std::string expire_cmd;   // 完整的 EXPIRE <hash_key> <ttl>
+};
+
+struct InstrumentEntry {
+  char id[81] = {0};        // 同 TThostFtdcInstrumentIDType
+  int  index = -1;
+  TickRespTemplate redis;
+};
+
+class InstrumentTable {
+public:
+  static constexpr int kMaxInstruments = 8192;
+
+  InstrumentTable() : entries_(kMaxInstruments), slots_(kSlots) {
+    for (auto& s : slots_) s.store(-1, std::memory_order_relaxed);
+  }
+
+  // 已登记数量；id 范围 [0, size())
+  int size() const { return count_.load(std::memory_order_acquire); }
+
+  // 无锁查找，未登记返回 -1
+  int find(const char* inst) const {
+    if (!inst || !*inst) return -1;
+    for (uint32_t i = hash_(inst) & kSlotMask;; i = (i + 1) & kSlotMask) {
+      int id = slots_[i].load(std::memory_order_acquire);
+      if (id < 0) return -1;
+      if (std::strcmp(entries_[id].id, inst) == 0) return id;
+    }
+  }
+
+  // 登记（已存在则直接返回 id）；表满或代码过长返回 -1
+  int add(const char* inst) {
+    int id = find(inst);
+    if (id >= 0 || !inst || !*inst || std::strlen(inst) >= sizeof(entries_[0].id)) return id;
+    std::lock_guard<std::mutex> lk(mtx_);
+    uint32_t i = hash_(inst) & kSlotMask;
+    for (;; i = (i + 1) & kSlotMask) {
+      int cur = slots_[i].load(std::memory_order_relaxed);
+      if (cur < 0) break;
+      if (std::strcmp(entries_[cur].id, inst) == 0) return cur;  // 并发登记
+    }
+    id = count_.load(std::memory_order_relaxed);
+    if (id >= kMaxInstruments) return -1;
+    InstrumentEntry& e = entries_[id];
+    std::strcpy(e.id, inst);
+    e.index = id;
+    // 条目填好后再发布槽位和数量
+    slots_[i].store(id, std::memory_order_release);
+    count_.store(id + 1, std::memory_order_release);
+    return id;
+  }
+
+  InstrumentEntry& at(int id) { return entries_[id]; }
+  const InstrumentEntry& at(int id) const { return entries_[id]; }
+
+private:
+  static constexpr uint32_t kSlots = kMaxInstruments * 2;  // 装载率 <= 50%
+  static constexpr uint32_t kSlotMask = kSlots - 1;
+  static uint32_t hash_(const char* s) {  // FNV-1a
+    uint32_t h = 2166136261u;
+    for (; *s; ++s) h = (h ^ (unsigned char)*s) * 16777619u;
+    return h;
+  }
+
+  std::vector<InstrumentEntry> entries_;  // 预分配，地址稳定
+  std::vector<std::atomic<int>> slots_;   // 开放寻址，值为 id，-1 为空
+  std::atomic<int> count_{0};
+  std::mutex mtx_;
+};
+
+// ---------------- RESP 命令拼装 ----------------
+
+inline void resp_append_bulk(std::string& out, const char* s, size_t n) {
+  char len[24];
+  int k = std::snprintf(len, sizeof(len), "$%zu\r\n", n);
+  out.append(len, k).append(s, n).append("\r\n", 2);
+}
+inline void resp_append_bulk(std::string& out, const std::string& s) { resp_append_bulk(out, s.data(), s.size()); }
+
+// 按前缀和 TTL 生成模板
+inline void build_tick_template(TickRespTemplate& t, const char* inst, const std::string& str_prefix,
+                                const std::string& hash_prefix, int ttl_sec, uint32_t prefix_gen) {
+  const std::string ttl = std::to_string(ttl_sec);
+  t.prefix_gen = prefix_gen;
+  t.str_key = str_prefix + inst;
+  t.hash_key = hash_prefix + inst;
+  t.set_head = "*5\r\n$3\r\nSET\r\n";
+  resp_append_bulk(t.set_head, t.str_key);
+  t.set_tail = "$2\r\nEX\r\n";
+  resp_append_bulk(t.set_tail, ttl);
+  t.json_head = std::string("{\"inst\":\"") + inst + "\",\"last\":";
+  t.hset_head = "*10\r\n$4\r\nHSET\r\n";
+  resp_append_bulk(t.hset_head, t.hash_key);
+  resp_append_bulk(t.hset_head, "last", 4);
+  t.hset_bin_head = "*4\r\n$4\r\nHSET\r\n";
+  resp_append_bulk(t.hset_bin_head, t.hash_key);
+  resp_append_bulk(t.hset_bin_head, "bin", 3);
+  t.expire_cmd = "*3\r\n$6\r\nEXPIRE\r\n";
+  resp_append_bulk(t.expire_cmd, t.hash_key);
+  resp_append_bulk(t.expire_cmd, ttl);
+}
+
+// 定点 10 位小数，输出与 "%.10f" 逐字节一致（|v| 过大或非有限值时直接用 snprintf）；buf 至少 352 字节
+// 整数部分与小数部分分开算；小数 ×1e10 的舍入误差用 fma 精确求出，只在恰好落在 .5 上时用于判定进位
+inline int fmt_fixed10(char* buf, double v) {
+  if (!(v > -1e15 && v < 1e15)) return std::snprintf(buf, 352, "%.10f", v);
+  const double a = std::fabs(v), ip = std::floor(a), frac = a - ip;  // frac 精确
+  const double r = frac * 1e10, err = std::fma(frac, 1e10, -r), fl = std::floor(r);
+  unsigned long long i = (unsigned long long)ip, f = (unsigned long long)fl;
+  const double d = r - fl;
+  if (d > 0.5 || (d == 0.5 && err > 0)) ++f;
+  if (f >= 10000000000ULL) { f -= 10000000000ULL; ++i; }
+
+  char* p = buf;
+  if (std::signbit(v)) *p++ = '-';
+  char tmp[20]; int n = 0;
+  do { tmp[n++] = char('0' + i % 10); i /= 10; } while (i);
+  while (n) *p++ = tmp[--n];
+  *p++ = '.';
+  for (int k = 9; k >= 0; --k) { p[k] = char('0' + f % 10); f /= 10; }
+  return int(p + 10 - buf);
+}
+
+// 一笔行情拼成三条连续的 RESP 命令写入 out（复用容量），lens 为各条长度
+// str_fmt / hash_fmt 为 TICK_FMT_BIN 时对应命令写 bin（此时 bin 不能为空；可指向 BinTickV2::v1，按 size 写出整条编码）
+inline void build_tick_commands(const TickRespTemplate& t, double last, double bid1, double ask1, long long ts_ms,
+                                std::string& out, size_t lens[3],
+                                const BinTickV1* bin = nullptr, int str_fmt = TICK_FMT_TEXT, int hash_fmt = TICK_FMT_TEXT) {
+  char nl[352], nb[352], na[352], nt[24];
+  int kl = 0, kb = 0, ka = 0, kt = 0;
+  if (str_fmt != TICK_FMT_BIN || hash_fmt != TICK_FMT_BIN) {
+    kl = fmt_fixed10(nl, last); kb = fmt_fixed10(nb, bid1); ka = fmt_fixed10(na, ask1);
+    kt = std::snprintf(nt, sizeof(nt), "%lld", ts_ms);
+  }
+
+  out.clear();
+  out.append(t.set_head);
+  if (str_fmt == TICK_FMT_BIN) {
+    resp_append_bulk(out, reinterpret_cast<const char*>(bin), bin->size);
+  } else {
+    // JSON 值需先知道长度
+    size_t json_len = t.json_head.size() + kl + kb + ka + kt + 23;  // 23 = ,"bid1": ,"ask1": ,"ts": }
+    char len[24];
+    out.append(len, std::snprintf(len, sizeof(len), "$%zu\r\n", json_len));
+    out.append(t.json_head).append(nl, kl);
+    out.append(",\"bid1\":", 8).append(nb, kb);
+    out.append(",\"ask1\":", 8).append(na, ka);
+    out.append(",\"ts\":", 6).append(nt, kt).append("}\r\n", 3);
+  }
+  out.append(t.set_tail);
+  lens[0] = out.size();
+
+  if (hash_fmt == TICK_FMT_BIN) {
+    out.append(t.hset_bin_head);
+    resp_append_bulk(out, reinterpret_cast<const char*>(bin), bin->size);
+  } else {
+    out.append(t.hset_head);
+    resp_append_bulk(out, nl, kl);
+    resp_append_bulk(out, "bid1", 4); resp_append_bulk(out, nb, kb);
+    resp_append_bulk(out, "ask1", 4); resp_append_bulk(out, na, ka);
+    resp_append_bulk(out, "ts", 2);   resp_append_bulk(out, nt, kt);
+  }
+  lens[1] = out.size() - lens[0];
+
+  out.append(t.expire_cmd);
+  lens[2] = t.expire_cmd.size();
+}
@@ -0,0 +1,162 @@
+// instrument_table.h / tick_codec.h 测试：登记/查找、定点格式化与 "%.10f" 一致、RESP 命令可被正确解析、二进制编解码、并发查找
+#include "instrument_table.h"
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 解析一条 RESP 数组命令，返回参数列表；格式错误返回空
+static std::vector<std::string> parse_resp(const char* p, size_t len) {
+  std::vector<std::string> args;
+  const char* end = p + len;
+  if (p >= end || *p != '*') return {};
+  int n = std::atoi(++p);
+  p = std::strstr(p, "\r\n") + 2;
+  for (int i = 0; i < n; ++i) {
+    if (p >= end || *p != '$') return {};
+    size_t k = std::strtoul(++p, nullptr, 10);
+    p = std::strstr(p, "\r\n") + 2;
+    if (p + k + 2 > end || p[k] != '\r' || p[k + 1] != '\n') return {};
+    args.emplace_back(p, k);
+    p += k + 2;
+  }
+  return p == end ? args : std::vector<std::string>{};
+}
+
+static std::string fmt10(double v) { char b[352]; std::snprintf(b, sizeof(b), "%.10f", v); return b; }
+
+static int test_table() {
+  InstrumentTable t;
+  if (t.add("IM2512") != 0 || t.add("rb2601") != 1 || t.add("IM2512") != 0) { std::printf("dense id failed\n"); return 1; }
+  if (t.find("rb2601") != 1 || t.find("rb2602") != -1 || t.find("") != -1 || t.size() != 2) { std::printf("find failed\n"); return 1; }
+  if (std::strcmp(t.at(1).id, "rb2601") != 0) { std::printf("at failed\n"); return 1; }
+  for (int i = 2; i < InstrumentTable::kMaxInstruments; ++i) t.add(("X" + std::to_string(i)).c_str());
+  if (t.add("overflow") != -1 || t.find("X8000") != 8000) { std::printf("capacity failed\n"); return 1; }
+  std::printf("table ok\n");
+  return 0;
+}
+
+static int test_fixed10() {
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> px(0.0, 200000.0);
+  std::uniform_int_distribution<int> ticks(0, 2000000);
+  std::vector<double> vals = {0.0, -0.0, -1e-12, 0.99999999999, -0.5, 1.0, 3456.2, 0.0001, -123.45, 8.99e8, 9.9e14, 1e15, DBL_MAX, -DBL_MAX, NAN};
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  for (int i = 0; i < 100000; ++i) {
+    vals.push_back(px(rng)); vals.push_back(ticks(rng) * 0.2); vals.push_back(ticks(rng) * 0.01);
+    vals.push_back(-unit(rng) * 1e6);
+    vals.push_back((std::floor(unit(rng) * 1e10) + 0.5) * 1e-10 + ticks(rng));  // 靠近第 11 位的 .5
+  }
+  int bad = 0;
+  for (double v : vals) {
+    char b[352]; int n = fmt_fixed10(b, v);
+    if (std::string(b, n) != fmt10(v) && ++bad <= 5) std::printf("fixed10 %.17g: %.*s vs %s\n", v, n, b, fmt10(v).c_str());
+  }
+  std::printf("fixed10 n=%zu bad=%d\n", vals.size(), bad);
+  return bad == 0 ? 0 : 1;
+}
+
+static int test_commands() {
+  TickRespTemplate tpl;
+  build_tick_template(tpl, "IM2512", "pre:json:", "pre:h:", 86400, 1);
+  std::string buf; size_t lens[3];
+  const double last = 6123.4, bid1 = 6123.2, ask1 = DBL_MAX;
+  build_tick_commands(tpl, last, bid1, ask1, 1760000000123LL, buf, lens);
+  if (lens[0] + lens[1] + lens[2] != buf.size()) { std::printf("lens mismatch\n"); return 1; }
+
+  char json[1024];
+  std::snprintf(json, sizeof(json), "{\"inst\":\"IM2512\",\"last\":%.10f,\"bid1\":%.10f,\"ask1\":%.10f,\"ts\":%lld}",
+                last, bid1, ask1, 1760000000123LL);
+  std::vector<std::vector<std::string>> expect = {
+    {"SET", "pre:json:IM2512", json, "EX", "86400"},
+    {"HSET", "pre:h:IM2512", "last", fmt10(last), "bid1", fmt10(bid1), "ask1", fmt10(ask1), "ts", "1760000000123"},
+    {"EXPIRE", "pre:h:IM2512", "86400"},
+  };
+  const char* p = buf.data();
+  for (int i = 0; i < 3; p += lens[i], ++i) {
+    if (parse_resp(p, lens[i]) != expect[i]) { std::printf("command %d mismatch: %.*s\n", i, (int)lens[i], p); return 1; }
+  }
+  std::printf("commands ok\n");
+  return 0;
+}
+
+static int test_binary() {
+  TickRespTemplate tpl;
+  build_tick_template(tpl, "IM2512", "pre:bin:", "pre:h:", 60, 1);
+  BinTickV1 bin;
+  init_bin_tick(bin, 7, "IM2512");
+  bin.last = 6123.4; bin.bid1 = 6123.2; bin.ask1 = 6123.6; bin.volume = 12345; bin.bid_vol1 = 3; bin.ask_vol1 = 4;
+  bin.exch_ts_ms = 1760000000000LL; bin.recv_ts_ms = 1760000000123LL;
+  std::string buf; size_t lens[3];
+  // SET 用二进制、HSET 保持文本
+  build_tick_commands(tpl, bin.last, bin.bid1, bin.ask1, bin.recv_ts_ms, buf, lens, &bin, TICK_FMT_BIN, TICK_FMT_TEXT);
+  auto set = parse_resp(buf.data(), lens[0]);
+  auto hset = parse_resp(buf.data() + lens[0], lens[1]);
+  if (set.size() != 5 || set[2].size() != sizeof(BinTickV1) || hset.size() != 10 || hset[3] != fmt10(bin.last)) {
+    std::printf("binary SET / text HSET mismatch\n"); return 1;
+  }
+  BinTickV1 out;
+  if (decode_bin_tick(set[2].data(), set[2].size(), &out) != 0 || std::strcmp(out.inst, "IM2512") != 0 ||
+      out.inst_id != 7 || out.last != bin.last || out.volume != 12345 || out.recv_ts_ms != bin.recv_ts_ms) {
+    std::printf("decode mismatch\n"); return 1;
+  }
+  // HSET 二进制：只有 bin 一个字段
+  build_tick_commands(tpl, 0, 0, 0, 0, buf, lens, &bin, TICK_FMT_TEXT, TICK_FMT_BIN);
+  hset = parse_resp(buf.data() + lens[0], lens[1]);
+  if (hset.size() != 4 || hset[2] != "bin" || decode_bin_tick(hset[3].data(), hset[3].size(), &out) != 0) {
+    std::printf("binary HSET mismatch\n"); return 1;
+  }
+  if (decode_bin_tick(set[2].data(), 10, &out) != -1) { std::printf("short buffer accepted\n"); return 1; }
+  std::string bad = set[2]; bad[0] = 'x';
+  if (decode_bin_tick(bad.data(), bad.size(), &out) != -2) { std::printf("bad magic accepted\n"); return 1; }
+  const size_t text_set = parse_resp(buf.data(), lens[0])[2].size();
+  // V2：追加 2..5 档；V1 读端按前 112 字节照常解码，V2 读端拿到深度，V1 编码返回 -3
+  BinTickV2 b2, out2;
+  init_bin_tick(b2, 7, "IM2512");
+  b2.v1.last = bin.last; b2.bid_px[3] = 6122.4; b2.ask_vol[0] = 9; b2.changed = 0x21;
+  build_tick_commands(tpl, 0, 0, 0, 0, buf, lens, &b2.v1, TICK_FMT_BIN, TICK_FMT_BIN);
+  set = parse_resp(buf.data(), lens[0]);
+  if (set.size() != 5 || set[2].size() != sizeof(BinTickV2) || decode_bin_tick(set[2].data(), set[2].size(), &out) != 0 ||
+      out.last != bin.last || decode_bin_tick(set[2].data(), set[2].size(), &out2) != 0 || out2.bid_px[3] != 6122.4 ||
+      out2.ask_vol[0] != 9 || out2.changed != 0x21) {
+    std::printf("v2 mismatch\n"); return 1;
+  }
+  hset = parse_resp(buf.data() + lens[0], lens[1]);
+  if (hset.size() != 4 || decode_bin_tick(hset[3].data(), hset[3].size(), &out2) != 0) { std::printf("v2 HSET mismatch\n"); return 1; }
+  std::string v1enc(reinterpret_cast<const char*>(&bin), sizeof(bin));
+  if (decode_bin_tick(v1enc.data(), v1enc.size(), &out2) != -3 || out2.v1.last != bin.last) { std::printf("v1 as v2\n"); return 1; }
+  std::printf("binary ok size=%zu/%zu text_set=%zu\n", sizeof(BinTickV1), sizeof(BinTickV2), text_set);
+  return 0;
+}
+
+// 一个线程登记、一个线程查找：已发布的 id 必须能查到且名字一致
+static int test_concurrent() {
+  InstrumentTable t;
+  const int N = 4000;
+  std::thread writer([&]{ for (int i = 0; i < N; ++i) t.add(("C" + std::to_string(i)).c_str()); });
+  long long bad = 0;
+  for (int seen = 0; seen < N;) {
+    int n = t.size();
+    for (int id = seen; id < n; ++id) {
+      std::string name = "C" + std::to_string(id);
+      if (t.find(name.c_str()) != id || name != t.at(id).id) ++bad;
+    }
+    seen = n;
+  }
+  writer.join();
+  std::printf("concurrent n=%d bad=%lld\n", t.size(), bad);
+  return bad == 0 ? 0 : 1;
+}
+
+int main() {
+  int rc = test_table();
+  rc |= test_fixed10();
+  rc |= test_commands();
+  rc |= test_binary();
+  rc |= test_concurrent();
+  std::printf(rc == 0 ? "ALL OK\n" : "FAILED\n");
+  return rc;
+}
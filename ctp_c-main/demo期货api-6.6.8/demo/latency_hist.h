@@ -0,0 +1,147 @@
+// 分段延迟直方图（HDR 风格对数-线性分桶）：[0,32) 每 ns 一桶，之后每个 2 的幂区间 32 个子桶，
+// 相对误差 ≤ 1/32（约 3%），上限 2^41ns（约 36 分钟，超出计入最后一桶）
+// 每个写线程首次 record 时分配自己的分片，之后只对本分片做 relaxed load+store（无 RMW、无共享缓存行），
+// 读取时合并所有分片；分片随直方图存活，线程退出后数据仍计入
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+
+struct LatencySummary {
+  uint64_t count;
+  int64_t  sum_ns, min_ns, max_ns;
+  int64_t  p50_ns, p90_ns, p99_ns, p999_ns;
+  double   mean_ns;
+};
+
+class LatencyHistogram {
+public:
+  static constexpr int kSubBits = 5;
+  static constexpr int kSub = 1 << kSubBits;
+  static constexpr int kMaxExp = 40;                           // 最高区间 [2^40, 2^41)
+  static constexpr int kBuckets = (kMaxExp - kSubBits + 2) * kSub;
+  static constexpr int kMaxHistograms = 64;                    // 线程本地分片槽位数，超出的直方图共用一个加锁分片
+
+  LatencyHistogram() : id_(next_id_().fetch_add(1, std::memory_order_relaxed)) {}
+  ~LatencyHistogram() {
+    for (Shard* s = head_.load(); s;) { Shard* n = s->next; delete s; s = n; }
+  }
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  static int bucket_of(int64_t v) {
+    if (v < kSub) return v < 0 ? 0 : (int)v;
+    int e = 63 - __builtin_clzll((uint64_t)v);
+    if (e > kMaxExp) return kBuckets - 1;
+    return (e - kSubBits + 1) * kSub + (int)((v >> (e - kSubBits)) - kSub);
+  }
+  // 桶内最大值（百分位按此报告，即不低估）
+  static int64_t bucket_high(int b) {
+    if (b < kSub) return b;
+    int e = b / kSub + kSubBits - 1;
+    int64_t sub = b % kSub;
+    return ((kSub + sub + 1) << (e - kSubBits)) - 1;
+  }
+
+  void record(int64_t ns) {
+    if (ns < 0) ns = 0;
+    if (id_ >= kMaxHistograms) {
+      std::lock_guard<std::mutex> lk(m_);
+      add_(shared_(), ns);
+      return;
+    }
+    Shard*& s = local_()[id_];
+    if (!s) s = attach_();
+    add_(s, ns);
+  }
+
+  // 合并全部分片；可与 record 并发（结果为近似一致的快照）
+  LatencySummary summary() const {
+    static thread_local uint64_t merged[kBuckets];
+    std::memset(merged, 0, sizeof(merged));
+    LatencySummary r{};
+    r.min_ns = INT64_MAX;
+    for (Shard* s = head_.load(std::memory_order_acquire); s; s = s->next) {
+      for (int b = 0; b < kBuckets; ++b) merged[b] += s->buckets[b].load(std::memory_order_relaxed);
+      r.count += s->count.load(std::memory_order_relaxed);
+      r.sum_ns += s->sum.load(std::memory_order_relaxed);
+      int64_t mn = s->min.load(std::memory_order_relaxed), mx = s->max.load(std::memory_order_relaxed);
+      if (mn < r.min_ns) r.min_ns = mn;
+      if (mx > r.max_ns) r.max_ns = mx;
+    }
+    uint64_t total = 0;
+    for (int b = 0; b < kBuckets; ++b) total += merged[b];
+    if (total == 0) { r.min_ns = 0; return r; }
+    r.mean_ns = r.count ? (double)r.sum_ns / r.count : 0.0;
+    const double qs[4] = {0.50, 0.90, 0.99, 0.999};
+    int64_t* outs[4] = {&r.p50_ns, &r.p90_ns, &r.p99_ns, &r.p999_ns};
+    uint64_t acc = 0;
+    int q = 0;
+    for (int b = 0; b < kBuckets && q < 4; ++b) {
+      acc += merged[b];
+      while (q < 4 && acc >= (uint64_t)(qs[q] * total + 0.5) && acc > 0) {
+        int64_t v = bucket_high(b);
+        *outs[q++] = v < r.max_ns ? v : r.max_ns;
+      }
+    }
+    return r;
+  }
+
+  // 清零；只在没有线程 record 时调用（否则并发写入的那几笔可能丢失）
+  void reset() {
+    for (Shard* s = head_.load(std::memory_order_acquire); s; s = s->next) {
+      for (auto& b : s->buckets) b.store(0, std::memory_order_relaxed);
+      s->count.store(0); s->sum.store(0); s->min.store(INT64_MAX); s->max.store(0);
+    }
+  }
+
+private:
+  struct Shard {
+    std::atomic<uint64_t> buckets[kBuckets];
+    std::atomic<uint64_t> count{0};
+    std::atomic<int64_t>  sum{0}, min{INT64_MAX}, max{0};
+    Shard* next = nullptr;
+    Shard() { for (auto& b : buckets) b.store(0, std::memory_order_relaxed); }
+  };
+
+  // 单写者更新：load + store，不用 fetch_add
+  static void add_(Shard* s, int64_t ns) {
+    auto inc = [](std::atomic<uint64_t>& a) { a.store(a.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); };
+    inc(s->buckets[bucket_of(ns)]);
+    inc(s->count);
+    s->sum.store(s->sum.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    if (ns < s->min.load(std::memory_order_relaxed)) s->min.store(ns, std::memory_order_relaxed);
+    if (ns > s->max.load(std::memory_order_relaxed)) s->max.store(ns, std::memory_order_relaxed);
+  }
+
+  Shard* attach_() {
+    Shard* s = new Shard();
+    std::lock_guard<std::mutex> lk(m_);
+    s->next = head_.load(std::memory_order_relaxed);
+    head_.store(s, std::memory_order_release);
+    return s;
+  }
+  Shard* shared_() {  // 已持有 m_
+    if (!shared_shard_) {
+      shared_shard_ = new Shard();
+      shared_shard_->next = head_.load(std::memory_order_relaxed);
+      head_.store(shared_shard_, std::memory_order_release);
+    }
+    return shared_shard_;
+  }
+
+  static Shard** local_() {
+    static thread_local Shard* slots[kMaxHistograms] = {nullptr};
+    return slots;
+  }
+  static std::atomic<int>& next_id_() {
+    static std::atomic<int> n{0};
+    return n;
+  }
+
+  const int id_;
+  std::atomic<Shard*> head_{nullptr};
+  Shard* shared_shard_ = nullptr;
+  std::mutex m_;
+};
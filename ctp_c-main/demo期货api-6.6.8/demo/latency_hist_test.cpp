@@ -0,0 +1,101 @@
+// latency_hist.h 测试：分桶边界与相对误差、百分位与精确排序对比、多线程分片合并、reset、record 耗时
+#include "latency_hist.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+static int envi(const char* k, int d){ const char* v=getenv(k); return (v&&*v)?std::atoi(v):d; }
+
+int main() {
+  int rc = 0;
+  typedef LatencyHistogram H;
+
+  // 1) 分桶：单调、包含 v、桶宽相对误差 ≤ 1/32
+  int prev = -1;
+  for (int64_t v = 0; v < (1LL << 42); v = v < 4096 ? v + 1 : v + v / 97 + 1) {
+    int b = H::bucket_of(v);
+    if (b < prev || b >= H::kBuckets) { std::printf("bucket order v=%lld b=%d\n", (long long)v, b); rc = 1; break; }
+    prev = b;
+    if (v < (2LL << H::kMaxExp)) {
+      int64_t hi = H::bucket_high(b);
+      if (hi < v || (v >= H::kSub && (double)(hi - v) / v > 1.0 / H::kSub)) {
+        std::printf("bucket range v=%lld hi=%lld\n", (long long)v, (long long)hi); rc = 1; break;
+      }
+    }
+  }
+  if (H::bucket_of(-5) != 0 || H::bucket_of(INT64_MAX) != H::kBuckets - 1) { std::printf("clamp\n"); rc = 1; }
+
+  // 2) 百分位与精确值对比（对数正态，模拟微秒级延迟带长尾）
+  {
+    H h;
+    std::mt19937_64 rng(11);
+    std::lognormal_distribution<double> dist(8.0, 1.2);
+    std::vector<int64_t> xs(200000);
+    for (auto& x : xs) { x = (int64_t)dist(rng); h.record(x); }
+    std::sort(xs.begin(), xs.end());
+    LatencySummary s = h.summary();
+    auto exact = [&](double q) { return xs[(size_t)(q * xs.size() + 0.5) - 1]; };
+    const double qs[4] = {0.5, 0.9, 0.99, 0.999};
+    const int64_t got[4] = {s.p50_ns, s.p90_ns, s.p99_ns, s.p999_ns};
+    for (int i = 0; i < 4; ++i) {
+      double e = exact(qs[i]);
+      if (got[i] < e || (got[i] - e) / e > 1.0 / H::kSub + 1e-9) {
+        std::printf("p%.1f got %lld exact %.0f\n", qs[i] * 100, (long long)got[i], e); rc = 1;
+      }
+    }
+    if (s.count != xs.size() || s.max_ns != xs.back() || s.min_ns != xs.front()) { std::printf("count/min/max\n"); rc = 1; }
+    std::printf("p50=%lld p99=%lld p999=%lld max=%lld mean=%.0f\n", (long long)s.p50_ns, (long long)s.p99_ns,
+                (long long)s.p999_ns, (long long)s.max_ns, s.mean_ns);
+    h.reset();
+    if (h.summary().count != 0 || h.summary().p99_ns != 0) { std::printf("reset\n"); rc = 1; }
+  }
+
+  // 3) 多线程：每线程一个分片，读者并发合并，最终计数与和精确
+  {
+    H h;
+    const int T = 4, N = envi("HIST_N", 500000);
+    std::vector<std::thread> ts;
+    for (int t = 0; t < T; ++t)
+      ts.emplace_back([&h, t, N] { for (int i = 0; i < N; ++i) h.record(100 * (t + 1)); });
+    uint64_t last = 0;
+    for (int i = 0; i < 50; ++i) {
+      uint64_t c = h.summary().count;
+      if (c < last) { std::printf("summary went backwards\n"); rc = 1; break; }
+      last = c;
+    }
+    for (auto& th : ts) th.join();
+    LatencySummary s = h.summary();
+    if (s.count != (uint64_t)T * N || s.sum_ns != (int64_t)N * 100 * (1 + 2 + 3 + 4) || s.max_ns != 400 || s.min_ns != 100) {
+      std::printf("merge count=%llu sum=%lld\n", (unsigned long long)s.count, (long long)s.sum_ns); rc = 1;
+    }
+  }
+
+  // 4) 超过线程本地槽位的直方图走共享分片
+  {
+    std::vector<H*> many;
+    for (int i = 0; i < H::kMaxHistograms + 4; ++i) many.push_back(new H());
+    for (H* p : many) p->record(42);
+    for (H* p : many) if (p->summary().count != 1 || p->summary().p50_ns != 42) { std::printf("many\n"); rc = 1; break; }
+    for (H* p : many) delete p;
+  }
+
+  // 5) record 耗时
+  {
+    H h;
+    const int N = 5000000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; ++i) h.record(i & 0xffff);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / N;
+    auto t1 = std::chrono::steady_clock::now();
+    LatencySummary s = h.summary();
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t1).count();
+    std::printf("record %.1f ns, summary %.1f us (count=%llu)\n", ns, us, (unsigned long long)s.count);
+  }
+
+  std::printf(rc == 0 ? "ALL OK\n" : "FAILED\n");
+  return rc;
+}
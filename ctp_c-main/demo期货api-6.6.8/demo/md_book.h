@@ -0,0 +1,145 @@
+// L5 盘口存储：按合约符号表下标（InstrumentTable id）分槽，字段/档位各占一列（SoA），64 字节对齐
+// 行情回调线程逐笔原地更新，同时与上一笔比较得出变动位（MD_BOOK_*），并产出一条紧凑的 MdBookTick 行；
+// 发布队列、Redis、共享内存快照、批量回调都从这一行取数，不再各自拷贝 CTP 原始结构体。
+// 单写者：只在行情回调线程读写，其他线程通过队列里的 MdBookTick 或共享内存快照读取
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include "ThostFtdcUserApiStruct.h"
+
+// 变动位：与该合约上一笔相比有变化的字段；合约首笔为 MD_BOOK_ALL
+enum : uint32_t {
+  MD_BOOK_LAST     = 1u << 0,
+  MD_BOOK_VOLUME   = 1u << 1,
+  MD_BOOK_TURNOVER = 1u << 2,
+  MD_BOOK_OI       = 1u << 3,
+  MD_BOOK_LIMITS   = 1u << 4,   // 涨跌停价
+  MD_BOOK_BID_PX0  = 1u << 5,   // 第 i 档买价为 MD_BOOK_BID_PX0 << i，下同
+  MD_BOOK_ASK_PX0  = 1u << 10,
+  MD_BOOK_BID_VOL0 = 1u << 15,
+  MD_BOOK_ASK_VOL0 = 1u << 20,
+  MD_BOOK_ALL      = (1u << 25) - 1,
+};
+static const int MD_BOOK_LEVELS = 5;
+
+// 一笔 L5 行；last..lower_limit 段与 MdSnapshotTick 的行情段布局一致，可整段拷贝
+struct MdBookTick {
+  double   last, turnover, open_interest;
+  int64_t  volume;
+  double   bid_px[MD_BOOK_LEVELS], ask_px[MD_BOOK_LEVELS];
+  int32_t  bid_vol[MD_BOOK_LEVELS], ask_vol[MD_BOOK_LEVELS];
+  double   upper_limit, lower_limit;
+  uint32_t changed;   // MD_BOOK_* 位
+  int32_t  id;        // 合约符号表下标，表满时为 -1
+};
+static const size_t MD_BOOK_TICK_FIELDS_BYTES = offsetof(MdBookTick, changed);
+
+// 从 CTP 结构体直接填一行（不经过存储，变动位全置）
+inline void md_book_fill(const CThostFtdcDepthMarketDataField& md, int id, MdBookTick* o) {
+  o->last = md.LastPrice; o->turnover = md.Turnover; o->open_interest = md.OpenInterest;
+  o->volume = md.Volume;
+  o->bid_px[0] = md.BidPrice1; o->bid_px[1] = md.BidPrice2; o->bid_px[2] = md.BidPrice3; o->bid_px[3] = md.BidPrice4; o->bid_px[4] = md.BidPrice5;
+  o->ask_px[0] = md.AskPrice1; o->ask_px[1] = md.AskPrice2; o->ask_px[2] = md.AskPrice3; o->ask_px[3] = md.AskPrice4; o->ask_px[4] = md.AskPrice5;
+  o->bid_vol[0] = md.BidVolume1; o->bid_vol[1] = md.BidVolume2; o->bid_vol[2] = md.BidVolume3; o->bid_vol[3] = md.BidVolume4; o->bid_vol[4] = md.BidVolume5;
+  o->ask_vol[0] = md.AskVolume1; o->ask_vol[1] = md.AskVolume2; o->ask_vol[2] = md.AskVolume3; o->ask_vol[3] = md.AskVolume4; o->ask_vol[4] = md.AskVolume5;
+  o->upper_limit = md.UpperLimitPrice; o->lower_limit = md.LowerLimitPrice;
+  o->changed = MD_BOOK_ALL;
+  o->id = id;
+}
+
+class MdBookStore {
+public:
+  // 列索引：double 列 / int32 列
+  enum { C_LAST, C_TURNOVER, C_OI, C_UPPER, C_LOWER, C_BID_PX0, C_ASK_PX0 = C_BID_PX0 + MD_BOOK_LEVELS,
+         kDoubleCols = C_ASK_PX0 + MD_BOOK_LEVELS };
+  enum { C_BID_VOL0, C_ASK_VOL0 = C_BID_VOL0 + MD_BOOK_LEVELS, kIntCols = C_ASK_VOL0 + MD_BOOK_LEVELS };
+
+  explicit MdBookStore(int capacity) : cap_(capacity > 0 ? capacity : 0) {
+    stride_ = ((size_t)cap_ + 15) & ~(size_t)15;  // 每列起点 64 字节对齐
+    dbl_ = alloc_<double>(stride_ * kDoubleCols);
+    i32_ = alloc_<int32_t>(stride_ * kIntCols);
+    vol_ = alloc_<int64_t>(stride_);
+    upd_ = alloc_<uint64_t>(stride_);
+  }
+  ~MdBookStore() { std::free(dbl_); std::free(i32_); std::free(vol_); std::free(upd_); }
+  MdBookStore(const MdBookStore&) = delete;
+  MdBookStore& operator=(const MdBookStore&) = delete;
+
+  int capacity() const { return cap_; }
+
+  // 原地更新 id 的盘口并填出本笔的行与变动位；id 越界时只填行（变动位全置）
+  uint32_t update(int id, const CThostFtdcDepthMarketDataField& md, MdBookTick* out) {
+    md_book_fill(md, id, out);
+    if (id < 0 || id >= cap_) return out->changed;
+    const bool first = upd_[id]++ == 0;
+    uint32_t m = 0;
+    auto d = [&](int col, double v, uint32_t bit) {
+      double& x = dbl_[col * stride_ + id];
+      if (x != v) { x = v; m |= bit; }
+    };
+    auto i = [&](int col, int32_t v, uint32_t bit) {
+      int32_t& x = i32_[col * stride_ + id];
+      if (x != v) { x = v; m |= bit; }
+    };
+    d(C_LAST, out->last, MD_BOOK_LAST);
+    d(C_TURNOVER, out->turnover, MD_BOOK_TURNOVER);
+    d(C_OI, out->open_interest, MD_BOOK_OI);
+    d(C_UPPER, out->upper_limit, MD_BOOK_LIMITS);
+    d(C_LOWER, out->lower_limit, MD_BOOK_LIMITS);
+    if (vol_[id] != out->volume) { vol_[id] = out->volume; m |= MD_BOOK_VOLUME; }
+    for (int k = 0; k < MD_BOOK_LEVELS; ++k) {
+      d(C_BID_PX0 + k, out->bid_px[k], MD_BOOK_BID_PX0 << k);
+      d(C_ASK_PX0 + k, out->ask_px[k], MD_BOOK_ASK_PX0 << k);
+      i(C_BID_VOL0 + k, out->bid_vol[k], MD_BOOK_BID_VOL0 << k);
+      i(C_ASK_VOL0 + k, out->ask_vol[k], MD_BOOK_ASK_VOL0 << k);
+    }
+    out->changed = first ? MD_BOOK_ALL : m;
+    return out->changed;
+  }
+
+  // 取出 id 当前的盘口（changed 为 0）；未更新过或越界返回 false
+  bool load(int id, MdBookTick* o) const {
+    if (id < 0 || id >= cap_ || upd_[id] == 0) return false;
+    o->last = col(C_LAST)[id]; o->turnover = col(C_TURNOVER)[id]; o->open_interest = col(C_OI)[id];
+    o->volume = vol_[id];
+    for (int k = 0; k < MD_BOOK_LEVELS; ++k) {
+      o->bid_px[k] = col(C_BID_PX0 + k)[id]; o->ask_px[k] = col(C_ASK_PX0 + k)[id];
+      o->bid_vol[k] = icol(C_BID_VOL0 + k)[id]; o->ask_vol[k] = icol(C_ASK_VOL0 + k)[id];
+    }
+    o->upper_limit = col(C_UPPER)[id]; o->lower_limit = col(C_LOWER)[id];
+    o->changed = 0;
+    o->id = id;
+    return true;
+  }
+
+  // 按列访问（跨合约扫描用），长度为 capacity()
+  const double*   col(int c) const { return dbl_ + c * stride_; }
+  const int32_t*  icol(int c) const { return i32_ + c * stride_; }
+  const int64_t*  volume() const { return vol_; }
+  uint64_t updates(int id) const { return (id >= 0 && id < cap_) ? upd_[id] : 0; }
+
+  // 清空全部合约（下一笔重新视为首笔）
+  void clear() {
+    std::memset(dbl_, 0, stride_ * kDoubleCols * sizeof(double));
+    std::memset(i32_, 0, stride_ * kIntCols * sizeof(int32_t));
+    std::memset(vol_, 0, stride_ * sizeof(int64_t));
+    std::memset(upd_, 0, stride_ * sizeof(uint64_t));
+  }
+
+private:
+  template <typename T> static T* alloc_(size_t n) {
+    size_t bytes = (n * sizeof(T) + 63) & ~(size_t)63;
+    T* p = static_cast<T*>(std::aligned_alloc(64, bytes ? bytes : 64));
+    if (p) std::memset(p, 0, bytes ? bytes : 64);
+    return p;
+  }
+
+  int cap_;
+  size_t stride_;
+  double* dbl_;
+  int32_t* i32_;
+  int64_t* vol_;
+  uint64_t* upd_;
+};
@@ -0,0 +1,75 @@
+// md_book.h 测试：首笔全量变动位、逐字段/逐档变动位、列对齐与按列读取、越界 id、clear、更新耗时
+#include "md_book.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+static CThostFtdcDepthMarketDataField make_md(double px) {
+  CThostFtdcDepthMarketDataField md;
+  std::memset(&md, 0, sizeof(md));
+  std::snprintf(md.InstrumentID, sizeof(md.InstrumentID), "IM2512");
+  md.LastPrice = px; md.Volume = 100; md.Turnover = 1e6; md.OpenInterest = 5000;
+  md.UpperLimitPrice = px * 1.1; md.LowerLimitPrice = px * 0.9;
+  md.BidPrice1 = px - 0.2; md.BidPrice2 = px - 0.4; md.BidPrice3 = px - 0.6; md.BidPrice4 = px - 0.8; md.BidPrice5 = px - 1.0;
+  md.AskPrice1 = px + 0.2; md.AskPrice2 = px + 0.4; md.AskPrice3 = px + 0.6; md.AskPrice4 = px + 0.8; md.AskPrice5 = px + 1.0;
+  md.BidVolume1 = 1; md.BidVolume2 = 2; md.BidVolume3 = 3; md.BidVolume4 = 4; md.BidVolume5 = 5;
+  md.AskVolume1 = 6; md.AskVolume2 = 7; md.AskVolume3 = 8; md.AskVolume4 = 9; md.AskVolume5 = 10;
+  return md;
+}
+
+int main() {
+  int rc = 0;
+  MdBookStore book(1000);
+  MdBookTick t, r;
+
+  // 1) 首笔全置；原样再来一笔无变动；行内容与 CTP 字段一致
+  CThostFtdcDepthMarketDataField md = make_md(6000);
+  if (book.update(3, md, &t) != MD_BOOK_ALL || t.id != 3) { std::printf("first update mask\n"); rc = 1; }
+  if (t.bid_px[4] != md.BidPrice5 || t.ask_vol[2] != md.AskVolume3 || t.upper_limit != md.UpperLimitPrice) { std::printf("row fields\n"); rc = 1; }
+  if (book.update(3, md, &t) != 0 || book.updates(3) != 2) { std::printf("unchanged mask=%x\n", t.changed); rc = 1; }
+
+  // 2) 逐项变动
+  md.AskVolume3 = 80;
+  if (book.update(3, md, &t) != (MD_BOOK_ASK_VOL0 << 2)) { std::printf("ask_vol3 mask=%x\n", t.changed); rc = 1; }
+  md.LastPrice += 0.2; md.Volume += 1; md.BidPrice5 -= 0.2;
+  if (book.update(3, md, &t) != (MD_BOOK_LAST | MD_BOOK_VOLUME | (MD_BOOK_BID_PX0 << 4))) { std::printf("multi mask=%x\n", t.changed); rc = 1; }
+  md.LowerLimitPrice = 1; md.OpenInterest = 1; md.Turnover = 1;
+  if (book.update(3, md, &t) != (MD_BOOK_LIMITS | MD_BOOK_OI | MD_BOOK_TURNOVER)) { std::printf("misc mask=%x\n", t.changed); rc = 1; }
+
+  // 3) load 与按列读取
+  if (!book.load(3, &r) || r.changed != 0 || std::memcmp(&r, &t, MD_BOOK_TICK_FIELDS_BYTES) != 0) { std::printf("load\n"); rc = 1; }
+  if (book.load(4, &r) || book.load(-1, &r) || book.load(1000, &r)) { std::printf("load empty/out of range\n"); rc = 1; }
+  for (int c = 0; c < MdBookStore::kDoubleCols; ++c)
+    if ((uintptr_t)book.col(c) % 64) { std::printf("col %d not aligned\n", c); rc = 1; }
+  for (int c = 0; c < MdBookStore::kIntCols; ++c)
+    if ((uintptr_t)book.icol(c) % 64) { std::printf("icol %d not aligned\n", c); rc = 1; }
+  if (book.col(MdBookStore::C_BID_PX0 + 4)[3] != md.BidPrice5 || book.icol(MdBookStore::C_ASK_VOL0 + 2)[3] != 80 ||
+      book.volume()[3] != md.Volume) {
+    std::printf("columns\n"); rc = 1;
+  }
+
+  // 4) 越界 id 只填行；clear 后重新视为首笔
+  if (book.update(-1, md, &t) != MD_BOOK_ALL || t.id != -1 || t.last != md.LastPrice) { std::printf("out of range id\n"); rc = 1; }
+  book.clear();
+  if (book.updates(3) != 0 || book.update(3, md, &t) != MD_BOOK_ALL) { std::printf("clear\n"); rc = 1; }
+
+  // 5) 更新耗时（200 个合约轮转，价格每笔变化）
+  {
+    const int N = 2000000;
+    long long sink = 0;
+    CThostFtdcDepthMarketDataField m = make_md(6000);
+    auto a = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; ++i) {
+      m.LastPrice = 6000 + (i & 63) * 0.2;
+      m.Volume = i;
+      sink += book.update(i % 200, m, &t);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - a).count() / N;
+    std::printf("update %.1f ns (sizeof MdBookTick=%zu, CTP=%zu, sink=%lld)\n", ns, sizeof(MdBookTick),
+                sizeof(CThostFtdcDepthMarketDataField), sink & 1);
+  }
+
+  std::printf(rc == 0 ? "ALL OK\n" : "FAILED\n");
+  return rc;
+}
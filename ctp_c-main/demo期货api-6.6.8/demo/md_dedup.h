@@ -0,0 +1,109 @@
+// 多前置行情合并去重：同一笔行情会从每个前置各到一次，先到的发布，之后到的丢弃
+// - 键：(UpdateTime + UpdateMillisec 折算的日内毫秒, Volume)，按合约（符号表 id）只记最后一个键
+// - 键更新 → 新行情；键比已发布的旧 → 慢前置送来的过期行情，丢弃；
+//   键相同时再比报价摘要（郑商所毫秒恒为 0，同一秒内无成交的报价变化键相同）：见过的摘要为重复，否则为新行情
+// - 日内毫秒回退超过 12 小时视为跨零点 / 跨交易日（夜盘 23:59:59 → 00:00:00、夜盘收盘 → 次日日盘），按新行情处理
+// - UpdateTime 无法解析时不去重，直接发布
+// 单线程调用（多前置时由调用方加锁，同时保护其后的单写者结构）
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include "ThostFtdcUserApiStruct.h"
+#include "exch_time.h"
+
+class MdFrontDedup {
+public:
+  static constexpr int kMaxFronts = 8;
+  static constexpr int kQuotesPerKey = 4;   // 同一键下记住的报价摘要数
+  enum Verdict { MD_FIRST = 0, MD_DUP = 1, MD_STALE = 2 };
+
+  explicit MdFrontDedup(int max_instruments) : st_((size_t)max_instruments) {}
+
+  // UpdateTime + UpdateMillisec → 日内毫秒；无法解析返回 -1
+  static int32_t time_key(const CThostFtdcDepthMarketDataField& md) {
+    const int64_t tod = ExchTimeDecoder::tod_ms(md.UpdateTime);
+    if (tod < 0 || md.UpdateMillisec < 0 || md.UpdateMillisec > 999) return -1;
+    return (int32_t)tod + md.UpdateMillisec;
+  }
+
+  // 一档报价 + 最新价的摘要（FNV-1a over 字段字节）
+  static uint32_t quote_hash(const CThostFtdcDepthMarketDataField& md) {
+    uint32_t h = 2166136261u;
+    auto mix = [&h](const void* p, size_t n) {
+      const unsigned char* b = (const unsigned char*)p;
+      for (size_t i = 0; i < n; ++i) h = (h ^ b[i]) * 16777619u;
+    };
+    mix(&md.LastPrice, sizeof(double));
+    mix(&md.BidPrice1, sizeof(double)); mix(&md.AskPrice1, sizeof(double));
+    mix(&md.BidVolume1, sizeof(int));   mix(&md.AskVolume1, sizeof(int));
+    mix(&md.OpenInterest, sizeof(double));
+    return h;
+  }
+
+  // 判定一笔；MD_DUP 时 *lag_ns 为比首个到达晚了多久（同一时钟的 now_ns 相减）
+  Verdict check(int id, int32_t tod_ms, int64_t volume, uint32_t qhash, int64_t now_ns, int64_t* lag_ns) {
+    if (lag_ns) *lag_ns = 0;
+    if (id < 0 || (size_t)id >= st_.size() || tod_ms < 0) return MD_FIRST;
+    Inst& s = st_[id];
+    if (s.n > 0) {
+      const int c = cmp_(tod_ms, volume, s.tod_ms, s.volume);
+      if (c < 0) return MD_STALE;
+      if (c == 0) {
+        for (int i = 0; i < s.n; ++i)
+          if (s.qhash[i] == qhash) { if (lag_ns) *lag_ns = now_ns - s.first_ns[i]; return MD_DUP; }
+        const int k = s.n < kQuotesPerKey ? s.n++ : (s.next++ % kQuotesPerKey);
+        s.qhash[k] = qhash; s.first_ns[k] = now_ns;
+        return MD_FIRST;
+      }
+    }
+    s.tod_ms = tod_ms; s.volume = volume;
+    s.n = 1; s.next = 0;
+    s.qhash[0] = qhash; s.first_ns[0] = now_ns;
+    return MD_FIRST;
+  }
+
+  void clear() { for (Inst& s : st_) s = Inst(); }
+
+private:
+  struct Inst {
+    int32_t  tod_ms = 0;
+    int32_t  n = 0, next = 0;        // 已记的摘要数 / 满后下一个覆盖位置
+    int64_t  volume = 0;
+    uint32_t qhash[kQuotesPerKey] = {0, 0, 0, 0};
+    int64_t  first_ns[kQuotesPerKey] = {0, 0, 0, 0};
+  };
+
+  static int cmp_(int32_t t, int64_t v, int32_t lt, int64_t lv) {
+    static const int32_t kHalfDay = 12 * 3600 * 1000;
+    const int32_t d = t - lt;
+    if (d != 0) return (d > 0) == (d < kHalfDay && d > -kHalfDay) ? 1 : -1;  // 回退超过半天视为跨日
+    return v > lv ? 1 : (v < lv ? -1 : 0);
+  }
+
+  std::vector<Inst> st_;
+};
+
+// 多个行情回调线程写同一条单生产者队列时用的自旋锁（临界区只有一次盘口更新和入队）
+class MdSpinLock {
+public:
+  void lock() {
+    while (f_.exchange(true, std::memory_order_acquire))
+      for (int spins = 0; f_.load(std::memory_order_relaxed);)
+        if (++spins < 256) pause_(); else std::this_thread::yield();  // 持有者被调度走时让出 CPU
+  }
+  void unlock() { f_.store(false, std::memory_order_release); }
+
+private:
+  static void pause_() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+  }
+  std::atomic<bool> f_{false};
+};
@@ -0,0 +1,130 @@
+// md_dedup.h 测试：先到先发布、重复 / 过期判定、同键不同报价（郑商所毫秒为 0）、跨零点 / 跨交易日、无法解析的时间、
+// 落后时长；多线程模拟三个前置（其一中途断线）合并后不重不漏且保序；判定耗时
+#include "md_dedup.h"
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+static CThostFtdcDepthMarketDataField make(const char* t, int ms, long long vol, double bid) {
+  CThostFtdcDepthMarketDataField md;
+  std::memset(&md, 0, sizeof(md));
+  std::strcpy(md.InstrumentID, "IF2512");
+  std::strcpy(md.UpdateTime, t);
+  md.UpdateMillisec = ms;
+  md.Volume = (int)vol;
+  md.LastPrice = 4000; md.BidPrice1 = bid; md.AskPrice1 = bid + 0.2;
+  md.BidVolume1 = 1; md.AskVolume1 = 2; md.OpenInterest = 1000;
+  return md;
+}
+
+static MdFrontDedup::Verdict feed(MdFrontDedup& d, int id, const CThostFtdcDepthMarketDataField& md, int64_t now, int64_t* lag = nullptr) {
+  return d.check(id, MdFrontDedup::time_key(md), md.Volume, MdFrontDedup::quote_hash(md), now, lag);
+}
+
+int main() {
+  int rc = 0;
+  MdFrontDedup d(16);
+  using V = MdFrontDedup;
+
+  // 1) 首到发布，之后同一笔为重复并给出落后时长；更旧的为过期
+  auto a = make("10:00:00", 500, 100, 3999.8), b = make("10:00:01", 0, 105, 3999.8);
+  int64_t lag = 0;
+  if (feed(d, 1, a, 1000) != V::MD_FIRST || feed(d, 1, a, 1700, &lag) != V::MD_DUP || lag != 700) { std::printf("dup lag=%lld\n", (long long)lag); rc = 1; }
+  if (feed(d, 1, b, 2000) != V::MD_FIRST || feed(d, 1, a, 2100) != V::MD_STALE || feed(d, 1, b, 2200) != V::MD_DUP) {
+    std::printf("stale\n"); rc = 1;
+  }
+  // 同一时间成交量更大 → 新；更小 → 过期
+  if (feed(d, 1, make("10:00:01", 0, 106, 3999.8), 2300) != V::MD_FIRST ||
+      feed(d, 1, make("10:00:01", 0, 105, 3999.8), 2400) != V::MD_STALE) { std::printf("volume order\n"); rc = 1; }
+
+  // 2) 同键不同报价：都是新行情；各自的重复仍被识别
+  auto q1 = make("13:30:00", 0, 500, 100.0), q2 = make("13:30:00", 0, 500, 100.2);
+  if (feed(d, 2, q1, 10) != V::MD_FIRST || feed(d, 2, q2, 20) != V::MD_FIRST ||
+      feed(d, 2, q1, 30, &lag) != V::MD_DUP || lag != 20 || feed(d, 2, q2, 40) != V::MD_DUP) {
+    std::printf("same key quotes\n"); rc = 1;
+  }
+
+  // 3) 跨零点：00:00:00 晚于 23:59:59；之后晚到的 23:59:59 为过期；夜盘 23:00 → 02:30 → 日盘 09:00
+  if (feed(d, 3, make("23:59:59", 500, 10, 1), 1) != V::MD_FIRST || feed(d, 3, make("00:00:00", 0, 11, 1), 2) != V::MD_FIRST ||
+      feed(d, 3, make("23:59:59", 500, 10, 1), 3) != V::MD_STALE) { std::printf("midnight\n"); rc = 1; }
+  if (feed(d, 4, make("23:00:00", 0, 50000, 1), 1) != V::MD_FIRST || feed(d, 4, make("02:30:00", 0, 60000, 1), 2) != V::MD_FIRST ||
+      feed(d, 4, make("09:00:00", 0, 3, 1), 3) != V::MD_FIRST || feed(d, 4, make("02:30:00", 0, 60000, 1), 4) != V::MD_STALE) {
+    std::printf("session change\n"); rc = 1;
+  }
+
+  // 4) 时间无法解析 / id 越界：不去重
+  auto bad = make("1000:00", 0, 1, 1);
+  if (MdFrontDedup::time_key(bad) != -1 || feed(d, 5, bad, 1) != V::MD_FIRST || feed(d, 5, bad, 2) != V::MD_FIRST ||
+      feed(d, 99, a, 1) != V::MD_FIRST || feed(d, 99, a, 2) != V::MD_FIRST) { std::printf("unparsable\n"); rc = 1; }
+  d.clear();
+  if (feed(d, 1, a, 1) != V::MD_FIRST) { std::printf("clear\n"); rc = 1; }
+
+  // 5) 三个前置各自送同一序列（随机延迟），前置 1 中途断线；合并后每合约按原顺序、不重不漏
+  {
+    const int kInst = 8, kTicks = 20000, kFronts = 3;
+    std::vector<CThostFtdcDepthMarketDataField> seq;
+    std::vector<int> seq_id;
+    std::mt19937 rng(7);
+    long long vol[kInst] = {0};
+    int tod[kInst] = {0};
+    for (int i = 0; i < kTicks; ++i) {
+      const int id = (int)(rng() % kInst);
+      const int ms_step = (int)(rng() % 3) * 250;   // 0 → 同键，靠成交量或报价区分
+      tod[id] += ms_step;
+      if (rng() % 2) vol[id] += 1 + rng() % 3;
+      const int t = 9 * 3600 * 1000 + tod[id];
+      char ts[16];
+      std::snprintf(ts, sizeof(ts), "%02d:%02d:%02d", t / 3600000, t / 60000 % 60, t / 1000 % 60);
+      seq.push_back(make(ts, t % 1000, vol[id], 100 + i * 0.01));
+      seq_id.push_back(id);
+    }
+    MdFrontDedup m(kInst);
+    MdSpinLock lock;
+    std::vector<int> out;   // 发布的序号
+    out.reserve(kTicks);
+    long long won[kFronts] = {0, 0, 0}, dups[kFronts] = {0, 0, 0}, stale[kFronts] = {0, 0, 0};
+    std::vector<std::thread> th;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int f = 0; f < kFronts; ++f)
+      th.emplace_back([&, f] {
+        std::mt19937 r(100 + f);
+        for (int i = 0; i < kTicks; ++i) {
+          if (f == 1 && i >= kTicks / 3) break;          // 断线
+          if (r() % 64 == 0) std::this_thread::yield();  // 抖动
+          const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+          std::lock_guard<MdSpinLock> lk(lock);
+          const auto v = m.check(seq_id[i], MdFrontDedup::time_key(seq[i]), seq[i].Volume, MdFrontDedup::quote_hash(seq[i]), now, nullptr);
+          if (v == V::MD_FIRST) { out.push_back(i); ++won[f]; }
+          else if (v == V::MD_DUP) ++dups[f];
+          else ++stale[f];
+        }
+      });
+    for (auto& x : th) x.join();
+    // 每个合约的发布序号严格递增且覆盖全部
+    std::vector<int> last(kInst, -1);
+    int bad_order = 0;
+    for (int i : out) { if (i <= last[seq_id[i]]) ++bad_order; last[seq_id[i]] = i; }
+    if ((int)out.size() != kTicks || bad_order) { std::printf("fan-in published=%zu bad_order=%d\n", out.size(), bad_order); rc = 1; }
+    std::printf("fan-in: won %lld/%lld/%lld dup %lld/%lld/%lld stale %lld/%lld/%lld\n", won[0], won[1], won[2],
+                dups[0], dups[1], dups[2], stale[0], stale[1], stale[2]);
+  }
+
+  // 6) 判定耗时
+  {
+    MdFrontDedup m(256);
+    std::vector<CThostFtdcDepthMarketDataField> v;
+    for (int i = 0; i < 1000; ++i) v.push_back(make("10:00:00", i % 1000, i, 100));
+    const int N = 2000000;
+    long long sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; ++i) sink += feed(m, i % 200, v[(i / 200) % 1000], i);
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / N;
+    std::printf("check %.1f ns (sink=%lld)\n", ns, sink & 1);
+  }
+
+  std::printf(rc == 0 ? "ALL OK\n" : "FAILED\n");
+  return rc;
+}
@@ -0,0 +1,172 @@
+// md_snapshot.h 实现
+#include "md_snapshot.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MD_SNAPSHOT_PAUSE() _mm_pause()
+#else
+#define MD_SNAPSHOT_PAUSE() ((void)0)
+#endif
+
+static const size_t MD_SNAPSHOT_HEADER_BYTES = 4096;
+static const int    MD_SNAPSHOT_READ_RETRIES = 1000;
+
+static size_t snapshot_bytes(uint32_t max_slots) {
+  return MD_SNAPSHOT_HEADER_BYTES + (size_t)max_slots * sizeof(MdSnapshotSlot);
+}
+
+bool MdSnapshotWriter::open(const std::string& name, uint32_t max_slots) {
+  close();
+  if (max_slots == 0) return false;
+  int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0) { std::perror("[snapshot] shm_open"); return false; }
+  const size_t total = snapshot_bytes(max_slots);
+  if (::ftruncate(fd, (off_t)total) != 0) { std::perror("[snapshot] ftruncate"); ::close(fd); return false; }
+  void* p = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) { std::perror("[snapshot] mmap"); return false; }
+  base_ = static_cast<char*>(p);
+  map_len_ = total;
+  name_ = name;
+  hdr_ = reinterpret_cast<MdSnapshotHeader*>(base_);
+  slots_ = reinterpret_cast<MdSnapshotSlot*>(base_ + MD_SNAPSHOT_HEADER_BYTES);
+
+  // 重建：先让 magic 失效，清空槽后再发布新的 epoch 与 magic，已打开的读端会重新扫描下标
+  std::memset(hdr_->magic, 0, sizeof(hdr_->magic));
+  std::atomic_thread_fence(std::memory_order_release);
+  hdr_->n_slots.store(0, std::memory_order_relaxed);
+  std::memset(static_cast<void*>(slots_), 0, (size_t)max_slots * sizeof(MdSnapshotSlot));
+  hdr_->version = MD_SNAPSHOT_VERSION;
+  hdr_->slot_size = sizeof(MdSnapshotSlot);
+  hdr_->max_slots = max_slots;
+  hdr_->writer_pid = (int32_t)::getpid();
+  hdr_->epoch_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::system_clock::now().time_since_epoch()).count();
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(hdr_->magic, MD_SNAPSHOT_MAGIC, 8);
+  return true;
+}
+
+void MdSnapshotWriter::close() {
+  if (base_) ::munmap(base_, map_len_);
+  base_ = nullptr; map_len_ = 0; hdr_ = nullptr; slots_ = nullptr;
+}
+
+void MdSnapshotWriter::update(int id, const char* inst, const MdBookTick& b, int64_t exch_ns, int64_t recv_ns) {
+  if (!base_ || id < 0 || (uint32_t)id >= hdr_->max_slots) return;
+  MdSnapshotSlot& s = slots_[id];
+  MdSnapshotTick& t = s.tick;
+  const uint32_t seq = s.seq.load(std::memory_order_relaxed);
+  s.seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);  // 奇数 seq 先于字段可见
+
+  if (seq == 0) {
+    std::memset(t.inst, 0, sizeof(t.inst));
+    if (inst) std::memcpy(t.inst, inst, strnlen(inst, sizeof(t.inst) - 1));
+  }
+  std::memcpy(&t.last, &b.last, MD_BOOK_TICK_FIELDS_BYTES);
+  t.exch_ns = exch_ns; t.recv_ns = recv_ns;
+  t.updates++;
+
+  s.seq.store(seq + 2, std::memory_order_release);
+  // 首次写入：inst 已随本次提交可见，再登记槽数
+  if (seq == 0 && (uint32_t)id >= hdr_->n_slots.load(std::memory_order_relaxed))
+    hdr_->n_slots.store((uint32_t)id + 1, std::memory_order_release);
+}
+
+bool MdSnapshotReader::open(const std::string& name) {
+  close();
+  int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) return false;
+  struct stat st{};
+  ::fstat(fd, &st);
+  MdSnapshotHeader h;
+  bool ok = (size_t)st.st_size >= sizeof(h) && ::pread(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h) &&
+            std::memcmp(h.magic, MD_SNAPSHOT_MAGIC, 8) == 0 && h.version == MD_SNAPSHOT_VERSION &&
+            h.slot_size == sizeof(MdSnapshotSlot) && (size_t)st.st_size >= snapshot_bytes(h.max_slots);
+  if (!ok) { ::close(fd); std::fprintf(stderr, "[snapshot] %s: not a compatible snapshot table\n", name.c_str()); return false; }
+  const size_t total = snapshot_bytes(h.max_slots);
+  void* p = ::mmap(nullptr, total, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) { std::perror("[snapshot] mmap"); return false; }
+  base_ = static_cast<const char*>(p);
+  map_len_ = total;
+  hdr_ = reinterpret_cast<const MdSnapshotHeader*>(base_);
+  slots_ = reinterpret_cast<const MdSnapshotSlot*>(base_ + MD_SNAPSHOT_HEADER_BYTES);
+  return true;
+}
+
+void MdSnapshotReader::close() {
+  if (base_) ::munmap(const_cast<char*>(base_), map_len_);
+  base_ = nullptr; map_len_ = 0; hdr_ = nullptr; slots_ = nullptr;
+  ids_.clear(); ids_epoch_ = 0; ids_scanned_ = 0;
+}
+
+int MdSnapshotReader::find(const char* inst) {
+  if (!hdr_ || !inst) return -1;
+  if (hdr_->epoch_ns != ids_epoch_) { ids_.clear(); ids_scanned_ = 0; ids_epoch_ = hdr_->epoch_ns; }
+  auto it = ids_.find(inst);
+  if (it != ids_.end()) return it->second;
+  // 只扫描上次之后新登记的槽；槽数按最大下标登记，中间可能有尚未写入的槽，下次从第一个这样的槽重新扫描
+  const uint32_t n = n_slots();
+  uint32_t first_empty = n;
+  for (uint32_t i = ids_scanned_; i < n && i < hdr_->max_slots; ++i) {
+    if (slots_[i].seq.load(std::memory_order_acquire) < 2) {  // 首次提交完成前 inst 可能未写完
+      if (first_empty == n) first_empty = i;
+      continue;
+    }
+    const char* name = slots_[i].tick.inst;
+    ids_.emplace(std::string(name, strnlen(name, sizeof(slots_[i].tick.inst))), (int)i);
+  }
+  ids_scanned_ = first_empty;
+  it = ids_.find(inst);
+  return it != ids_.end() ? it->second : -1;
+}
+
+template <class F>
+int MdSnapshotReader::read_(int id, F&& copy) const {
+  if (!hdr_ || id < 0 || (uint32_t)id >= hdr_->max_slots) return -1;
+  const MdSnapshotSlot& s = slots_[id];
+  for (int i = 0; i < MD_SNAPSHOT_READ_RETRIES; ++i) {
+    const uint32_t s1 = s.seq.load(std::memory_order_acquire);
+    if (s1 == 0) return -1;
+    if (s1 & 1) { MD_SNAPSHOT_PAUSE(); continue; }
+    copy(s.tick);
+    std::atomic_thread_fence(std::memory_order_acquire);  // 字段读取先于第二次读 seq
+    if (s.seq.load(std::memory_order_relaxed) == s1) return 0;
+  }
+  return -2;
+}
+
+int MdSnapshotReader::read(int id, MdSnapshotTick* out) const {
+  if (!out) return -1;
+  return read_(id, [out](const MdSnapshotTick& t) { std::memcpy(out, &t, sizeof(*out)); });
+}
+
+int MdSnapshotReader::read_l1(int id, MdSnapshotL1* out) const {
+  if (!out) return -1;
+  return read_(id, [out](const MdSnapshotTick& t) {
+    out->last = t.last; out->bid1 = t.bid_px[0]; out->ask1 = t.ask_px[0];
+    out->bid_vol1 = t.bid_vol[0]; out->ask_vol1 = t.ask_vol[0];
+    out->exch_ns = t.exch_ns; out->recv_ns = t.recv_ns; out->updates = t.updates;
+  });
+}
+
+extern "C" {
+void* ctp_snap_open(const char* name) {
+  MdSnapshotReader* r = new MdSnapshotReader();
+  if (!name || !r->open(name)) { delete r; return nullptr; }
+  return r;
+}
+void ctp_snap_close(void* h) { delete static_cast<MdSnapshotReader*>(h); }
+int ctp_snap_find(void* h, const char* inst) { return h ? static_cast<MdSnapshotReader*>(h)->find(inst) : -1; }
+int ctp_snap_read(void* h, int id, MdSnapshotTick* out) { return h ? static_cast<MdSnapshotReader*>(h)->read(id, out) : -1; }
+int ctp_snap_read_l1(void* h, int id, MdSnapshotL1* out) { return h ? static_cast<MdSnapshotReader*>(h)->read_l1(id, out) : -1; }
+int ctp_snap_count(void* h) { return h ? (int)static_cast<MdSnapshotReader*>(h)->n_slots() : 0; }
+}
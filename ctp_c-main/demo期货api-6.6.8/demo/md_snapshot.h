@@ -0,0 +1,123 @@
+// 行情快照：POSIX 共享内存里的最新 tick 表，按合约符号表下标（InstrumentTable id）分槽，每槽一个 seqlock
+// 写端（桥的行情回调线程，单写者）：seq 置奇数 → 写字段 → seq 置偶数；读端拷贝前后 seq 相同且为偶数即为一致快照，
+// 不加锁、无系统调用，其他进程 mmap 后直接读，写端不会被读端阻塞。
+// 文件布局：[MdSnapshotHeader 4KB][MdSnapshotSlot × max_slots]，槽 256 字节对齐
+// 读端 C 接口（ctp_snap_*）供 Python ctypes 使用，md_snapshot.cpp 可单独编成小库
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "md_book.h"
+
+static const char     MD_SNAPSHOT_MAGIC[8] = {'C', 'T', 'P', 'S', 'N', 'A', 'P', '1'};
+static const uint32_t MD_SNAPSHOT_VERSION  = 1;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+// 单合约快照（L5），读端拿到的是它的完整拷贝
+typedef struct {
+  char     inst[32];
+  double   last, turnover, open_interest;
+  int64_t  volume;
+  double   bid_px[5], ask_px[5];
+  int32_t  bid_vol[5], ask_vol[5];
+  double   upper_limit, lower_limit;
+  int64_t  exch_ns, recv_ns;   // 交易所时间 / 本机收到时间（Unix ns）
+  uint64_t updates;            // 该槽累计更新次数
+} MdSnapshotTick;
+
+// 一档快照：只拷贝常用字段
+typedef struct {
+  double   last, bid1, ask1;
+  int32_t  bid_vol1, ask_vol1;
+  int64_t  exch_ns, recv_ns;
+  uint64_t updates;
+} MdSnapshotL1;
+#ifdef __cplusplus
+}
+#endif
+
+struct alignas(64) MdSnapshotSlot {
+  std::atomic<uint32_t> seq;   // 偶数稳定，奇数写入中；0 表示从未写入
+  uint32_t reserved;
+  MdSnapshotTick tick;
+};
+static_assert(sizeof(MdSnapshotSlot) == 256, "MdSnapshotSlot layout");
+static_assert(offsetof(MdSnapshotTick, exch_ns) - offsetof(MdSnapshotTick, last) == MD_BOOK_TICK_FIELDS_BYTES &&
+              offsetof(MdSnapshotTick, lower_limit) - offsetof(MdSnapshotTick, last) == offsetof(MdBookTick, lower_limit),
+              "MdSnapshotTick quote fields must mirror MdBookTick");
+
+struct MdSnapshotHeader {
+  char     magic[8];
+  uint32_t version, slot_size;
+  uint32_t max_slots, reserved;
+  int64_t  epoch_ns;                  // 写端每次新建表时更新；读端据此判断下标缓存是否失效
+  int32_t  writer_pid;
+  std::atomic<uint32_t> n_slots;      // 已使用的槽数（下标 < n_slots 的槽 inst 已填好）
+};
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "seqlock must be lock-free in shared memory");
+
+class MdSnapshotWriter {
+public:
+  ~MdSnapshotWriter() { close(); }
+
+  // 新建（或重建）共享内存表；name 如 "/ctp_md_snapshot"
+  bool open(const std::string& name, uint32_t max_slots);
+  void close();
+  bool is_open() const { return base_ != nullptr; }
+
+  // 单写者；id 越界时忽略。行情字段整段取自 md_book.h 的 MdBookTick，inst 只在该槽首次写入时使用
+  void update(int id, const char* inst, const MdBookTick& b, int64_t exch_ns, int64_t recv_ns);
+
+private:
+  char* base_ = nullptr;
+  size_t map_len_ = 0;
+  MdSnapshotHeader* hdr_ = nullptr;
+  MdSnapshotSlot* slots_ = nullptr;
+  std::string name_;
+};
+
+class MdSnapshotReader {
+public:
+  ~MdSnapshotReader() { close(); }
+
+  bool open(const std::string& name);
+  void close();
+
+  // 合约 → 槽下标，未找到返回 -1（按名字扫描，结果缓存；写端重建表后自动重新扫描）
+  int find(const char* inst);
+  // 0 成功；-1 下标无效或该槽未写入；-2 写端持续写入，重试后仍未取得一致快照
+  int read(int id, MdSnapshotTick* out) const;
+  int read_l1(int id, MdSnapshotL1* out) const;
+
+  uint32_t n_slots() const { return hdr_ ? hdr_->n_slots.load(std::memory_order_acquire) : 0; }
+  const MdSnapshotHeader* header() const { return hdr_; }
+
+private:
+  template <class F> int read_(int id, F&& copy) const;
+
+  const char* base_ = nullptr;
+  size_t map_len_ = 0;
+  const MdSnapshotHeader* hdr_ = nullptr;
+  const MdSnapshotSlot* slots_ = nullptr;
+  std::unordered_map<std::string, int> ids_;
+  int64_t ids_epoch_ = 0;
+  uint32_t ids_scanned_ = 0;
+};
+
+// 读端 C 接口：句柄为 MdSnapshotReader*
+#ifdef __cplusplus
+extern "C" {
+#endif
+void* ctp_snap_open(const char* name);
+void  ctp_snap_close(void* h);
+int   ctp_snap_find(void* h, const char* inst);
+int   ctp_snap_read(void* h, int id, MdSnapshotTick* out);
+int   ctp_snap_read_l1(void* h, int id, MdSnapshotL1* out);
+int   ctp_snap_count(void* h);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,147 @@
+// md_snapshot.h 测试：写入/按名字查找/读取、并发写入下无撕裂读（线程 + 子进程）、写端重建后重新查找、读取耗时
+#include "md_snapshot.h"
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+static int envi(const char* k, int d){ const char* v=getenv(k); return (v&&*v)?std::atoi(v):d; }
+
+// 所有价格/量字段都由 k 决定，读端据此判断是否读到撕裂的快照
+static CThostFtdcDepthMarketDataField make_md(const char* inst, long long k) {
+  CThostFtdcDepthMarketDataField md;
+  std::memset(&md, 0, sizeof(md));
+  std::snprintf(md.InstrumentID, sizeof(md.InstrumentID), "%s", inst);
+  double p = (double)k;
+  md.LastPrice = p; md.Turnover = p; md.OpenInterest = p; md.Volume = (int)k;
+  md.BidPrice1 = md.BidPrice2 = md.BidPrice3 = md.BidPrice4 = md.BidPrice5 = p;
+  md.AskPrice1 = md.AskPrice2 = md.AskPrice3 = md.AskPrice4 = md.AskPrice5 = p;
+  md.BidVolume1 = md.BidVolume2 = md.BidVolume3 = md.BidVolume4 = md.BidVolume5 = (int)k;
+  md.AskVolume1 = md.AskVolume2 = md.AskVolume3 = md.AskVolume4 = md.AskVolume5 = (int)k;
+  md.UpperLimitPrice = md.LowerLimitPrice = p;
+  return md;
+}
+
+static void put(MdSnapshotWriter& w, int id, const CThostFtdcDepthMarketDataField& md, int64_t exch_ns, int64_t recv_ns) {
+  MdBookTick b;
+  md_book_fill(md, id, &b);
+  w.update(id, md.InstrumentID, b, exch_ns, recv_ns);
+}
+
+static bool consistent(const MdSnapshotTick& t) {
+  const double p = t.last;
+  if (t.turnover != p || t.open_interest != p || (double)t.volume != p || t.upper_limit != p || t.lower_limit != p) return false;
+  for (int i = 0; i < 5; ++i)
+    if (t.bid_px[i] != p || t.ask_px[i] != p || t.bid_vol[i] != (int)p || t.ask_vol[i] != (int)p) return false;
+  return t.exch_ns == (int64_t)p && t.recv_ns == (int64_t)p + 1;
+}
+
+// 读端循环：返回撕裂次数，reads 为成功读取次数
+static long long reader_loop(const std::string& name, const std::atomic<bool>* stop, long long max_reads, long long* reads) {
+  MdSnapshotReader r;
+  while (!r.open(name)) std::this_thread::yield();
+  int id = -1;
+  while ((id = r.find("HOT")) < 0) std::this_thread::yield();
+  long long torn = 0, n = 0;
+  MdSnapshotTick t;
+  while ((stop ? !stop->load(std::memory_order_relaxed) : true) && n < max_reads) {
+    if (r.read(id, &t) == 0) { ++n; if (!consistent(t)) ++torn; }
+  }
+  *reads = n;
+  return torn;
+}
+
+int main() {
+  int rc = 0;
+  const std::string name = "/md_snapshot_test_" + std::to_string(getpid());
+  const long long W = envi("SNAP_WRITES", 2000000);
+
+  MdSnapshotWriter w;
+  if (!w.open(name, 1024)) { std::printf("writer open failed\n"); return 1; }
+
+  // 1) 基本读写
+  put(w, 0, make_md("IM2512", 6000), 6000, 6001);
+  put(w, 5, make_md("IF2512", 4000), 4000, 4001);
+  {
+    MdSnapshotReader r;
+    if (!r.open(name)) { std::printf("reader open failed\n"); return 1; }
+    MdSnapshotTick t;
+    MdSnapshotL1 l1;
+    if (r.find("IM2512") != 0 || r.find("IF2512") != 5 || r.find("rb2601") != -1 || r.n_slots() != 6) {
+      std::printf("find: %d %d n=%u\n", r.find("IM2512"), r.find("IF2512"), r.n_slots()); rc = 1;
+    }
+    if (r.read(5, &t) != 0 || !consistent(t) || t.last != 4000 || std::strcmp(t.inst, "IF2512") != 0 || t.updates != 1) {
+      std::printf("read slot 5\n"); rc = 1;
+    }
+    if (r.read(3, &t) != -1 || r.read(5000, &t) != -1) { std::printf("empty/out-of-range slot readable\n"); rc = 1; }
+    // 后注册的合约在下次 find 时被扫描到
+    put(w, 2, make_md("rb2601", 3100), 3100, 3101);
+    if (r.find("rb2601") != 2) { std::printf("late find\n"); rc = 1; }
+    if (r.read_l1(0, &l1) != 0 || l1.last != 6000 || l1.bid1 != 6000 || l1.ask_vol1 != 6000 || l1.recv_ns != 6001) {
+      std::printf("read_l1\n"); rc = 1;
+    }
+  }
+
+  // 2) 并发：写线程持续更新同一槽，读线程与子进程读端检查撕裂
+  put(w, 7, make_md("HOT", 1), 1, 2);
+  pid_t pid = fork();
+  if (pid == 0) {
+    long long reads = 0;
+    long long torn = reader_loop(name, nullptr, W / 4, &reads);
+    _exit(torn == 0 && reads == W / 4 ? 0 : 3);
+  }
+  std::atomic<bool> stop{false};
+  long long th_reads = 0, th_torn = 0;
+  std::thread reader([&] { th_torn = reader_loop(name, &stop, 1LL << 62, &th_reads); });
+  auto t0 = std::chrono::steady_clock::now();
+  for (long long k = 2; k < W; ++k) put(w, 7, make_md("HOT", k), k, k + 1);
+  double write_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / W;
+  int status = 0;
+  // 子进程需读满 W/4 次；写端结束后槽不再变化，读取只会更快
+  waitpid(pid, &status, 0);
+  stop.store(true);
+  reader.join();
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) { std::printf("child reader failed status=%d\n", status); rc = 1; }
+  if (th_torn != 0) { std::printf("torn reads: %lld of %lld\n", th_torn, th_reads); rc = 1; }
+  std::printf("update %.1f ns, thread reader %lld reads, torn=%lld\n", write_ns, th_reads, th_torn);
+
+  // 3) 写端重建：读端按 epoch 失效下标缓存
+  {
+    MdSnapshotReader r;
+    r.open(name);
+    if (r.find("IM2512") != 0) { std::printf("pre-rebuild find\n"); rc = 1; }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    w.open(name, 1024);
+    put(w, 0, make_md("AU2512", 900), 900, 901);
+    if (r.find("IM2512") != -1 || r.find("AU2512") != 0) { std::printf("rebuild: stale ids\n"); rc = 1; }
+  }
+
+  // 4) 读取耗时（无竞争）
+  {
+    MdSnapshotReader r;
+    r.open(name);
+    MdSnapshotTick t;
+    MdSnapshotL1 l1;
+    const int N = 2000000;
+    long long sink = 0;
+    auto a = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; ++i) { r.read(0, &t); sink += t.volume; }
+    auto b = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; ++i) { r.read_l1(0, &l1); sink += l1.bid_vol1; }
+    auto c = std::chrono::steady_clock::now();
+    std::printf("read L5 %.1f ns, read L1 %.1f ns (sink=%lld)\n",
+                std::chrono::duration<double, std::nano>(b - a).count() / N,
+                std::chrono::duration<double, std::nano>(c - b).count() / N, sink & 1);
+  }
+
+  w.close();
+  shm_unlink(name.c_str());
+  std::printf(rc == 0 ? "ALL OK\n" : "FAILED\n");
+  return rc;
+}
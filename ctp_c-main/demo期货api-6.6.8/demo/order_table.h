@@ -0,0 +1,159 @@
+// 报单状态表：按数值 OrderRef 开放寻址的预分配表，下单线程无锁登记，交易回调线程更新状态，任意线程查询
+// OrderRef 由原子计数顺序分配，起始槽为 ref & (kSlots-1)，实际几乎总命中起始槽；
+// 槽位只在其中的报单已终结（成交/撤单/拒单）后复用，从不清回空槽，因此探测链不会断。
+// 登记时先写只读字段再发布 ref；状态、成交量等可变字段都是原子量，读端拷贝后复核 ref 判断槽位是否被复用。
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include "ThostFtdcUserApiDataType.h"
+
+enum OrderState : int {
+  ORDER_NONE = 0,
+  ORDER_INSERTED,    // 已调用 ReqOrderInsert
+  ORDER_ACCEPTED,    // CTP / 交易所已接受，未成交
+  ORDER_PARTIAL,     // 部分成交，仍在队列中
+  ORDER_FILLED,      // 全部成交
+  ORDER_CANCELLED,   // 已撤单（可能有部分成交）
+  ORDER_REJECTED,    // 报单被拒
+};
+inline bool order_state_final(int s) { return s >= ORDER_FILLED; }
+
+// OnRtnOrder 的 OrderStatus / OrderSubmitStatus → OrderState
+inline int order_state_from_ctp(char status, char submit_status) {
+  if (submit_status == THOST_FTDC_OSS_InsertRejected) return ORDER_REJECTED;
+  switch (status) {
+    case THOST_FTDC_OST_AllTraded:             return ORDER_FILLED;
+    case THOST_FTDC_OST_PartTradedQueueing:    return ORDER_PARTIAL;
+    case THOST_FTDC_OST_PartTradedNotQueueing: return ORDER_CANCELLED;  // 剩余部分已不在队列
+    case THOST_FTDC_OST_Canceled:              return ORDER_CANCELLED;
+    default:                                   return ORDER_ACCEPTED;
+  }
+}
+
+struct OrderSlot {
+  std::atomic<int> ref{0};          // 0 空；-1 登记中
+  std::atomic<int> state{ORDER_NONE};
+  std::atomic<int> traded{0};       // 已成交量（OnRtnOrder 的 VolumeTraded 与 OnRtnTrade 累计取大）
+  std::atomic<int> trade_sum{0};
+  std::atomic<int> flags{0};        // ORDER_F_*
+  int       volume = 0;
+  char      direction = 0, offset = 0;
+  double    price = 0;
+  long long insert_ns = 0;          // ReqOrderInsert 前时刻（单调时钟）
+  char      strategy[32] = {0};
+  char      inst[32] = {0};
+  char      exch[12] = {0};         // 首个 OnRtnOrder 填写，ORDER_F_EXCH 置位后可读
+  char      order_sys_id[24] = {0}; // 交易所编号，ORDER_F_SYSID 置位后可读
+};
+enum : int {
+  ORDER_F_RTN   = 1,   // 已收本会话 OnRtnOrder
+  ORDER_F_TRADE = 2,   // 已收 OnRtnTrade
+  ORDER_F_EXCH  = 4,
+  ORDER_F_SYSID = 8,
+};
+
+struct OrderInfo {
+  int       ref, state, volume, traded;
+  char      direction, offset;
+  double    price;
+  long long insert_ns;
+  char      strategy[32], inst[32], exch[12], order_sys_id[24];
+};
+
+class OrderTable {
+public:
+  static constexpr int kSlots = 8192;
+  static constexpr int kMaxProbe = 64;
+
+  // 登记一笔报单（可多线程并发）；探测范围内无可用槽时返回 nullptr（报单照发，只是不跟踪）
+  OrderSlot* insert(int ref, const char* strategy, const char* inst, char direction, char offset,
+                    int volume, double price, long long insert_ns) {
+    if (ref <= 0) return nullptr;
+    for (int k = 0; k < kMaxProbe; ++k) {
+      OrderSlot& s = slots_[(ref + k) & (kSlots - 1)];
+      int cur = s.ref.load(std::memory_order_acquire);
+      if (cur == ref) return nullptr;  // 重复的引用
+      if (cur < 0 || (cur > 0 && !order_state_final(s.state.load(std::memory_order_acquire)))) continue;
+      if (!s.ref.compare_exchange_strong(cur, -1, std::memory_order_acq_rel)) continue;
+      s.state.store(ORDER_INSERTED, std::memory_order_relaxed);
+      s.traded.store(0, std::memory_order_relaxed);
+      s.trade_sum.store(0, std::memory_order_relaxed);
+      s.flags.store(0, std::memory_order_relaxed);
+      s.volume = volume; s.direction = direction; s.offset = offset; s.price = price; s.insert_ns = insert_ns;
+      copy_(s.strategy, sizeof(s.strategy), strategy);
+      copy_(s.inst, sizeof(s.inst), inst);
+      s.exch[0] = 0; s.order_sys_id[0] = 0;
+      s.ref.store(ref, std::memory_order_release);
+      return &s;
+    }
+    return nullptr;
+  }
+
+  OrderSlot* find(int ref) {
+    if (ref <= 0) return nullptr;
+    for (int k = 0; k < kMaxProbe; ++k) {
+      OrderSlot& s = slots_[(ref + k) & (kSlots - 1)];
+      int cur = s.ref.load(std::memory_order_acquire);
+      if (cur == ref) return &s;
+      if (cur == 0) return nullptr;
+    }
+    return nullptr;
+  }
+
+  // ---- 以下更新只在交易回调线程调用 ----
+  // 状态只前进不回退（成交回报先于报单回报到达时不会被改回未成交）
+  static void advance(OrderSlot& s, int state) {
+    int cur = s.state.load(std::memory_order_relaxed);
+    if (state > cur && !order_state_final(cur)) s.state.store(state, std::memory_order_release);
+  }
+  static void on_rtn_order(OrderSlot& s, char status, char submit_status, int volume_traded,
+                           const char* exch, const char* order_sys_id) {
+    int f = s.flags.load(std::memory_order_relaxed);
+    if (!(f & ORDER_F_EXCH) && exch && *exch) { copy_(s.exch, sizeof(s.exch), exch); f |= ORDER_F_EXCH; }
+    if (!(f & ORDER_F_SYSID) && order_sys_id && *order_sys_id) {
+      copy_(s.order_sys_id, sizeof(s.order_sys_id), order_sys_id); f |= ORDER_F_SYSID;
+    }
+    s.flags.store(f, std::memory_order_release);
+    if (volume_traded > s.traded.load(std::memory_order_relaxed)) s.traded.store(volume_traded, std::memory_order_release);
+    advance(s, order_state_from_ctp(status, submit_status));
+  }
+  static void on_rtn_trade(OrderSlot& s, int volume) {
+    const int sum = s.trade_sum.load(std::memory_order_relaxed) + volume;
+    s.trade_sum.store(sum, std::memory_order_relaxed);
+    if (sum > s.traded.load(std::memory_order_relaxed)) s.traded.store(sum, std::memory_order_release);
+    advance(s, sum >= s.volume ? ORDER_FILLED : ORDER_PARTIAL);
+  }
+
+  // 拷贝一笔报单的当前状态；未登记或读取期间槽位被复用返回 false
+  bool read(int ref, OrderInfo* out) {
+    OrderSlot* s = find(ref);
+    if (!s || !out) return false;
+    const int f = s->flags.load(std::memory_order_acquire);
+    out->ref = ref;
+    out->state = s->state.load(std::memory_order_acquire);
+    out->traded = s->traded.load(std::memory_order_acquire);
+    out->volume = s->volume; out->direction = s->direction; out->offset = s->offset;
+    out->price = s->price; out->insert_ns = s->insert_ns;
+    std::memcpy(out->strategy, s->strategy, sizeof(out->strategy));
+    std::memcpy(out->inst, s->inst, sizeof(out->inst));
+    if (f & ORDER_F_EXCH) std::memcpy(out->exch, s->exch, sizeof(out->exch)); else out->exch[0] = 0;
+    if (f & ORDER_F_SYSID) std::memcpy(out->order_sys_id, s->order_sys_id, sizeof(out->order_sys_id)); else out->order_sys_id[0] = 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return s->ref.load(std::memory_order_relaxed) == ref;
+  }
+
+  // 清空；只在没有下单线程和交易回调时调用
+  void clear() {
+    for (auto& s : slots_) { s.ref.store(0, std::memory_order_relaxed); s.state.store(ORDER_NONE, std::memory_order_relaxed); }
+  }
+
+private:
+  static void copy_(char* dst, size_t cap, const char* src) {
+    size_t n = src ? strnlen(src, cap - 1) : 0;
+    std::memcpy(dst, src ? src : "", n);
+    dst[n] = 0;
+  }
+
+  OrderSlot slots_[kSlots];
+};
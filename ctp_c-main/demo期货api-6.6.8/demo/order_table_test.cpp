@@ -0,0 +1,112 @@
+// order_table.h 测试：状态映射与只进不退、成交累计、槽位复用与探测、多线程并发登记 + 回报线程更新 + 读端查询、登记耗时
+#include "order_table.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static OrderTable g_t;  // 表较大，放静态区
+
+int main() {
+  int rc = 0;
+  OrderInfo info;
+
+  // 1) 单笔生命周期
+  OrderSlot* s = g_t.insert(11, "stratA", "IM2512", '0', '0', 3, 6000.2, 123);
+  if (!s || g_t.find(11) != s || g_t.insert(11, "x", "y", '0', '0', 1, 1, 1) != nullptr) { std::printf("insert/find/dup\n"); rc = 1; }
+  if (!g_t.read(11, &info) || info.state != ORDER_INSERTED || std::strcmp(info.strategy, "stratA") != 0 ||
+      info.volume != 3 || info.price != 6000.2 || info.exch[0] != 0) {
+    std::printf("read inserted\n"); rc = 1;
+  }
+  OrderTable::on_rtn_order(*s, THOST_FTDC_OST_Unknown, THOST_FTDC_OSS_InsertSubmitted, 0, "CFFEX", "");
+  OrderTable::on_rtn_order(*s, THOST_FTDC_OST_NoTradeQueueing, THOST_FTDC_OSS_Accepted, 0, "CFFEX", "  12345");
+  g_t.read(11, &info);
+  if (info.state != ORDER_ACCEPTED || std::strcmp(info.exch, "CFFEX") != 0 || std::strcmp(info.order_sys_id, "  12345") != 0) {
+    std::printf("accepted state=%d exch=%s\n", info.state, info.exch); rc = 1;
+  }
+  // 成交回报先到：部分成交 → 全部成交；之后迟到的报单回报不能把状态改回
+  OrderTable::on_rtn_trade(*s, 1);
+  g_t.read(11, &info);
+  if (info.state != ORDER_PARTIAL || info.traded != 1) { std::printf("partial\n"); rc = 1; }
+  OrderTable::on_rtn_trade(*s, 2);
+  OrderTable::on_rtn_order(*s, THOST_FTDC_OST_PartTradedQueueing, THOST_FTDC_OSS_Accepted, 1, "CFFEX", "  12345");
+  g_t.read(11, &info);
+  if (info.state != ORDER_FILLED || info.traded != 3) { std::printf("filled state=%d traded=%d\n", info.state, info.traded); rc = 1; }
+  if (order_state_from_ctp(THOST_FTDC_OST_Canceled, THOST_FTDC_OSS_InsertRejected) != ORDER_REJECTED ||
+      order_state_from_ctp(THOST_FTDC_OST_PartTradedNotQueueing, THOST_FTDC_OSS_Accepted) != ORDER_CANCELLED) {
+    std::printf("state map\n"); rc = 1;
+  }
+
+  // 2) 槽位：同起始槽的未终结报单被跳过，终结后可复用；旧引用复用后查不到
+  OrderSlot* a = g_t.insert(11 + OrderTable::kSlots, "B", "rb2601", '1', '1', 1, 0, 0);  // 起始槽与 11 相同，11 已终结 → 复用
+  if (a != s || g_t.find(11) != nullptr || g_t.read(11, &info)) { std::printf("reuse final slot\n"); rc = 1; }
+  OrderSlot* b = g_t.insert(11 + 2 * OrderTable::kSlots, "C", "rb2601", '1', '1', 1, 0, 0);  // 起始槽被未终结报单占用 → 探测
+  if (!b || b == a || g_t.find(11 + 2 * OrderTable::kSlots) != b || g_t.find(11 + OrderTable::kSlots) != a) { std::printf("probe\n"); rc = 1; }
+  g_t.clear();
+
+  // 3) 并发：4 个下单线程原子分配引用并登记，回报线程按序推进状态，读端并发查询
+  {
+    const int T = 4, N = 200000;
+    std::atomic<int> next_ref{1}, published{0}, settled{0};
+    std::atomic<bool> done{false};
+    std::vector<std::thread> placers;
+    std::atomic<long long> lost{0};
+    for (int t = 0; t < T; ++t)
+      placers.emplace_back([&, t] {
+        char strat[32]; std::snprintf(strat, sizeof(strat), "s%d", t);
+        for (int i = 0; i < N; ++i) {
+          int ref = next_ref.fetch_add(1);
+          // 在途报单保持在表容量一半以内（实盘在途单远少于此）
+          while (ref - settled.load() > OrderTable::kSlots / 2) std::this_thread::yield();
+          if (!g_t.insert(ref, strat, "IF2512", '0', '0', 2, 1.0, ref)) lost.fetch_add(1);
+          int p = published.load();
+          while (p < ref && !published.compare_exchange_weak(p, ref)) {}
+        }
+      });
+    // 回报线程：落后下单线程一段，依次把每笔推进到全部成交（终结后的槽才能被复用）
+    long long bad = 0;
+    std::thread cb([&] {
+      for (int ref = 1; ref <= T * N;) {
+        if (ref > published.load() - 64 && !done.load()) { std::this_thread::yield(); continue; }
+        if (OrderSlot* o = g_t.find(ref)) {
+          OrderTable::on_rtn_order(*o, THOST_FTDC_OST_NoTradeQueueing, THOST_FTDC_OSS_Accepted, 0, "CFFEX", "");
+          OrderTable::on_rtn_trade(*o, 2);
+          if (o->state.load() != ORDER_FILLED) ++bad;
+        }
+        settled.store(ref++);
+      }
+    });
+    long long reads = 0, mismatch = 0;
+    std::thread reader([&] {
+      OrderInfo i;
+      while (!done.load()) {
+        int ref = published.load();
+        if (ref > 0 && g_t.read(ref, &i)) { ++reads; if (i.ref != ref || i.insert_ns != ref || i.strategy[0] != 's') ++mismatch; }
+      }
+    });
+    for (auto& th : placers) th.join();
+    done.store(true);
+    cb.join();
+    reader.join();
+    if (bad || mismatch || lost.load() || reads == 0) { std::printf("concurrent bad=%lld mismatch=%lld\n", bad, mismatch); rc = 1; }
+    std::printf("concurrent orders=%d untracked=%lld reads=%lld\n", T * N, lost.load(), reads);
+  }
+  g_t.clear();
+
+  // 4) 登记耗时
+  {
+    const int N = 1000000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 1; i <= N; ++i) {
+      OrderSlot* o = g_t.insert(i, "strat", "IM2512", '0', '0', 1, 6000, i);
+      if (o) o->state.store(ORDER_FILLED, std::memory_order_relaxed);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / N;
+    std::printf("insert %.1f ns\n", ns);
+  }
+
+  std::printf(rc == 0 ? "ALL OK\n" : "FAILED\n");
+  return rc;
+}
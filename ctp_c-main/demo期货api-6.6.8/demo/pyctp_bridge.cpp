@@ -11,6 +11,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <chrono>
+#include <thread>
 
 #include <sys/stat.h>
 #include <unistd.h>
@@ -21,15 +22,36 @@
 #include "td_hook.h"          // 交易钩子：traderSpi.cpp 内部调用；这里注册转发给 Python
 #include "redis_client.h"     // 仅用已实现好的 RedisClient
 #include "pyctp_bridge.h"     // 对外 C 接口声明
-#include <iconv.h>
+#include "spsc_ring.h"        // 行情回调 → 发布线程的无锁队列
+#include "instrument_table.h" // 合约符号表 + 预生成的 Redis 命令模板
+#include "tick_journal.h"     // 原始行情 mmap 日志
+#include "tick_replay.h"      // 日志 / CSV 回放数据源
+#include "exch_time.h"        // 交易所时间解析
+#include "latency_hist.h"     // 分段延迟直方图
+#include "md_book.h"          // L5 盘口存储（SoA）
+#include "md_snapshot.h"      // 共享内存最新 tick 表
+#include "order_table.h"      // 报单状态表
+#include "async_log.h"        // 异步日志
+#include "gbk_utf8.h"         // GBK → UTF-8（每线程缓存句柄）
+#include "bar_agg.h"          // K 线聚合
+#include "column_store.h"     // 列式 K 线库
+#include "instrument_master.h" // 合约主数据 mmap 缓存
+#include "md_dedup.h"          // 多前置行情去重
+#include "thread_tuning.h"     // 绑核 / 忙等退避
 
 // 全局日志文件（匹配 define.h 的 extern FILE* 声明，防止 undefined/conflict）
 FILE* logfile = stdout;
 
 extern "C" void ctp_set_log_file(const char* path) {
   if (!path || !*path) return;
-  if (FILE* f = std::fopen(path, "a")) logfile = f;
+  if (FILE* f = std::fopen(path, "a")) alog::set_logfile(f);
 }
+extern "C" int ctp_set_log_rotate(const char* path, long long max_bytes, int max_files) {
+  return alog::open_file(path, max_bytes, max_files) ? 0 : -1;
+}
+extern "C" void ctp_set_log_drop(int drop) { alog::set_full_policy(drop ? alog::FULL_DROP : alog::FULL_BLOCK); }
+extern "C" int ctp_log_flush(int timeout_ms) { return alog::flush(timeout_ms > 0 ? timeout_ms : 1000) ? 0 : -1; }
+extern "C" void ctp_log_stats(long long* written, long long* dropped) { alog::stats(written, dropped); }
 
 // 小工具
 static inline void sanitize_copy(char* dst, size_t cap, const char* src) {
@@ -47,12 +69,14 @@ static inline void sanitize_copy(char* dst, size_t cap, const char* src) {
   dst[n] = '\0';
 }
 static void log_hex(const char* name, const char* s) {
-  if (!s) { std::fprintf(logfile, "%s=null\n", name); std::fflush(logfile); return; }
-  std::fprintf(logfile, "%s(len=%zu) hex:", name, std::strlen(s));
+  if (!s) { LOG_DEBUG("%s=null\n", name); return; }
+  std::string line = std::string(name) + "(len=" + std::to_string(std::strlen(s)) + ") hex:";
+  char b[4];
   for (const unsigned char* p = (const unsigned char*)s; *p; ++p) {
-    std::fprintf(logfile, " %02X", *p);
+    std::snprintf(b, sizeof(b), " %02X", *p);
+    line += b;
   }
-  std::fprintf(logfile, "\n"); std::fflush(logfile);
+  LOG_DEBUG("%s\n", line);
 }
 static int ensure_dir(const char* p) {
   if (!p || !*p) return -1;
@@ -62,49 +86,30 @@ static int ensure_dir(const char* p) {
   ::mkdir(s.c_str(), 0755);
   return access(s.c_str(), W_OK);
 }
+static inline long long now_ns() {
+  using namespace std::chrono;
+  return duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+static inline long long mono_ns() {
+  using namespace std::chrono;
+  return duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 static inline long long now_ms() {
   using namespace std::chrono;
   return duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 }
 static std::string gbk_to_utf8(const char* s) {
   if (!s) return {};
-  iconv_t cd = iconv_open("UTF-8//IGNORE", "GBK");
-  if (cd == (iconv_t)-1) return std::string(s);
-  size_t inlen = std::strlen(s);
-  size_t outlen = inlen * 3 + 8;
-  std::string out; out.resize(outlen);
-  char* inbuf = const_cast<char*>(s);
-  char* outbuf = out.data();
-  size_t outleft = outlen;
-  if (iconv(cd, &inbuf, &inlen, &outbuf, &outleft) == (size_t)-1) {
-    iconv_close(cd);
-    return std::string(s);
-  }
-  iconv_close(cd);
-  out.resize(outlen - outleft);
-  return out;
-}
-static long long exch_ts_ms(const CThostFtdcDepthMarketDataField* md) {
-  if (!md) return 0;
-  const char* day = (md->ActionDay[0] ? md->ActionDay : md->TradingDay);
-  int y=0,m=0,d=0,H=0,M=0,S=0;
-  if (std::sscanf(day, "%4d%2d%2d", &y, &m, &d) != 3) return 0;
-  if (std::sscanf(md->UpdateTime, "%2d:%2d:%2d", &H, &M, &S) != 3) return 0;
-  std::tm tm{};
-  tm.tm_year = y - 1900; tm.tm_mon = m - 1; tm.tm_mday = d;
-  tm.tm_hour = H; tm.tm_min = M; tm.tm_sec = S;
-  time_t sec = std::mktime(&tm); if (sec < 0) return 0;
-  return (long long)sec * 1000 + (long long)md->UpdateMillisec;
+  return gbk_to_utf8_tls().convert(s);
 }
+// 交易所时间解析（exch_time.h），仅行情回调线程使用
+static ExchTimeDecoder g_exch_time;
 // 对 Python 的回调（仅行情/交易；日志回调易崩，log 仅写文件）
 static log_cb_t   g_log_cb   = nullptr;
 static md_cb_t    g_md_cb    = nullptr;
 static trade_cb_t g_trade_cb = nullptr;
 
-static void logx(const char* s) {
-  std::fprintf(logfile, "%s\n", s ? s : "");
-  std::fflush(logfile);
-}
+static void logx(const char* s) { LOG_INFO("%s\n", s ? s : ""); }
 
 extern "C" void ctp_set_log_cb(log_cb_t cb) { g_log_cb = nullptr; /* 避免从 CTP 线程跨语言回调 */ }
 extern "C" void ctp_set_md_cb(md_cb_t cb)   { g_md_cb = cb; }
@@ -114,6 +119,18 @@ extern "C" void ctp_set_trade_cb(trade_cb_t cb);
 static RedisClient g_redis;
 static std::string g_str_prefix  = (std::getenv("REDIS_STR_PREFIX")  ? std::getenv("REDIS_STR_PREFIX")  : "teamPublic:md:last_json:");
 static std::string g_hash_prefix = (std::getenv("REDIS_HASH_PREFIX") ? std::getenv("REDIS_HASH_PREFIX") : "teamPublic:mdh:last:");
+static std::mutex g_prefix_m;                    // 保护两个前缀（发布线程只在重建模板时读取）
+static std::atomic<uint32_t> g_prefix_gen{1};    // 前缀版本，变化后各合约的命令模板按需重建
+static const int MD_REDIS_TTL_SEC = 86400;
+// 两类 key 的取值格式（TickFormat），可用环境变量 REDIS_STR_FORMAT / REDIS_HASH_FORMAT=bin 预设
+static int env_tick_format(const char* k) { const char* v = std::getenv(k); return (v && std::strcmp(v, "bin") == 0) ? TICK_FMT_BIN : TICK_FMT_TEXT; }
+static std::atomic<int> g_str_fmt{env_tick_format("REDIS_STR_FORMAT")};
+static std::atomic<int> g_hash_fmt{env_tick_format("REDIS_HASH_FORMAT")};
+
+// 合约符号表：订阅时登记，发布线程按 id 取预生成的 key / 命令模板
+static InstrumentTable g_instruments;
+// 合约主数据（ctp_instruments_load 在行情启动前加载，之后只读）
+static InstrumentMaster g_master;
 
 extern "C" {
 int ctp_redis_init_acl(const char* host, int port,
@@ -127,11 +144,129 @@ int ctp_redis_init(const char* host, int port, const char* password, int db, con
 }
 void ctp_redis_close(void) { g_redis.close(); }
 void ctp_redis_set_prefixes(const char* str_prefix, const char* hash_prefix) {
+  ctp_redis_set_prefixes_ex(str_prefix, hash_prefix, -1, -1);
+}
+void ctp_redis_set_prefixes_ex(const char* str_prefix, const char* hash_prefix, int str_fmt, int hash_fmt) {
+  std::lock_guard<std::mutex> lk(g_prefix_m);
   if (str_prefix && *str_prefix)  g_str_prefix  = str_prefix;
   if (hash_prefix && *hash_prefix) g_hash_prefix = hash_prefix;
+  if (str_fmt >= 0)  g_str_fmt.store(str_fmt == TICK_FMT_BIN ? TICK_FMT_BIN : TICK_FMT_TEXT);
+  if (hash_fmt >= 0) g_hash_fmt.store(hash_fmt == TICK_FMT_BIN ? TICK_FMT_BIN : TICK_FMT_TEXT);
+  g_prefix_gen.fetch_add(1, std::memory_order_release);
+}
+int ctp_decode_tick(const void* buf, int len, BinTickV1* out) {
+  return len < 0 ? -1 : decode_bin_tick(buf, (size_t)len, out);
+}
+int ctp_decode_tick_v2(const void* buf, int len, BinTickV2* out) {
+  return len < 0 ? -1 : decode_bin_tick(buf, (size_t)len, out);
 }
 int ctp_redis_set_pipeline(int enabled, int window_cmds) {
-  g_redis.setPipeline(enabled != 0, window_cmds > 0 ? window_cmds : 0);
+  return ctp_redis_set_pipeline_ex(enabled, window_cmds, 0);
+}
+int ctp_redis_set_pipeline_ex(int enabled, int window_cmds, int max_delay_us) {
+  g_redis.setPipeline(enabled != 0, window_cmds > 0 ? window_cmds : 0, max_delay_us > 0 ? max_delay_us : 0);
+  return 0;
+}
+int ctp_redis_set_async(int enabled) { return g_redis.setAsync(enabled != 0) ? 0 : -1; }
+void ctp_redis_async_stats(long long* sent, long long* ok, long long* failed, long long* in_flight) {
+  g_redis.asyncStats(sent, ok, failed, in_flight);
+}
+int ctp_redis_read_last_ticks(const char* const* insts, int n,
+                              double* last, double* bid1, double* ask1, long long* ts_ms) {
+  if (!insts || n <= 0) return 0;
+  std::string hash_prefix;
+  { std::lock_guard<std::mutex> lk(g_prefix_m); hash_prefix = g_hash_prefix; }
+  std::vector<std::string> names(insts, insts + n);
+  std::vector<RedisLastTick> out;
+  const int n_ok = g_redis.readLastTicks(hash_prefix, names, out);
+  if (n_ok < 0) return -1;
+  for (int i = 0; i < n; ++i) {
+    if (last) last[i] = out[i].last;
+    if (bid1) bid1[i] = out[i].bid1;
+    if (ask1) ask1[i] = out[i].ask1;
+    if (ts_ms) ts_ms[i] = out[i].ok ? out[i].ts_ms : 0;
+  }
+  return n_ok;
+}
+} // extern "C"
+
+// ---------------- 线程绑核 / 忙等 ----------------
+// 角色的 CPU 列表来自 ctp_set_thread_cpus 或环境变量（CTP_CPU_MD_PUB 等，首次启动 / 设置时读一次）；
+// 未配置的角色不动线程原有的亲和性。配置变化时 g_cpu_gen 加一，各线程在下一次回调 / 下一轮里比对后重新绑定
+enum ThreadRole { TR_MD_PUB = 0, TR_MD_CB, TR_TD_CB, TR_COUNT };
+static const char* const kThreadRoleName[TR_COUNT] = {"md_pub", "md_cb", "td_cb"};
+static const char* const kThreadRoleEnv[TR_COUNT]  = {"CTP_CPU_MD_PUB", "CTP_CPU_MD_CB", "CTP_CPU_TD_CB"};
+static std::mutex g_cpu_m;
+static std::vector<int> g_role_cpus[TR_COUNT];
+static bool g_role_set[TR_COUNT] = {false, false, false};
+static std::atomic<int> g_cpu_gen{0};
+static std::atomic<int> g_role_cpu_seen[TR_COUNT];   // 绑定时所在 CPU（sched_getcpu），未绑定为 -1
+static std::atomic<bool> g_busy_poll{false};
+static std::once_flag g_cpu_env_once;
+
+static void thread_cfg_from_env() {
+  std::call_once(g_cpu_env_once, [] {
+    for (int r = 0; r < TR_COUNT; ++r) g_role_cpu_seen[r].store(-1);
+    std::lock_guard<std::mutex> lk(g_cpu_m);
+    for (int r = 0; r < TR_COUNT; ++r) {
+      const char* e = std::getenv(kThreadRoleEnv[r]);
+      if (e && parse_cpu_list(e, g_role_cpus[r])) g_role_set[r] = true;
+    }
+    if (const char* e = std::getenv("CTP_BUSY_POLL")) g_busy_poll.store(std::atoi(e) != 0);
+    g_cpu_gen.fetch_add(1, std::memory_order_release);
+  });
+}
+
+// 调用线程按角色绑核；slot 为多前置时的前置序号（列表中有多个 CPU 时各取其一，否则绑到整个列表）
+static void thread_apply_role(int role, int slot) {
+  std::vector<int> cpus;
+  {
+    std::lock_guard<std::mutex> lk(g_cpu_m);
+    if (!g_role_set[role]) return;
+    cpus = g_role_cpus[role];
+  }
+  if (role == TR_MD_CB && cpus.size() > 1) cpus = {cpus[(size_t)slot % cpus.size()]};
+  const int rc = thread_pin_self(cpus);
+  if (rc == 0 && !cpus.empty()) sched_yield();   // 让调度器把线程迁到目标 CPU 后再记录
+  const int cpu = sched_getcpu();
+  g_role_cpu_seen[role].store(cpus.empty() ? -1 : cpu);
+  LOG_INFO("<thread> %s[%d] pinned=%d rc=%d cpu=%d node=%d\n", kThreadRoleName[role], slot, (int)cpus.size(), rc, cpu, cpu_numa_node(cpu));
+}
+
+// 回调线程热路径上只有一次 relaxed load；gen 为调用线程私有的已应用版本
+static inline void thread_role_check(int role, int slot, int& gen) {
+  const int g = g_cpu_gen.load(std::memory_order_relaxed);
+  if (__builtin_expect(g != gen, 0)) { gen = g; thread_apply_role(role, slot); }
+}
+
+extern "C" {
+int ctp_set_thread_cpus(const char* role, const char* cpus) {
+  thread_cfg_from_env();
+  std::vector<int> v;
+  if (!parse_cpu_list(cpus, v)) return -2;
+  if (role && std::strcmp(role, "log") == 0) return alog::set_cpus(cpus) ? 0 : -2;
+  for (int r = 0; r < TR_COUNT; ++r) {
+    if (!role || std::strcmp(role, kThreadRoleName[r]) != 0) continue;
+    { std::lock_guard<std::mutex> lk(g_cpu_m); g_role_cpus[r].swap(v); g_role_set[r] = true; }
+    g_cpu_gen.fetch_add(1, std::memory_order_release);
+    return 0;
+  }
+  return -1;
+}
+int ctp_thread_cpu(const char* role) {
+  thread_cfg_from_env();
+  for (int r = 0; r < TR_COUNT; ++r)
+    if (role && std::strcmp(role, kThreadRoleName[r]) == 0) return g_role_cpu_seen[r].load();
+  return -1;
+}
+int ctp_pin_current_thread(const char* cpus) {
+  std::vector<int> v;
+  if (!parse_cpu_list(cpus, v)) return -2;
+  return thread_pin_self(v);
+}
+int ctp_set_busy_poll(int on) {
+  thread_cfg_from_env();
+  g_busy_poll.store(on != 0);
   return 0;
 }
 } // extern "C"
@@ -142,95 +277,901 @@ static std::atomic<int> g_md_ready{0};
 static std::mutex g_md_m;
 static std::condition_variable g_md_cv;
 static char g_md_broker[32]{0}, g_md_user[32]{0}, g_md_pass[64]{0};
-static std::string g_md_front_str;
+
+class MdSpiBridge;
+// 多前置：每个前置一个 CThostFtdcMdApi 会话，各自的回调线程去重后写同一条发布队列
+// 任一前置登录成功即就绪；断线的前置重连登录后自动重新订阅，其余前置的行情不中断
+struct MdFront {
+  CThostFtdcMdApi* api = nullptr;
+  MdSpiBridge* spi = nullptr;
+  std::string addr;
+  std::atomic<int> state{0};    // 0 连接中 / 1 已登录 / -1 断开或登录失败
+  // 仅该前置的回调线程写
+  std::atomic<long long> received{0}, won{0}, dup{0}, stale{0}, disconnects{0};
+  LatencyHistogram behind;      // 重复笔比首个到达晚多久（单调时钟）
+  LatencyHistogram exch_recv;   // 交易所时间 → 本前置收到
+};
+static MdFront g_md_fronts[MdFrontDedup::kMaxFronts];
+static int g_md_n_fronts = 0;   // 启动前设置；>1 时回调走去重合并
+static MdSpinLock g_md_lock;    // 多前置时保护去重表及其后的单写者结构（盘口、快照、日志、队列生产端）
+// 已订阅合约：后登录 / 重连的前置按此重新订阅
+static std::mutex g_md_subs_m;
+static std::vector<std::string> g_md_subs;
+
+static void md_update_ready() {
+  int up = 0, down = 0;
+  for (int i = 0; i < g_md_n_fronts; ++i) {
+    const int st = g_md_fronts[i].state.load();
+    up += st == 1; down += st < 0;
+  }
+  g_md_ready.store(up ? 1 : (down == g_md_n_fronts ? -1 : 0));
+  g_md_cv.notify_all();
+}
+
+static int md_subscribe_on(CThostFtdcMdApi* api, const std::vector<std::string>& v) {
+  if (v.empty()) return 0;
+  std::vector<char*> ptr; ptr.reserve(v.size()); for (auto& s:v) ptr.push_back(const_cast<char*>(s.c_str()));
+  return api->SubscribeMarketData(ptr.data(), (int)v.size());
+}
 
 class MdSpiBridge : public CThostFtdcMdSpi {
 public:
-  explicit MdSpiBridge(CThostFtdcMdApi* api): api_(api) {}
+  explicit MdSpiBridge(CThostFtdcMdApi* api, int front = 0): api_(api), front_(front) {}
   void OnFrontConnected() override {
-    logx("<Md OnFrontConnected>");
+    thread_role_check(TR_MD_CB, front_, cpu_gen_);
+    LOG_INFO("<Md OnFrontConnected> front=%d %s\n", front_, g_md_fronts[front_].addr.c_str());
     CThostFtdcReqUserLoginField req{};
     std::strncpy(req.BrokerID, g_md_broker, sizeof(req.BrokerID)-1);
     std::strncpy(req.UserID,  g_md_user,   sizeof(req.UserID)-1);
     std::strncpy(req.Password,g_md_pass,   sizeof(req.Password)-1);
     api_->ReqUserLogin(&req, 1);
   }
-  void OnFrontDisconnected(int) override {
-    logx("<Md OnFrontDisconnected>");
-    g_md_ready.store(-1);
-    g_md_cv.notify_all();
+  void OnFrontDisconnected(int reason) override {
+    LOG_INFO("<Md OnFrontDisconnected> front=%d reason=0x%x\n", front_, reason);
+    g_md_fronts[front_].disconnects.fetch_add(1, std::memory_order_relaxed);
+    g_md_fronts[front_].state.store(-1);
+    md_update_ready();
   }
   void OnRspUserLogin(CThostFtdcRspUserLoginField*, CThostFtdcRspInfoField* e, int, bool) override {
-    if (e && e->ErrorID != 0){ logx("<Md Login Failed>"); g_md_ready.store(-1); }
-    else { logx("<Md Login OK>"); g_md_ready.store(1); }
-    g_md_cv.notify_all();
+    if (e && e->ErrorID != 0){ LOG_INFO("<Md Login Failed> front=%d\n", front_); g_md_fronts[front_].state.store(-1); }
+    else {
+      LOG_INFO("<Md Login OK> front=%d\n", front_);
+      g_md_fronts[front_].state.store(1);
+      // 先置登录状态再取订阅表：与 ctp_md_subscribe 并发时至少一方会覆盖新合约
+      std::lock_guard<std::mutex> lk(g_md_subs_m);
+      md_subscribe_on(api_, g_md_subs);
+    }
+    md_update_ready();
   }
   void OnRspError(CThostFtdcRspInfoField*, int, bool) override {
-    logx("<Md RspError>");
-    g_md_ready.store(-1);
-    g_md_cv.notify_all();
+    LOG_INFO("<Md RspError> front=%d\n", front_);
+    g_md_fronts[front_].state.store(-1);
+    md_update_ready();
   }
   void OnRspSubMarketData(CThostFtdcSpecificInstrumentField*, CThostFtdcRspInfoField* e, int, bool) override {
     if (e && e->ErrorID != 0) logx("<SubMD Fail>"); else logx("<SubMD OK>");
   }
-  void OnRtnDepthMarketData(CThostFtdcDepthMarketDataField* md) override {
-    if (!md) return;
-    long long recv_ms  = now_ms();               // C++收到回调时刻(ms)
-    long long ex_ms    = exch_ts_ms(md);         // 交易所时间(ms)
-    bool ok1 = g_redis.writeTickString(g_str_prefix,  md->InstrumentID, md->LastPrice, md->BidPrice1, md->AskPrice1, recv_ms, 86400);
-    bool ok2 = g_redis.writeTickHash  (g_hash_prefix, md->InstrumentID, md->LastPrice, md->BidPrice1, md->AskPrice1, recv_ms, 86400);
-    long long redis_ms = (ok1 && ok2) ? now_ms() : 0;  // 写入成功后的时间(ms)，失败则为0
-    if (g_md_cb) g_md_cb(md->InstrumentID, md->LastPrice, md->BidPrice1, md->AskPrice1, ex_ms, recv_ms, redis_ms);
-  }
+  // CTP 线程只做一次拷贝入队，不碰网络；队列满时丢弃本条并计数
+  void OnRtnDepthMarketData(CThostFtdcDepthMarketDataField* md) override;
 private:
   CThostFtdcMdApi* api_;
+  int front_;
+  int cpu_gen_ = 0;   // 仅本前置的回调线程读写
 };
 
 static MdSpiBridge* g_md_spi = nullptr;
 
+// ---------------- 行情发布队列 ----------------
+// OnRtnDepthMarketData → SpscRing → 发布线程：批量写 Redis（SET + HSET）并转发 md_cb。
+// Redis 慢/阻塞只会让队列变深，不会拖住 CTP 回调线程。
+// 队列里只放 L5 盘口行（md_book.h）而不是整个 CTP 结构体，下游各输出都从这一行取数
+struct MdTick {
+  MdBookTick book;    // 本笔 L5 行（含合约 id、变动位）
+  char inst[32];      // InstrumentID（md_cb、表满时的旧写入路径用）
+  long long recv_ms;  // C++ 收到回调时刻(ms)
+  long long exch_ns;  // 交易所时间（Unix ns，与 recv 同一时基），无法解析时为 0
+  long long cb_ns;    // 回调入口时刻（单调时钟，用于分段延迟）
+  long long enq_ns;   // 入队时刻（单调时钟）
+};
+static const size_t MD_QUEUE_DEFAULT_CAPACITY = 16384;
+static const size_t MD_PUBLISH_BATCH = 256;        // 发布线程每次最多取出的条数
+static size_t g_md_queue_capacity = MD_QUEUE_DEFAULT_CAPACITY;
+static SpscRing<MdTick>* g_md_queue = nullptr;
+static std::mutex g_md_queue_m;  // 保护 g_md_queue 的分配 / 释放（ctp_md_queue_stats 可在任意线程读深度）
+static std::thread g_md_pub_thread;
+static std::atomic<bool> g_md_pub_run{false};
+// 生产者侧计数（仅 CTP 回调线程写）
+static std::atomic<long long> g_md_enqueued{0}, g_md_dropped{0}, g_md_overflow{0}, g_md_max_depth{0};
+static bool g_md_in_overflow = false;                // 当前是否处于队列满状态，用于统计溢出次数
+// 消费者侧计数（仅发布线程写）
+static std::atomic<long long> g_md_published{0}, g_md_redis_fail{0};
+static std::atomic<long long> g_md_last_pub_ns{0};   // 最近一笔处理完的时刻（单调时钟）
+
+// 分段延迟直方图（latency_hist.h，每写线程一个分片，读时合并），单调时钟 ns；ctp_stats_snapshot 读取
+static LatencyHistogram g_lat_exch_recv;    // 交易所时间 → 收到（系统时钟，两端时钟不同步，交易所时间只到 ms）
+static LatencyHistogram g_lat_cb;           // 回调入口 → 入队完成（含写行情日志）
+static LatencyHistogram g_lat_queue;        // 入队 → 发布线程取出
+static LatencyHistogram g_lat_redis;        // Redis 写入调用
+static LatencyHistogram g_lat_enq_redis;    // 入队 → Redis 写入返回（同步模式即收到应答；pipeline/异步模式为交给客户端）
+static LatencyHistogram g_lat_e2e;          // 回调入口 → md_cb 返回
+static LatencyHistogram g_lat_order_rtn;    // ReqOrderInsert → 首个 OnRtnOrder
+static LatencyHistogram g_lat_order_trade;  // ReqOrderInsert → 首个 OnRtnTrade
+static std::atomic<long long> g_exch_recv_negative{0};  // 收到时间早于交易所时间的笔数（本机时钟偏慢）
+static void md_stats_reset() {
+  g_lat_exch_recv.reset(); g_lat_cb.reset(); g_lat_queue.reset();
+  g_lat_redis.reset(); g_lat_enq_redis.reset(); g_lat_e2e.reset();
+  g_exch_recv_negative.store(0);
+  for (MdFront& f : g_md_fronts) { f.behind.reset(); f.exch_recv.reset(); }
+}
+
+static std::atomic<bool> g_md_replaying{false};  // 回放模式：行情来自日志回放而非 CTP 前置
+static long long g_replay_ref_ns = 0;              // 当前回放记录的录制收到时间（仅回放线程读写）
+
+// ---------------- 原始行情日志 ----------------
+// 开启后 CTP 回调线程在入队前把原始结构体追加到 {dir}/md_{TradingDay}.jrnl（仅回调线程访问 g_journal）
+static std::string g_journal_dir;
+static uint64_t g_journal_max_records = JOURNAL_DEFAULT_RECORDS;
+static TickJournalWriter g_journal;
+
+static void md_journal_append(const CThostFtdcDepthMarketDataField& md, long long recv_ns) {
+  // 跨交易日（或首笔）时切换文件；打开失败后按当日不再重试，避免每笔都做文件操作
+  static char failed_day[16] = {0};
+  if (!g_journal.is_open() || std::strcmp(g_journal.trading_day(), md.TradingDay) != 0) {
+    if (std::strcmp(failed_day, md.TradingDay) == 0) { g_journal.append(md, recv_ns); return; }
+    if (g_journal.is_open() && g_journal.roll(md.TradingDay)) {
+      // 换到后台预建的文件：回调线程只交换指针，改名和预建下一份由日志后台线程完成
+      LOG_INFO("<Journal> roll to %s\n", md.TradingDay);
+      failed_day[0] = 0;
+    } else if (g_journal.open_day(g_journal_dir, md.TradingDay, g_journal_max_records)) {
+      // 首笔，或预建文件未就绪时回退到同步打开
+      logx((std::string("<Journal> ") + TickJournalWriter::day_path(g_journal_dir, md.TradingDay)).c_str());
+      failed_day[0] = 0;
+    } else {
+      std::snprintf(failed_day, sizeof(failed_day), "%s", md.TradingDay);
+    }
+  }
+  g_journal.append(md, recv_ns);
+}
+
+// 共享内存快照（md_snapshot.h），仅行情回调线程写
+static MdSnapshotWriter g_snapshot;
+// L5 盘口（md_book.h），按符号表 id 原地更新，仅行情回调线程读写
+static MdBookStore g_book(InstrumentTable::kMaxInstruments);
+
+// 多前置时只记去重后的行情，回放即合并后的行情流
+static MdFrontDedup g_md_dedup(InstrumentTable::kMaxInstruments);
+
+// 一笔行情写入盘口 / 快照 / 日志并入队；单写者（单前置为其回调线程，多前置在 g_md_lock 内）
+static void md_accept(const CThostFtdcDepthMarketDataField* md, int id, long long cb_ns, long long recv_ns) {
+  if (!g_journal_dir.empty() && !g_md_replaying.load(std::memory_order_relaxed)) md_journal_append(*md, recv_ns);
+  if (id < 0) id = g_instruments.find(md->InstrumentID);
+  if (id < 0) id = g_instruments.add(md->InstrumentID);  // 未经 ctp_md_subscribe 登记的合约在此补登记
+  MdTick t;
+  g_book.update(id, *md, &t.book);
+  std::memset(t.inst, 0, sizeof(t.inst));
+  std::memcpy(t.inst, md->InstrumentID, strnlen(md->InstrumentID, sizeof(t.inst) - 1));
+  t.recv_ms = recv_ns / 1000000;
+  t.cb_ns = cb_ns;
+  // 回放时以录制时的收到时间作为夜盘日期修正的参照
+  const long long ref_ns = g_md_replaying.load(std::memory_order_relaxed) ? g_replay_ref_ns : recv_ns;
+  t.exch_ns = g_exch_time.decode_ns(*md, ref_ns);
+  if (t.exch_ns > 0) {
+    if (ref_ns < t.exch_ns) g_exch_recv_negative.fetch_add(1, std::memory_order_relaxed);
+    g_lat_exch_recv.record(ref_ns - t.exch_ns);
+  }
+  if (g_snapshot.is_open()) g_snapshot.update(id, t.inst, t.book, t.exch_ns, recv_ns);
+  t.enq_ns = mono_ns();
+  if (!g_md_queue->push(t)) {
+    g_md_dropped.fetch_add(1, std::memory_order_relaxed);
+    if (!g_md_in_overflow) { g_md_in_overflow = true; g_md_overflow.fetch_add(1, std::memory_order_relaxed); }
+    return;
+  }
+  g_md_in_overflow = false;
+  g_md_enqueued.fetch_add(1, std::memory_order_relaxed);
+  long long depth = (long long)g_md_queue->size();
+  if (depth > g_md_max_depth.load(std::memory_order_relaxed)) g_md_max_depth.store(depth, std::memory_order_relaxed);
+  g_lat_cb.record(mono_ns() - cb_ns);
+}
+
+// 多前置合并：按 (UpdateTime, UpdateMillisec, Volume) 先到先发布，重复 / 过期的只计数
+static void md_merge(const CThostFtdcDepthMarketDataField* md, int front, long long cb_ns, long long recv_ns) {
+  MdFront& f = g_md_fronts[front];
+  f.received.fetch_add(1, std::memory_order_relaxed);
+  std::lock_guard<MdSpinLock> lk(g_md_lock);
+  int id = g_instruments.find(md->InstrumentID);
+  if (id < 0) id = g_instruments.add(md->InstrumentID);
+  const long long ex = g_exch_time.decode_ns(*md, recv_ns);
+  if (ex > 0) f.exch_recv.record(recv_ns - ex);
+  int64_t lag = 0;
+  switch (g_md_dedup.check(id, MdFrontDedup::time_key(*md), md->Volume, MdFrontDedup::quote_hash(*md), cb_ns, &lag)) {
+    case MdFrontDedup::MD_DUP:   f.dup.fetch_add(1, std::memory_order_relaxed); f.behind.record(lag); return;
+    case MdFrontDedup::MD_STALE: f.stale.fetch_add(1, std::memory_order_relaxed); return;
+    default: break;
+  }
+  f.won.fetch_add(1, std::memory_order_relaxed);
+  md_accept(md, id, cb_ns, recv_ns);
+}
+
+void MdSpiBridge::OnRtnDepthMarketData(CThostFtdcDepthMarketDataField* md) {
+  if (!md || !g_md_queue) return;
+  thread_role_check(TR_MD_CB, front_, cpu_gen_);
+  const long long cb_ns = mono_ns();
+  const long long recv_ns = now_ns();
+  if (g_md_n_fronts > 1) md_merge(md, front_, cb_ns, recv_ns);
+  else md_accept(md, -1, cb_ns, recv_ns);
+}
+
+// 单笔行情的 Redis 写入：命令模板（key、命令头尾）按合约缓存，逐笔只填数字；SET 合并 EX，每笔 3 条命令
+static std::string g_md_cmd_buf;  // 仅发布线程使用，容量复用
+// 符号表下标取 t.book.id（<0 表示表满，走不带模板的旧路径）
+static bool md_write_redis(const MdTick& t, long long ex_ms) {
+  const MdBookTick& b = t.book;
+  const int id = b.id;
+  if (id < 0) {
+    std::string str_prefix, hash_prefix;
+    { std::lock_guard<std::mutex> lk(g_prefix_m); str_prefix = g_str_prefix; hash_prefix = g_hash_prefix; }
+    bool ok1 = g_redis.writeTickString(str_prefix,  t.inst, b.last, b.bid_px[0], b.ask_px[0], t.recv_ms, MD_REDIS_TTL_SEC);
+    bool ok2 = g_redis.writeTickHash  (hash_prefix, t.inst, b.last, b.bid_px[0], b.ask_px[0], t.recv_ms, MD_REDIS_TTL_SEC);
+    return ok1 && ok2;
+  }
+  InstrumentEntry& e = g_instruments.at(id);
+  uint32_t gen = g_prefix_gen.load(std::memory_order_acquire);
+  if (e.redis.prefix_gen != gen) {
+    std::lock_guard<std::mutex> lk(g_prefix_m);
+    build_tick_template(e.redis, e.id, g_str_prefix, g_hash_prefix, MD_REDIS_TTL_SEC, gen);
+  }
+  const int str_fmt = g_str_fmt.load(std::memory_order_relaxed), hash_fmt = g_hash_fmt.load(std::memory_order_relaxed);
+  BinTickV2 bin;
+  if (str_fmt == TICK_FMT_BIN || hash_fmt == TICK_FMT_BIN) {
+    init_bin_tick(bin, (uint32_t)id, e.id);
+    BinTickV1& v = bin.v1;
+    v.last = b.last; v.bid1 = b.bid_px[0]; v.ask1 = b.ask_px[0];
+    v.turnover = b.turnover; v.open_interest = b.open_interest;
+    v.volume = b.volume; v.bid_vol1 = b.bid_vol[0]; v.ask_vol1 = b.ask_vol[0];
+    v.exch_ts_ms = ex_ms; v.recv_ts_ms = t.recv_ms;
+    std::memcpy(bin.bid_px, b.bid_px + 1, sizeof(bin.bid_px)); std::memcpy(bin.ask_px, b.ask_px + 1, sizeof(bin.ask_px));
+    std::memcpy(bin.bid_vol, b.bid_vol + 1, sizeof(bin.bid_vol)); std::memcpy(bin.ask_vol, b.ask_vol + 1, sizeof(bin.ask_vol));
+    bin.changed = b.changed;
+  }
+  size_t lens[3];
+  build_tick_commands(e.redis, b.last, b.bid_px[0], b.ask_px[0], t.recv_ms, g_md_cmd_buf, lens,
+                      &bin.v1, str_fmt, hash_fmt);
+  return g_redis.writeFormatted(g_md_cmd_buf.data(), lens, 3);
+}
+
+// ---------------- 批量行情回调 ----------------
+// 发布线程把每笔写入 ctp_md_tick_t 数组，攒满 max_batch 或最早一笔等待超过 max_delay 后整批交给回调（仅发布线程读写缓冲）
+static_assert(sizeof(ctp_md_tick_t) == 128, "ctp_md_tick_t layout (Python dtype depends on it)");
+static std::atomic<md_batch_cb_t> g_md_batch_cb{nullptr};
+static std::atomic<int> g_md_batch_max{256};
+static std::atomic<long long> g_md_batch_delay_ns{1000000};
+static std::vector<ctp_md_tick_t> g_md_batch_buf;
+static std::vector<long long> g_md_batch_cb_ns;  // 各笔回调入口时刻，交付后计端到端延迟
+static size_t g_md_batch_n = 0;
+static long long g_md_batch_first_ns = 0;         // 当前批第一笔加入时刻
+static long long g_md_batch_seq = 0;
+
+static void md_batch_flush() {
+  if (g_md_batch_n == 0) return;
+  if (md_batch_cb_t cb = g_md_batch_cb.load(std::memory_order_acquire)) cb(g_md_batch_buf.data(), (int)g_md_batch_n);
+  const long long t_done = mono_ns();
+  for (size_t i = 0; i < g_md_batch_n; ++i) g_lat_e2e.record(t_done - g_md_batch_cb_ns[i]);
+  g_md_batch_n = 0;
+}
+
+static void md_batch_add(const MdTick& t, long long ex_ms, long long redis_ms) {
+  const size_t cap = (size_t)g_md_batch_max.load(std::memory_order_relaxed);
+  if (g_md_batch_buf.size() != cap) {
+    md_batch_flush();
+    g_md_batch_buf.resize(cap);
+    g_md_batch_cb_ns.resize(cap);
+  }
+  if (g_md_batch_n == 0) g_md_batch_first_ns = mono_ns();
+  const MdBookTick& b = t.book;
+  ctp_md_tick_t& o = g_md_batch_buf[g_md_batch_n];
+  std::memcpy(o.inst, t.inst, sizeof(o.inst));
+  o.last = b.last; o.bid1 = b.bid_px[0]; o.ask1 = b.ask_px[0];
+  o.turnover = b.turnover; o.open_interest = b.open_interest;
+  o.volume = b.volume; o.bid_vol1 = b.bid_vol[0]; o.ask_vol1 = b.ask_vol[0];
+  o.exch_ts_ms = ex_ms; o.recv_cpp_ms = t.recv_ms; o.redis_ok_ms = redis_ms;
+  o.seq = ++g_md_batch_seq;
+  o.inst_id = b.id;
+  o.changed = b.changed;
+  g_md_batch_cb_ns[g_md_batch_n] = t.cb_ns;
+  if (++g_md_batch_n >= cap) md_batch_flush();
+}
+
+// 发布循环每轮调用：批未满但等待超时也交付
+static void md_batch_flush_if_due() {
+  if (g_md_batch_n && mono_ns() - g_md_batch_first_ns >= g_md_batch_delay_ns.load(std::memory_order_relaxed))
+    md_batch_flush();
+}
+
+// ---------------- K 线 ----------------
+// 配置只在行情启动前写（ctp_md_set_bars），之后仅发布线程读写
+static BarAggregator g_bars(InstrumentTable::kMaxInstruments);
+static std::string g_bar_prefix, g_bar_dir;
+static int g_bar_maxlen = 10000;
+static const long long BAR_CLOSE_GRACE_MS = 1500;  // 实盘按时钟收盘的宽限（交易所推送约 500ms 一笔）
+static FILE* g_bar_file = nullptr;
+static long long g_bar_day_lo = 0, g_bar_day_hi = 0;  // 当前文件对应的本地日期 [lo, hi)（ms）
+static long long g_bar_next_check_ms = 0;
+static std::string g_bar_cmd;
+static std::atomic<long long> g_bars_emitted{0}, g_bars_redis_fail{0};
+static std::atomic<bar_cb_t> g_bar_cb{nullptr};
+static_assert(sizeof(ctp_bar_t) == sizeof(BarRecord) && offsetof(ctp_bar_t, start_ms) == offsetof(BarRecord, bar.start_ms) &&
+              offsetof(ctp_bar_t, flags) == offsetof(BarRecord, bar.flags), "ctp_bar_t mirrors BarRecord");
+// 列式 K 线库（column_store.h）：{dir}/{周期}/{合约}/*.npy，每秒刷新一次
+static ColumnStoreWriter g_bar_store;
+static long long g_bar_store_next_flush_ms = 0;
+static std::atomic<long long> g_bar_store_rows{0}, g_bar_store_dropped{0};
+// 各 id 的乘数是否已确定（显式设置或已查过主数据）；启动前主线程写，之后仅发布线程读写
+static std::vector<uint8_t> g_bar_mult_known(InstrumentTable::kMaxInstruments, 0);
+
+// 乘数取自主数据；主数据里没有的合约保持未设置（按逐笔价格加权）
+static void bar_mult_from_master(int id) {
+  g_bar_mult_known[id] = 1;
+  const int m = g_master.find(g_instruments.at(id).id);
+  if (m >= 0) g_bars.set_multiplier(id, g_master.at(m).multiplier);
+}
+
+static void bar_label(char* out, size_t cap, int sec) {
+  if (sec % 3600 == 0) std::snprintf(out, cap, "%dh", sec / 3600);
+  else if (sec % 60 == 0) std::snprintf(out, cap, "%dm", sec / 60);
+  else std::snprintf(out, cap, "%ds", sec);
+}
+
+static void bar_file_write(const BarRecord& r) {
+  const Bar& b = r.bar;
+  if (b.start_ms < g_bar_day_lo || b.start_ms >= g_bar_day_hi || !g_bar_file) {
+    if (g_bar_file) { std::fclose(g_bar_file); g_bar_file = nullptr; }
+    time_t sec = (time_t)(b.start_ms / 1000);
+    struct tm tm;
+    localtime_r(&sec, &tm);
+    char day[16];
+    std::strftime(day, sizeof(day), "%Y%m%d", &tm);
+    tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+    g_bar_day_lo = (long long)mktime(&tm) * 1000;
+    g_bar_day_hi = g_bar_day_lo + 86400000LL;
+    g_bar_file = std::fopen((g_bar_dir + "/bars_" + day + ".bin").c_str(), "ab");
+    if (!g_bar_file) return;
+  }
+  std::fwrite(&r, sizeof(r), 1, g_bar_file);
+}
+
+static void bar_emit(const Bar& b) {
+  const char* inst = g_instruments.at(b.inst_id).id;
+  char label[16];
+  bar_label(label, sizeof(label), b.interval_s);
+  if (!g_bar_prefix.empty()) {
+    char maxlen[16], num[11][352];
+    std::snprintf(maxlen, sizeof(maxlen), "%d", g_bar_maxlen);
+    const std::string key = g_bar_prefix + inst + ":" + label;
+    int n[11];
+    n[0] = std::snprintf(num[0], sizeof(num[0]), "%lld", (long long)b.start_ms);
+    n[1] = fmt_fixed10(num[1], b.open);  n[2] = fmt_fixed10(num[2], b.high);
+    n[3] = fmt_fixed10(num[3], b.low);   n[4] = fmt_fixed10(num[4], b.close);
+    n[5] = std::snprintf(num[5], sizeof(num[5]), "%lld", (long long)b.volume);
+    n[6] = fmt_fixed10(num[6], b.turnover); n[7] = fmt_fixed10(num[7], b.vwap);
+    n[8] = fmt_fixed10(num[8], b.open_interest); n[9] = fmt_fixed10(num[9], b.oi_delta);
+    n[10] = std::snprintf(num[10], sizeof(num[10]), "%d", b.ticks);
+    char flags[16];
+    const int nf = std::snprintf(flags, sizeof(flags), "%u", b.flags);
+    static const char* const names[11] = {"ts", "o", "h", "l", "c", "v", "to", "vwap", "oi", "doi", "n"};
+    g_bar_cmd.clear();
+    g_bar_cmd += "*30\r\n";
+    resp_append_bulk(g_bar_cmd, "XADD", 4);
+    resp_append_bulk(g_bar_cmd, key);
+    resp_append_bulk(g_bar_cmd, "MAXLEN", 6);
+    resp_append_bulk(g_bar_cmd, "~", 1);
+    resp_append_bulk(g_bar_cmd, maxlen, std::strlen(maxlen));
+    resp_append_bulk(g_bar_cmd, "*", 1);
+    for (int i = 0; i < 11; ++i) {
+      resp_append_bulk(g_bar_cmd, names[i], std::strlen(names[i]));
+      resp_append_bulk(g_bar_cmd, num[i], (size_t)n[i]);
+    }
+    resp_append_bulk(g_bar_cmd, "flags", 5);
+    resp_append_bulk(g_bar_cmd, flags, (size_t)nf);
+    const size_t len = g_bar_cmd.size();
+    if (!g_redis.writeFormatted(g_bar_cmd.data(), &len, 1)) g_bars_redis_fail.fetch_add(1, std::memory_order_relaxed);
+  }
+  const bar_cb_t cb = g_bar_cb.load(std::memory_order_acquire);
+  if (!g_bar_dir.empty() || cb) {
+    BarRecord r;
+    std::memset(r.inst, 0, sizeof(r.inst));
+    std::memcpy(r.inst, inst, strnlen(inst, sizeof(r.inst) - 1));
+    r.bar = b;
+    if (!g_bar_dir.empty()) bar_file_write(r);
+    if (cb) cb(reinterpret_cast<const ctp_bar_t*>(&r));
+  }
+  if (g_bar_store.enabled()) {
+    if (g_bar_store.append(label, inst, b.start_ms, (float)b.close, b.volume)) g_bar_store_rows.fetch_add(1, std::memory_order_relaxed);
+    else g_bar_store_dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+  g_bars_emitted.fetch_add(1, std::memory_order_relaxed);
+}
+
+// 发布线程空闲时调用：实盘下把过了收盘宽限仍未收盘的 bar 产出（回放时以数据时间为准，不按时钟收盘）
+static void bar_close_if_due() {
+  if (!g_bars.intervals()) return;
+  const long long now = now_ms();
+  if (now < g_bar_next_check_ms) return;
+  g_bar_next_check_ms = now + 100;
+  if (g_bar_file) std::fflush(g_bar_file);
+  if (g_bar_store.enabled() && now >= g_bar_store_next_flush_ms) {
+    g_bar_store.flush_all();
+    g_bar_store_next_flush_ms = now + 1000;
+  }
+  if (g_md_replaying.load(std::memory_order_relaxed)) return;
+  Bar out[64];
+  for (int n; (n = g_bars.close_expired(now, BAR_CLOSE_GRACE_MS, out, 64)) > 0;)
+    for (int i = 0; i < n; ++i) bar_emit(out[i]);
+}
+
+static void bar_close_all() {
+  Bar out[64];
+  for (int n; (n = g_bars.close_all(out, 64)) > 0;)
+    for (int i = 0; i < n; ++i) bar_emit(out[i]);
+  if (g_bar_file) { std::fclose(g_bar_file); g_bar_file = nullptr; g_bar_day_lo = g_bar_day_hi = 0; }
+  g_bar_store.flush_all();
+}
+
+static void md_publish_tick(const MdTick& t) {
+  const MdBookTick& b = t.book;
+  const long long t_pop = mono_ns();
+  g_lat_queue.record(t_pop - t.enq_ns);
+  long long ex_ms = t.exch_ns / 1000000;   // 交易所时间(ms)
+  bool ok = md_write_redis(t, ex_ms);
+  const long long t_redis = mono_ns();
+  g_lat_redis.record(t_redis - t_pop);
+  g_lat_enq_redis.record(t_redis - t.enq_ns);
+  long long redis_ms = ok ? now_ms() : 0;  // 写入成功后的时间(ms)，失败则为0
+  if (g_bars.intervals() && b.id >= 0) {
+    if (!g_bar_mult_known[b.id]) bar_mult_from_master(b.id);  // 启动后才订阅的合约（如期权）首笔时查一次
+    Bar done[BarAggregator::kMaxIntervals];
+    const int n = g_bars.update(b.id, ex_ms > 0 ? ex_ms : t.recv_ms, b.last, b.volume, b.turnover, b.open_interest, done);
+    for (int i = 0; i < n; ++i) bar_emit(done[i]);
+  }
+  if (g_md_batch_cb.load(std::memory_order_relaxed)) {
+    md_batch_add(t, ex_ms, redis_ms);  // 端到端延迟在整批交付后记录
+  } else if (g_md_cb) {
+    g_md_cb(t.inst, b.last, b.bid_px[0], b.ask_px[0], ex_ms, t.recv_ms, redis_ms);
+  }
+  const long long t_done = mono_ns();
+  if (!g_md_batch_cb.load(std::memory_order_relaxed)) g_lat_e2e.record(t_done - t.cb_ns);
+  g_md_last_pub_ns.store(t_done, std::memory_order_relaxed);
+  // 计数放在最后：回放等待以计数判断排空，此时本笔的延迟已记录
+  if (ok) g_md_published.fetch_add(1, std::memory_order_release);
+  else g_md_redis_fail.fetch_add(1, std::memory_order_release);
+}
+
+static std::atomic<bool> g_md_queue_ready{false};
+
+static void md_publish_loop() {
+  int cpu_gen = 0;
+  thread_role_check(TR_MD_PUB, 0, cpu_gen);
+  // 绑核之后再分配并清零队列和批缓冲：按首次写入落在本线程所在的 NUMA 节点
+  { std::lock_guard<std::mutex> lk(g_md_queue_m); g_md_queue = new SpscRing<MdTick>(g_md_queue_capacity); }
+  g_md_queue_ready.store(true, std::memory_order_release);
+  std::vector<MdTick> batch(MD_PUBLISH_BATCH);
+  SpinBackoff backoff(g_busy_poll.load());
+  for (;;) {
+    // 先读运行标志再取数据：停止时保证 ctp_md_stop 之前入队的数据全部发完
+    bool running = g_md_pub_run.load(std::memory_order_acquire);
+    size_t n = g_md_queue->pop_batch(batch.data(), batch.size());
+    if (n == 0) {
+      if (!running) break;
+      g_redis.flushIfDue();  // 行情间隙把 pipeline 中积压超时的命令发出去
+      md_batch_flush_if_due();
+      bar_close_if_due();
+      // 空闲退避：先 pause / 让出 CPU，持续空闲再短暂休眠；忙等模式不休眠，没有唤醒延迟
+      thread_role_check(TR_MD_PUB, 0, cpu_gen);
+      backoff.set_busy(g_busy_poll.load(std::memory_order_relaxed));
+      backoff.idle();
+      continue;
+    }
+    backoff.reset();
+    for (size_t i = 0; i < n; ++i) md_publish_tick(batch[i]);
+    md_batch_flush_if_due();
+  }
+  md_batch_flush();
+  bar_close_all();
+}
+
+static void md_publisher_start() {
+  if (g_md_pub_run.load()) return;
+  thread_cfg_from_env();
+  { std::lock_guard<std::mutex> lk(g_md_queue_m); delete g_md_queue; g_md_queue = nullptr; }
+  g_md_in_overflow = false;
+  g_md_queue_ready.store(false);
+  g_md_pub_run.store(true, std::memory_order_release);
+  g_md_pub_thread = std::thread(md_publish_loop);
+  spin_wait_for([] { return g_md_queue_ready.load(std::memory_order_acquire); }, -1, false);
+}
+
+// 需在 CTP 行情线程停止（Release）之后调用
+static void md_publisher_stop() {
+  if (!g_md_pub_run.load()) return;
+  g_md_pub_run.store(false, std::memory_order_release);
+  if (g_md_pub_thread.joinable()) g_md_pub_thread.join();
+  std::lock_guard<std::mutex> lk(g_md_queue_m);
+  delete g_md_queue; g_md_queue = nullptr;
+}
+
+// ---------------- 行情回放 ----------------
+// 回放线程按记录的 recv_ns 间隔（除以 speed）调用 MdSpiBridge::OnRtnDepthMarketData，之后与实盘走同一条路径
+static TickReplaySource* g_replay_src = nullptr;
+static std::thread g_replay_thread;
+static std::atomic<bool> g_replay_run{false};
+static std::atomic<long long> g_replay_injected{0};
+static std::atomic<long long> g_replay_lag_max_ns{0};  // 注入时刻落后于回放时间轴的最大值
+static std::atomic<bool> g_replay_injected_all{false};
+static long long g_replay_start_ns = 0;
+static long long g_replay_base_done = 0;     // 回放开始时已处理的笔数（published + redis_fail）
+static long long g_replay_base_dropped = 0;  // 回放开始时的队列满丢弃数
+
+static long long md_processed() {
+  return g_md_published.load(std::memory_order_acquire) + g_md_redis_fail.load(std::memory_order_acquire);
+}
+
+static void md_replay_loop(double speed) {
+  const size_t n = g_replay_src->size();
+  const long long first_ns = g_replay_src->at(0).recv_ns;
+  const long long start = g_replay_start_ns;
+  for (size_t i = 0; i < n && g_replay_run.load(std::memory_order_relaxed); ++i) {
+    const JournalRecord& r = g_replay_src->at(i);
+    if (speed > 0) {
+      const long long target = start + (long long)((r.recv_ns - first_ns) / speed);
+      long long now = mono_ns();
+      if (target > now) {
+        // 远处睡眠，最后 100us 自旋，保证时间间隔精度
+        if (target - now > 200000) std::this_thread::sleep_for(std::chrono::nanoseconds(target - now - 100000));
+        while (mono_ns() < target) {}
+      } else if (now - target > g_replay_lag_max_ns.load(std::memory_order_relaxed)) {
+        g_replay_lag_max_ns.store(now - target, std::memory_order_relaxed);
+      }
+    } else {
+      // 最大速度：队列满时等待发布线程而不是丢弃，测的是整条链路的吞吐
+      while (g_md_queue->size() >= g_md_queue->capacity() && g_replay_run.load(std::memory_order_relaxed))
+        std::this_thread::yield();
+    }
+    CThostFtdcDepthMarketDataField md = r.md;
+    g_replay_ref_ns = r.recv_ns;
+    g_md_spi->OnRtnDepthMarketData(&md);
+    g_replay_injected.store((long long)i + 1, std::memory_order_relaxed);
+  }
+  g_replay_injected_all.store(true, std::memory_order_release);
+}
+
+static void md_replay_stop() {
+  g_replay_run.store(false);
+  if (g_replay_thread.joinable()) g_replay_thread.join();
+}
+
 extern "C" {
+int ctp_md_start_replay(const char* path, double speed){
+  if (g_md || g_md_replaying.load()) return -1;  // 已有行情在运行
+  TickReplaySource* src = new TickReplaySource();
+  int rc = src->open(path ? path : "");
+  if (rc != 0) { delete src; return rc == -1 ? -2 : -3; }
+  delete g_replay_src;
+  g_replay_src = src;
+
+  md_stats_reset();  // 回放开始时没有行情线程在写
+  g_book.clear();
+  g_bars.clear();
+  g_replay_injected.store(0); g_replay_lag_max_ns.store(0); g_replay_injected_all.store(false);
+  g_md_replaying.store(true);
+  md_publisher_start();
+  g_md_spi = new MdSpiBridge(nullptr);
+  g_replay_base_done = md_processed();
+  g_replay_base_dropped = g_md_dropped.load();
+  g_replay_start_ns = mono_ns();
+  g_md_last_pub_ns.store(g_replay_start_ns);
+  g_md_ready.store(1);
+  g_md_cv.notify_all();
+  g_replay_run.store(true);
+  g_replay_thread = std::thread(md_replay_loop, speed);
+  logx("<Md Replay Start>");
+  return 0;
+}
+
+void ctp_md_replay_stats(ctp_replay_stats_t* out){
+  if (!out) return;
+  std::memset(out, 0, sizeof(*out));
+  if (!g_replay_src) return;
+  out->total = (long long)g_replay_src->size();
+  out->injected = g_replay_injected.load(std::memory_order_relaxed);
+  out->processed = md_processed() - g_replay_base_done;
+  out->done = (g_replay_injected_all.load(std::memory_order_acquire) &&
+               out->processed >= out->injected - (g_md_dropped.load() - g_replay_base_dropped)) ? 1 : 0;
+  const long long end = out->done ? g_md_last_pub_ns.load(std::memory_order_relaxed) : mono_ns();
+  out->elapsed_s = (end - g_replay_start_ns) / 1e9;
+  out->ticks_per_sec = out->elapsed_s > 0 ? out->processed / out->elapsed_s : 0.0;
+  out->lag_max_us = g_replay_lag_max_ns.load(std::memory_order_relaxed) / 1e3;
+  auto rd = [](const LatencyHistogram& h, double* avg_us, double* max_us) {
+    LatencySummary r = h.summary();
+    *avg_us = r.mean_ns / 1e3;
+    *max_us = r.max_ns / 1e3;
+  };
+  rd(g_lat_cb, &out->cb_avg_us, &out->cb_max_us);
+  rd(g_lat_queue, &out->queue_avg_us, &out->queue_max_us);
+  rd(g_lat_redis, &out->redis_avg_us, &out->redis_max_us);
+  rd(g_lat_e2e, &out->e2e_avg_us, &out->e2e_max_us);
+}
+
+static void fill_latency(const LatencyHistogram& h, ctp_latency_t* o) {
+  LatencySummary r = h.summary();
+  o->count = (long long)r.count;
+  o->mean_ns = r.mean_ns;
+  o->min_ns = r.min_ns; o->p50_ns = r.p50_ns; o->p90_ns = r.p90_ns;
+  o->p99_ns = r.p99_ns; o->p999_ns = r.p999_ns; o->max_ns = r.max_ns;
+}
+
+int ctp_set_md_batch_cb(md_batch_cb_t cb, int max_batch, int max_delay_us){
+  if (max_batch <= 0) max_batch = 256;
+  if (max_batch > 65536) max_batch = 65536;
+  if (max_delay_us < 0) max_delay_us = 0;
+  g_md_batch_max.store(max_batch, std::memory_order_relaxed);
+  g_md_batch_delay_ns.store((long long)max_delay_us * 1000, std::memory_order_relaxed);
+  g_md_batch_cb.store(cb, std::memory_order_release);
+  return 0;
+}
+
+void ctp_stats_snapshot(ctp_stats_t* out){
+  if (!out) return;
+  std::memset(out, 0, sizeof(*out));
+  fill_latency(g_lat_exch_recv, &out->exch_to_recv);
+  fill_latency(g_lat_cb, &out->recv_to_enqueue);
+  fill_latency(g_lat_queue, &out->queue_wait);
+  fill_latency(g_lat_redis, &out->redis_write);
+  fill_latency(g_lat_enq_redis, &out->enqueue_to_redis);
+  fill_latency(g_lat_e2e, &out->recv_to_md_cb);
+  fill_latency(g_lat_order_rtn, &out->order_to_rtn_order);
+  fill_latency(g_lat_order_trade, &out->order_to_rtn_trade);
+  out->exch_recv_negative = g_exch_recv_negative.load(std::memory_order_relaxed);
+}
+
+void ctp_stats_reset(void){
+  md_stats_reset();
+  g_lat_order_rtn.reset();
+  g_lat_order_trade.reset();
+}
+
+int ctp_md_replay_wait(int timeout_ms){
+  const long long deadline = mono_ns() + (long long)timeout_ms * 1000000;
+  ctp_replay_stats_t st;
+  for (;;) {
+    ctp_md_replay_stats(&st);
+    if (st.done) return 1;
+    if (timeout_ms >= 0 && mono_ns() >= deadline) return 0;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+static std::vector<std::string> split_csv(const char* csv){
+  std::vector<std::string> out; if (!csv) return out; std::stringstream ss(csv); std::string s;
+  while (std::getline(ss, s, ',')) if (!s.empty()) out.push_back(s); return out;
+}
 int ctp_md_start(const char* front, const char* broker_id, const char* user_id, const char* password){
   if (g_md) return 0;
   std::strncpy(g_md_broker, broker_id?broker_id:"", sizeof(g_md_broker)-1);
   std::strncpy(g_md_user,   user_id?user_id:"",     sizeof(g_md_user)-1);
   std::strncpy(g_md_pass,   password?password:"",   sizeof(g_md_pass)-1);
 
+  thread_cfg_from_env();   // CTP_CPU_* / CTP_BUSY_POLL
   const char* flow = std::getenv("CTP_FLOW_DIR_MD");
   if (!flow || !*flow) flow = std::getenv("CTP_FLOW_DIR");
   if (!flow || !*flow) flow = "/tmp/ctp_flow_md";
   if (ensure_dir(flow) != 0) { g_md_ready.store(-3); return -3; }
+  std::vector<std::string> fronts = split_csv(front);
+  if (fronts.empty()) fronts.push_back("");
+  if ((int)fronts.size() > MdFrontDedup::kMaxFronts) fronts.resize(MdFrontDedup::kMaxFronts);
+  // 第 2 个起的会话各用一个流文件子目录（同一目录下多个会话的 .con 文件会互相覆盖）
+  std::vector<std::string> flows(fronts.size(), flow);
+  for (size_t i = 1; i < fronts.size(); ++i) {
+    flows[i] = std::string(flow) + "/front" + std::to_string(i);
+    if (ensure_dir(flows[i].c_str()) != 0) { g_md_ready.store(-3); return -3; }
+    flows[i] += "/";
+  }
   g_md_ready.store(0);
 
-  g_md = CThostFtdcMdApi::CreateFtdcMdApi(flow);
-  g_md_spi = new MdSpiBridge(g_md);
-  g_md->RegisterSpi(g_md_spi);
-  g_md_front_str = front ? front : "";
-  g_md->RegisterFront(const_cast<char*>(g_md_front_str.c_str()));
-  g_md->Init();
+  g_book.clear();  // 行情线程尚未启动；新会话各合约首笔的变动位全置
+  g_bars.clear();  // 累计成交量以新会话首笔为基准
+  g_md_dedup.clear();
+  md_publisher_start();
+  g_md_n_fronts = (int)fronts.size();
+  for (int i = 0; i < g_md_n_fronts; ++i) {
+    MdFront& f = g_md_fronts[i];
+    f.addr = fronts[i];
+    f.state.store(0);
+    f.received.store(0); f.won.store(0); f.dup.store(0); f.stale.store(0); f.disconnects.store(0);
+    f.behind.reset(); f.exch_recv.reset();
+    f.api = CThostFtdcMdApi::CreateFtdcMdApi(flows[i].c_str());
+    f.spi = new MdSpiBridge(f.api, i);
+    f.api->RegisterSpi(f.spi);
+    f.api->RegisterFront(const_cast<char*>(f.addr.c_str()));
+  }
+  g_md = g_md_fronts[0].api;
+  g_md_spi = g_md_fronts[0].spi;
+  for (int i = 0; i < g_md_n_fronts; ++i) g_md_fronts[i].api->Init();
   return 0;
 }
 int ctp_md_ready(void){ return g_md_ready.load(); }
 int ctp_md_wait_ready(int timeout_ms){
+  if (g_md_ready.load() == 1) return 1;
+  if (g_busy_poll.load()) {   // 忙等：不经条件变量，状态一变立即返回
+    if (!spin_wait_for([]{ return g_md_ready.load()!=0; }, timeout_ms, true)) return 0;
+    return g_md_ready.load();
+  }
   std::unique_lock<std::mutex> lk(g_md_m);
   if (g_md_ready.load() == 1) return 1;
   if (timeout_ms < 0) g_md_cv.wait(lk, []{ return g_md_ready.load()!=0; });
   else if (!g_md_cv.wait_for(lk, std::chrono::milliseconds(timeout_ms), []{ return g_md_ready.load()!=0; })) return 0;
   return g_md_ready.load();
 }
-static std::vector<std::string> split_csv(const char* csv){
-  std::vector<std::string> out; if (!csv) return out; std::stringstream ss(csv); std::string s;
-  while (std::getline(ss, s, ',')) if (!s.empty()) out.push_back(s); return out;
-}
 int ctp_md_subscribe(const char* instruments_csv){
+  if (g_md_replaying.load()) {  // 回放模式：数据源已确定，只登记合约
+    for (auto& s : split_csv(instruments_csv)) g_instruments.add(s.c_str());
+    return 0;
+  }
   if (!g_md) return -1; if (g_md_ready.load()!=1) return -2;
   auto v = split_csv(instruments_csv); if (v.empty()) return 0;
-  std::vector<char*> ptr; ptr.reserve(v.size()); for (auto& s:v) ptr.push_back(const_cast<char*>(s.c_str()));
-  return g_md->SubscribeMarketData(ptr.data(), (int)v.size());
+  for (auto& s : v) g_instruments.add(s.c_str());
+  { std::lock_guard<std::mutex> lk(g_md_subs_m); g_md_subs.insert(g_md_subs.end(), v.begin(), v.end()); }
+  int rc = 0;
+  for (int i = 0; i < g_md_n_fronts; ++i) {
+    if (g_md_fronts[i].state.load() != 1) continue;  // 未登录的前置登录后按订阅表补订
+    const int r = md_subscribe_on(g_md_fronts[i].api, v);
+    if (r != 0 && rc == 0) rc = r;
+  }
+  return rc;
 }
 void ctp_md_stop(void){
-  if (g_md){ g_md->Release(); g_md=nullptr; }
+  md_replay_stop();
+  for (int i = 0; i < g_md_n_fronts; ++i)
+    if (g_md_fronts[i].api) { g_md_fronts[i].api->Release(); g_md_fronts[i].api = nullptr; }
+  g_md = nullptr;
+  md_publisher_stop();
+  g_journal.close();
+  delete g_replay_src; g_replay_src = nullptr;
+  g_md_replaying.store(false);
+  for (int i = 0; i < g_md_n_fronts; ++i) {
+    if (g_md_fronts[i].spi != g_md_spi) delete g_md_fronts[i].spi;
+    g_md_fronts[i].spi = nullptr;
+  }
+  g_md_n_fronts = 0;
+  { std::lock_guard<std::mutex> lk(g_md_subs_m); g_md_subs.clear(); }
   delete g_md_spi; g_md_spi=nullptr; g_md_ready.store(0);
 }
+int ctp_md_front_stats(int front, ctp_md_front_stats_t* out){
+  if (front < 0 || front >= g_md_n_fronts || !out) return g_md_n_fronts;
+  const MdFront& f = g_md_fronts[front];
+  std::memset(out, 0, sizeof(*out));
+  std::snprintf(out->addr, sizeof(out->addr), "%s", f.addr.c_str());
+  out->state = f.state.load();
+  out->received = f.received.load(std::memory_order_relaxed);
+  out->won = f.won.load(std::memory_order_relaxed);
+  out->dup = f.dup.load(std::memory_order_relaxed);
+  out->stale = f.stale.load(std::memory_order_relaxed);
+  out->disconnects = f.disconnects.load(std::memory_order_relaxed);
+  out->win_rate = out->received ? (double)out->won / out->received : 0.0;
+  fill_latency(f.behind, &out->behind);
+  fill_latency(f.exch_recv, &out->exch_to_recv);
+  return g_md_n_fronts;
+}
+int ctp_md_set_queue_capacity(int capacity){
+  if (g_md) return -1;  // 行情已启动，队列已分配
+  g_md_queue_capacity = capacity > 0 ? (size_t)capacity : MD_QUEUE_DEFAULT_CAPACITY;
+  return 0;
+}
+int ctp_md_set_journal(const char* dir, long long max_records){
+  if (g_md) return -1;  // 行情已启动
+  if (!dir || !*dir) { g_journal_dir.clear(); return 0; }
+  if (ensure_dir(dir) != 0) return -2;
+  g_journal_dir = dir;
+  g_journal_max_records = max_records > 0 ? (uint64_t)max_records : JOURNAL_DEFAULT_RECORDS;
+  return 0;
+}
+int ctp_md_set_snapshot(const char* shm_name){
+  if (g_md || g_md_replaying.load()) return -1;  // 行情已启动
+  if (!shm_name || !*shm_name) { g_snapshot.close(); return 0; }
+  return g_snapshot.open(shm_name, InstrumentTable::kMaxInstruments) ? 0 : -2;
+}
+void ctp_set_bar_cb(bar_cb_t cb){ g_bar_cb.store(cb, std::memory_order_release); }
+int ctp_md_set_bars(const char* intervals_csv, const char* stream_prefix, int stream_maxlen, const char* dir){
+  if (g_md || g_md_replaying.load()) return -1;  // 行情已启动
+  if (dir && *dir && ensure_dir(dir) != 0) return -2;
+  std::vector<int> iv;
+  for (auto& s : split_csv(intervals_csv)) iv.push_back(std::atoi(s.c_str()));
+  g_bars.set_intervals(iv.data(), (int)iv.size());
+  g_bar_prefix = stream_prefix ? stream_prefix : "";
+  g_bar_maxlen = stream_maxlen > 0 ? stream_maxlen : 10000;
+  g_bar_dir = dir ? dir : "";
+  return 0;
+}
+int ctp_md_set_bar_store(const char* dir, int chunk_rows){
+  if (g_md || g_md_replaying.load()) return -1;
+  if (dir && *dir && ensure_dir(dir) != 0) return -2;
+  g_bar_store.set_root(dir ? dir : "", chunk_rows);
+  return 0;
+}
+int ctp_md_set_bar_multiplier(const char* instrument, double multiplier){
+  if (g_md || g_md_replaying.load()) return -1;
+  const int id = instrument ? g_instruments.add(instrument) : -1;
+  if (id < 0) return -2;
+  g_bars.set_multiplier(id, multiplier);
+  g_bar_mult_known[id] = 1;
+  return 0;
+}
+static bool ends_with(const char* s, const char* suffix) {
+  const size_t n = std::strlen(s), k = std::strlen(suffix);
+  return n >= k && std::strcmp(s + n - k, suffix) == 0;
+}
+int ctp_instruments_load(const char* source, const char* cache_dir){
+  if (g_md || g_md_replaying.load()) return -1;  // 行情已启动
+  if (!source || !*source) return -2;
+  if (ends_with(source, ".bin")) {
+    if (!g_master.open(source)) return -2;
+  } else {
+    const char* dir = (cache_dir && *cache_dir) ? cache_dir : ".";
+    if (ensure_dir(dir) != 0) return -3;
+    const int rc = instrument_master_from_dat(source, dir, g_master);
+    if (rc == -1) return -2;
+    if (rc != 0) return -3;
+  }
+  // 期货按主数据顺序预登记：空表时符号表 id 即主数据 id；期权数量远超符号表容量，订阅时再登记
+  for (int i = 0; i < g_master.n_futures(); ++i) {
+    const int id = g_instruments.add(g_master.at(i).inst);
+    if (id < 0) break;
+    if (!g_bar_mult_known[id]) bar_mult_from_master(id);
+  }
+  char buf[160];
+  std::snprintf(buf, sizeof(buf), "[instruments] TradingDay=%d instruments=%d futures=%d",
+                g_master.trading_day(), g_master.size(), g_master.n_futures());
+  logx(buf);
+  return g_master.size();
+}
+int ctp_instrument_info(const char* instrument, ctp_instrument_info_t* out){
+  const int m = g_master.find(instrument);
+  if (m < 0 || !out) return -1;
+  const InstrumentRecord& r = g_master.at(m);
+  std::memset(out, 0, sizeof(*out));
+  std::memcpy(out->inst, r.inst, sizeof(out->inst));
+  std::memcpy(out->exchange, r.exchange, sizeof(out->exchange));
+  std::memcpy(out->product, r.product, sizeof(out->product));
+  out->price_tick = r.price_tick; out->multiplier = r.multiplier; out->strike = r.strike;
+  out->long_margin = r.long_margin; out->short_margin = r.short_margin;
+  out->expire_date = r.expire_date; out->master_id = r.id;
+  out->symbol_id = g_instruments.find(r.inst);
+  out->option_type = r.option_type; out->is_trading = r.is_trading;
+  return 0;
+}
+void ctp_md_bar_stats(long long* emitted, long long* redis_fail){
+  if (emitted)    *emitted    = g_bars_emitted.load(std::memory_order_relaxed);
+  if (redis_fail) *redis_fail = g_bars_redis_fail.load(std::memory_order_relaxed);
+}
+void ctp_md_bar_store_stats(long long* rows, long long* dropped){
+  if (rows)    *rows    = g_bar_store_rows.load(std::memory_order_relaxed);
+  if (dropped) *dropped = g_bar_store_dropped.load(std::memory_order_relaxed);
+}
+void ctp_md_journal_stats(long long* records, long long* dropped){
+  if (records) *records = (long long)g_journal.committed();
+  if (dropped) *dropped = (long long)g_journal.dropped();
+}
+void ctp_md_queue_stats(long long* depth, long long* max_depth, long long* enqueued, long long* dropped,
+                        long long* overflow, long long* published, long long* redis_fail){
+  if (depth) {
+    std::lock_guard<std::mutex> lk(g_md_queue_m);  // 与 md_publisher_stop 的释放互斥
+    *depth = g_md_queue ? (long long)g_md_queue->size() : 0;
+  }
+  if (max_depth)  *max_depth  = g_md_max_depth.load(std::memory_order_relaxed);
+  if (enqueued)   *enqueued   = g_md_enqueued.load(std::memory_order_relaxed);
+  if (dropped)    *dropped    = g_md_dropped.load(std::memory_order_relaxed);
+  if (overflow)   *overflow   = g_md_overflow.load(std::memory_order_relaxed);
+  if (published)  *published  = g_md_published.load(std::memory_order_relaxed);
+  if (redis_fail) *redis_fail = g_md_redis_fail.load(std::memory_order_relaxed);
+}
 } // extern "C"
 
 // ---------------- 交易（TD） ----------------
@@ -238,21 +1179,55 @@ static CThostFtdcTraderApi* g_td = nullptr;
 static std::atomic<int> g_td_ready{0};
 static std::mutex g_td_m; static std::condition_variable g_td_cv;
 static char g_td_broker[32]{0}, g_td_user[32]{0}, g_td_pass[64]{0}, g_td_app[64]{0}, g_td_auth[64]{0};
-static int g_order_ref = 1;
 static std::string g_td_front_str;
 
-struct OrderKey{ std::string strategy, inst, exch, ref; };
-static std::unordered_map<std::string, OrderKey> g_ref_map;
+// 报单引用：原子分配（多个策略线程可并发下单）；g_td_send_turn 保证 ReqOrderInsert 按引用递增的顺序提交
+// （CTP 要求同一会话内 OrderRef 递增）。登录后从 MaxOrderRef+1 开始
+static std::atomic<int> g_order_ref{1};
+static std::atomic<int> g_td_send_turn{1};
+// 报单状态表（order_table.h）：下单时登记，OnRtnOrder / OnRtnTrade 更新，兼作报单时延的下单时刻记录
+static OrderTable g_orders;
+static std::atomic<int> g_td_front_id{0}, g_td_session_id{0};
+
+static void td_refs_reset(int next) {
+  if (next < 1) next = 1;
+  g_order_ref.store(next);
+  g_td_send_turn.store(next);
+}
+// OrderRef 文本：至少 8 位补零（同 "%08d"）
+static void fmt_order_ref(char* out, size_t cap, int ref) {
+  char tmp[12]; int n = 0;
+  unsigned v = (unsigned)ref;
+  do { tmp[n++] = char('0' + v % 10); v /= 10; } while (v);
+  while (n < 8) tmp[n++] = '0';
+  size_t k = 0;
+  while (n && k + 1 < cap) out[k++] = tmp[--n];
+  out[k] = 0;
+}
+static int parse_order_ref(const char* s) {
+  if (!s) return 0;
+  int v = 0;
+  for (; *s == ' '; ++s) {}
+  for (; *s >= '0' && *s <= '9'; ++s) v = v * 10 + (*s - '0');
+  return v;
+}
+// 首次出现 flag 时返回下单时刻，否则 0（仅交易回调线程调用）
+static long long td_timing_first(OrderSlot& o, int flag) {
+  int f = o.flags.load(std::memory_order_relaxed);
+  if (flag == ORDER_F_TRADE && !(f & ORDER_F_RTN)) return 0;
+  if (f & flag) return 0;
+  o.flags.store(f | flag, std::memory_order_release);
+  return o.insert_ns;
+}
 
 // 交易钩子适配：traderSpi.cpp 在各回调尾部调用 td_set_hook，这里将其转给 Python，并更新就绪状态
 static void td_hook_adapter(const char* phase, const char* order_ref, const char* inst, const char* text) {
   // 仅转发消息（中文转 UTF-8）；不在此处修改就绪状态
   const char* ref = order_ref ? order_ref : "";
   const char* ph  = phase ? phase : "";
-  std::string msg = gbk_to_utf8(text ? text : "");
-  if (g_trade_cb) {
-    g_trade_cb(ref, ph, msg.c_str());
-  }
+  if (!g_trade_cb) return;
+  // 纯 ASCII（绝大多数回报）原样转发；反复出现的中文状态 / 错误文本命中缓存
+  g_trade_cb(ref, ph, gbk_to_utf8_tls().convert(text));
 }
 
 extern "C" void ctp_set_trade_cb(trade_cb_t cb){
@@ -260,12 +1235,21 @@ extern "C" void ctp_set_trade_cb(trade_cb_t cb){
   td_set_hook(td_hook_adapter);
 }
 
+// 合约查询（ctp_td_query_instruments）：分页回报逐条记入主数据构建器，最后一页到达后唤醒等待方
+static std::mutex g_td_instr_m;
+static std::condition_variable g_td_instr_cv;
+static InstrumentMasterBuilder g_td_instr_builder;
+static bool g_td_instr_active = false;
+static int g_td_instr_req = 100;  // 与登录流程的请求号错开
+static int g_td_instr_err = 0;
+
 // 覆盖 OnFrontConnected/OnRspAuthenticate，禁止用户系统信息上报，仅发起认证/登录
 class PyTraderSpi : public CTraderSpi {
 public:
   explicit PyTraderSpi(CThostFtdcTraderApi* api) : api_(api) {}
 
   void OnFrontConnected() override {
+    thread_role_check(TR_TD_CB, 0, cpu_gen_);
     logx("<Td OnFrontConnected>");
     if (g_td_app[0] && g_td_auth[0]) {
       CThostFtdcReqAuthenticateField a{};
@@ -308,6 +1292,10 @@ public:
       std::snprintf(buf, sizeof(buf), "TradingDay=%s FrontID=%d SessionID=%d",
                     p->TradingDay, p->FrontID, p->SessionID);
       logx(buf);
+      g_td_front_id.store(p->FrontID);
+      g_td_session_id.store(p->SessionID);
+      const int max_ref = parse_order_ref(p->MaxOrderRef);
+      if (max_ref + 1 > g_order_ref.load()) td_refs_reset(max_ref + 1);
     }
     if (e && e->ErrorID != 0) {
       if (e->ErrorMsg[0]) { std::string m = gbk_to_utf8(e->ErrorMsg); logx(m.c_str()); }
@@ -338,8 +1326,53 @@ public:
     if (g_trade_cb) g_trade_cb("", "Confirm", "OK");
     g_td_cv.notify_all();
   }
+  void OnRtnOrder(CThostFtdcOrderField* o) override {
+    thread_role_check(TR_TD_CB, 0, cpu_gen_);
+    const long long now = mono_ns();
+    // 只认本会话的回报（其他会话的同号 OrderRef 不是我们的单）
+    if (o && o->FrontID == g_td_front_id.load(std::memory_order_relaxed) &&
+        o->SessionID == g_td_session_id.load(std::memory_order_relaxed)) {
+      if (OrderSlot* s = g_orders.find(parse_order_ref(o->OrderRef))) {
+        if (long long t0 = td_timing_first(*s, ORDER_F_RTN)) g_lat_order_rtn.record(now - t0);
+        OrderTable::on_rtn_order(*s, o->OrderStatus, o->OrderSubmitStatus, o->VolumeTraded, o->ExchangeID, o->OrderSysID);
+      }
+    }
+    CTraderSpi::OnRtnOrder(o);
+  }
+  // OnRtnTrade 无会话字段：要求该槽已收到本会话的 OnRtnOrder
+  void OnRtnTrade(CThostFtdcTradeField* t) override {
+    thread_role_check(TR_TD_CB, 0, cpu_gen_);
+    const long long now = mono_ns();
+    if (t) {
+      OrderSlot* s = g_orders.find(parse_order_ref(t->OrderRef));
+      if (s && (s->flags.load(std::memory_order_relaxed) & ORDER_F_RTN)) {
+        if (long long t0 = td_timing_first(*s, ORDER_F_TRADE)) g_lat_order_trade.record(now - t0);
+        OrderTable::on_rtn_trade(*s, t->Volume);
+      }
+    }
+    CTraderSpi::OnRtnTrade(t);
+  }
+  // 不转给基类：基类每条合约打印 40 行日志，全市场上万条
+  void OnRspQryInstrument(CThostFtdcInstrumentField* p, CThostFtdcRspInfoField* e, int id, bool last) override {
+    std::lock_guard<std::mutex> lk(g_td_instr_m);
+    if (!g_td_instr_active || id != g_td_instr_req) return;
+    if (p) g_td_instr_builder.add(*p);
+    if (e && e->ErrorID != 0) g_td_instr_err = e->ErrorID;
+    if (last) { g_td_instr_active = false; g_td_instr_cv.notify_all(); }
+  }
+  void OnRspOrderInsert(CThostFtdcInputOrderField* o, CThostFtdcRspInfoField* e, int id, bool last) override {
+    if (o && e && e->ErrorID != 0)
+      if (OrderSlot* s = g_orders.find(parse_order_ref(o->OrderRef))) OrderTable::advance(*s, ORDER_REJECTED);
+    CTraderSpi::OnRspOrderInsert(o, e, id, last);
+  }
+  void OnErrRtnOrderInsert(CThostFtdcInputOrderField* o, CThostFtdcRspInfoField* e) override {
+    if (o && e && e->ErrorID != 0)
+      if (OrderSlot* s = g_orders.find(parse_order_ref(o->OrderRef))) OrderTable::advance(*s, ORDER_REJECTED);
+    CTraderSpi::OnErrRtnOrderInsert(o, e);
+  }
 private:
   CThostFtdcTraderApi* api_;
+  int cpu_gen_ = 0;   // 仅交易回调线程读写
 };
 
 extern "C" {
@@ -358,11 +1391,14 @@ int ctp_td_start(const char* front, const char* broker_id, const char* user_id,
   log_hex("AppID",    g_td_app);
   log_hex("AuthCode", g_td_auth);
 
+  thread_cfg_from_env();   // CTP_CPU_* / CTP_BUSY_POLL
   const char* flow = std::getenv("CTP_FLOW_DIR_TD");
   if (!flow || !*flow) flow = std::getenv("CTP_FLOW_DIR");
   if (!flow || !*flow) flow = "/tmp/ctp_flow_td";
   if (ensure_dir(flow) != 0) { g_td_ready.store(-3); return -3; }
   g_td_ready.store(0);
+  g_orders.clear();
+  td_refs_reset(1);
 
   g_td = CThostFtdcTraderApi::CreateFtdcTraderApi(flow);
   CTraderSpi* spi = new PyTraderSpi(g_td);
@@ -377,6 +1413,11 @@ int ctp_td_start(const char* front, const char* broker_id, const char* user_id,
 }
 int ctp_td_ready(void){ return g_td_ready.load(); }
 int ctp_td_wait_ready(int timeout_ms){
+  if (g_td_ready.load()==1) return 1;
+  if (g_busy_poll.load()) {
+    if (!spin_wait_for([]{ return g_td_ready.load()!=0; }, timeout_ms, true)) return 0;
+    return g_td_ready.load();
+  }
   std::unique_lock<std::mutex> lk(g_td_m);
   if (g_td_ready.load()==1) return 1;
   if (timeout_ms<0) g_td_cv.wait(lk, []{ return g_td_ready.load()!=0; });
@@ -384,13 +1425,13 @@ int ctp_td_wait_ready(int timeout_ms){
   return g_td_ready.load();
 }
 
-int ctp_td_place(const char* strategy, const char* instrument, char side, char offset, int volume,
-  char pricetype, double price){
+int ctp_td_place_ex(const char* strategy, const char* instrument, char side, char offset, int volume,
+  char pricetype, double price, int* order_ref_out){
+if (order_ref_out) *order_ref_out = 0;
 if (!g_td) return -1; if (g_td_ready.load()!=1) return -2;
 CThostFtdcInputOrderField o{}; std::strncpy(o.BrokerID,g_td_broker,sizeof(o.BrokerID)-1);
 std::strncpy(o.InvestorID,g_td_user,sizeof(o.InvestorID)-1);
 std::strncpy(o.InstrumentID,instrument?instrument:"",sizeof(o.InstrumentID)-1);
-std::snprintf(o.OrderRef, sizeof(o.OrderRef), "%08d", g_order_ref++);
 o.Direction = (side=='B'||side=='b')? THOST_FTDC_D_Buy : THOST_FTDC_D_Sell;
 o.CombOffsetFlag[0] = (offset=='O'||offset=='o')? THOST_FTDC_OF_Open : THOST_FTDC_OF_Close;
 o.CombHedgeFlag[0]  = THOST_FTDC_HF_Speculation;
@@ -413,15 +1454,35 @@ o.MinVolume = 1;
 o.ForceCloseReason = THOST_FTDC_FCC_NotForceClose;
 o.IsAutoSuspend = 0;
 
+// 字段校验都在分配引用之前：分配后必须提交，否则后面的引用会一直等轮次
+const int ref = g_order_ref.fetch_add(1, std::memory_order_relaxed);
+fmt_order_ref(o.OrderRef, sizeof(o.OrderRef), ref);
+g_orders.insert(ref, strategy, o.InstrumentID, o.Direction, o.CombOffsetFlag[0], o.VolumeTotalOriginal, o.LimitPrice, mono_ns());
+// 重新登录可能把轮次推到前面，此时不再等待；先 pause 自旋，前一单的线程被调度走时让出 CPU（不休眠）
+for (SpinBackoff bo(false, 0); g_td_send_turn.load(std::memory_order_acquire) < ref;) bo.idle();
 int rc = g_td->ReqOrderInsert(&o, 11);
-if (g_trade_cb){
-char msg[256]; std::snprintf(msg,sizeof(msg),"ReqOrderInsert rc=%d ref=%s inst=%s", rc, o.OrderRef, o.InstrumentID);
-g_trade_cb(strategy?strategy:"", "PlaceReq", msg);
-}
-g_ref_map[o.OrderRef] = OrderKey{ strategy?strategy:"", instrument?instrument:"", "", o.OrderRef };
+int turn = ref;
+g_td_send_turn.compare_exchange_strong(turn, ref + 1, std::memory_order_acq_rel);
+if (rc != 0) if (OrderSlot* s = g_orders.find(ref)) s->state.store(ORDER_REJECTED, std::memory_order_release);
+if (order_ref_out) *order_ref_out = ref;
+// 下单线程只入队异步日志（格式化在后台线程），不再回调 Python：rc / ref 已经通过返回值和 order_ref_out 交给调用方
+LOG_INFO("<PlaceReq> ReqOrderInsert rc=%d ref=%d inst=%s\n", rc, ref, o.InstrumentID);
 return rc;
 }
 
+int ctp_td_place(const char* strategy, const char* instrument, char side, char offset, int volume,
+  char pricetype, double price){
+  return ctp_td_place_ex(strategy, instrument, side, offset, volume, pricetype, price, nullptr);
+}
+
+int ctp_td_order_info(int order_ref, ctp_order_info_t* out){
+  OrderInfo i;
+  if (!out || !g_orders.read(order_ref, &i)) return -1;
+  static_assert(sizeof(ctp_order_info_t) == sizeof(OrderInfo), "ctp_order_info_t mirrors OrderInfo");
+  std::memcpy(out, &i, sizeof(i));
+  return 0;
+}
+
 int ctp_td_cancel(const char* strategy, const char* instrument, const char* exchange, const char* order_ref){
   if (!g_td) return -1; if (g_td_ready.load()!=1) return -2;
   CThostFtdcInputOrderActionField a{};
@@ -431,6 +1492,13 @@ int ctp_td_cancel(const char* strategy, const char* instrument, const char* exch
   if (instrument) std::strncpy(a.InstrumentID,instrument,sizeof(a.InstrumentID)-1);
   if (exchange)   std::strncpy(a.ExchangeID,exchange,sizeof(a.ExchangeID)-1);
   if (order_ref)  std::strncpy(a.OrderRef,order_ref,sizeof(a.OrderRef)-1);
+  // 按 OrderRef 撤单需带本会话的 FrontID/SessionID；未给交易所/合约时取报单表中的记录
+  a.FrontID = g_td_front_id.load(); a.SessionID = g_td_session_id.load();
+  OrderInfo oi;
+  if (g_orders.read(parse_order_ref(order_ref), &oi)) {
+    if (!a.ExchangeID[0])   std::strncpy(a.ExchangeID, oi.exch, sizeof(a.ExchangeID)-1);
+    if (!a.InstrumentID[0]) std::strncpy(a.InstrumentID, oi.inst, sizeof(a.InstrumentID)-1);
+  }
   int rc = g_td->ReqOrderAction(&a, 12);
   if (g_trade_cb){
     char msg[256]; std::snprintf(msg,sizeof(msg),"ReqOrderAction rc=%d ref=%s inst=%s", rc, a.OrderRef, a.InstrumentID);
@@ -439,8 +1507,43 @@ int ctp_td_cancel(const char* strategy, const char* instrument, const char* exch
   return rc;
 }
 
+int ctp_td_query_instruments(const char* cache_dir, int timeout_ms, char* path_out, int path_cap){
+  if (path_out && path_cap > 0) path_out[0] = 0;
+  if (!g_td) return -1; if (g_td_ready.load()!=1) return -1;
+  const char* dir = (cache_dir && *cache_dir) ? cache_dir : ".";
+  if (ensure_dir(dir) != 0) return -4;
+  int req;
+  {
+    std::lock_guard<std::mutex> lk(g_td_instr_m);
+    if (g_td_instr_active) return -2;  // 上一次查询还没结束
+    g_td_instr_builder.clear();
+    g_td_instr_err = 0;
+    req = ++g_td_instr_req;
+    g_td_instr_active = true;
+  }
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms > 0 ? timeout_ms : 60000);
+  CThostFtdcQryInstrumentField q{};  // 全部交易所、全部合约
+  int r;
+  // -2 / -3：未处理请求过多 / 每秒请求数超限（流控），稍后重试
+  while ((r = g_td->ReqQryInstrument(&q, req)) == -2 || r == -3) {
+    if (std::chrono::steady_clock::now() >= deadline) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  }
+  std::unique_lock<std::mutex> lk(g_td_instr_m);
+  if (r != 0) { g_td_instr_active = false; return -2; }
+  if (!g_td_instr_cv.wait_until(lk, deadline, []{ return !g_td_instr_active; })) { g_td_instr_active = false; return -3; }
+  if (g_td_instr_err != 0 && g_td_instr_builder.size() == 0) return -2;
+  const char* day = g_td->GetTradingDay();
+  const int32_t trading_day = day ? std::atoi(day) : 0;
+  const std::string path = instrument_master_path(dir, trading_day);
+  if (!g_td_instr_builder.write(path, trading_day, INSTR_SRC_QRY)) return -4;
+  if (path_out && path_cap > 0) std::snprintf(path_out, (size_t)path_cap, "%s", path.c_str());
+  return (int)g_td_instr_builder.size();
+}
 void ctp_td_stop(void){
+  { std::lock_guard<std::mutex> lk(g_td_instr_m); g_td_instr_active = false; }
+  g_td_instr_cv.notify_all();
   if (g_td){ g_td->Release(); g_td=nullptr; }
-  g_td_ready.store(0); g_ref_map.clear();
+  g_td_ready.store(0); g_orders.clear();
 }
 } // extern "C"
\ No newline at end of file
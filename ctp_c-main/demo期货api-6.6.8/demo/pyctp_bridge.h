@@ -2,6 +2,7 @@
 #pragma once
 #include "ThostFtdcMdApi.h"
 #include "ThostFtdcTraderApi.h"
+#include "tick_codec.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -9,7 +10,24 @@ extern "C" {
 #ifdef __cplusplus
 extern "C" {
 #endif
+// window_cmds: 累计命令数达到即 flush
 int  ctp_redis_set_pipeline(int enabled, int window_cmds);
+// 同上；max_delay_us>0 时最早一条命令积压超过该时长也会 flush（发布线程空闲时兜底检查）
+int  ctp_redis_set_pipeline_ex(int enabled, int window_cmds, int max_delay_us);
+// 异步写入：命令交给独立 IO 线程发送，行情发布线程不等待回复；需先 ctp_redis_init*
+int  ctp_redis_set_async(int enabled);
+void ctp_redis_async_stats(long long* sent, long long* ok, long long* failed, long long* in_flight);
+// 批量读 hash 前缀下 n 个合约的最近行情（文本字段），一次往返；数组长度 n、可为 NULL，缺失的合约 ts_ms 为 0
+// 返回读到的合约数，未连接返回 -1
+int  ctp_redis_read_last_ticks(const char* const* insts, int n,
+                               double* last, double* bid1, double* ask1, long long* ts_ms);
+// Redis key 前缀与取值格式：fmt 0=文本(JSON / HSET 文本字段)，1=二进制 BinTickV2（tick_codec.h，前 112 字节即 BinTickV1）；<0 保持不变
+void ctp_redis_set_prefixes(const char* str_prefix, const char* hash_prefix);
+void ctp_redis_set_prefixes_ex(const char* str_prefix, const char* hash_prefix, int str_fmt, int hash_fmt);
+// 解码二进制行情（GET 的值或 HGET bin 字段）：0 成功，-1 长度不足，-2 格式不识别
+int  ctp_decode_tick(const void* buf, int len, BinTickV1* out);
+// 同上，带 2..5 档与变动位；-3 表示是 V1 编码（只填了 out->v1）
+int  ctp_decode_tick_v2(const void* buf, int len, BinTickV2* out);
 #ifdef __cplusplus
 }
 #endif
@@ -19,11 +37,48 @@ typedef void (*md_cb_t)(const char* inst, double last, double bid1, double ask1,
                         long long exch_ts_ms, long long recv_cpp_ms, long long redis_ok_ms);
 typedef void (*trade_cb_t)(const char* strategy, const char* phase, const char* text);
 
+// 批量行情：发布线程攒批后一次交付 n 笔定长记录（128 字节，字段顺序即 numpy dtype，见 test_bridge.py）
+// ticks 仅在回调期间有效，需保留时在回调内拷贝
+typedef struct {
+  char      inst[32];
+  double    last, bid1, ask1;
+  double    turnover, open_interest;
+  long long volume;
+  int       bid_vol1, ask_vol1;
+  long long exch_ts_ms, recv_cpp_ms, redis_ok_ms;  // 同 md_cb
+  long long seq;                                   // 发布线程递增序号（从 1 开始），用于核对连续性
+  int       inst_id;                               // 合约符号表下标，表满时为 -1
+  unsigned  changed;                               // 与该合约上一笔相比变动的字段位（md_book.h 的 MD_BOOK_*）
+} ctp_md_tick_t;
+typedef void (*md_batch_cb_t)(const ctp_md_tick_t* ticks, int n);
+
+// 收盘 bar（128 字节，与 bar_agg.h 的 BarRecord / bars_*.bin 记录同布局）；bar 仅在回调期间有效
+typedef struct {
+  char      inst[32];
+  long long start_ms;          // 区间起点（交易所时间，epoch ms）
+  int       inst_id, interval_s;
+  double    open, high, low, close, vwap;
+  double    turnover, open_interest, oi_delta;
+  long long volume;
+  int       ticks;
+  unsigned  flags;             // BAR_F_*
+} ctp_bar_t;
+typedef void (*bar_cb_t)(const ctp_bar_t* bar);
+
 // 回调注册
 void ctp_set_log_cb(log_cb_t cb);
 void ctp_set_md_cb(md_cb_t cb);
+// 设置后不再逐笔调用 md_cb；攒满 max_batch（<=0 取 256）或首笔等待超过 max_delay_us 即交付；cb 为 NULL 恢复逐笔
+int  ctp_set_md_batch_cb(md_batch_cb_t cb, int max_batch, int max_delay_us);
 void ctp_set_trade_cb(trade_cb_t cb);
 
+// 日志：LOG / 桥接层日志都经异步日志（async_log.h）由后台线程写出
+// 按大小滚动写 path：超过 max_bytes（<=0 不滚动）依次改名为 path.1..path.{max_files}；path 为 NULL/空恢复写 logfile
+int  ctp_set_log_rotate(const char* path, long long max_bytes, int max_files);
+void ctp_set_log_drop(int drop);       // 1 缓冲满时丢弃并计数（默认），0 等待
+int  ctp_log_flush(int timeout_ms);    // 等到之前的日志全部写出；超时或后台未运行返回 -1
+void ctp_log_stats(long long* written, long long* dropped);
+
 // Redis（可选）: host, port, password 可为空, db<0 跳过 SELECT, stream_key 如 "md:ticks"
 int  ctp_redis_init(const char* host, int port, const char* password, int db, const char* stream_key);
 int  ctp_redis_init_acl(const char* host, int port,
@@ -32,12 +87,126 @@ int  ctp_redis_init_acl(const char* host, int port,
 void ctp_redis_close(void);
 
 // 行情: 启动/等待/订阅/停止
+// front 可为逗号分隔的多个前置（最多 8 个）：同时登录，行情按合约 (UpdateTime, UpdateMillisec, Volume) 去重、先到先发布；
+// 任一前置登录即就绪（全部断开为 -1），断线重连的前置自动重新订阅；各前置统计见 ctp_md_front_stats
 int  ctp_md_start(const char* front, const char* broker_id, const char* user_id, const char* password);
 int  ctp_md_ready(void);
 int  ctp_md_wait_ready(int timeout_ms);
-int  ctp_md_subscribe(const char* instruments_csv); // 用逗号分隔
+int  ctp_md_subscribe(const char* instruments_csv); // 用逗号分隔；发往所有已登录的前置
 void ctp_md_stop(void);
 
+// 行情发布队列: 回调线程入队，独立发布线程写 Redis 并调用 md_cb（md_cb 在发布线程中执行）
+int  ctp_md_set_queue_capacity(int capacity); // 需在 ctp_md_start 之前调用；<=0 恢复默认 16384，取整到 2 的幂
+// 队列统计（指针可为 NULL）: 当前深度/历史最大深度/入队数/队列满丢弃数/溢出次数(进入满状态的次数)/写入成功数/写入失败数
+void ctp_md_queue_stats(long long* depth, long long* max_depth, long long* enqueued, long long* dropped,
+                        long long* overflow, long long* published, long long* redis_fail);
+// 原始行情日志：每个交易日一个 mmap 文件 {dir}/md_{TradingDay}.jrnl（tick_journal.h），需在 ctp_md_start 前调用
+// dir 为空关闭；max_records<=0 用默认容量（仅新建文件时生效，写满后丢弃并计数）
+int  ctp_md_set_journal(const char* dir, long long max_records);
+void ctp_md_journal_stats(long long* records, long long* dropped);
+// 最新 tick 共享内存表（md_snapshot.h）：回调线程按合约符号表下标逐笔更新 L5 快照，其他进程用 ctp_snap_* 无锁读取
+// 需在 ctp_md_start / ctp_md_start_replay 前调用；shm_name 如 "/ctp_md_snapshot"，为空关闭；0 成功，-1 行情已启动，-2 创建失败
+int  ctp_md_set_snapshot(const char* shm_name);
+// K 线聚合（bar_agg.h）：发布线程逐笔更新各合约 OHLCV / VWAP / 持仓变化，收盘的 bar：
+//   - stream_prefix 非空时 XADD {stream_prefix}{inst}:{周期} MAXLEN ~ stream_maxlen（<=0 取 10000），
+//     字段 ts o h l c v to vwap oi doi n flags；周期写作 1s / 1m / 1h 形式
+//   - dir 非空时追加到 {dir}/bars_{YYYYMMDD}.bin（本地日期，定长 128 字节 BarRecord）
+// intervals_csv 为周期秒数（如 "1,60"，最多 4 个），为空关闭；实盘时区间结束 1.5s 后仍无新 tick 也按时钟收盘
+// 需在 ctp_md_start / ctp_md_start_replay 前调用；0 成功，-1 行情已启动，-2 目录不可用
+int  ctp_md_set_bars(const char* intervals_csv, const char* stream_prefix, int stream_maxlen, const char* dir);
+// 列式 K 线库（column_store.h）：收盘的 bar 追加到 {dir}/{周期}/{合约}/timestamp.npy / price.npy（收盘价）/ volume.npy，
+// 另有 chunks.npy 记录每 chunk_rows 行（<=0 取 4096）的时间 / 价格范围；发布线程每秒刷新一次，回测引擎和 Python 直接 mmap 读取
+// 周期目录与 stream 周期写法相同（1s / 1m / 1h）；同一序列时间戳倒退的 bar 丢弃并计数
+// 需在行情启动前调用；dir 为空关闭；0 成功，-1 行情已启动，-2 目录不可用
+int  ctp_md_set_bar_store(const char* dir, int chunk_rows);
+void ctp_md_bar_store_stats(long long* rows, long long* dropped);
+// 合约乘数（VWAP = 成交额差 / (成交量差 × 乘数)；未设置时按逐笔价格 × 成交量加权），同样需在行情启动前调用
+int  ctp_md_set_bar_multiplier(const char* instrument, double multiplier);
+void ctp_md_bar_stats(long long* emitted, long long* redis_fail);
+// 收盘 bar 回调：发布线程每收盘一根 bar（与 stream / 落盘 / 列式库同一时刻）调用一次，可随时设置，NULL 关闭；
+// 回调在发布线程上执行，需尽快返回（如直接推进 MultiWeightState，见 backtest 的 bar_feed.hpp）
+void ctp_set_bar_cb(bar_cb_t cb);
+
+// 合约主数据（instrument_master.h）：每个交易日一个 mmap 二进制文件，启动时不再解析 JSON / 分页查询
+// source 为 live_futuresinstruments.dat 时按其首行日期在 cache_dir 下建立 / 复用 instruments_{YYYYMMDD}.bin（dat 变化自动重建），
+// 为 *.bin 时直接打开（如 ctp_td_query_instruments 写出的文件）
+// 加载后按主数据顺序预登记全部期货（符号表为空时 id 与主数据 id 一致），并设置 K 线的合约乘数；之后订阅的期权首笔时查主数据
+// 需在 ctp_md_start / ctp_md_start_replay 前调用；返回合约数，-1 行情已启动，-2 源文件不可读或格式错误，-3 缓存写入失败
+int  ctp_instruments_load(const char* source, const char* cache_dir);
+typedef struct {
+  char   inst[32], exchange[12], product[12];
+  double price_tick, multiplier, strike, long_margin, short_margin;
+  int    expire_date;            // YYYYMMDD，未知为 0
+  int    master_id, symbol_id;   // 主数据 id / 符号表 id（未登记为 -1）
+  char   option_type;            // 0 期货 / '1' 看涨 / '2' 看跌
+  int    is_trading;
+} ctp_instrument_info_t;
+// 0 成功；-1 未加载主数据或没有该合约
+int  ctp_instrument_info(const char* instrument, ctp_instrument_info_t* out);
+
+// 行情回放：读取 tick 日志（*.jrnl）或 data_recorder.py CSV（文件或当日目录），从 OnRtnDepthMarketData 起走与实盘相同的路径
+// speed: 1 按原始间隔，N 为 N 倍速，<=0 不等待（最大速度）；返回 0 成功，-1 已有行情在运行，-2 打不开，-3 无记录
+// 回放时不写行情日志；ctp_md_subscribe 只登记合约；ctp_md_stop 结束回放
+typedef struct {
+  long long total;                      // 数据源记录数
+  long long injected;                   // 已注入回调的笔数
+  long long processed;                  // 发布线程已处理的笔数（含 Redis 写失败）
+  int       done;                       // 1: 全部注入且已处理完
+  double    elapsed_s;                  // 开始 → 最后一笔处理完（未完成时为到当前）
+  double    ticks_per_sec;              // processed / elapsed_s
+  double    lag_max_us;                 // 注入落后于回放时间轴的最大值（speed>0 时有意义）
+  double    cb_avg_us, cb_max_us;       // 回调：日志 + 入队
+  double    queue_avg_us, queue_max_us; // 入队 → 发布线程取出
+  double    redis_avg_us, redis_max_us; // Redis 写入
+  double    e2e_avg_us, e2e_max_us;     // 回调入口 → md_cb 返回
+} ctp_replay_stats_t;
+int  ctp_md_start_replay(const char* path, double speed);
+int  ctp_md_replay_wait(int timeout_ms);  // 1 完成，0 超时；timeout_ms<0 一直等
+void ctp_md_replay_stats(ctp_replay_stats_t* out);
+
+// 分段延迟统计：桥内按段累计直方图（相对误差约 3%），单位 ns；供监控定期拉取，不依赖逐笔 md_cb
+typedef struct {
+  long long count;
+  double    mean_ns;
+  long long min_ns, p50_ns, p90_ns, p99_ns, p999_ns, max_ns;
+} ctp_latency_t;
+typedef struct {
+  ctp_latency_t exch_to_recv;       // 交易所时间 → 收到（系统时钟；交易所时间只到 ms，本机须对时）
+  ctp_latency_t recv_to_enqueue;    // 回调入口 → 入队完成
+  ctp_latency_t queue_wait;         // 入队 → 发布线程取出
+  ctp_latency_t redis_write;        // Redis 写入调用
+  ctp_latency_t enqueue_to_redis;   // 入队 → Redis 写入返回（同步模式即应答；pipeline/异步模式为交给客户端）
+  ctp_latency_t recv_to_md_cb;      // 回调入口 → md_cb 返回
+  ctp_latency_t order_to_rtn_order; // ReqOrderInsert → 首个 OnRtnOrder
+  ctp_latency_t order_to_rtn_trade; // ReqOrderInsert → 首个 OnRtnTrade
+  long long exch_recv_negative;     // 收到时间早于交易所时间的笔数（计为 0 延迟）
+} ctp_stats_t;
+void ctp_stats_snapshot(ctp_stats_t* out);
+void ctp_stats_reset(void);  // 清零；在行情/交易空闲时调用
+
+// 单个行情前置（多前置合并时）：won 为先到而被发布的笔数，dup 为晚到的重复，stale 为比已发布行情还旧的
+typedef struct {
+  char          addr[64];
+  int           state;          // 0 连接中 / 1 已登录 / -1 断开或登录失败
+  long long     received, won, dup, stale, disconnects;
+  double        win_rate;       // won / received
+  ctp_latency_t behind;         // 重复笔比首个到达晚多久
+  ctp_latency_t exch_to_recv;   // 交易所时间 → 本前置收到
+} ctp_md_front_stats_t;
+// 返回前置数；front 越界时只返回前置数
+int  ctp_md_front_stats(int front, ctp_md_front_stats_t* out);
+
+// 线程绑核 / 忙等（thread_tuning.h）
+// role: "md_pub" 发布线程 / "md_cb" 行情回调线程（多前置时按前置序号轮流取列表中的 CPU）/ "td_cb" 交易回调线程 / "log" 日志后台线程
+// cpus 同 taskset -c（"3"、"2,5"、"4-7"），空串解除绑定；也可用环境变量 CTP_CPU_MD_PUB / CTP_CPU_MD_CB / CTP_CPU_TD_CB / CTP_CPU_LOG
+// 随时可调：回调线程在下一次回调时、发布 / 日志线程在下一轮空闲时生效；未配置的角色不改原有亲和性
+// 发布队列在绑核后由发布线程分配并清零，页面落在该 CPU 的 NUMA 节点；0 成功，-1 未知角色，-2 CPU 列表格式错误
+int  ctp_set_thread_cpus(const char* role, const char* cpus);
+int  ctp_thread_cpu(const char* role);          // 该角色线程绑定后所在的 CPU；未绑定 / 未知角色为 -1
+int  ctp_pin_current_thread(const char* cpus);  // 调用线程绑核（如 Python 策略 / 下单线程）；0 成功，-2 格式错误，其他为 errno
+// 忙等：发布线程空闲时只 pause 自旋不休眠，ctp_md_wait_ready / ctp_td_wait_ready 自旋等待；独占 CPU 时用。也可用 CTP_BUSY_POLL=1
+int  ctp_set_busy_poll(int on);
+
 // 交易: 启动(可选认证)/下单/撤单/停止
 int  ctp_td_start(const char* front, const char* broker_id, const char* user_id, const char* password,
                   const char* app_id, const char* auth_code); // app/auth 可为NULL跳过认证
@@ -48,10 +217,28 @@ int  ctp_td_wait_ready(int timeout_ms);
 // 返回 0 成功（仅代表请求已发出），回报通过 trade_cb 返回
 int  ctp_td_place(const char* strategy, const char* instrument, char side, char offset, int volume,
                   char pricetype, double price);
+// 同上，order_ref_out 返回本单的 OrderRef（数值）；可多线程并发调用
+int  ctp_td_place_ex(const char* strategy, const char* instrument, char side, char offset, int volume,
+                     char pricetype, double price, int* order_ref_out);
 
-// 撤单: 仅演示按 OrderRef 撤（要求策略先下过单）；instrument/ exchange 留空时尽力匹配
+// 报单状态（order_table.h）：state 0 无 / 1 已发出 / 2 已接受 / 3 部分成交 / 4 全部成交 / 5 已撤单 / 6 拒单
+typedef struct {
+  int       ref, state, volume, traded;
+  char      direction, offset;
+  double    price;
+  long long insert_ns;
+  char      strategy[32], inst[32], exch[12], order_sys_id[24];
+} ctp_order_info_t;
+// 0 成功；-1 未知的 OrderRef（未登记或槽位已被新报单复用）
+int  ctp_td_order_info(int order_ref, ctp_order_info_t* out);
+
+// 撤单: 按 OrderRef 撤（要求本会话下过的单）；instrument / exchange 留空时取报单表中的记录
 int  ctp_td_cancel(const char* strategy, const char* instrument, const char* exchange, const char* order_ref);
 
+// 查询全部合约并写出 {cache_dir}/instruments_{TradingDay}.bin，供之后的启动用 ctp_instruments_load 直接打开
+// 需交易已就绪；timeout_ms<=0 取 60s；path_out 可为 NULL；返回合约数，-1 交易未就绪，-2 请求失败，-3 超时，-4 写文件失败
+int  ctp_td_query_instruments(const char* cache_dir, int timeout_ms, char* path_out, int path_cap);
+
 void ctp_td_stop(void);
 
 #ifdef __cplusplus
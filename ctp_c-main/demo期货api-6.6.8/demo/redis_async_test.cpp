@@ -0,0 +1,166 @@
+// RedisClient 异步模式测试：进程内假 Redis（只回 +PONG / +OK），模拟服务端断开异步连接后重新开启，
+// 以及反复开关；检查重新开启后写入成功、线程可回收、文件描述符不泄漏
+#include "redis_client.h"
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 假服务端：每个连接一个线程，逐条解析 RESP 数组命令并回复；drop_after_first 断开第一个（同步）之后的连接
+class FakeRedis {
+public:
+  bool start() {
+    lfd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in a{}; a.sin_family = AF_INET; a.sin_addr.s_addr = htonl(INADDR_LOOPBACK); a.sin_port = 0;
+    if (lfd_ < 0 || ::bind(lfd_, (sockaddr*)&a, sizeof(a)) != 0 || ::listen(lfd_, 16) != 0) return false;
+    socklen_t len = sizeof(a);
+    ::getsockname(lfd_, (sockaddr*)&a, &len);
+    port_ = ntohs(a.sin_port);
+    accept_thread_ = std::thread([this] {
+      for (;;) {
+        const int fd = ::accept(lfd_, nullptr, nullptr);
+        if (fd < 0) return;
+        std::lock_guard<std::mutex> lk(mu_);
+        conns_.push_back(fd);
+        threads_.emplace_back([this, fd, i = conns_.size() - 1] {
+          serve(fd);
+          std::lock_guard<std::mutex> lk2(mu_);  // 连接结束即关闭，fd 计数只反映客户端
+          conns_[i] = -1;
+          ::close(fd);
+        });
+      }
+    });
+    return true;
+  }
+  void stop() {
+    ::shutdown(lfd_, SHUT_RDWR);
+    accept_thread_.join();
+    ::close(lfd_);
+    std::vector<std::thread> threads;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      for (int fd : conns_) if (fd >= 0) ::shutdown(fd, SHUT_RDWR);
+      threads.swap(threads_);
+    }
+    for (auto& t : threads) t.join();
+  }
+  void drop_after_first() {
+    std::lock_guard<std::mutex> lk(mu_);
+    for (size_t i = 1; i < conns_.size(); ++i) if (conns_[i] >= 0) ::shutdown(conns_[i], SHUT_RDWR);
+  }
+  int port() const { return port_; }
+
+private:
+  void serve(int fd) {
+    std::string in, out;
+    char tmp[4096];
+    for (;;) {
+      const ssize_t n = ::recv(fd, tmp, sizeof(tmp), 0);
+      if (n <= 0) return;
+      in.append(tmp, (size_t)n);
+      size_t used;
+      out.clear();
+      while ((used = parse(in, out)) > 0) in.erase(0, used);
+      if (!out.empty() && ::send(fd, out.data(), out.size(), MSG_NOSIGNAL) < 0) return;
+    }
+  }
+  // 解析一条完整命令并把回复追加到 out，返回消耗的字节数；不完整返回 0
+  static size_t parse(const std::string& b, std::string& out) {
+    if (b.empty() || b[0] != '*') return 0;
+    size_t p = b.find("\r\n");
+    if (p == std::string::npos) return 0;
+    const int argc = std::atoi(b.c_str() + 1);
+    p += 2;
+    std::string first;
+    for (int i = 0; i < argc; ++i) {
+      const size_t e = b.find("\r\n", p);
+      if (e == std::string::npos || b[p] != '$') return 0;
+      const size_t len = (size_t)std::atol(b.c_str() + p + 1);
+      if (b.size() < e + 2 + len + 2) return 0;
+      if (i == 0) first = b.substr(e + 2, len);
+      p = e + 2 + len + 2;
+    }
+    out += first == "PING" ? "+PONG\r\n" : "+OK\r\n";
+    return p;
+  }
+
+  int lfd_ = -1, port_ = 0;
+  std::thread accept_thread_;
+  std::mutex mu_;
+  std::vector<int> conns_;
+  std::vector<std::thread> threads_;
+};
+
+static int count_fds() {
+  int n = 0;
+  if (DIR* d = ::opendir("/proc/self/fd")) { while (::readdir(d)) ++n; ::closedir(d); }
+  return n;
+}
+
+// 等到 pred 成立，最多 timeout_ms
+template <typename F>
+static bool wait_for(F pred, int timeout_ms = 2000) {
+  for (int i = 0; i < timeout_ms; ++i) {
+    if (pred()) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return pred();
+}
+
+int main() {
+  int rc = 0;
+  FakeRedis server;
+  if (!server.start()) { std::printf("listen failed\n"); return 1; }
+
+  RedisClient client;
+  if (!client.connect("127.0.0.1", server.port(), "", "", -1)) { std::printf("connect failed\n"); return 1; }
+  long long sent = 0, ok = 0, failed = 0, in_flight = 0;
+  auto acked = [&](long long want) {
+    return wait_for([&] { client.asyncStats(&sent, &ok, &failed, &in_flight); return ok >= want && in_flight == 0; });
+  };
+
+  // 1) 开启异步，写入得到回复
+  if (!client.setAsync(true) || !client.asyncEnabled()) { std::printf("setAsync\n"); rc = 1; }
+  for (int i = 0; i < 10; ++i) client.writeTickHash("t:", "IF2512", 1, 1, 1, i);
+  if (!acked(10)) { std::printf("async ok=%lld\n", ok); rc = 1; }
+
+  // 2) 服务端断开异步连接：自动退回同步写入
+  server.drop_after_first();
+  if (!wait_for([&] { return !client.asyncEnabled(); })) { std::printf("disconnect not noticed\n"); rc = 1; }
+  if (!client.writeTickHash("t:", "IF2512", 1, 1, 1, 0)) { std::printf("sync fallback\n"); rc = 1; }
+
+  // 3) 重新开启（断开后原 IO 线程已退出，需先回收，否则 std::thread 赋值会 terminate）
+  if (!client.setAsync(true) || !client.asyncEnabled()) { std::printf("re-enable\n"); rc = 1; }
+  client.asyncStats(&sent, &ok, &failed, &in_flight);
+  const long long base = ok;
+  for (int i = 0; i < 10; ++i) client.writeTickHash("t:", "IF2512", 1, 1, 1, i);
+  if (!acked(base + 10)) { std::printf("after re-enable ok=%lld\n", ok - base); rc = 1; }
+
+  // 4) 反复断开 / 开关：文件描述符数不增长
+  const int fds_before = count_fds();
+  for (int round = 0; round < 5; ++round) {
+    server.drop_after_first();
+    wait_for([&] { return !client.asyncEnabled(); });
+    if (!client.setAsync(true)) { std::printf("round %d re-enable\n", round); rc = 1; }
+    client.setAsync(false);
+    client.setAsync(true);
+  }
+  client.setAsync(false);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));  // 等服务端线程关闭已断开的连接
+  const int grown = count_fds() - fds_before;
+  if (grown > 0) { std::printf("fd growth %d\n", grown); rc = 1; }
+
+  client.close();
+  server.stop();
+  std::printf(rc == 0 ? "ALL OK\n" : "FAILED\n");
+  return rc;
+}
@@ -2,10 +2,21 @@
 // 文件：/home/zhousiyuan/ctp_c/demo期货api-6.6.8/demo/redis_client.cpp
 #include "redis_client.h"
 #include <hiredis/hiredis.h>
+#include <hiredis/async.h>
 #include <sys/time.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdarg>
 #include <cstdio>
 #include <cstdlib>
 
+static int64_t mono_us() {
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
 RedisClient::RedisClient() : ctx_(nullptr) {}
 RedisClient::~RedisClient() { close(); }
 
@@ -25,26 +36,45 @@ bool RedisClient::connect(const std::string& host, int port,
   }
   if (!ping_()) { close(); return false; }
   if (db >= 0 && !select_(db)) { close(); return false; }
+  host_ = host.empty() ? "127.0.0.1" : host; port_ = port > 0 ? port : 6379;
+  username_ = username; password_ = password; db_ = db;
   return true;
 }
 
 void RedisClient::close() {
+  asyncStop_();
   std::lock_guard<std::mutex> lk(mtx_);
   flushPendingLocked_();
   if (ctx_) { redisFree(ctx_); ctx_ = nullptr; }
 }
 
 // 新增：pipeline 控制
-void RedisClient::setPipeline(bool enabled, int window_cmds) {
+void RedisClient::setPipeline(bool enabled, int window_cmds, int max_delay_us) {
   std::lock_guard<std::mutex> lk(mtx_);
+  flushPendingLocked_();  // 先取回旧窗口内的回复，避免与之后的同步命令错位
   pipeline_   = enabled;
   pipe_window_= enabled ? (window_cmds > 0 ? window_cmds : 0) : 0;
-  pending_    = 0;
+  pipe_max_delay_us_ = enabled ? (max_delay_us > 0 ? max_delay_us : 0) : 0;
 }
 bool RedisClient::flushPipeline() {
   std::lock_guard<std::mutex> lk(mtx_);
   return flushPendingLocked_();
 }
+bool RedisClient::flushIfDue() {
+  std::lock_guard<std::mutex> lk(mtx_);
+  if (pending_ <= 0 || pipe_max_delay_us_ <= 0) return true;
+  if (mono_us() - first_pending_us_ < pipe_max_delay_us_) return true;
+  return flushPendingLocked_();
+}
+void RedisClient::notePendingLocked_() {
+  if (pending_++ == 0) first_pending_us_ = mono_us();
+}
+bool RedisClient::maybeFlushLocked_() {
+  if (pending_ <= 0) return true;
+  if (pipe_window_ > 0 && pending_ >= pipe_window_) return flushPendingLocked_();
+  if (pipe_max_delay_us_ > 0 && mono_us() - first_pending_us_ >= pipe_max_delay_us_) return flushPendingLocked_();
+  return true;
+}
 bool RedisClient::flushPendingLocked_() {
   if (!ctx_ || pending_ <= 0) return true;
   bool ok = true;
@@ -59,33 +89,101 @@ bool RedisClient::flushPendingLocked_() {
   return ok;
 }
 
-// 流写入仍按立即发送
+// 流写入：MAXLEN ~ 近似裁剪，与 hash/string 相同走 pipeline / 异步
+#define XADD_TICK_FIELDS "* inst %s last %.10f bid1 %.10f ask1 %.10f ts %lld"
+
+void RedisClient::setStreamMaxLen(long long maxlen) {
+  stream_maxlen_.store(maxlen > 0 ? maxlen : 0, std::memory_order_relaxed);
+}
+
+bool RedisClient::appendTickXaddLocked_(const char* stream_key, const char* inst,
+                                        double last, double bid1, double ask1, int64_t ts_ms) {
+  const long long maxlen = stream_maxlen_.load(std::memory_order_relaxed);
+  int rc = maxlen > 0
+      ? redisAppendCommand(ctx_, "XADD %s MAXLEN ~ %lld " XADD_TICK_FIELDS,
+                           stream_key, maxlen, inst, last, bid1, ask1, (long long)ts_ms)
+      : redisAppendCommand(ctx_, "XADD %s " XADD_TICK_FIELDS,
+                           stream_key, inst, last, bid1, ask1, (long long)ts_ms);
+  if (rc != REDIS_OK) return false;
+  notePendingLocked_();
+  return true;
+}
+
+bool RedisClient::finishWriteLocked_(bool appended) {
+  if (pipeline_) return maybeFlushLocked_() && appended;
+  return flushPendingLocked_() && appended;  // 非 pipeline：一次往返取回本次全部回复
+}
+
 bool RedisClient::writeTickStream(const std::string& stream_key,
                                   const std::string& inst,
                                   double last, double bid1, double ask1,
                                   int64_t ts_ms) {
+  RedisStreamTick t{inst.c_str(), last, bid1, ask1, ts_ms};
+  return writeTickStreamBatch(stream_key, &t, 1);
+}
+
+bool RedisClient::writeTickStreamBatch(const std::string& stream_key, const RedisStreamTick* ticks, int n) {
+  if (n <= 0) return true;
+  if (async_enabled_.load(std::memory_order_acquire)) {
+    const long long maxlen = stream_maxlen_.load(std::memory_order_relaxed);
+    bool ok = true;
+    for (int i = 0; i < n; ++i) {
+      const RedisStreamTick& t = ticks[i];
+      ok &= maxlen > 0
+          ? asyncCommand_("XADD %s MAXLEN ~ %lld " XADD_TICK_FIELDS, stream_key.c_str(), maxlen,
+                          t.inst, t.last, t.bid1, t.ask1, (long long)t.ts_ms)
+          : asyncCommand_("XADD %s " XADD_TICK_FIELDS, stream_key.c_str(),
+                          t.inst, t.last, t.bid1, t.ask1, (long long)t.ts_ms);
+    }
+    return ok;
+  }
+
   std::lock_guard<std::mutex> lk(mtx_);
   if (!ctx_) return false;
-  redisReply* r = (redisReply*)redisCommand(ctx_,
-      "XADD %s * inst %s last %.10f bid1 %.10f ask1 %.10f ts %lld",
-      stream_key.c_str(), inst.c_str(), last, bid1, ask1, (long long)ts_ms);
-  bool ok = commandOk_(r); if (r) freeReplyObject(r);
-  return ok;
+  bool appended = true;
+  for (int i = 0; i < n; ++i)
+    appended &= appendTickXaddLocked_(stream_key.c_str(), ticks[i].inst, ticks[i].last,
+                                      ticks[i].bid1, ticks[i].ask1, ticks[i].ts_ms);
+  return finishWriteLocked_(appended);
+}
+
+bool RedisClient::writeTickStreamBin(const std::string& stream_key, const std::string& inst,
+                                     const void* blob, size_t len) {
+  const long long maxlen = stream_maxlen_.load(std::memory_order_relaxed);
+  if (async_enabled_.load(std::memory_order_acquire)) {
+    return maxlen > 0
+        ? asyncCommand_("XADD %s MAXLEN ~ %lld * inst %s bin %b", stream_key.c_str(), maxlen, inst.c_str(), blob, len)
+        : asyncCommand_("XADD %s * inst %s bin %b", stream_key.c_str(), inst.c_str(), blob, len);
+  }
+
+  std::lock_guard<std::mutex> lk(mtx_);
+  if (!ctx_) return false;
+  int rc = maxlen > 0
+      ? redisAppendCommand(ctx_, "XADD %s MAXLEN ~ %lld * inst %s bin %b", stream_key.c_str(), maxlen, inst.c_str(), blob, len)
+      : redisAppendCommand(ctx_, "XADD %s * inst %s bin %b", stream_key.c_str(), inst.c_str(), blob, len);
+  if (rc == REDIS_OK) notePendingLocked_();
+  return finishWriteLocked_(rc == REDIS_OK);
 }
 
 // 改写：支持 pipeline
 bool RedisClient::writeTickString(const std::string& string_key_prefix,
     const std::string& inst, double last, double bid1, double ask1,
     int64_t ts_ms, int ttl_sec) {
-  std::lock_guard<std::mutex> lk(mtx_);
-  if (!ctx_) return false;
-
   char key[256]; std::snprintf(key, sizeof(key), "%s%s", string_key_prefix.c_str(), inst.c_str());
   char val[512];
   std::snprintf(val, sizeof(val),
     "{\"inst\":\"%s\",\"last\":%.10f,\"bid1\":%.10f,\"ask1\":%.10f,\"ts\":%lld}",
     inst.c_str(), last, bid1, ask1, (long long)ts_ms);
 
+  if (async_enabled_.load(std::memory_order_acquire)) {
+    bool ok = asyncCommand_("SET %s %s", key, val);
+    if (ok && ttl_sec > 0) ok = asyncCommand_("EXPIRE %s %d", key, ttl_sec);
+    return ok;
+  }
+
+  std::lock_guard<std::mutex> lk(mtx_);
+  if (!ctx_) return false;
+
   if (!pipeline_) {
     redisReply* r = (redisReply*)redisCommand(ctx_, "SET %s %s", key, val);
     bool ok = commandOk_(r); if (r) freeReplyObject(r);
@@ -94,21 +192,27 @@ bool RedisClient::writeTickString(const std::string& string_key_prefix,
   }
 
   // pipeline：append 命令并按阈值批量取回回复
-  if (redisAppendCommand(ctx_, "SET %s %s", key, val) == REDIS_OK) ++pending_;
-  if (ttl_sec > 0) { if (redisAppendCommand(ctx_, "EXPIRE %s %d", key, ttl_sec) == REDIS_OK) ++pending_; }
-  if (pipe_window_ > 0 && pending_ >= pipe_window_) return flushPendingLocked_();
-  return true;
+  if (redisAppendCommand(ctx_, "SET %s %s", key, val) == REDIS_OK) notePendingLocked_();
+  if (ttl_sec > 0) { if (redisAppendCommand(ctx_, "EXPIRE %s %d", key, ttl_sec) == REDIS_OK) notePendingLocked_(); }
+  return maybeFlushLocked_();
 }
 
 bool RedisClient::writeTickHash(const std::string& hash_key_prefix,
                                 const std::string& inst,
                                 double last, double bid1, double ask1,
                                 int64_t ts_ms, int ttl_sec) {
+  char key[256]; std::snprintf(key, sizeof(key), "%s%s", hash_key_prefix.c_str(), inst.c_str());
+
+  if (async_enabled_.load(std::memory_order_acquire)) {
+    bool ok = asyncCommand_("HSET %s last %.10f bid1 %.10f ask1 %.10f ts %lld",
+                            key, last, bid1, ask1, (long long)ts_ms);
+    if (ok && ttl_sec > 0) ok = asyncCommand_("EXPIRE %s %d", key, ttl_sec);
+    return ok;
+  }
+
   std::lock_guard<std::mutex> lk(mtx_);
   if (!ctx_) return false;
 
-  char key[256]; std::snprintf(key, sizeof(key), "%s%s", hash_key_prefix.c_str(), inst.c_str());
-
   if (!pipeline_) {
     redisReply* r = (redisReply*)redisCommand(ctx_,
         "HSET %s last %.10f bid1 %.10f ask1 %.10f ts %lld",
@@ -119,10 +223,38 @@ bool RedisClient::writeTickHash(const std::string& hash_key_prefix,
   }
 
   if (redisAppendCommand(ctx_, "HSET %s last %.10f bid1 %.10f ask1 %.10f ts %lld",
-                         key, last, bid1, ask1, (long long)ts_ms) == REDIS_OK) ++pending_;
-  if (ttl_sec > 0) { if (redisAppendCommand(ctx_, "EXPIRE %s %d", key, ttl_sec) == REDIS_OK) ++pending_; }
-  if (pipe_window_ > 0 && pending_ >= pipe_window_) return flushPendingLocked_();
-  return true;
+                         key, last, bid1, ask1, (long long)ts_ms) == REDIS_OK) notePendingLocked_();
+  if (ttl_sec > 0) { if (redisAppendCommand(ctx_, "EXPIRE %s %d", key, ttl_sec) == REDIS_OK) notePendingLocked_(); }
+  return maybeFlushLocked_();
+}
+
+bool RedisClient::writeFormatted(const char* buf, const size_t* lens, int n) {
+  if (async_enabled_.load(std::memory_order_acquire)) {
+    // 异步上下文按命令登记回调，需逐条提交
+    std::lock_guard<std::mutex> lk(async_mtx_);
+    if (!actx_) { async_failed_.fetch_add(n, std::memory_order_relaxed); return false; }
+    for (int i = 0; i < n; buf += lens[i], ++i) {
+      if (redisAsyncFormattedCommand(actx_, asyncReplyCb_, this, buf, lens[i]) != REDIS_OK) {
+        async_failed_.fetch_add(n - i, std::memory_order_relaxed);
+        return false;
+      }
+      async_sent_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  std::lock_guard<std::mutex> lk(mtx_);
+  if (!ctx_) return false;
+  size_t total = 0;
+  for (int i = 0; i < n; ++i) total += lens[i];
+  if (redisAppendFormattedCommand(ctx_, buf, total) != REDIS_OK) return false;
+  if (pipeline_) {
+    for (int i = 0; i < n; ++i) notePendingLocked_();
+    return maybeFlushLocked_();
+  }
+  // 非 pipeline：一次往返取回 n 条回复
+  pending_ += n;
+  return flushPendingLocked_();
 }
 
 bool RedisClient::authLegacy_(const std::string& password) {
@@ -213,6 +345,46 @@ bool RedisClient::readLastTickHash(const std::string& hash_key_prefix,
   return ok;
 }
 
+int RedisClient::readLastTicks(const std::string& hash_key_prefix,
+                               const std::vector<std::string>& insts,
+                               std::vector<RedisLastTick>& out) {
+  out.assign(insts.size(), RedisLastTick());
+  std::lock_guard<std::mutex> lk(mtx_);
+  if (!ctx_) return -1;
+  flushPendingLocked_();
+
+  // 全部 HMGET 先进输出缓冲，第一次 redisGetReply 一并发出，之后按序取回
+  std::string key;
+  size_t appended = 0;
+  for (; appended < insts.size(); ++appended) {
+    key.assign(hash_key_prefix).append(insts[appended]);
+    if (redisAppendCommand(ctx_, "HMGET %b last bid1 ask1 ts", key.data(), key.size()) != REDIS_OK) break;
+  }
+
+  int n_ok = 0;
+  for (size_t i = 0; i < appended; ++i) {
+    void* rp = nullptr;
+    if (redisGetReply(ctx_, &rp) != REDIS_OK || !rp) break;  // 连接出错，其余回复已无法取回
+    redisReply* r = (redisReply*)rp;
+    if (r->type == REDIS_REPLY_ARRAY && r->elements >= 4) {
+      bool ok = true;
+      for (size_t k = 0; k < 4; ++k)
+        ok = ok && r->element[k] && r->element[k]->type == REDIS_REPLY_STRING;
+      if (ok) {
+        RedisLastTick& t = out[i];
+        t.last = std::atof(r->element[0]->str);
+        t.bid1 = std::atof(r->element[1]->str);
+        t.ask1 = std::atof(r->element[2]->str);
+        t.ts_ms = std::atoll(r->element[3]->str);
+        t.ok = true;
+        ++n_ok;
+      }
+    }
+    freeReplyObject(r);
+  }
+  return n_ok;
+}
+
 bool RedisClient::writeTradeEvent(const std::string& stream_key,
                                   const std::string& strategy,
                                   const std::string& phase,
@@ -254,8 +426,139 @@ bool RedisClient::writeTradeHash(const std::string& hash_key_prefix,
 
   if (redisAppendCommand(ctx_, "HSET %s strat %s phase %s text %s inst %s ts %lld",
                          key, strategy.c_str(), phase.c_str(), text.c_str(),
-                         inst.c_str(), (long long)ts_ms) == REDIS_OK) ++pending_;
-  if (ttl_sec > 0) { if (redisAppendCommand(ctx_, "EXPIRE %s %d", key, ttl_sec) == REDIS_OK) ++pending_; }
-  if (pipe_window_ > 0 && pending_ >= pipe_window_) return flushPendingLocked_();
+                         inst.c_str(), (long long)ts_ms) == REDIS_OK) notePendingLocked_();
+  if (ttl_sec > 0) { if (redisAppendCommand(ctx_, "EXPIRE %s %d", key, ttl_sec) == REDIS_OK) notePendingLocked_(); }
+  return maybeFlushLocked_();
+}
+
+// ---------------- 异步后端 ----------------
+// 自带最小事件循环：IO 线程 poll(连接 fd + 唤醒管道)，按 hiredis 的读写关注标志调用 redisAsyncHandleRead/Write。
+// 所有 redisAsync* 调用（写入线程发命令、IO 线程收发）都在 async_mtx_ 下进行。
+
+bool RedisClient::setAsync(bool enabled) {
+  if (!enabled) { asyncStop_(); return true; }
+  {
+    std::lock_guard<std::mutex> lk(async_mtx_);
+    if (actx_) return true;
+  }
+  // 服务端断开后 IO 线程已自行退出：先回收线程与唤醒管道，再重建连接
+  asyncStop_();
+  std::lock_guard<std::mutex> lk(async_mtx_);
+  if (host_.empty()) return false;  // 需先 connect（复用其连接参数）
+
+  redisAsyncContext* ac = redisAsyncConnect(host_.c_str(), port_);
+  if (!ac || ac->err) {
+    std::fprintf(stderr, "[redis-async] connect error: %s\n", ac && ac->errstr ? ac->errstr : "(alloc)");
+    if (ac) redisAsyncFree(ac);
+    return false;
+  }
+  if (::pipe(wake_fd_) != 0) { redisAsyncFree(ac); return false; }
+  for (int fd : wake_fd_) ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+  actx_ = ac;
+  want_read_ = want_write_ = false;
+  ac->data = this;
+  ac->ev.data = this;
+  ac->ev.addRead  = [](void* p){ static_cast<RedisClient*>(p)->want_read_ = true; };
+  ac->ev.delRead  = [](void* p){ static_cast<RedisClient*>(p)->want_read_ = false; };
+  ac->ev.addWrite = [](void* p){
+    RedisClient* self = static_cast<RedisClient*>(p);
+    if (!self->want_write_) { self->want_write_ = true; self->asyncWake_(); }
+  };
+  ac->ev.delWrite = [](void* p){ static_cast<RedisClient*>(p)->want_write_ = false; };
+  ac->ev.cleanup  = [](void* p){ RedisClient* self = static_cast<RedisClient*>(p); self->want_read_ = self->want_write_ = false; };
+  redisAsyncSetConnectCallback(ac, [](const redisAsyncContext* c, int status){
+    if (status != REDIS_OK) std::fprintf(stderr, "[redis-async] connect failed: %s\n", c->errstr ? c->errstr : "");
+  });
+  // 断开后 hiredis 会释放上下文；回调在持 async_mtx_ 的 IO 线程内执行
+  redisAsyncSetDisconnectCallback(ac, [](const redisAsyncContext* c, int status){
+    RedisClient* self = static_cast<RedisClient*>(c->data);
+    if (status != REDIS_OK) std::fprintf(stderr, "[redis-async] disconnected: %s\n", c->errstr ? c->errstr : "");
+    self->actx_ = nullptr;
+    self->async_enabled_.store(false, std::memory_order_release);
+  });
+
+  // 鉴权 / 选库排在所有写命令之前（同一连接上按序执行）
+  auto control_cb = [](redisAsyncContext*, void* r, void*){
+    redisReply* rr = static_cast<redisReply*>(r);
+    if (!rr || rr->type == REDIS_REPLY_ERROR)
+      std::fprintf(stderr, "[redis-async] auth/select error: %s\n", rr && rr->str ? rr->str : "(no reply)");
+  };
+  if (!username_.empty()) redisAsyncCommand(ac, control_cb, nullptr, "AUTH %s %s", username_.c_str(), password_.c_str());
+  else if (!password_.empty()) redisAsyncCommand(ac, control_cb, nullptr, "AUTH %s", password_.c_str());
+  if (db_ >= 0) redisAsyncCommand(ac, control_cb, nullptr, "SELECT %d", db_);
+
+  async_stop_.store(false);
+  async_enabled_.store(true, std::memory_order_release);
+  async_thread_ = std::thread(&RedisClient::asyncLoop_, this);
   return true;
-}
\ No newline at end of file
+}
+
+void RedisClient::asyncReplyCb_(redisAsyncContext*, void* r, void* priv) {
+  RedisClient* self = static_cast<RedisClient*>(priv);
+  redisReply* rr = static_cast<redisReply*>(r);
+  if (!rr || rr->type == REDIS_REPLY_ERROR) self->async_failed_.fetch_add(1, std::memory_order_relaxed);
+  else self->async_ok_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool RedisClient::asyncCommand_(const char* fmt, ...) {
+  std::lock_guard<std::mutex> lk(async_mtx_);
+  if (!actx_) { async_failed_.fetch_add(1, std::memory_order_relaxed); return false; }
+  va_list ap;
+  va_start(ap, fmt);
+  int rc = redisvAsyncCommand(actx_, asyncReplyCb_, this, fmt, ap);
+  va_end(ap);
+  if (rc != REDIS_OK) { async_failed_.fetch_add(1, std::memory_order_relaxed); return false; }
+  async_sent_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void RedisClient::asyncWake_() {
+  if (wake_fd_[1] >= 0) { char c = 1; (void)!::write(wake_fd_[1], &c, 1); }
+}
+
+void RedisClient::asyncLoop_() {
+  int64_t stop_deadline = 0;
+  for (;;) {
+    pollfd fds[2];
+    fds[0] = pollfd{wake_fd_[0], POLLIN, 0};
+    {
+      std::lock_guard<std::mutex> lk(async_mtx_);
+      if (!actx_) break;
+      if (async_stop_.load()) {
+        // 停止：等已发命令的回复取回后断开，最多等 1 秒
+        if (stop_deadline == 0) { stop_deadline = mono_us() + 1000000; redisAsyncDisconnect(actx_); if (!actx_) break; }
+        else if (mono_us() > stop_deadline) break;
+      }
+      short ev = 0;
+      if (want_read_) ev |= POLLIN;
+      if (want_write_) ev |= POLLOUT;
+      fds[1] = pollfd{actx_->c.fd, ev, 0};
+    }
+    int rc = ::poll(fds, 2, 10);  // 10ms 兜底，定期检查停止标志
+    if (rc <= 0) continue;
+    if (fds[0].revents & POLLIN) { char buf[64]; while (::read(wake_fd_[0], buf, sizeof(buf)) > 0) {} }
+    std::lock_guard<std::mutex> lk(async_mtx_);
+    if (actx_ && (fds[1].revents & (POLLIN | POLLERR | POLLHUP))) redisAsyncHandleRead(actx_);
+    if (actx_ && (fds[1].revents & POLLOUT)) redisAsyncHandleWrite(actx_);
+  }
+}
+
+void RedisClient::asyncStop_() {
+  async_enabled_.store(false, std::memory_order_release);
+  if (!async_thread_.joinable()) return;
+  async_stop_.store(true);
+  asyncWake_();
+  async_thread_.join();
+  std::lock_guard<std::mutex> lk(async_mtx_);
+  if (actx_) { redisAsyncFree(actx_); actx_ = nullptr; }  // 超时未断开：未回复的命令按失败计
+  for (int& fd : wake_fd_) { if (fd >= 0) ::close(fd); fd = -1; }
+}
+
+void RedisClient::asyncStats(long long* sent, long long* ok, long long* failed, long long* in_flight) const {
+  long long s = async_sent_.load(), o = async_ok_.load(), f = async_failed_.load();
+  if (sent) *sent = s;
+  if (ok) *ok = o;
+  if (failed) *failed = f;
+  if (in_flight) *in_flight = s > o + f ? s - o - f : 0;
+}
@@ -3,10 +3,29 @@
 #pragma once
 #include <string>
 #include <mutex>
+#include <atomic>
+#include <thread>
 #include <cstdint>
+#include <cstddef>
+#include <vector>
 
 struct redisContext;
 struct redisReply;
+struct redisAsyncContext;
+
+// readLastTicks 的单个合约结果；ok=false 表示 key 不存在或字段不全
+struct RedisLastTick {
+  double last = 0, bid1 = 0, ask1 = 0;
+  int64_t ts_ms = 0;
+  bool ok = false;
+};
+
+// writeTickStreamBatch 的一条记录
+struct RedisStreamTick {
+  const char* inst;
+  double last, bid1, ask1;
+  int64_t ts_ms;
+};
 
 class RedisClient {
 public:
@@ -20,13 +39,24 @@ public:
 
   void close();
 
-  // 行情写入
+  // 行情写入：XADD stream_key MAXLEN ~ N * inst .. last .. bid1 .. ask1 .. ts ..（N 见 setStreamMaxLen）
+  // 与 writeTickHash 相同遵循 pipeline / 异步设置
   bool writeTickStream(const std::string& stream_key,
                        const std::string& inst,
                        double last, double bid1, double ask1,
                        int64_t ts_ms);
+  // 多条一起 append；非 pipeline 时一次往返取回全部回复
+  bool writeTickStreamBatch(const std::string& stream_key, const RedisStreamTick* ticks, int n);
+
+  // 二进制行情（tick_codec.h 的 BinTickV1 等）：XADD stream_key MAXLEN ~ N * inst <inst> bin <blob>
+  bool writeTickStreamBin(const std::string& stream_key, const std::string& inst,
+                          const void* blob, size_t len);
 
-  // 若未开启 pipeline：每次立即发送并等待回复；若开启 pipeline：仅 append 命令，达阈值自动 flush
+  // 流的近似裁剪长度（MAXLEN ~，按宏节点整块裁剪，开销与 XADD 本身相当）；<=0 不裁剪，默认 100000
+  void setStreamMaxLen(long long maxlen);
+
+  // 若未开启 pipeline：每次立即发送并等待回复；若开启 pipeline：仅 append 命令，达条数或时间阈值自动 flush
+  // 若开启异步模式：交给 IO 线程发送，立即返回（返回 true 仅代表已入发送缓冲）
   bool writeTickHash(const std::string& hash_key_prefix,
                      const std::string& inst,
                      double last, double bid1, double ask1,
@@ -37,11 +67,20 @@ public:
                        double last, double bid1, double ask1,
                        int64_t ts_ms, int ttl_sec = -1);
 
+  // 预格式化的 RESP 命令（buf 内 n 条首尾相接，lens 为各条长度），同样遵循 pipeline / 异步设置
+  bool writeFormatted(const char* buf, const size_t* lens, int n);
+
   bool readLastTickHash(const std::string& hash_key_prefix,
                         const std::string& inst,
                         double& last, double& bid1, double& ask1,
                         int64_t& ts_ms);
 
+  // 批量读取多个合约的最近行情（文本 hash 字段）：各 HMGET 一起 append，一次往返取回；
+  // out 按 insts 顺序填写，返回成功条数，未连接返回 -1
+  int readLastTicks(const std::string& hash_key_prefix,
+                    const std::vector<std::string>& insts,
+                    std::vector<RedisLastTick>& out);
+
   bool writeTradeEvent(const std::string& stream_key,
                        const std::string& strategy,
                        const std::string& phase,
@@ -59,8 +98,17 @@ public:
                       int64_t ts_ms, int ttl_sec = -1);
 
   // 新增：pipeline 控制
-  void setPipeline(bool enabled, int window_cmds);
+  // window_cmds: 累计多少条命令自动 flush；max_delay_us: 首条未发命令最多滞留多久（<=0 不限时），先到先 flush
+  void setPipeline(bool enabled, int window_cmds, int max_delay_us = 0);
   bool flushPipeline();  // 手动 flush 未取回的回复
+  bool flushIfDue();     // 未发命令已滞留超过 max_delay_us 时 flush；供调用方空闲时轮询，行情稀疏时也能按时发出
+
+  // 异步模式：行情写入（writeTickString/writeTickHash）改走独立的 redisAsyncContext 连接，
+  // 由内部 IO 线程发送并消费回复，调用方不等待网络往返；其余命令仍走同步连接。需在 connect 之后开启
+  bool setAsync(bool enabled);
+  bool asyncEnabled() const { return async_enabled_.load(std::memory_order_acquire); }  // 服务端断开后自动变为 false
+  // 异步统计（指针可为 NULL）：已发送 / 成功回复 / 失败（错误回复或连接断开）/ 未回复
+  void asyncStats(long long* sent, long long* ok, long long* failed, long long* in_flight) const;
 
 private:
   bool authAcl_(const std::string& username, const std::string& password);
@@ -70,9 +118,21 @@ private:
   bool commandOk_(redisReply* r);
   bool commandStatusIs_(redisReply* r, const char* expect);
   bool expire_(const std::string& key, int ttl_sec);
+  bool appendTickXaddLocked_(const char* stream_key, const char* inst,
+                             double last, double bid1, double ask1, int64_t ts_ms);  // 需持锁调用
+  bool finishWriteLocked_(bool appended);  // pipeline 下按阈值 flush，否则立即取回
 
   // 新增：pipeline 内部
   bool flushPendingLocked_(); // 需持锁调用
+  void notePendingLocked_();  // append 成功后调用，记录首条未发命令的时间
+  bool maybeFlushLocked_();   // 达到条数/时间阈值则 flush
+
+  // 异步后端内部（async_mtx_ 保护 actx_ 及读写关注标志）
+  bool asyncCommand_(const char* fmt, ...);
+  static void asyncReplyCb_(redisAsyncContext* ac, void* reply, void* priv);
+  void asyncLoop_();
+  void asyncStop_();
+  void asyncWake_();
 
 private:
   redisContext* ctx_;
@@ -80,4 +140,21 @@ private:
   bool pipeline_ = false;  // 是否启用 pipeline
   int  pipe_window_ = 0;   // 达到多少“命令数”时自动 flush
   int  pending_ = 0;       // 未取回的回复条数
+  int  pipe_max_delay_us_ = 0;    // 首条未发命令最多滞留的微秒数
+  int64_t first_pending_us_ = 0;  // 首条未发命令 append 的时刻（单调时钟）
+  std::atomic<long long> stream_maxlen_{100000};  // XADD MAXLEN ~ 的长度，<=0 不裁剪
+
+  // 连接参数（异步连接复用）
+  std::string host_, username_, password_;
+  int port_ = 0, db_ = -1;
+
+  // 异步后端
+  redisAsyncContext* actx_ = nullptr;
+  std::mutex async_mtx_;
+  std::thread async_thread_;
+  std::atomic<bool> async_enabled_{false};
+  std::atomic<bool> async_stop_{false};
+  bool want_read_ = false, want_write_ = false;
+  int  wake_fd_[2] = {-1, -1};    // 唤醒 IO 线程的管道
+  std::atomic<long long> async_sent_{0}, async_ok_{0}, async_failed_{0};
 };
\ No newline at end of file
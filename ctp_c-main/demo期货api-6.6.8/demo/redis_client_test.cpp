@@ -7,6 +7,9 @@
 #include <cinttypes>
 #include <cstring>
 #include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
 
 static int64_t now_ms() {
   using namespace std::chrono;
@@ -33,7 +36,9 @@ struct Cfg {
   int         window      = envi("BATCH_WINDOW", 1000);   // pipeline 每批条数
   bool        do_set      = envb("WRITE_SET", true);
   bool        do_hash     = envb("WRITE_HASH", true);
-  const char* mode        = envs("BATCH_MODE", "client"); // client | pipeline
+  const char* mode        = envs("BATCH_MODE", "client"); // client | pipeline | async | read | stream
+  const char* stream_key  = envs("TEST_STREAM", "teamPublic:md:ticks:bench");
+  int         maxlen      = envi("STREAM_MAXLEN", 10000);
 };
 
 static void print_cfg(const Cfg& c){
@@ -54,6 +59,8 @@ static int bench_client(const Cfg& cfg){
   bool okc = rc.connect(cfg.host, cfg.port, cfg.user, cfg.pass, cfg.db);
   std::printf("connect=%d\n", okc?1:0);
   if (!okc) return 1;
+  bool async = strcasecmp(cfg.mode, "async")==0;
+  if (async && !rc.setAsync(true)) { std::printf("setAsync failed\n"); return 1; }
 
   // 预热
   rc.writeTickHash(cfg.hash_prefix, make_inst(cfg, -1), 1,1,1, now_ms(), cfg.ttl);
@@ -67,6 +74,14 @@ static int bench_client(const Cfg& cfg){
     if (cfg.do_set)  ok_set  += rc.writeTickString(cfg.str_prefix,  inst, last, bid1, ask1, ts, cfg.ttl) ? 1:0;
     if (cfg.do_hash) ok_hset += rc.writeTickHash  (cfg.hash_prefix, inst, last, bid1, ask1, ts, cfg.ttl) ? 1:0;
   }
+  long long sent=0, acked=0, failed=0, in_flight=0;
+  if (async) {
+    // 计时到全部回复返回为止（最多等 10 秒）
+    for (int64_t dl = now_ms() + 10000; now_ms() < dl; std::this_thread::sleep_for(std::chrono::milliseconds(1))) {
+      rc.asyncStats(&sent, &acked, &failed, &in_flight);
+      if (in_flight == 0) break;
+    }
+  }
   int64_t t1 = now_ms();
   int cmds = (cfg.do_set?1:0) + (cfg.do_hash?1:0);
   double dur_ms = double(t1 - t0);
@@ -74,6 +89,7 @@ static int bench_client(const Cfg& cfg){
 
   std::printf("client: wrote=%d recs, cmds/recs=%d, ok_set=%ld ok_hset=%ld, time_ms=%.3f, qps=%.1f cmd/s\n",
               cfg.N, cmds, ok_set, ok_hset, dur_ms, qps);
+  if (async) std::printf("async: sent=%lld ok=%lld failed=%lld in_flight=%lld\n", sent, acked, failed, in_flight);
   return 0;
 }
 
@@ -147,8 +163,80 @@ static int bench_pipeline(const Cfg& c){
   return 0;
 }
 
+// 快照读：逐个 readLastTickHash（每合约一次往返）vs readLastTicks（一次往返）；先用 pipeline 写入 N 个合约
+static int bench_read(const Cfg& cfg){
+  RedisClient rc;
+  if (!rc.connect(cfg.host, cfg.port, cfg.user, cfg.pass, cfg.db)) { std::printf("connect=0\n"); return 1; }
+  std::vector<std::string> insts;
+  rc.setPipeline(true, cfg.window > 0 ? cfg.window : 1000);
+  for (int i=0;i<cfg.N;i++){
+    insts.push_back(make_inst(cfg, i));
+    rc.writeTickHash(cfg.hash_prefix, insts.back(), 100+i, 99+i, 101+i, 1000+i, cfg.ttl);
+  }
+  rc.setPipeline(false, 0);
+
+  int64_t t0 = now_ms();
+  int ok_single = 0;
+  for (const auto& inst : insts){
+    double last, bid1, ask1; int64_t ts;
+    ok_single += rc.readLastTickHash(cfg.hash_prefix, inst, last, bid1, ask1, ts) ? 1 : 0;
+  }
+  int64_t t1 = now_ms();
+  std::vector<RedisLastTick> out;
+  int ok_batch = rc.readLastTicks(cfg.hash_prefix, insts, out);
+  int64_t t2 = now_ms();
+  int mismatch = 0;
+  for (int i=0;i<(int)out.size();i++)
+    if (!out[i].ok || out[i].last != 100+i || out[i].bid1 != 99+i || out[i].ask1 != 101+i || out[i].ts_ms != 1000+i) ++mismatch;
+  std::printf("read: insts=%d single ok=%d time_ms=%lld, batch ok=%d time_ms=%lld, mismatch=%d\n",
+              cfg.N, ok_single, (long long)(t1-t0), ok_batch, (long long)(t2-t1), mismatch);
+  return mismatch == 0 ? 0 : 1;
+}
+
+// 流写入：逐条 XADD（每条一次往返）vs writeTickStreamBatch（每 window 条一次往返），均带 MAXLEN ~
+static int bench_stream(const Cfg& cfg){
+  RedisClient rc;
+  if (!rc.connect(cfg.host, cfg.port, cfg.user, cfg.pass, cfg.db)) { std::printf("connect=0\n"); return 1; }
+  rc.setStreamMaxLen(cfg.maxlen);
+  const int window = cfg.window > 0 ? cfg.window : 1000;
+  std::vector<std::string> insts;
+  for (int i=0;i<cfg.N;i++) insts.push_back(make_inst(cfg, i % 100));
+
+  int64_t t0 = now_ms();
+  long ok_single = 0;
+  for (int i=0;i<cfg.N;i++) ok_single += rc.writeTickStream(cfg.stream_key, insts[i], 100, 99, 101, now_ms()) ? 1 : 0;
+  int64_t t1 = now_ms();
+  std::vector<RedisStreamTick> batch;
+  long ok_batch = 0;
+  for (int i=0;i<cfg.N;i+=window){
+    batch.clear();
+    for (int k=i;k<std::min(cfg.N, i+window);k++) batch.push_back({insts[k].c_str(), 100, 99, 101, now_ms()});
+    ok_batch += rc.writeTickStreamBatch(cfg.stream_key, batch.data(), (int)batch.size()) ? (long)batch.size() : 0;
+  }
+  int64_t t2 = now_ms();
+
+  // 裁剪后流长度应在 maxlen 附近（~ 按宏节点裁剪，略大于 maxlen）
+  timeval timeout{2,0};
+  long long xlen = -1;
+  if (redisContext* ctx = redisConnectWithTimeout(cfg.host, cfg.port, timeout)) {
+    redisReply* r = (cfg.user && *cfg.user) ? (redisReply*)redisCommand(ctx, "AUTH %s %s", cfg.user, cfg.pass)
+                                            : (redisReply*)redisCommand(ctx, "AUTH %s", cfg.pass);
+    if (r) freeReplyObject(r);
+    if (cfg.db >= 0) { r = (redisReply*)redisCommand(ctx, "SELECT %d", cfg.db); if (r) freeReplyObject(r); }
+    r = (redisReply*)redisCommand(ctx, "XLEN %s", cfg.stream_key);
+    if (r && r->type == REDIS_REPLY_INTEGER) xlen = r->integer;
+    if (r) freeReplyObject(r);
+    redisFree(ctx);
+  }
+  std::printf("stream: N=%d single ok=%ld time_ms=%lld, batch(window=%d) ok=%ld time_ms=%lld, xlen=%lld maxlen=%d\n",
+              cfg.N, ok_single, (long long)(t1-t0), window, ok_batch, (long long)(t2-t1), xlen, cfg.maxlen);
+  return 0;
+}
+
 int main(){
   Cfg cfg; print_cfg(cfg);
   if (strcasecmp(cfg.mode, "pipeline")==0) return bench_pipeline(cfg);
+  if (strcasecmp(cfg.mode, "read")==0) return bench_read(cfg);
+  if (strcasecmp(cfg.mode, "stream")==0) return bench_stream(cfg);
   return bench_client(cfg);
 }
\ No newline at end of file
@@ -0,0 +1,64 @@
+// 单生产者/单消费者无锁环形队列：CTP 行情回调线程写入，发布线程批量取出
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+template <typename T>
+class SpscRing {
+public:
+  // capacity 向上取整到 2 的幂；槽位一次性预分配，运行期不再分配内存
+  explicit SpscRing(size_t capacity = 65536) {
+    size_t n = 2;
+    while (n < capacity) n <<= 1;
+    slots_.resize(n);
+    mask_ = n - 1;
+  }
+
+  size_t capacity() const { return slots_.size(); }
+
+  // 当前队列深度（近似值，可在任意线程读取）：先读 tail_ 再读 head_，两次读取之间消费者前移不会让差值回绕；
+  // 读取线程被延迟时 head_ 可能已超前不止一圈，结果截断到 [0, capacity()]
+  size_t size() const {
+    const uint64_t t = tail_.load(std::memory_order_acquire);
+    const uint64_t h = head_.load(std::memory_order_acquire);
+    if (h <= t) return 0;
+    return h - t < slots_.size() ? (size_t)(h - t) : slots_.size();
+  }
+
+  // 生产者：满时返回 false，不阻塞
+  bool push(const T& v) {
+    const uint64_t h = head_.load(std::memory_order_relaxed);
+    if (h - tail_cache_ >= slots_.size()) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (h - tail_cache_ >= slots_.size()) return false;
+    }
+    slots_[h & mask_] = v;
+    head_.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // 消费者：最多取出 max_n 条到 out，返回实际条数
+  size_t pop_batch(T* out, size_t max_n) {
+    const uint64_t t = tail_.load(std::memory_order_relaxed);
+    if (head_cache_ - t < max_n) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (head_cache_ == t) return 0;
+    }
+    size_t n = (size_t)(head_cache_ - t);
+    if (n > max_n) n = max_n;
+    for (size_t i = 0; i < n; ++i) out[i] = slots_[(t + i) & mask_];
+    tail_.store(t + n, std::memory_order_release);
+    return n;
+  }
+
+private:
+  std::vector<T> slots_;
+  size_t mask_ = 0;
+  // head_ 由生产者写、tail_ 由消费者写，分占缓存行避免伪共享；*_cache_ 为各自线程私有的对端位置快照
+  alignas(64) std::atomic<uint64_t> head_{0};
+  uint64_t tail_cache_ = 0;
+  alignas(64) std::atomic<uint64_t> tail_{0};
+  uint64_t head_cache_ = 0;
+};
@@ -0,0 +1,75 @@
+// spsc_ring.h 测试：单线程满/空边界 + 双线程顺序与吞吐 + 第三方线程读 size() 不越界
+#include "spsc_ring.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+static int envi(const char* k, int d){ const char* v=getenv(k); return (v&&*v)?std::atoi(v):d; }
+
+struct Item { long long seq; double px[4]; };
+
+static int test_bounds(){
+  SpscRing<Item> q(5);  // 取整到 8
+  if (q.capacity() != 8) { std::printf("capacity=%zu expect 8\n", q.capacity()); return 1; }
+  int pushed = 0;
+  for (int i = 0; i < 10; ++i) if (q.push(Item{i, {0,0,0,0}})) ++pushed;
+  if (pushed != 8 || q.size() != 8) { std::printf("pushed=%d size=%zu expect 8\n", pushed, q.size()); return 1; }
+  Item out[16];
+  size_t n = q.pop_batch(out, 3);
+  if (n != 3 || out[0].seq != 0 || out[2].seq != 2) { std::printf("pop_batch(3) n=%zu\n", n); return 1; }
+  if (!q.push(Item{100, {0,0,0,0}})) { std::printf("push after pop failed\n"); return 1; }
+  n = q.pop_batch(out, 16);
+  if (n != 6 || out[0].seq != 3 || out[5].seq != 100) { std::printf("pop_batch(16) n=%zu\n", n); return 1; }
+  if (q.pop_batch(out, 16) != 0 || q.size() != 0) { std::printf("not empty\n"); return 1; }
+  std::printf("bounds ok\n");
+  return 0;
+}
+
+static int test_threads(){
+  const long long N = envi("RING_N", 5000000);
+  const int cap = envi("RING_CAP", 16384);
+  SpscRing<Item> q(cap);
+  long long full = 0;
+
+  // 统计线程：既非生产者也非消费者，读到的深度必须在 [0, capacity()]
+  std::atomic<bool> done{false};
+  long long size_bad = 0;
+  std::thread observer([&]{
+    while (!done.load(std::memory_order_relaxed)) if (q.size() > q.capacity()) ++size_bad;
+  });
+
+  auto t0 = std::chrono::steady_clock::now();
+  std::thread producer([&]{
+    for (long long i = 0; i < N; ++i) {
+      Item it{i, {1.0*i, 2.0, 3.0, 4.0}};
+      while (!q.push(it)) { ++full; std::this_thread::yield(); }
+    }
+  });
+
+  std::vector<Item> batch(256);
+  long long expect = 0, bad = 0;
+  while (expect < N) {
+    size_t n = q.pop_batch(batch.data(), batch.size());
+    if (n == 0) { std::this_thread::yield(); continue; }
+    for (size_t i = 0; i < n; ++i, ++expect)
+      if (batch[i].seq != expect || batch[i].px[0] != 1.0*expect) ++bad;
+  }
+  producer.join();
+  done.store(true);
+  observer.join();
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  std::printf("threads N=%lld cap=%zu bad=%lld size_bad=%lld full_spins=%lld %.1f Mops/s\n",
+              N, q.capacity(), bad, size_bad, full, N / sec / 1e6);
+  return bad == 0 && size_bad == 0 ? 0 : 1;
+}
+
+int main(){
+  int rc = test_bounds();
+  rc |= test_threads();
+  std::printf(rc == 0 ? "ALL OK\n" : "FAILED\n");
+  return rc;
+}
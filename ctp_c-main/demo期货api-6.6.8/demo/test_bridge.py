@@ -1,6 +1,6 @@
 # /home/zhousiyuan/ctp_c/demo期货api-6.6.8/demo/test_bridge.py
 import os, time, configparser, socket, re
-from ctypes import cdll, c_char_p, c_double, c_int, PYFUNCTYPE, c_char, c_longlong
+from ctypes import cdll, c_char_p, c_double, c_int, PYFUNCTYPE, c_char, c_longlong, POINTER, byref, Structure, c_void_p
 now_time = time.time()
 base = os.path.dirname(__file__); os.chdir(base)
 # flow 目录
@@ -49,6 +49,42 @@ trd_cb = TRD(on_trd)
 lib.ctp_set_md_cb(md_cb)
 lib.ctp_set_trade_cb(trd_cb)
 
+# 批量行情（MD_BATCH=1 启用）：每批一次回调，numpy 直接映射 ctp_md_tick_t 数组，不逐笔装箱
+md_batch_cb = None
+if os.environ.get("MD_BATCH"):
+    import numpy as np
+    TICK_DTYPE = np.dtype([
+        ("inst", "S32"), ("last", "<f8"), ("bid1", "<f8"), ("ask1", "<f8"),
+        ("turnover", "<f8"), ("open_interest", "<f8"), ("volume", "<i8"),
+        ("bid_vol1", "<i4"), ("ask_vol1", "<i4"),
+        ("exch_ts_ms", "<i8"), ("recv_cpp_ms", "<i8"), ("redis_ok_ms", "<i8"),
+        ("seq", "<i8"), ("inst_id", "<i4"), ("changed", "<u4"),
+    ])
+    assert TICK_DTYPE.itemsize == 128
+    MD_BATCH = PYFUNCTYPE(None, c_void_p, c_int)
+
+    def on_md_batch(ptr, n):
+        try:
+            # 缓冲区只在回调期间有效：视图内用完，或 .copy() 后保留
+            ticks = np.frombuffer((c_char * (n * TICK_DTYPE.itemsize)).from_address(ptr), dtype=TICK_DTYPE)
+            rev = ticks[::-1]  # 每个合约取本批最后一笔
+            for rec in rev[np.unique(rev["inst_id"], return_index=True)[1]]:
+                last_tick[rec["inst"].decode()] = (rec["last"], rec["bid1"], rec["ask1"])
+        except Exception as e:
+            print("batch error:", e)
+
+    md_batch_cb = MD_BATCH(on_md_batch)
+    lib.ctp_set_md_batch_cb.argtypes = [MD_BATCH, c_int, c_int]
+    lib.ctp_set_md_batch_cb.restype  = c_int
+    lib.ctp_set_md_batch_cb(md_batch_cb, 512, 2000)   # 最多 512 笔或 2ms 交付一次
+
+
+# 日志按 64MB 滚动，保留 5 个旧文件（后台线程写出，不占 CTP 回调线程）
+lib.ctp_set_log_rotate.argtypes = [c_char_p, c_longlong, c_int]
+lib.ctp_set_log_rotate.restype  = c_int
+lib.ctp_set_log_rotate(b"./ctp_bridge.log", 64 << 20, 5)
+lib.ctp_log_stats.argtypes = [POINTER(c_longlong), POINTER(c_longlong)]
+lib.ctp_log_stats.restype  = None
 
 # 新增：设置 Redis 前缀（只用 SET/HSET）
 try:
@@ -64,10 +100,11 @@ rc = lib.ctp_redis_init_acl(b"192.168.10.12", 6381, b"teamPublic_write", b"f2f71
 print("redis init rc =", rc)
 
 try:
-    lib.ctp_redis_set_pipeline.argtypes = [c_int, c_int]
-    lib.ctp_redis_set_pipeline.restype  = c_int
+    lib.ctp_redis_set_pipeline_ex.argtypes = [c_int, c_int, c_int]
+    lib.ctp_redis_set_pipeline_ex.restype  = c_int
     # 启用 pipeline，窗口按“命令数”计数，建议 500~4000；越大吞吐越高但延迟上升
-    lib.ctp_redis_set_pipeline(1, 2000)
+    # 第三个参数为最大积压时长(us)，行情稀疏时也能在 2ms 内落库
+    lib.ctp_redis_set_pipeline_ex(1, 2000, 2000)
 except AttributeError:
     pass
 
@@ -89,6 +126,17 @@ lib.ctp_md_wait_ready.restype  = c_int
 lib.ctp_md_subscribe.argtypes  = [c_char_p]
 lib.ctp_md_subscribe.restype   = c_int
 
+lib.ctp_md_set_queue_capacity.argtypes = [c_int]
+lib.ctp_md_set_queue_capacity.restype  = c_int
+lib.ctp_md_set_queue_capacity(65536)   # 开盘集中推送时留足余量
+# 1s / 1m K 线：收盘后写 Redis Stream 并落盘，Python 端不再从 tick 重算
+lib.ctp_md_set_bars.argtypes = [c_char_p, c_char_p, c_int, c_char_p]
+lib.ctp_md_set_bars.restype  = c_int
+lib.ctp_md_set_bars(b"1,60", b"teamPublic:md:bar:", 20000, b"./bars")
+# 合约主数据：当日首次启动解析 dat 并写 ./instruments/instruments_YYYYMMDD.bin，之后直接 mmap；同时预登记期货、设置 K 线乘数
+lib.ctp_instruments_load.argtypes = [c_char_p, c_char_p]
+lib.ctp_instruments_load.restype  = c_int
+print("instruments =", lib.ctp_instruments_load(os.path.join(base, "live_futuresinstruments.dat").encode(), b"./instruments"))
 assert lib.ctp_md_start(md_front, broker, user, pwd) == 0
 assert lib.ctp_md_wait_ready(15000) == 1
 # 粘贴到 test_bridge.py 示例：
@@ -103,6 +151,15 @@ lib.ctp_td_wait_ready.argtypes = [c_int]
 lib.ctp_td_wait_ready.restype  = c_int
 lib.ctp_td_place.argtypes = [c_char_p, c_char_p, c_char, c_char, c_int, c_char, c_double]
 lib.ctp_td_place.restype  = c_int
+lib.ctp_td_place_ex.argtypes = [c_char_p, c_char_p, c_char, c_char, c_int, c_char, c_double, POINTER(c_int)]
+lib.ctp_td_place_ex.restype  = c_int
+class CtpOrderInfo(Structure):
+    _fields_ = [("ref", c_int), ("state", c_int), ("volume", c_int), ("traded", c_int),
+                ("direction", c_char), ("offset", c_char), ("price", c_double), ("insert_ns", c_longlong),
+                ("strategy", c_char * 32), ("inst", c_char * 32), ("exch", c_char * 12), ("order_sys_id", c_char * 24)]
+lib.ctp_td_order_info.argtypes = [c_int, POINTER(CtpOrderInfo)]
+lib.ctp_td_order_info.restype  = c_int
+ORDER_STATES = ("none", "inserted", "accepted", "partial", "filled", "cancelled", "rejected")
 
 # 前置连通性快速检查
 m = re.match(rb"tcp://([^:]+):(\d+)", td_front)
@@ -163,9 +220,52 @@ print(l, b, a)
 # price = a if side == b'B' else b
 # if price <= 0:
 #     raise RuntimeError("无有效盘口价，暂不下单")
-# rc = lib.ctp_td_place(b"strat_alpha", inst.encode(), side, offset, 1, pricetype, float(price))
-# print("place rc =", rc)
+# ref = c_int(0)
+# rc = lib.ctp_td_place_ex(b"strat_alpha", inst.encode(), side, offset, 1, pricetype, float(price), byref(ref))
+# print("place rc =", rc, "ref =", ref.value)
+# oi = CtpOrderInfo()
+# if lib.ctp_td_order_info(ref.value, byref(oi)) == 0:
+#     print(ORDER_STATES[oi.state], oi.traded, "/", oi.volume, oi.exch, oi.order_sys_id)
+
+# 行情发布队列统计
+lib.ctp_md_queue_stats.argtypes = [POINTER(c_longlong)] * 7
+lib.ctp_md_queue_stats.restype  = None
+def md_queue_stats():
+    v = [c_longlong() for _ in range(7)]
+    lib.ctp_md_queue_stats(*[byref(x) for x in v])
+    names = ("depth", "max_depth", "enqueued", "dropped", "overflow", "published", "redis_fail")
+    return dict(zip(names, (x.value for x in v)))
+
+# 分段延迟统计（桥内直方图，单位 ns）
+class CtpLatency(Structure):
+    _fields_ = [("count", c_longlong), ("mean_ns", c_double),
+                ("min_ns", c_longlong), ("p50_ns", c_longlong), ("p90_ns", c_longlong),
+                ("p99_ns", c_longlong), ("p999_ns", c_longlong), ("max_ns", c_longlong)]
+
+_STAGES = ("exch_to_recv", "recv_to_enqueue", "queue_wait", "redis_write",
+           "enqueue_to_redis", "recv_to_md_cb", "order_to_rtn_order", "order_to_rtn_trade")
+
+class CtpStats(Structure):
+    _fields_ = [(n, CtpLatency) for n in _STAGES] + [("exch_recv_negative", c_longlong)]
+
+lib.ctp_stats_snapshot.argtypes = [POINTER(CtpStats)]
+lib.ctp_stats_snapshot.restype  = None
+def stats_snapshot():
+    st = CtpStats()
+    lib.ctp_stats_snapshot(byref(st))
+    return {n: {"n": getattr(st, n).count, "p50_us": getattr(st, n).p50_ns / 1e3,
+                "p99_us": getattr(st, n).p99_ns / 1e3, "p999_us": getattr(st, n).p999_ns / 1e3,
+                "max_us": getattr(st, n).max_ns / 1e3} for n in _STAGES}
 
 # 常驻
-for _ in range(600):
-    time.sleep(1)
\ No newline at end of file
+for i in range(600):
+    time.sleep(1)
+    if i % 10 == 0:
+        print("md queue", md_queue_stats())
+        lw, ld = c_longlong(), c_longlong()
+        lib.ctp_log_stats(byref(lw), byref(ld))
+        print("log written", lw.value, "dropped", ld.value)
+        for name, v in stats_snapshot().items():
+            if v["n"]:
+                print(f"  {name:20s} n={v['n']} p50={v['p50_us']:.1f}us p99={v['p99_us']:.1f}us "
+                      f"p999={v['p999_us']:.1f}us max={v['max_us']:.1f}us")
\ No newline at end of file
@@ -0,0 +1,125 @@
+// 热点线程的绑核与忙等
+// - CPU 列表写法同 taskset -c："3"、"2,5"、"4-7"、"0,2-3"；空串 / "-1" 表示不绑
+// - 绑核只作用于调用线程（pthread_setaffinity_np）；CTP 自己创建的回调线程在回调里自行绑定
+// - NUMA 不依赖 libnuma：按 sysfs 查 CPU 所在节点；内存靠首次写入（first-touch）落在写入线程所在节点，
+//   因此队列等缓冲由绑核后的线程自己分配并清零
+// - SpinBackoff：先 pause 自旋，超过阈值 yield；非忙等模式下持续空闲再短暂休眠
+#pragma once
+#include <sched.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// 解析 CPU 列表；格式错误返回 false（out 清空）
+inline bool parse_cpu_list(const char* s, std::vector<int>& out) {
+  out.clear();
+  if (!s) return true;
+  while (*s == ' ') ++s;
+  if (!*s || std::strcmp(s, "-1") == 0) return true;
+  for (const char* p = s; *p;) {
+    char* e = nullptr;
+    const long a = std::strtol(p, &e, 10);
+    if (e == p || a < 0 || a >= CPU_SETSIZE) { out.clear(); return false; }
+    long b = a;
+    p = e;
+    if (*p == '-') {
+      b = std::strtol(p + 1, &e, 10);
+      if (e == p + 1 || b < a || b >= CPU_SETSIZE) { out.clear(); return false; }
+      p = e;
+    }
+    for (long c = a; c <= b; ++c) out.push_back((int)c);
+    while (*p == ' ') ++p;
+    if (*p == ',') ++p;
+    else if (*p) { out.clear(); return false; }
+  }
+  return true;
+}
+
+// 把调用线程绑到 cpus（空表示解除绑定：全部 CPU，内核再与 cpuset 取交集）；返回 0 或 errno
+inline int thread_pin_self(const std::vector<int>& cpus) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (cpus.empty()) {
+    const long n = sysconf(_SC_NPROCESSORS_CONF);
+    for (long c = 0; c < n && c < CPU_SETSIZE; ++c) CPU_SET((int)c, &set);
+  } else {
+    for (int c : cpus) CPU_SET(c, &set);
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// CPU 所在 NUMA 节点；无 NUMA 信息返回 -1
+inline int cpu_numa_node(int cpu) {
+  char path[64];
+  std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+  DIR* d = opendir(path);
+  if (!d) return -1;
+  int node = -1;
+  while (dirent* e = readdir(d))
+    if (std::strncmp(e->d_name, "node", 4) == 0 && e->d_name[4] >= '0' && e->d_name[4] <= '9') { node = std::atoi(e->d_name + 4); break; }
+  closedir(d);
+  return node;
+}
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#else
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// 空闲退避：每次空转调用 idle()，拿到数据后 reset()
+// busy=true：只 pause，每 kYieldEvery 次 yield 一次（与其他线程共用 CPU 时不至于饿死持有者）；
+// busy=false：前 kSpinBeforeYield 次 pause，之后 yield，再之后每次休眠 sleep_us（<=0 则一直 yield，不休眠）
+class SpinBackoff {
+public:
+  static constexpr int kSpinBeforeYield = 64;
+  static constexpr int kYieldBeforeSleep = 64;
+  static constexpr int kYieldEvery = 4096;
+
+  explicit SpinBackoff(bool busy = false, int sleep_us = 100) : busy_(busy), sleep_us_(sleep_us) {}
+  void set_busy(bool busy) { busy_ = busy; }
+  void reset() { n_ = 0; }
+  void idle() {
+    ++n_;
+    if (busy_) {
+      if (n_ % kYieldEvery == 0) std::this_thread::yield();
+      else cpu_relax();
+    } else if (n_ <= kSpinBeforeYield) {
+      cpu_relax();
+    } else if (sleep_us_ <= 0 || n_ <= kSpinBeforeYield + kYieldBeforeSleep) {
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(sleep_us_));
+    }
+  }
+
+private:
+  bool busy_;
+  int sleep_us_;
+  unsigned n_ = 0;
+};
+
+// 条件满足前自旋等待（代替 condition_variable，没有唤醒延迟）；timeout_ms<0 一直等；超时返回 false
+template <typename Pred>
+inline bool spin_wait_for(Pred pred, int timeout_ms, bool busy) {
+  SpinBackoff bo(busy, 50);
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms < 0 ? 0 : timeout_ms);
+  for (unsigned i = 0; !pred(); ++i) {
+    if (timeout_ms >= 0 && (i & 63) == 0 && std::chrono::steady_clock::now() >= deadline) return pred();
+    bo.idle();
+  }
+  return true;
+}
@@ -0,0 +1,107 @@
+// thread_tuning.h 测试：CPU 列表解析、绑核 / 解绑、NUMA 节点查询、SpinBackoff 各阶段、spin_wait_for 超时；
+// 两线程乒乓对比条件变量唤醒与自旋等待的往返时延（单核机器上自旋靠 yield 交替，只看数量级）
+#include "thread_tuning.h"
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+
+static bool same(const std::vector<int>& a, std::initializer_list<int> b) { return a == std::vector<int>(b); }
+
+static int affinity_count() {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+  return CPU_COUNT(&set);
+}
+
+int main() {
+  int rc = 0;
+
+  // 1) 解析
+  std::vector<int> v;
+  if (!parse_cpu_list("3", v) || !same(v, {3}) || !parse_cpu_list("0,2-4, 7", v) || !same(v, {0, 2, 3, 4, 7}) ||
+      !parse_cpu_list("", v) || !v.empty() || !parse_cpu_list("-1", v) || !v.empty() || !parse_cpu_list(nullptr, v) || !v.empty()) {
+    std::printf("parse ok cases\n"); rc = 1;
+  }
+  for (const char* bad : {"a", "3-1", "1,,x", "2-", "99999", "1;2"})
+    if (parse_cpu_list(bad, v) || !v.empty()) { std::printf("parse accepted '%s'\n", bad); rc = 1; }
+
+  // 2) 绑核 / 解绑；不存在的 CPU 报错且不改亲和性
+  const long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  const int before = affinity_count();
+  const int last = (int)ncpu - 1;
+  if (thread_pin_self({last}) != 0 || affinity_count() != 1) { std::printf("pin\n"); rc = 1; }
+  std::this_thread::yield();
+  if (sched_getcpu() != last) { std::printf("running on %d, want %d\n", sched_getcpu(), last); rc = 1; }
+  if (thread_pin_self({CPU_SETSIZE - 1}) == 0 || affinity_count() != 1) { std::printf("bad cpu accepted\n"); rc = 1; }
+  if (thread_pin_self({}) != 0 || affinity_count() < before) { std::printf("unpin %d < %d\n", affinity_count(), before); rc = 1; }
+  std::printf("cpus=%ld cpu%d node=%d\n", ncpu, last, cpu_numa_node(last));
+  if (cpu_numa_node(CPU_SETSIZE + 5) != -1) { std::printf("numa bogus\n"); rc = 1; }
+
+  // 3) SpinBackoff：非忙等模式在 pause / yield 阶段之后才休眠；sleep_us<=0 不休眠；忙等模式不休眠
+  auto elapsed_us = [](SpinBackoff& b, int n) {
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; ++i) b.idle();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+  };
+  {
+    SpinBackoff slow(false, 200), never(false, 0), busy(true);
+    const double early = elapsed_us(slow, SpinBackoff::kSpinBeforeYield + SpinBackoff::kYieldBeforeSleep);
+    const double sleeping = elapsed_us(slow, 10);
+    const double no_sleep = elapsed_us(never, 1000);
+    const double spin = elapsed_us(busy, 10000);
+    if (sleeping < 10 * 200 || no_sleep > 10 * 200 || spin > 10 * 200) {
+      std::printf("backoff early=%.0f sleeping=%.0f no_sleep=%.0f spin=%.0f us\n", early, sleeping, no_sleep, spin); rc = 1;
+    }
+    slow.reset();
+    if (elapsed_us(slow, 1) > 100) { std::printf("reset\n"); rc = 1; }
+  }
+
+  // 4) spin_wait_for：超时返回 false，条件满足返回 true
+  {
+    const auto t0 = std::chrono::steady_clock::now();
+    const bool r = spin_wait_for([] { return false; }, 20, true);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::atomic<bool> flag{false};
+    std::thread t([&] { std::this_thread::sleep_for(std::chrono::milliseconds(5)); flag.store(true); });
+    const bool w = spin_wait_for([&] { return flag.load(); }, -1, false);
+    t.join();
+    if (r || ms < 19 || ms > 500 || !w || !spin_wait_for([] { return true; }, 0, true)) { std::printf("spin_wait_for r=%d ms=%.1f\n", r, ms); rc = 1; }
+  }
+
+  // 5) 乒乓往返：条件变量 vs 自旋
+  {
+    const int N = 2000;
+    std::mutex m;
+    std::condition_variable cv;
+    int turn = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    std::thread peer([&] {
+      for (int i = 0; i < N; ++i) {
+        std::unique_lock<std::mutex> lk(m);
+        cv.wait(lk, [&] { return turn == 1; });
+        turn = 0; cv.notify_one();
+      }
+    });
+    for (int i = 0; i < N; ++i) {
+      std::unique_lock<std::mutex> lk(m);
+      turn = 1; cv.notify_one();
+      cv.wait(lk, [&] { return turn == 0; });
+    }
+    peer.join();
+    const double cv_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / N;
+
+    std::atomic<int> st{0};
+    t0 = std::chrono::steady_clock::now();
+    std::thread speer([&] {
+      for (int i = 0; i < N; ++i) { spin_wait_for([&] { return st.load(std::memory_order_acquire) == 1; }, -1, false); st.store(0, std::memory_order_release); }
+    });
+    for (int i = 0; i < N; ++i) { st.store(1, std::memory_order_release); spin_wait_for([&] { return st.load(std::memory_order_acquire) == 0; }, -1, false); }
+    speer.join();
+    const double spin_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / N;
+    std::printf("round trip: condvar %.2f us, spin %.2f us\n", cv_us, spin_us);
+  }
+
+  std::printf(rc == 0 ? "ALL OK\n" : "FAILED\n");
+  return rc;
+}
@@ -0,0 +1,77 @@
+// 行情二进制编码：定长、带版本号的小端结构体，作为一个 bulk string 写入 Redis
+// 与 JSON / %.10f 文本相比免去两端的格式化与解析；Python 侧可直接 struct.unpack(BIN_TICK_PY_FORMAT)
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+static const uint8_t BIN_TICK_MAGIC   = 0xB7;
+static const uint8_t BIN_TICK_VERSION = 2;
+// Python struct 格式（与 BinTickV1 字段一一对应）；V2 在其后追加 2..5 档与变动位
+#define BIN_TICK_PY_FORMAT    "<BBHI32s5dq2i2q"
+#define BIN_TICK_V2_PY_FORMAT "<BBHI32s5dq2i2q8d8i2I"
+
+// 字段按自然对齐排列，无填充；新版本只在末尾追加字段，size 记录实际长度
+struct BinTickV1 {
+  uint8_t  magic;          // BIN_TICK_MAGIC
+  uint8_t  version;        // BIN_TICK_VERSION
+  uint16_t size;           // 编码长度（字节）
+  uint32_t inst_id;        // 进程内合约 id（InstrumentTable），跨进程以 inst 为准
+  char     inst[32];       // InstrumentID，'\0' 结尾
+  double   last, bid1, ask1;
+  double   turnover, open_interest;
+  int64_t  volume;
+  int32_t  bid_vol1, ask_vol1;
+  int64_t  exch_ts_ms;     // 交易所时间（ms），无法解析时为 0
+  int64_t  recv_ts_ms;     // 本机收到时间（ms）
+};
+static_assert(sizeof(BinTickV1) == 112, "BinTickV1 layout");
+static_assert(offsetof(BinTickV1, last) == 40 && offsetof(BinTickV1, exch_ts_ms) == 96, "BinTickV1 layout");
+
+// V2：V1 + 2..5 档价量 + 变动位（md_book.h 的 MD_BOOK_*）；只读 V1 的旧读端取前 112 字节即可
+struct BinTickV2 {
+  BinTickV1 v1;
+  double   bid_px[4], ask_px[4];   // 第 2..5 档
+  int32_t  bid_vol[4], ask_vol[4];
+  uint32_t changed;
+  uint32_t reserved;
+};
+static_assert(sizeof(BinTickV2) == 216 && offsetof(BinTickV2, bid_px) == sizeof(BinTickV1), "BinTickV2 layout");
+
+inline void init_bin_tick(BinTickV1& t, uint32_t inst_id, const char* inst) {
+  std::memset(&t, 0, sizeof(t));
+  t.magic = BIN_TICK_MAGIC;
+  t.version = 1;
+  t.size = (uint16_t)sizeof(BinTickV1);
+  t.inst_id = inst_id;
+  if (inst) std::strncpy(t.inst, inst, sizeof(t.inst) - 1);
+}
+
+inline void init_bin_tick(BinTickV2& t, uint32_t inst_id, const char* inst) {
+  std::memset(&t, 0, sizeof(t));
+  init_bin_tick(t.v1, inst_id, inst);
+  t.v1.version = 2;
+  t.v1.size = (uint16_t)sizeof(BinTickV2);
+}
+
+// 解码：0 成功；-1 长度不足；-2 magic / 版本不识别。高版本只读取 V1 部分
+inline int decode_bin_tick(const void* buf, size_t len, BinTickV1* out) {
+  if (!buf || !out || len < sizeof(BinTickV1)) return -1;
+  const uint8_t* p = static_cast<const uint8_t*>(buf);
+  if (p[0] != BIN_TICK_MAGIC || p[1] < 1) return -2;
+  std::memcpy(out, buf, sizeof(BinTickV1));
+  if (out->size < sizeof(BinTickV1) || out->size > len) return -1;
+  out->inst[sizeof(out->inst) - 1] = '\0';
+  return 0;
+}
+
+// 解码 V2：0 成功；-3 为 V1 编码（无 2..5 档，out->v1 已填好），其余同 decode_bin_tick
+inline int decode_bin_tick(const void* buf, size_t len, BinTickV2* out) {
+  if (!out) return -1;
+  int rc = decode_bin_tick(buf, len, &out->v1);
+  if (rc != 0) return rc;
+  if (out->v1.version < 2 || out->v1.size < sizeof(BinTickV2)) return -3;
+  std::memcpy(reinterpret_cast<char*>(out) + sizeof(BinTickV1), static_cast<const char*>(buf) + sizeof(BinTickV1),
+              sizeof(BinTickV2) - sizeof(BinTickV1));
+  return 0;
+}
@@ -0,0 +1,295 @@
+// tick_journal.h 实现
+#include "tick_journal.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+
+static size_t align_page(size_t n) { return (n + 4095) & ~size_t(4095); }
+
+// 各区偏移只由容量决定，新建与续写校验共用
+static void journal_layout(uint64_t max_records, uint64_t& index_off, uint64_t& chunk_off,
+                           uint64_t& data_off, uint64_t& total) {
+  const uint64_t max_chunks = (max_records + JOURNAL_CHUNK_RECORDS - 1) / JOURNAL_CHUNK_RECORDS;
+  index_off = align_page(sizeof(JournalHeader));
+  chunk_off = index_off + align_page(sizeof(JournalInstrument) * JOURNAL_MAX_INSTRUMENTS);
+  data_off  = chunk_off + align_page(sizeof(JournalChunk) * max_chunks);
+  total     = data_off + max_records * sizeof(JournalRecord);
+}
+
+// 映射一个日志文件：spare 为 true 时截断新建、头部不写交易日和 magic（roll 启用时补写）；失败返回 nullptr
+static JournalFile* journal_map(const std::string& path, const char* trading_day, uint64_t max_records, bool spare) {
+  if (max_records == 0) max_records = JOURNAL_DEFAULT_RECORDS;
+  const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | (spare ? O_TRUNC : 0), 0644);
+  if (fd < 0) { std::perror("[journal] open"); return nullptr; }
+  struct stat st{};
+  ::fstat(fd, &st);
+
+  bool fresh = st.st_size == 0;
+  if (!fresh) {
+    // 续写：按已有文件的容量映射，格式不符则拒绝（不覆盖）
+    JournalHeader h;
+    if (::pread(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) || std::memcmp(h.magic, JOURNAL_MAGIC, 8) != 0 ||
+        h.version != JOURNAL_VERSION || h.record_size != sizeof(JournalRecord) ||
+        h.max_instruments != JOURNAL_MAX_INSTRUMENTS || h.chunk_records != JOURNAL_CHUNK_RECORDS) {
+      std::fprintf(stderr, "[journal] %s: incompatible journal file\n", path.c_str());
+      ::close(fd);
+      return nullptr;
+    }
+    max_records = h.max_records;
+  }
+  uint64_t index_off, chunk_off, data_off, total;
+  journal_layout(max_records, index_off, chunk_off, data_off, total);
+  if (fresh && ::ftruncate(fd, (off_t)total) != 0) { std::perror("[journal] ftruncate"); ::close(fd); return nullptr; }
+  if (!fresh && (uint64_t)st.st_size < total) {
+    std::fprintf(stderr, "[journal] %s: truncated journal file\n", path.c_str());
+    ::close(fd);
+    return nullptr;
+  }
+
+  void* p = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) { std::perror("[journal] mmap"); ::close(fd); return nullptr; }
+  JournalFile* f = new JournalFile();
+  f->path = path;
+  f->fd = fd;
+  f->base = static_cast<char*>(p);
+  f->map_len = total;
+  f->hdr = reinterpret_cast<JournalHeader*>(f->base);
+  f->index = reinterpret_cast<JournalInstrument*>(f->base + index_off);
+  f->chunks = reinterpret_cast<JournalChunk*>(f->base + chunk_off);
+  f->records = reinterpret_cast<JournalRecord*>(f->base + data_off);
+
+  if (fresh) {
+    // ftruncate 出的区域全为 0，只需填写头部；magic 最后写，避免读者看到半成品头部
+    f->hdr->version = JOURNAL_VERSION;
+    f->hdr->record_size = sizeof(JournalRecord);
+    f->hdr->max_instruments = JOURNAL_MAX_INSTRUMENTS;
+    f->hdr->chunk_records = JOURNAL_CHUNK_RECORDS;
+    f->hdr->max_records = max_records;
+    f->hdr->index_offset = index_off;
+    f->hdr->chunk_offset = chunk_off;
+    f->hdr->data_offset = data_off;
+    if (!spare) {
+      std::snprintf(f->hdr->trading_day, sizeof(f->hdr->trading_day), "%s", trading_day ? trading_day : "");
+      std::atomic_thread_fence(std::memory_order_release);
+      std::memcpy(f->hdr->magic, JOURNAL_MAGIC, 8);
+    }
+  }
+
+  // 合约下标按文件内既有顺序重新登记，续写时 id 不变
+  const uint32_t n = f->hdr->n_instruments.load(std::memory_order_relaxed);
+  for (uint32_t i = 0; i < n; ++i) f->ids.add(f->index[i].inst);
+  f->prefaulted = f->hdr->committed.load(std::memory_order_relaxed);
+  return f;
+}
+
+static void journal_unmap(JournalFile* f) {
+  if (!f) return;
+  ::munmap(f->base, f->map_len);
+  ::close(f->fd);
+  delete f;
+}
+
+// 把 [prefaulted, target) 的页面预先映射为可写；只建立页表，不改动内容，可与写入并发
+static void journal_prefault(JournalFile* f, uint64_t target, bool& populate) {
+  if (target > f->hdr->max_records) target = f->hdr->max_records;
+  if (target <= f->prefaulted) return;
+  char* data = reinterpret_cast<char*>(f->records);
+  uintptr_t b = reinterpret_cast<uintptr_t>(data + f->prefaulted * sizeof(JournalRecord)) & ~uintptr_t(4095);
+  uintptr_t e = reinterpret_cast<uintptr_t>(data + target * sizeof(JournalRecord));
+#ifdef MADV_POPULATE_WRITE
+  if (populate && ::madvise(reinterpret_cast<void*>(b), e - b, MADV_POPULATE_WRITE) != 0) populate = false;
+#else
+  populate = false;
+#endif
+  if (!populate) {
+    // 旧内核：只读触碰，至少把页面读入页缓存
+    for (uintptr_t p = b; p < e; p += 4096) (void)*reinterpret_cast<volatile const char*>(p);
+  }
+  f->prefaulted = target;
+}
+
+// 预建文件启用后改名为 {dir}/md_{TradingDay}.jrnl；同名文件已存在（不覆盖）时加 .{pid} 后缀
+static void journal_rename(JournalFile* f, const std::string& dir) {
+  std::string path = TickJournalWriter::day_path(dir, f->hdr->trading_day);
+  if (::link(f->path.c_str(), path.c_str()) == 0) {
+    ::unlink(f->path.c_str());
+  } else {
+    if (errno == EEXIST) {
+      path += "." + std::to_string(::getpid());
+      std::fprintf(stderr, "[journal] %s exists, writing to %s\n", TickJournalWriter::day_path(dir, f->hdr->trading_day).c_str(), path.c_str());
+    }
+    if (::rename(f->path.c_str(), path.c_str()) != 0) { std::perror("[journal] rename"); path = f->path; }
+  }
+  f->path = path;
+  f->named.store(true, std::memory_order_release);
+}
+
+std::string TickJournalWriter::day_path(const std::string& dir, const char* trading_day) {
+  return dir + "/md_" + (trading_day ? trading_day : "") + ".jrnl";
+}
+
+bool TickJournalWriter::open(const std::string& path, const char* trading_day, uint64_t max_records) {
+  return open_(path, trading_day, max_records, std::string());
+}
+
+bool TickJournalWriter::open_day(const std::string& dir, const char* trading_day, uint64_t max_records) {
+  return open_(day_path(dir, trading_day), trading_day, max_records, dir);
+}
+
+bool TickJournalWriter::open_(const std::string& path, const char* trading_day, uint64_t max_records,
+                              const std::string& dir) {
+  close();
+  cur_ = journal_map(path, trading_day, max_records, false);
+  if (!cur_) return false;
+  dir_ = dir;  // 后台线程启动前写入，之后只读
+  max_records_ = max_records ? max_records : JOURNAL_DEFAULT_RECORDS;
+  committed_.store(cur_->hdr->committed.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  active_.store(cur_, std::memory_order_release);
+  prefault_stop_.store(false);
+  prefault_thread_ = std::thread(&TickJournalWriter::prefaultLoop_, this);
+  return true;
+}
+
+bool TickJournalWriter::roll(const char* trading_day) {
+  // 后台线程只在 retired_ 为空时预建，取到 spare_ 时 retired_ 一定已空
+  if (dir_.empty()) return false;
+  JournalFile* f = spare_.exchange(nullptr, std::memory_order_acq_rel);
+  if (!f) return false;
+  std::snprintf(f->hdr->trading_day, sizeof(f->hdr->trading_day), "%s", trading_day ? trading_day : "");
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(f->hdr->magic, JOURNAL_MAGIC, 8);
+  JournalFile* old = cur_;
+  cur_ = f;
+  committed_.store(0, std::memory_order_relaxed);
+  active_.store(f, std::memory_order_release);
+  retired_.store(old, std::memory_order_release);
+  return true;
+}
+
+void TickJournalWriter::prefaultLoop_() {
+  bool populate = true;
+  int spare_backoff = 0;  // 预建失败后隔一段时间再试，避免每毫秒报错
+  const std::string spare_path = dir_.empty() ? std::string() : dir_ + "/.md_spare_" + std::to_string(::getpid()) + ".jrnl";
+  while (!prefault_stop_.load(std::memory_order_relaxed)) {
+    if (JournalFile* r = retired_.exchange(nullptr, std::memory_order_acq_rel)) journal_unmap(r);
+    // 旧文件只由本线程回收，这里读到的 f 在本轮内一直有效
+    if (JournalFile* f = active_.load(std::memory_order_acquire)) {
+      if (!f->named.load(std::memory_order_acquire)) journal_rename(f, dir_);
+      journal_prefault(f, committed_.load(std::memory_order_relaxed) + JOURNAL_PREFAULT_RECORDS, populate);
+    }
+    // retired_ 为空才预建：保证 roll 取到 spare_ 时换下的旧文件有空位
+    if (!spare_path.empty() && !spare_.load(std::memory_order_acquire) && !retired_.load(std::memory_order_acquire) &&
+        --spare_backoff <= 0) {
+      if (JournalFile* s = journal_map(spare_path, nullptr, max_records_, true)) {
+        journal_prefault(s, JOURNAL_PREFAULT_RECORDS, populate);
+        s->named.store(false, std::memory_order_relaxed);
+        spare_.store(s, std::memory_order_release);
+      } else {
+        spare_backoff = 1000;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+void TickJournalWriter::close() {
+  prefault_stop_.store(true);
+  if (prefault_thread_.joinable()) prefault_thread_.join();
+  if (cur_ && !cur_->named.load()) journal_rename(cur_, dir_);
+  journal_unmap(cur_);
+  journal_unmap(retired_.exchange(nullptr));
+  if (JournalFile* s = spare_.exchange(nullptr)) { ::unlink(s->path.c_str()); journal_unmap(s); }
+  cur_ = nullptr;
+  active_.store(nullptr);
+  dir_.clear();
+}
+
+bool TickJournalWriter::append(const CThostFtdcDepthMarketDataField& md, int64_t recv_ns) {
+  JournalFile* f = cur_;
+  if (!f) { dropped_.fetch_add(1, std::memory_order_relaxed); return false; }
+  const uint64_t n = f->hdr->committed.load(std::memory_order_relaxed);
+  int id = f->ids.find(md.InstrumentID);
+  if (id < 0) {
+    if (std::strlen(md.InstrumentID) >= sizeof(f->index[0].inst)) { dropped_.fetch_add(1, std::memory_order_relaxed); return false; }
+    id = f->ids.add(md.InstrumentID);
+  }
+  if (n >= f->hdr->max_records || id < 0) { dropped_.fetch_add(1, std::memory_order_relaxed); return false; }
+
+  JournalRecord& r = f->records[n];
+  r.recv_ns = recv_ns;
+  r.inst_id = (uint32_t)id;
+  r.reserved = 0;
+  std::memcpy(&r.md, &md, sizeof(md));
+
+  JournalInstrument& ins = f->index[id];
+  if ((uint32_t)id >= f->hdr->n_instruments.load(std::memory_order_relaxed)) {
+    // 新合约：索引项填好后再增加 n_instruments
+    std::snprintf(ins.inst, sizeof(ins.inst), "%s", md.InstrumentID);
+    ins.first_record = n;
+    f->hdr->n_instruments.store((uint32_t)id + 1, std::memory_order_release);
+  }
+  ins.n_records++;
+  ins.last_record = n;
+
+  JournalChunk& c = f->chunks[n / JOURNAL_CHUNK_RECORDS];
+  if (n % JOURNAL_CHUNK_RECORDS == 0) c.first_recv_ns = recv_ns;
+  c.last_recv_ns = recv_ns;
+
+  f->hdr->committed.store(n + 1, std::memory_order_release);
+  committed_.store(n + 1, std::memory_order_relaxed);
+  return true;
+}
+
+bool TickJournalReader::open(const std::string& path) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) { std::perror("[journal] open"); return false; }
+  struct stat st{};
+  ::fstat(fd, &st);
+  JournalHeader h;
+  bool ok = ::pread(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h) && std::memcmp(h.magic, JOURNAL_MAGIC, 8) == 0 &&
+            h.version == JOURNAL_VERSION && h.record_size == sizeof(JournalRecord) &&
+            h.chunk_records == JOURNAL_CHUNK_RECORDS && h.max_instruments == JOURNAL_MAX_INSTRUMENTS;
+  uint64_t index_off = 0, chunk_off = 0, data_off = 0, total = 0;
+  if (ok) journal_layout(h.max_records, index_off, chunk_off, data_off, total);
+  if (!ok || (uint64_t)st.st_size < total || index_off != h.index_offset || data_off != h.data_offset) {
+    std::fprintf(stderr, "[journal] %s: not a compatible journal file\n", path.c_str());
+    ::close(fd);
+    return false;
+  }
+  void* p = ::mmap(nullptr, total, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) { std::perror("[journal] mmap"); return false; }
+  base_ = static_cast<const char*>(p);
+  map_len_ = total;
+  hdr_ = reinterpret_cast<const JournalHeader*>(base_);
+  index_ = reinterpret_cast<const JournalInstrument*>(base_ + index_off);
+  chunks_ = reinterpret_cast<const JournalChunk*>(base_ + chunk_off);
+  records_ = reinterpret_cast<const JournalRecord*>(base_ + data_off);
+  return true;
+}
+
+void TickJournalReader::close() {
+  if (base_) ::munmap(const_cast<char*>(base_), map_len_);
+  base_ = nullptr; map_len_ = 0;
+  hdr_ = nullptr; index_ = nullptr; chunks_ = nullptr; records_ = nullptr;
+}
+
+uint64_t TickJournalReader::seek_time(int64_t ns) const {
+  const uint64_t n = size();
+  if (n == 0) return 0;
+  // 最后一个 first_recv_ns < ns 的块
+  uint64_t lo = 0, hi = (n - 1) / JOURNAL_CHUNK_RECORDS + 1;
+  while (hi - lo > 1) {
+    uint64_t mid = (lo + hi) / 2;
+    if (chunks_[mid].first_recv_ns < ns) lo = mid; else hi = mid;
+  }
+  uint64_t i = lo * JOURNAL_CHUNK_RECORDS;
+  while (i < n && records_[i].recv_ns < ns) ++i;
+  return i;
+}
@@ -0,0 +1,137 @@
+// 行情日志：每个交易日一个 mmap 文件，逐笔追加原始 CThostFtdcDepthMarketDataField + recv_ns
+// 文件布局：[JournalHeader 4KB][合约索引 JOURNAL_MAX_INSTRUMENTS 项][分块表 max_chunks 项][定长记录...]
+// 追加 = memcpy + 更新索引 + committed 原子 store(release)，不做系统调用；后台线程提前把写入点之后的页面
+// 预先映射为可写（MADV_POPULATE_WRITE），回调线程写新页时不触发缺页
+// 进程崩溃后 committed 之内的记录完整可用（页面在内核页缓存中，由内核回写）
+// 按交易日滚动（open_day）：后台线程预建一份空白日志（已 ftruncate / mmap / 预缺页），跨日时回调线程只交换指针，
+// 改名为 md_{TradingDay}.jrnl 和再预建下一份由后台线程完成
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include "ThostFtdcUserApiStruct.h"
+#include "instrument_table.h"
+
+static const char     JOURNAL_MAGIC[8]        = {'C', 'T', 'P', 'J', 'R', 'N', 'L', '1'};
+static const uint32_t JOURNAL_VERSION         = 1;
+static const uint32_t JOURNAL_MAX_INSTRUMENTS = InstrumentTable::kMaxInstruments;
+static const uint32_t JOURNAL_CHUNK_RECORDS   = 4096;     // 分块表粒度（条）
+static const uint64_t JOURNAL_DEFAULT_RECORDS = 4u << 20;  // 默认容量约 2GB（稀疏文件，按实际写入占盘）
+static const uint64_t JOURNAL_PREFAULT_RECORDS = 16384;    // 预缺页提前量（约 10MB）
+
+struct JournalRecord {
+  int64_t  recv_ns;    // 本机收到时间（ns，系统时钟）
+  uint32_t inst_id;    // 本文件合约索引下标
+  uint32_t reserved;
+  CThostFtdcDepthMarketDataField md;
+};
+
+// 合约索引：按 inst_id 下标
+struct JournalInstrument {
+  char     inst[40];
+  uint64_t n_records;
+  uint64_t first_record, last_record;
+};
+static_assert(sizeof(JournalInstrument) == 64, "JournalInstrument layout");
+
+// 分块表：第 c 块为记录 [c*JOURNAL_CHUNK_RECORDS, (c+1)*JOURNAL_CHUNK_RECORDS)
+struct JournalChunk {
+  int64_t first_recv_ns, last_recv_ns;
+};
+
+struct JournalHeader {
+  char     magic[8];
+  uint32_t version, record_size;
+  uint32_t max_instruments, chunk_records;
+  uint64_t max_records;
+  uint64_t index_offset, chunk_offset, data_offset;  // 各区相对文件头的字节偏移
+  char     trading_day[16];
+  std::atomic<uint64_t> committed;                     // 已提交记录数，读者只读取其之内的记录
+  std::atomic<uint32_t> n_instruments;
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "committed must be lock-free in shared memory");
+
+// 一个已映射的日志文件（写端内部使用）
+struct JournalFile {
+  std::string path;
+  char* base = nullptr;
+  size_t map_len = 0;
+  int fd = -1;
+  JournalHeader* hdr = nullptr;
+  JournalInstrument* index = nullptr;
+  JournalChunk* chunks = nullptr;
+  JournalRecord* records = nullptr;
+  InstrumentTable ids;              // InstrumentID → 本文件 inst_id
+  uint64_t prefaulted = 0;          // 已预缺页到的记录号（仅后台线程读写）
+  std::atomic<bool> named{true};    // 预建文件启用后为 false，后台线程改名完成后置 true
+};
+
+// 写端：仅由单个线程（CTP 行情回调线程）调用 append / roll
+class TickJournalWriter {
+public:
+  ~TickJournalWriter() { close(); }
+
+  // 新建或续写（同名文件且格式一致时从 committed 处继续）；max_records 仅对新建文件生效
+  bool open(const std::string& path, const char* trading_day, uint64_t max_records = JOURNAL_DEFAULT_RECORDS);
+  // 打开 {dir}/md_{trading_day}.jrnl（同 open），并由后台线程在 dir 下预建下一份日志供 roll 使用
+  bool open_day(const std::string& dir, const char* trading_day, uint64_t max_records = JOURNAL_DEFAULT_RECORDS);
+  // 切换到新交易日：预建文件就绪时只交换指针（不做文件系统调用、不分配），返回 true；
+  // 未就绪（或不是 open_day 打开的）返回 false，由调用方回退到 open_day
+  bool roll(const char* trading_day);
+  void close();
+  bool is_open() const { return cur_ != nullptr; }
+  bool spare_ready() const { return spare_.load(std::memory_order_acquire) != nullptr; }
+
+  // 追加一条；未打开或已满返回 false（计入 dropped）
+  bool append(const CThostFtdcDepthMarketDataField& md, int64_t recv_ns);
+
+  const char* trading_day() const { return cur_ ? cur_->hdr->trading_day : ""; }
+  uint64_t committed() const { return committed_.load(std::memory_order_relaxed); }
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  static std::string day_path(const std::string& dir, const char* trading_day);
+
+private:
+  JournalFile* cur_ = nullptr;                    // 回调线程使用
+  std::atomic<JournalFile*> active_{nullptr};     // 后台线程看到的当前文件
+  std::atomic<JournalFile*> spare_{nullptr};      // 后台线程预建，roll 取走
+  std::atomic<JournalFile*> retired_{nullptr};    // roll 换下的旧文件，后台线程解除映射
+  std::string dir_;                               // 非空时预建下一份
+  uint64_t max_records_ = JOURNAL_DEFAULT_RECORDS;
+  std::atomic<uint64_t> committed_{0}, dropped_{0};  // 供其他线程读取统计
+
+  bool open_(const std::string& path, const char* trading_day, uint64_t max_records, const std::string& dir);
+
+  // 后台线程：保持写入点之后 JOURNAL_PREFAULT_RECORDS 条已映射，回收旧文件、改名、预建下一份
+  void prefaultLoop_();
+  std::thread prefault_thread_;
+  std::atomic<bool> prefault_stop_{false};
+};
+
+// 读端：只读映射，可读取正在写入的文件（以 committed 为准）
+class TickJournalReader {
+public:
+  ~TickJournalReader() { close(); }
+
+  bool open(const std::string& path);
+  void close();
+
+  const JournalHeader& header() const { return *hdr_; }
+  uint64_t size() const { return hdr_->committed.load(std::memory_order_acquire); }
+  const JournalRecord& at(uint64_t i) const { return records_[i]; }
+  int n_instruments() const { return (int)hdr_->n_instruments.load(std::memory_order_acquire); }
+  const JournalInstrument& instrument(int id) const { return index_[id]; }
+
+  // 第一个 recv_ns >= ns 的记录下标（按分块表二分后块内顺序查找；recv_ns 非严格递增时为近似位置）
+  uint64_t seek_time(int64_t ns) const;
+
+private:
+  const char* base_ = nullptr;
+  size_t map_len_ = 0;
+  const JournalHeader* hdr_ = nullptr;
+  const JournalInstrument* index_ = nullptr;
+  const JournalChunk* chunks_ = nullptr;
+  const JournalRecord* records_ = nullptr;
+};
@@ -0,0 +1,134 @@
+// tick_journal.h 测试：写入/读回、索引与分块表、续写、子进程崩溃后数据完整、追加耗时、跨交易日切换预建文件
+#include "tick_journal.h"
+#include <dirent.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+static int envi(const char* k, int d){ const char* v=getenv(k); return (v&&*v)?std::atoi(v):d; }
+
+static CThostFtdcDepthMarketDataField make_md(long long i) {
+  CThostFtdcDepthMarketDataField md;
+  std::memset(&md, 0, sizeof(md));
+  std::snprintf(md.InstrumentID, sizeof(md.InstrumentID), "IM25%02lld", i % 7);
+  std::snprintf(md.TradingDay, sizeof(md.TradingDay), "20251014");
+  md.LastPrice = 6000.0 + i * 0.2;
+  md.Volume = (int)i;
+  return md;
+}
+
+// 校验前 n 条记录内容与索引
+static int verify(const std::string& path, long long n) {
+  TickJournalReader r;
+  if (!r.open(path)) { std::printf("reader open failed\n"); return 1; }
+  if ((long long)r.size() != n) { std::printf("size=%llu expect %lld\n", (unsigned long long)r.size(), n); return 1; }
+  long long counts[7] = {0};
+  for (long long i = 0; i < n; ++i) {
+    const JournalRecord& rec = r.at(i);
+    CThostFtdcDepthMarketDataField md = make_md(i);
+    if (std::memcmp(&rec.md, &md, sizeof(md)) != 0 || rec.recv_ns != 1000 * i ||
+        std::strcmp(r.instrument(rec.inst_id).inst, md.InstrumentID) != 0) {
+      std::printf("record %lld mismatch\n", i); return 1;
+    }
+    counts[rec.inst_id]++;
+  }
+  if (r.n_instruments() != (n >= 7 ? 7 : (int)n)) { std::printf("n_instruments=%d\n", r.n_instruments()); return 1; }
+  for (int id = 0; id < r.n_instruments(); ++id)
+    if ((long long)r.instrument(id).n_records != counts[id]) { std::printf("index count mismatch id=%d\n", id); return 1; }
+  if (n > 5000 && r.seek_time(1000LL * 5000) != 5000) { std::printf("seek_time=%llu\n", (unsigned long long)r.seek_time(5000000)); return 1; }
+  if (std::strcmp(r.header().trading_day, "20251014") != 0) { std::printf("trading_day mismatch\n"); return 1; }
+  return 0;
+}
+
+int main() {
+  const long long N = envi("JOURNAL_N", 200000);
+  std::string path = "/tmp/tick_journal_test_" + std::to_string(getpid()) + ".jrnl";
+  int rc = 0;
+
+  {
+    TickJournalWriter w;
+    if (!w.open(path, "20251014", N + 10)) { std::printf("writer open failed\n"); return 1; }
+    auto t0 = std::chrono::steady_clock::now();
+    for (long long i = 0; i < N / 2; ++i) w.append(make_md(i), 1000 * i);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / (N / 2);
+    std::printf("append %lld records, %.1f ns/record (record=%zu bytes)\n", N / 2, ns, sizeof(JournalRecord));
+  }
+  rc |= verify(path, N / 2);
+
+  // 续写：子进程写完后不 close 直接退出，模拟崩溃
+  pid_t pid = fork();
+  if (pid == 0) {
+    TickJournalWriter* w = new TickJournalWriter();
+    if (!w->open(path, "20251014")) _exit(2);
+    for (long long i = N / 2; i < N; ++i) w->append(make_md(i), 1000 * i);
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) { std::printf("child failed\n"); rc = 1; }
+  rc |= verify(path, N);
+
+  // 写满后丢弃并计数
+  {
+    TickJournalWriter w;
+    w.open(path, "20251014");
+    int ok = 0;
+    for (int i = 0; i < 20; ++i) ok += w.append(make_md(N + i), 1000 * (N + i)) ? 1 : 0;
+    if (ok != 10 || w.dropped() != 10) { std::printf("full: ok=%d dropped=%llu\n", ok, (unsigned long long)w.dropped()); rc = 1; }
+  }
+
+  // 非日志文件拒绝打开
+  std::string bad = path + ".bad";
+  if (FILE* f = std::fopen(bad.c_str(), "w")) { std::fputs("not a journal", f); std::fclose(f); }
+  TickJournalWriter wb;
+  TickJournalReader rb;
+  if (wb.open(bad, "20251014") || rb.open(bad)) { std::printf("bad file accepted\n"); rc = 1; }
+
+  // 跨交易日：roll 换到后台预建的文件（只交换指针），旧日文件完整，新文件改名为 md_{day}.jrnl，预建文件不残留
+  {
+    char dir[] = "/tmp/tick_journal_rollXXXXXX";
+    if (!mkdtemp(dir)) { std::printf("mkdtemp\n"); return 1; }
+    TickJournalWriter w;
+    auto t0 = std::chrono::steady_clock::now();
+    if (!w.open_day(dir, "20251014", 100000)) { std::printf("open_day failed\n"); rc = 1; }
+    const double open_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    for (long long i = 0; i < 1000; ++i) w.append(make_md(i), 1000 * i);
+    for (int i = 0; i < 2000 && !w.spare_ready(); ++i) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    t0 = std::chrono::steady_clock::now();
+    const bool rolled = w.roll("20251015");
+    const double roll_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    if (!rolled || std::strcmp(w.trading_day(), "20251015") != 0 || w.committed() != 0) { std::printf("roll failed\n"); rc = 1; }
+    for (long long i = 0; i < 500; ++i) {
+      CThostFtdcDepthMarketDataField md = make_md(i);
+      std::snprintf(md.TradingDay, sizeof(md.TradingDay), "20251015");
+      w.append(md, 1000 * i);
+    }
+    // 后台线程改名后下一份预建就绪
+    for (int i = 0; i < 2000 && !w.spare_ready(); ++i) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    TickJournalReader r1, r2;
+    if (!r1.open(TickJournalWriter::day_path(dir, "20251014")) || r1.size() != 1000) { std::printf("old day journal\n"); rc = 1; }
+    if (!r2.open(TickJournalWriter::day_path(dir, "20251015")) || r2.size() != 500 ||
+        std::strcmp(r2.header().trading_day, "20251015") != 0 || r2.n_instruments() != 7 ||
+        std::strcmp(r2.at(499).md.TradingDay, "20251015") != 0) { std::printf("new day journal\n"); rc = 1; }
+    w.close();
+    int files = 0, spare = 0;
+    if (DIR* d = opendir(dir)) {
+      while (dirent* e = readdir(d)) { files += e->d_name[0] != '.'; spare += std::strncmp(e->d_name, ".md_spare", 9) == 0; }
+      closedir(d);
+    }
+    if (files != 2 || spare != 0) { std::printf("roll files=%d spare=%d\n", files, spare); rc = 1; }
+    std::printf("open_day %.1f us, roll %.2f us\n", open_us, roll_us);
+    std::string cmd = std::string("rm -rf ") + dir;
+    if (std::system(cmd.c_str()) != 0) {}
+  }
+
+  unlink(path.c_str());
+  unlink(bad.c_str());
+  std::printf(rc == 0 ? "ALL OK\n" : "FAILED\n");
+  return rc;
+}
@@ -0,0 +1,122 @@
+// tick_replay.h 实现
+#include "tick_replay.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+static bool ends_with(const std::string& s, const char* suffix) {
+  size_t n = std::strlen(suffix);
+  return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+static std::vector<std::string> split_commas(const std::string& line) {
+  std::vector<std::string> out;
+  size_t b = 0;
+  for (;;) {
+    size_t e = line.find(',', b);
+    out.push_back(line.substr(b, e == std::string::npos ? std::string::npos : e - b));
+    if (e == std::string::npos) break;
+    b = e + 1;
+  }
+  if (!out.empty() && !out.back().empty() && out.back().back() == '\r') out.back().pop_back();
+  return out;
+}
+
+// data_recorder.py 的一个 CSV 文件（表头见其 CSV_HEADER），按列名取值，空值记 0
+static void load_recorder_csv(const std::string& path, std::vector<JournalRecord>& out) {
+  std::ifstream in(path);
+  std::string line;
+  if (!std::getline(in, line)) return;
+  std::unordered_map<std::string, int> col;
+  auto header = split_commas(line);
+  for (size_t i = 0; i < header.size(); ++i) col[header[i]] = (int)i;
+  if (!col.count("code") || !col.count("trade_time") || !col.count("recv_ts_ms")) {
+    std::fprintf(stderr, "[replay] %s: not a data_recorder csv\n", path.c_str());
+    return;
+  }
+
+  std::vector<std::string> f;
+  auto str = [&](const char* name) -> const std::string& {
+    static const std::string empty;
+    auto it = col.find(name);
+    return (it != col.end() && it->second < (int)f.size()) ? f[it->second] : empty;
+  };
+  auto num = [&](const char* name) { return std::atof(str(name).c_str()); };
+  auto vol = [&](const char* name) { return std::atoi(str(name).c_str()); };
+
+  while (std::getline(in, line)) {
+    if (line.empty()) continue;
+    f = split_commas(line);
+    JournalRecord r;
+    std::memset(&r, 0, sizeof(r));
+    CThostFtdcDepthMarketDataField& md = r.md;
+    std::snprintf(md.InstrumentID, sizeof(md.InstrumentID), "%s", str("code").c_str());
+    // trade_time: "YYYY-MM-DD HH:MM:SS"
+    const std::string& tt = str("trade_time");
+    if (tt.size() >= 19) {
+      std::snprintf(md.ActionDay, sizeof(md.ActionDay), "%.4s%.2s%.2s", tt.c_str(), tt.c_str() + 5, tt.c_str() + 8);
+      std::memcpy(md.TradingDay, md.ActionDay, sizeof(md.TradingDay));
+      std::snprintf(md.UpdateTime, sizeof(md.UpdateTime), "%.8s", tt.c_str() + 11);
+    }
+    md.UpdateMillisec = vol("update_ms");
+    md.LastPrice = num("price");
+    md.OpenPrice = num("open");
+    md.ClosePrice = num("close");
+    md.HighestPrice = num("highest");
+    md.LowestPrice = num("lowest");
+    md.UpperLimitPrice = num("upper_limit");
+    md.LowerLimitPrice = num("lower_limit");
+    md.SettlementPrice = num("settlement");
+    md.Volume = vol("volume");
+    md.Turnover = num("turnover");
+    md.OpenInterest = num("open_interest");
+    md.PreClosePrice = num("pre_close");
+    md.PreSettlementPrice = num("pre_settlement");
+    md.PreOpenInterest = num("pre_open_interest");
+    md.BidPrice1 = num("bid1"); md.BidVolume1 = vol("bid1_vol"); md.AskPrice1 = num("ask1"); md.AskVolume1 = vol("ask1_vol");
+    md.BidPrice2 = num("bid2"); md.BidVolume2 = vol("bid2_vol"); md.AskPrice2 = num("ask2"); md.AskVolume2 = vol("ask2_vol");
+    md.BidPrice3 = num("bid3"); md.BidVolume3 = vol("bid3_vol"); md.AskPrice3 = num("ask3"); md.AskVolume3 = vol("ask3_vol");
+    md.BidPrice4 = num("bid4"); md.BidVolume4 = vol("bid4_vol"); md.AskPrice4 = num("ask4"); md.AskVolume4 = vol("ask4_vol");
+    md.BidPrice5 = num("bid5"); md.BidVolume5 = vol("bid5_vol"); md.AskPrice5 = num("ask5"); md.AskVolume5 = vol("ask5_vol");
+    r.recv_ns = std::atoll(str("recv_ts_ms").c_str()) * 1000000LL;
+    out.push_back(r);
+  }
+}
+
+bool TickReplaySource::loadCsv_(const std::string& path) {
+  struct stat st{};
+  if (::stat(path.c_str(), &st) != 0) return false;
+  if (S_ISDIR(st.st_mode)) {
+    // 目录：data_recorder 的 ticks/<env>/<YYYYMMDD>/，每个合约一个 CSV，合并后按时间排序
+    DIR* d = ::opendir(path.c_str());
+    if (!d) return false;
+    while (dirent* e = ::readdir(d)) {
+      std::string name = e->d_name;
+      if (ends_with(name, ".csv")) load_recorder_csv(path + "/" + name, records_);
+    }
+    ::closedir(d);
+  } else {
+    load_recorder_csv(path, records_);
+  }
+  std::stable_sort(records_.begin(), records_.end(),
+                   [](const JournalRecord& a, const JournalRecord& b) { return a.recv_ns < b.recv_ns; });
+  return true;
+}
+
+int TickReplaySource::open(const std::string& path) {
+  journal_.close();
+  journal_open_ = false;
+  records_.clear();
+  if (ends_with(path, ".jrnl")) {
+    if (!journal_.open(path)) return -1;
+    journal_open_ = true;
+  } else if (!loadCsv_(path)) {
+    return -1;
+  }
+  return size() > 0 ? 0 : -2;
+}
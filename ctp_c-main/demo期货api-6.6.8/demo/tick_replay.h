@@ -0,0 +1,23 @@
+// 行情回放数据源：读取 tick_journal 日志（*.jrnl，直接映射）或 data_recorder.py 的 CSV（单文件或按合约分文件的目录），
+// 统一成按 recv_ns 排列的 JournalRecord 序列，供回放线程按原始时间间隔重新驱动 OnRtnDepthMarketData
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "tick_journal.h"
+
+class TickReplaySource {
+public:
+  // 0 成功；-1 打不开；-2 无可用记录
+  int open(const std::string& path);
+
+  size_t size() const { return journal_open_ ? (size_t)journal_.size() : records_.size(); }
+  const JournalRecord& at(size_t i) const { return journal_open_ ? journal_.at(i) : records_[i]; }
+
+private:
+  bool loadCsv_(const std::string& path);
+
+  TickJournalReader journal_;
+  bool journal_open_ = false;
+  std::vector<JournalRecord> records_;  // CSV 解析结果，已按 recv_ns 稳定排序
+};
@@ -0,0 +1,89 @@
+// tick_replay.h 测试：日志文件直接读取、data_recorder CSV 解析、按合约分文件目录合并排序、异常输入
+#include "tick_replay.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+static const char* kHeader =
+    "event_time,trade_time,update_ms,code,price,open,close,highest,lowest,upper_limit,lower_limit,settlement,"
+    "volume,turnover,open_interest,pre_close,pre_settlement,pre_open_interest,"
+    "bid1,bid1_vol,ask1,ask1_vol,bid2,bid2_vol,ask2,ask2_vol,bid3,bid3_vol,ask3,ask3_vol,"
+    "bid4,bid4_vol,ask4,ask4_vol,bid5,bid5_vol,ask5,ask5_vol,recv_ts_ms\n";
+
+// 一行 CSV：价格 = base + i，recv_ts_ms = ts
+static void write_row(FILE* f, const char* code, int i, double base, long long ts) {
+  std::fprintf(f, "2025-10-14 09:30:%02d,2025-10-14 09:30:%02d,%d,%s,%.1f,%.1f,,%.1f,%.1f,0,0,0,"
+               "%d,%.1f,100,0,0,0,%.1f,%d,%.1f,%d,,,,,,,,,,,,,,,,,%lld\r\n",
+               i % 60, i % 60, 500, code, base + i, base, base + i, base, i * 10, (base + i) * 10.0,
+               base + i - 1, i + 1, base + i + 1, i + 2, ts);
+}
+
+int main() {
+  int rc = 0;
+  const std::string dir = "/tmp/tick_replay_test_" + std::to_string(getpid());
+  ::mkdir(dir.c_str(), 0755);
+
+  // 1) 按合约分文件的目录：两文件交错时间，合并后应按 recv_ts_ms 排序，同时间戳保持文件内顺序
+  {
+    FILE* a = std::fopen((dir + "/IM2510.csv").c_str(), "w");
+    FILE* b = std::fopen((dir + "/IF2510.csv").c_str(), "w");
+    std::fputs(kHeader, a); std::fputs(kHeader, b);
+    for (int i = 0; i < 50; ++i) { write_row(a, "IM2510", i, 6000.0, 1000 + 2 * i); write_row(b, "IF2510", i, 4000.0, 1001 + 2 * i); }
+    std::fclose(a); std::fclose(b);
+    FILE* junk = std::fopen((dir + "/notes.txt").c_str(), "w");
+    std::fputs("ignored\n", junk); std::fclose(junk);
+
+    TickReplaySource src;
+    if (src.open(dir) != 0 || src.size() != 100) { std::printf("dir: size=%zu\n", src.size()); rc = 1; }
+    for (size_t i = 1; i < src.size(); ++i)
+      if (src.at(i).recv_ns < src.at(i - 1).recv_ns) { std::printf("dir: not sorted at %zu\n", i); rc = 1; break; }
+    if (src.size() == 100) {
+      const CThostFtdcDepthMarketDataField& md = src.at(2).md;  // IM2510 第 2 行（ts=1002）
+      if (std::strcmp(md.InstrumentID, "IM2510") != 0 || md.LastPrice != 6001.0 || md.Volume != 10 ||
+          md.BidPrice1 != 6000.0 || md.AskVolume1 != 3 || md.UpdateMillisec != 500 ||
+          std::strcmp(md.TradingDay, "20251014") != 0 || std::strcmp(md.UpdateTime, "09:30:01") != 0 ||
+          src.at(2).recv_ns != 1002LL * 1000000) {
+        std::printf("dir: field mismatch %s %.1f %d\n", md.InstrumentID, md.LastPrice, md.Volume); rc = 1;
+      }
+    }
+  }
+
+  // 2) tick 日志：记录原样返回
+  const std::string jrnl = dir + "/md_20251014.jrnl";
+  {
+    TickJournalWriter w;
+    w.open(jrnl, "20251014", 1000);
+    CThostFtdcDepthMarketDataField md;
+    std::memset(&md, 0, sizeof(md));
+    for (int i = 0; i < 300; ++i) {
+      std::snprintf(md.InstrumentID, sizeof(md.InstrumentID), "rb25%02d", i % 3);
+      md.LastPrice = 3000 + i;
+      w.append(md, 5000LL * i);
+    }
+  }
+  {
+    TickReplaySource src;
+    if (src.open(jrnl) != 0 || src.size() != 300 || src.at(299).md.LastPrice != 3299 || src.at(299).recv_ns != 5000LL * 299) {
+      std::printf("jrnl: size=%zu\n", src.size()); rc = 1;
+    }
+  }
+
+  // 3) 异常输入：不存在、表头不符、空日志
+  {
+    TickReplaySource src;
+    if (src.open(dir + "/missing.csv") != -1) { std::printf("missing accepted\n"); rc = 1; }
+    FILE* f = std::fopen((dir + "/bad.csv").c_str(), "w");
+    std::fputs("a,b,c\n1,2,3\n", f); std::fclose(f);
+    if (src.open(dir + "/bad.csv") != -2) { std::printf("bad csv accepted\n"); rc = 1; }
+    { TickJournalWriter w; w.open(dir + "/empty.jrnl", "20251014", 100); }
+    if (src.open(dir + "/empty.jrnl") != -2) { std::printf("empty journal accepted\n"); rc = 1; }
+  }
+
+  for (const char* n : {"IM2510.csv", "IF2510.csv", "notes.txt", "md_20251014.jrnl", "bad.csv", "empty.jrnl"})
+    ::unlink((dir + "/" + n).c_str());
+  ::rmdir(dir.c_str());
+  std::printf(rc == 0 ? "ALL OK\n" : "FAILED\n");
+  return rc;
+}